@@ -16,12 +16,19 @@
 #include "export_ids.h"
 #include "display.h" 
 #include "wifi_station.h"
+#include "wifi_resume.h"
 #include "nvs_flash.h"
 #include "esp_log.h"
 #include "cli_menu.h"
 #include "uart_bridge.h"
+#include "task_profile.h"
+#include "link_profile.h"
+#include "task_monitor.h"
+#include "boot_timeline.h"
+#include "metrics_server.h"
 #include "lcd_fonts.h"
 #include "version.h"
+#include <inttypes.h>
 
 static const char *TAG = "app_main";
 
@@ -34,21 +41,38 @@ static const char *TAG = "app_main";
  */
 static void wifi_station_event_callback(wifi_station_event_t event, const wifi_connection_status_t *status, void *user_ctx)
 {
+    // 屏幕只在状态变化时刷新
+    display_notify_wifi();
+
     switch (event) {
         case WIFI_EVENT_CONNECTED:
+        case WIFI_EVENT_GOT_IP:
+            // 先到的事件启动服务, 已经启动时再次调用直接返回
+            boot_timeline_mark(event == WIFI_EVENT_GOT_IP ? BOOT_PHASE_GOT_IP : BOOT_PHASE_WIFI_CONNECTED);
+            if (event == WIFI_EVENT_CONNECTED) {
+                wifi_resume_on_connected(status);
+                link_profile_apply_wifi();
+            } else if (wifi_resume_on_got_ip(status)) {
+                // 宽限期内IP变化, 保留的连接已经无效
+                uart_bridge_stop_all();
+            }
             ESP_LOGI(TAG, "WiFi connected, starting TCP server...");
-            esp_err_t err = uart_bridge_start_tcp_server();
+            esp_err_t err = uart_bridge_start_all();
             if (err != ESP_OK) {
                 ESP_LOGE(TAG, "Failed to start TCP server: %s", esp_err_to_name(err));
+            } else {
+                boot_timeline_mark(BOOT_PHASE_FORWARDING);
             }
             break;
 
         case WIFI_EVENT_DISCONNECTED:
-            ESP_LOGI(TAG, "WiFi disconnected, stopping TCP server...");
-            uart_bridge_stop_tcp_server();
-            break;
-
-        case WIFI_EVENT_GOT_IP:
+            // 宽限期内保留网络服务, 到期后由wifi_resume_poll关闭
+            if (wifi_resume_on_disconnected(status)) {
+                ESP_LOGI(TAG, "WiFi disconnected, keeping TCP server for %" PRIu16 "s", wifi_resume_get_grace());
+            } else {
+                ESP_LOGI(TAG, "WiFi disconnected, stopping TCP server...");
+                uart_bridge_stop_all();
+            }
             break;
 
         default:
@@ -71,6 +95,7 @@ void app_main(void)
     //esp_log_level_set("tcp_server", ESP_LOG_DEBUG);
     //esp_log_level_set("uart_bridge", ESP_LOG_DEBUG);
 
+    boot_timeline_mark(BOOT_PHASE_APP_START);
     ESP_LOGI(TAG, "idf-version: %s, app-version: %s", esp_get_idf_version(), APP_VERSION);
 
     // 初始化APP事件循环, GPIO按键事件处理
@@ -86,9 +111,7 @@ void app_main(void)
         ret = nvs_flash_init();
     }    
     ESP_ERROR_CHECK(ret);
-
-    // 初始化字库
-    lcd_font_init();
+    boot_timeline_mark(BOOT_PHASE_NVS_READY);
 
     // 初始化网络接口
     ESP_ERROR_CHECK(esp_netif_init());
@@ -103,26 +126,54 @@ void app_main(void)
     // 0x33 = 00110011，表示LED会以更快的速度闪烁
     ext_led_flash(GPIO_SYS_LED, 0x01, 0xFFFFFFFF);
 
-    // 初始化TCP转串口桥接模块
-    ESP_ERROR_CHECK(uart_bridge_init(UART_PRIMARY));  // 使用默认配置（从NVS加载）
+    // 加载任务调度方案, 之后创建的任务按方案分配优先级和核心
+    ESP_ERROR_CHECK(task_profile_init());
+
+    // 任务CPU占用和栈使用统计, 显示和命令行都使用它的采样结果
+    ESP_ERROR_CHECK(task_monitor_start());
+
+    // 加载链路方案, 串口时钟源和浅睡眠唤醒在初始化桥接实例时按方案配置
+    ESP_ERROR_CHECK(link_profile_init());
+
+    // 初始化TCP转串口桥接实例, 实例数和每个实例的配置从NVS加载
+    // 串口先于网络和显示开始工作
+    ESP_ERROR_CHECK(uart_bridge_init_all());
+    boot_timeline_mark(BOOT_PHASE_UART_READY);
 
     // 初始化WiFi Station组件，使用tcp_uart_bridge的WiFi事件回调
+    // TCP服务器将通过WiFi事件回调自动启动/停止
+    ESP_ERROR_CHECK(wifi_resume_init());
     ESP_ERROR_CHECK(wifi_station_init(wifi_station_event_callback, NULL));
+    boot_timeline_mark(BOOT_PHASE_WIFI_STARTED);
+
+    // 统计导出服务监听所有接口, 获取IP后即可访问, 失败时不影响数据转发
+    ret = metrics_server_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start metrics server: %s", esp_err_to_name(ret));
+    }
 
     // 初始化命令行菜单
     ESP_ERROR_CHECK(cli_menu_init());
     ESP_ERROR_CHECK(cli_menu_start());
+    boot_timeline_mark(BOOT_PHASE_CLI_READY);
 
-    // 初始化显示模块
-    ESP_ERROR_CHECK(display_init());
-
-    // 启动显示任务
-    ESP_ERROR_CHECK(display_task_start());
+    // 字库和显示最慢, 放在最后, 与WiFi连接同时进行(主任务优先级最低)
+    lcd_font_init();
+    boot_timeline_mark(BOOT_PHASE_FONTS_READY);
 
-    // TCP服务器将通过WiFi事件回调自动启动/停止
-    // 当WiFi连接时启动TCP服务器，断开时停止TCP服务器
+    // 初始化显示模块, 失败时不影响数据转发
+    ret = display_init();
+    if (ret == ESP_OK) {
+        ret = display_task_start();
+    }
+    if (ret == ESP_OK) {
+        boot_timeline_mark(BOOT_PHASE_DISPLAY_READY);
+    } else {
+        ESP_LOGE(TAG, "Failed to start display: %s", esp_err_to_name(ret));
+    }
 
     while (1) {
         mdelay(1000);
+        wifi_resume_poll();
     }
 }
@@ -15,6 +15,7 @@
 #include "export_ids.h"
 #include "ext_gpio.h"
 #include "bus_manager.h"
+#include "board.h"
 
 #include "esp_log.h"
 
@@ -47,6 +48,26 @@ static const uart_hw_config_t s_uart_hw_config = {
     .txd_pin = GPIO_NUM_4,
 };
 
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+/// 第二个桥接串口, 只有ESP32-S3有多余的UART
+static const uart_hw_config_t s_uart2_hw_config = {
+    .uart_port = UART_NUM_2,
+    .rxd_pin = GPIO_NUM_18,
+    .txd_pin = GPIO_NUM_17,
+};
+#endif
+
+/// 串口硬件流控引脚, 只有在设置中开启流控后才会使用
+static const board_uart_flow_pins_t s_uart_flow_pins = {
+    #ifdef CONFIG_IDF_TARGET_ESP32S3
+    .rts_pin = GPIO_NUM_15,
+    .cts_pin = GPIO_NUM_16,
+    #else
+    .rts_pin = GPIO_NUM_0,
+    .cts_pin = GPIO_NUM_1,
+    #endif
+};
+
 /**
  * @brief 板级初始化
  * 
@@ -60,10 +81,22 @@ int board_init(void)
     ESP_ERROR_CHECK(i2c_bus_init(BUS_I2C0, &s_i2c_bus_config));
 
     ESP_ERROR_CHECK(uart_hw_config_add(UART_PRIMARY, &s_uart_hw_config));
+    #ifdef CONFIG_IDF_TARGET_ESP32S3
+    ESP_ERROR_CHECK(uart_hw_config_add(UART_SECONDARY, &s_uart2_hw_config));
+    #endif
 
     ESP_LOGI(TAG, "Board initialized success");
 
     return 0;
 }
 
+const board_uart_flow_pins_t *board_uart_flow_pins_get(uint8_t uart_id)
+{
+    if (uart_id == UART_PRIMARY) {
+        return &s_uart_flow_pins;
+    }
+
+    return NULL;
+}
+
 
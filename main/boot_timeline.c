@@ -0,0 +1,53 @@
+/**
+ * @file boot_timeline.c
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 启动阶段计时
+ * @version 0.1
+ * @date 2025-11-05
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "boot_timeline.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdatomic.h>
+
+static const char *TAG = "boot";
+
+// 0表示还没有到达, esp_timer在app_main之前就已经开始计时
+static atomic_llong s_phase_us[BOOT_PHASE_MAX];
+
+static const char *s_phase_names[BOOT_PHASE_MAX] = {
+    "App Start", "NVS Ready", "UART Ready", "WiFi Started", "CLI Ready",
+    "WiFi Connected", "Got IP", "Forwarding", "Fonts Ready", "Display Ready",
+};
+
+void boot_timeline_mark(boot_phase_t phase)
+{
+    if (phase >= BOOT_PHASE_MAX) {
+        return;
+    }
+
+    long long expected = 0;
+    const long long now = esp_timer_get_time();
+    if (atomic_compare_exchange_strong(&s_phase_us[phase], &expected, now)) {
+        ESP_LOGI(TAG, "%s at %lld ms", s_phase_names[phase], now / 1000);
+    }
+}
+
+int64_t boot_timeline_get(boot_phase_t phase)
+{
+    if (phase >= BOOT_PHASE_MAX) {
+        return -1;
+    }
+
+    const long long us = atomic_load(&s_phase_us[phase]);
+    return us > 0 ? us : -1;
+}
+
+const char *boot_phase_name(boot_phase_t phase)
+{
+    return phase < BOOT_PHASE_MAX ? s_phase_names[phase] : "?";
+}
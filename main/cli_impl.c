@@ -10,13 +10,24 @@
  */
 
 #include "wifi_station.h"
+#include "wifi_resume.h"
 #include "uart_bridge.h"
+#include "task_profile.h"
+#include "link_profile.h"
+#include "task_monitor.h"
+#include "traffic_capture.h"
+#include "uart_bench.h"
+#include "boot_timeline.h"
+#include "metrics_server.h"
+#include "display.h"
+#include "mem_arena.h"
 #include "esp_types.h"
 #include "esp_err.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/timers.h"
+#include "sdkconfig.h"
 #include <stdint.h>
 #include <string.h>
 #include <stdio.h>
@@ -35,6 +46,7 @@ typedef enum {
     CLI_STATE_UART,
     CLI_STATE_DEBUG,
     CLI_STATE_ABOUT,
+    CLI_STATE_SETTINGS,
 } cli_state_t;
 
 typedef enum {
@@ -69,9 +81,14 @@ typedef struct {
 #define _SUB_STEP_DELETE_NETWORK 3
 #define _SUB_STEP_ADD_NETWORK_INPUT_SSID 4
 #define _SUB_STEP_ADD_NETWORK_INPUT_PASSWORD 5
+#define _SUB_STEP_CHOOSE_SETTING 6
+#define _SUB_STEP_INPUT_SETTING 7
+#define _SUB_STEP_CHOOSE_DEBUG 8
+#define _SUB_STEP_INPUT_BENCH 9
     uint8_t sub_step;
     int input_index;
     char input_buffer[128];  // 用于多步骤输入
+    uint8_t bridge_index;    // 当前操作的桥接实例
 } cli_state_machine_t;
 
 const uint32_t g_supported_baudrates[] = {
@@ -81,14 +98,849 @@ const uint32_t g_supported_baudrates[] = {
 
 const int g_supported_baudrates_count = sizeof(g_supported_baudrates) / sizeof(g_supported_baudrates[0]);
 
+// 桥接参数设置项
+typedef struct {
+    const char *name;                               // 设置项名称
+    const char *hint;                               // 输入提示
+    void (*format)(char *buf, size_t size);         // 格式化当前值
+    esp_err_t (*apply)(const char *input);          // 应用输入的新值
+} cli_setting_item_t;
+
 static cli_state_machine_t s_cli_sm = {0};
 
+/**
+ * @brief 菜单当前操作的桥接实例
+ * 
+ * @return uart_bridge_handle_t 
+ */
+static uart_bridge_handle_t cli_bridge(void)
+{
+    uart_bridge_handle_t bridge = uart_bridge_get(s_cli_sm.bridge_index);
+    return bridge ? bridge : uart_bridge_get(0);
+}
+
+static void format_bridge_instance(char *buf, size_t size)
+{
+    snprintf(buf, size, "%d of %d", s_cli_sm.bridge_index + 1, uart_bridge_get_instance_count());
+}
+
+static esp_err_t apply_bridge_instance(const char *input)
+{
+    int value = atoi(input);
+    if (value < 1 || !uart_bridge_get(value - 1)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_cli_sm.bridge_index = (uint8_t)(value - 1);
+    return ESP_OK;
+}
+
+static void format_bridge_count(char *buf, size_t size)
+{
+    snprintf(buf, size, "%d (max %d)", uart_bridge_get_instance_count(), UART_BRIDGE_MAX_INSTANCES);
+}
+
+static esp_err_t apply_bridge_count(const char *input)
+{
+    int value = atoi(input);
+    if (value < 1 || value > UART_BRIDGE_MAX_INSTANCES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return uart_bridge_set_instance_count((uint8_t)value);
+}
+
+static void format_task_profile(char *buf, size_t size)
+{
+    const task_profile_t saved = task_profile_get_saved();
+    const task_profile_t active = task_profile_get_active();
+
+    if (saved == active) {
+        snprintf(buf, size, "%s", task_profile_name(active));
+    } else {
+        snprintf(buf, size, "%s (reboot to apply)", task_profile_name(saved));
+    }
+}
+
+static esp_err_t apply_task_profile(const char *input)
+{
+    return task_profile_set((task_profile_t)atoi(input));
+}
+
+static void format_link_profile(char *buf, size_t size)
+{
+    snprintf(buf, size, "%s%s", link_profile_name(link_profile_get()),
+             link_profile_reboot_pending() ? " (reboot to apply sleep)" : "");
+}
+
+static esp_err_t apply_link_profile(const char *input)
+{
+    return link_profile_set((link_profile_t)atoi(input));
+}
+
+static void format_wifi_grace(char *buf, size_t size)
+{
+    snprintf(buf, size, "%" PRIu16, wifi_resume_get_grace());
+}
+
+static esp_err_t apply_wifi_grace(const char *input)
+{
+    int value = atoi(input);
+    if (value < 0 || value > WIFI_RESUME_MAX_GRACE_SEC) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return wifi_resume_set_grace((uint16_t)value);
+}
+
+static void format_metrics_port(char *buf, size_t size)
+{
+    const uint16_t port = metrics_server_get_port();
+    if (port == 0) {
+        snprintf(buf, size, "off");
+        return;
+    }
+    snprintf(buf, size, "%" PRIu16, port);
+}
+
+static esp_err_t apply_metrics_port(const char *input)
+{
+    int value = atoi(input);
+    if (value < 0 || value > 65535) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return metrics_server_set_port((uint16_t)value);
+}
+
+static void format_display_off(char *buf, size_t size)
+{
+    const uint16_t seconds = display_get_off_timeout();
+    if (seconds == 0) {
+        snprintf(buf, size, "never");
+        return;
+    }
+    snprintf(buf, size, "%" PRIu16, seconds);
+}
+
+static esp_err_t apply_display_off(const char *input)
+{
+    int value = atoi(input);
+    if (value < 0 || value > DISPLAY_OFF_TIMEOUT_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return display_set_off_timeout((uint16_t)value);
+}
+
+static const char *s_slow_client_policy_names[] = {
+    "drop-oldest", "drop-newest", "disconnect"
+};
+
+static void format_slow_client_policy(char *buf, size_t size)
+{
+    uart_bridge_slow_client_policy_t policy = UART_BRIDGE_SLOW_CLIENT_DROP_OLDEST;
+    uint32_t stall_ms = 0;
+    uart_bridge_get_slow_client_policy(cli_bridge(), &policy, &stall_ms);
+    snprintf(buf, size, "%s", s_slow_client_policy_names[policy]);
+}
+
+static esp_err_t apply_slow_client_policy(const char *input)
+{
+    uart_bridge_slow_client_policy_t policy;
+    uint32_t stall_ms = 0;
+    uart_bridge_get_slow_client_policy(cli_bridge(), &policy, &stall_ms);
+    return uart_bridge_set_slow_client_policy(cli_bridge(), (uart_bridge_slow_client_policy_t)atoi(input), stall_ms);
+}
+
+static void format_stall_timeout(char *buf, size_t size)
+{
+    uart_bridge_slow_client_policy_t policy;
+    uint32_t stall_ms = 0;
+    uart_bridge_get_slow_client_policy(cli_bridge(), &policy, &stall_ms);
+    snprintf(buf, size, "%" PRIu32, stall_ms);
+}
+
+static esp_err_t apply_stall_timeout(const char *input)
+{
+    uart_bridge_slow_client_policy_t policy;
+    uint32_t stall_ms = 0;
+    uart_bridge_get_slow_client_policy(cli_bridge(), &policy, &stall_ms);
+
+    int value = atoi(input);
+    if (value < 100 || value > 60000) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return uart_bridge_set_slow_client_policy(cli_bridge(), policy, (uint32_t)value);
+}
+
+static const char *s_uart_tx_policy_names[] = {
+    "drop", "no-drop"
+};
+
+static void format_uart_tx_policy(char *buf, size_t size)
+{
+    snprintf(buf, size, "%s", s_uart_tx_policy_names[uart_bridge_get_uart_tx_policy(cli_bridge())]);
+}
+
+static esp_err_t apply_uart_tx_policy(const char *input)
+{
+    return uart_bridge_set_uart_tx_policy(cli_bridge(), (uart_bridge_uart_tx_policy_t)atoi(input));
+}
+
+static const char *s_tx_arbiter_names[] = {
+    "direct", "fair", "exclusive"
+};
+
+static void format_tx_arbiter(char *buf, size_t size)
+{
+    snprintf(buf, size, "%s", s_tx_arbiter_names[uart_bridge_get_tx_arbiter(cli_bridge())]);
+}
+
+static esp_err_t apply_tx_arbiter(const char *input)
+{
+    return uart_bridge_set_tx_arbiter(cli_bridge(), (uart_bridge_tx_arbiter_t)atoi(input));
+}
+
+static const char *s_flow_ctrl_names[] = {
+    "off", "rts/cts"
+};
+
+static void format_flow_ctrl(char *buf, size_t size)
+{
+    uart_bridge_flow_ctrl_t mode = UART_BRIDGE_FLOW_CTRL_NONE;
+    uint8_t rts_thresh = 0;
+    uart_bridge_get_flow_ctrl(cli_bridge(), &mode, &rts_thresh);
+    snprintf(buf, size, "%s", s_flow_ctrl_names[mode]);
+}
+
+static esp_err_t apply_flow_ctrl(const char *input)
+{
+    uart_bridge_flow_ctrl_t mode;
+    uint8_t rts_thresh = 0;
+    uart_bridge_get_flow_ctrl(cli_bridge(), &mode, &rts_thresh);
+    return uart_bridge_set_flow_ctrl(cli_bridge(), (uart_bridge_flow_ctrl_t)atoi(input), rts_thresh);
+}
+
+static void format_rts_thresh(char *buf, size_t size)
+{
+    uart_bridge_flow_ctrl_t mode;
+    uint8_t rts_thresh = 0;
+    uart_bridge_get_flow_ctrl(cli_bridge(), &mode, &rts_thresh);
+    snprintf(buf, size, "%d", rts_thresh);
+}
+
+static esp_err_t apply_rts_thresh(const char *input)
+{
+    uart_bridge_flow_ctrl_t mode;
+    uint8_t rts_thresh = 0;
+    uart_bridge_get_flow_ctrl(cli_bridge(), &mode, &rts_thresh);
+
+    int value = atoi(input);
+    if (value < 1 || value > 127) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return uart_bridge_set_flow_ctrl(cli_bridge(), mode, (uint8_t)value);
+}
+
+static const char *s_transport_names[] = {
+    "tcp", "udp", "rfc2217", "modbus-gw"
+};
+
+static void format_transport(char *buf, size_t size)
+{
+    snprintf(buf, size, "%s", s_transport_names[uart_bridge_get_transport(cli_bridge())]);
+}
+
+static esp_err_t apply_transport(const char *input)
+{
+    return uart_bridge_set_transport(cli_bridge(), (uart_bridge_transport_t)atoi(input));
+}
+
+static void format_rtu_framing(char *buf, size_t size)
+{
+    snprintf(buf, size, "%s", uart_bridge_get_rtu_framing(cli_bridge()) ? "on" : "off");
+}
+
+static esp_err_t apply_rtu_framing(const char *input)
+{
+    int value = atoi(input);
+    if (value < 0 || value > 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return uart_bridge_set_rtu_framing(cli_bridge(), value == 1);
+}
+
+static void format_modbus_timeout(char *buf, size_t size)
+{
+    uart_bridge_modbus_config_t modbus = {0};
+    uart_bridge_get_modbus_config(cli_bridge(), &modbus);
+    snprintf(buf, size, "%u", modbus.response_timeout_ms);
+}
+
+static esp_err_t apply_modbus_timeout(const char *input)
+{
+    uart_bridge_modbus_config_t modbus = {0};
+    uart_bridge_get_modbus_config(cli_bridge(), &modbus);
+
+    int value = atoi(input);
+    if (value < 10 || value > 10000) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    modbus.response_timeout_ms = (uint16_t)value;
+    return uart_bridge_set_modbus_config(cli_bridge(), &modbus);
+}
+
+static void format_modbus_turnaround(char *buf, size_t size)
+{
+    uart_bridge_modbus_config_t modbus = {0};
+    uart_bridge_get_modbus_config(cli_bridge(), &modbus);
+    snprintf(buf, size, "%u", modbus.turnaround_ms);
+}
+
+static esp_err_t apply_modbus_turnaround(const char *input)
+{
+    uart_bridge_modbus_config_t modbus = {0};
+    uart_bridge_get_modbus_config(cli_bridge(), &modbus);
+
+    int value = atoi(input);
+    if (value < 0 || value > 1000) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    modbus.turnaround_ms = (uint16_t)value;
+    return uart_bridge_set_modbus_config(cli_bridge(), &modbus);
+}
+
+static void format_udp_peer(char *buf, size_t size)
+{
+    uart_bridge_udp_config_t udp = {0};
+    uart_bridge_get_udp_config(cli_bridge(), &udp);
+    if (udp.peer_addr == 0) {
+        snprintf(buf, size, "last sender");
+        return;
+    }
+    snprintf(buf, size, "%d.%d.%d.%d:%d",
+             (int)(udp.peer_addr & 0xFF), (int)((udp.peer_addr >> 8) & 0xFF),
+             (int)((udp.peer_addr >> 16) & 0xFF), (int)((udp.peer_addr >> 24) & 0xFF),
+             udp.peer_port);
+}
+
+static esp_err_t apply_udp_peer(const char *input)
+{
+    uart_bridge_udp_config_t udp = {0};
+    uart_bridge_get_udp_config(cli_bridge(), &udp);
+
+    if (strcmp(input, "0") == 0) {
+        udp.peer_addr = 0;
+        udp.peer_port = 0;
+        return uart_bridge_set_udp_config(cli_bridge(), &udp);
+    }
+
+    unsigned int a, b, c, d, port = 0;
+    int n = sscanf(input, "%u.%u.%u.%u:%u", &a, &b, &c, &d, &port);
+    if (n < 4 || a > 255 || b > 255 || c > 255 || d > 255 || port > 65535 || (a | b | c | d) == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 与wifi_station的地址格式一致(网络字节序)
+    udp.peer_addr = (uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24);
+    udp.peer_port = (uint16_t)port;
+    return uart_bridge_set_udp_config(cli_bridge(), &udp);
+}
+
+static void format_udp_seq_header(char *buf, size_t size)
+{
+    uart_bridge_udp_config_t udp = {0};
+    uart_bridge_get_udp_config(cli_bridge(), &udp);
+    snprintf(buf, size, "%s", udp.seq_header ? "on" : "off");
+}
+
+static esp_err_t apply_udp_seq_header(const char *input)
+{
+    uart_bridge_udp_config_t udp = {0};
+    uart_bridge_get_udp_config(cli_bridge(), &udp);
+
+    int value = atoi(input);
+    if (value < 0 || value > 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    udp.seq_header = (uint8_t)value;
+    return uart_bridge_set_udp_config(cli_bridge(), &udp);
+}
+
+static void format_rfc2217_persist(char *buf, size_t size)
+{
+    snprintf(buf, size, "%s", uart_bridge_get_rfc2217_persist(cli_bridge()) ? "save" : "runtime only");
+}
+
+static esp_err_t apply_rfc2217_persist(const char *input)
+{
+    int value = atoi(input);
+    if (value < 0 || value > 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return uart_bridge_set_rfc2217_persist(cli_bridge(), value == 1);
+}
+
+static const char *s_rx_engine_names[] = {
+    "driver",
+    "dma",
+};
+
+static void format_rx_engine(char *buf, size_t size)
+{
+    snprintf(buf, size, "%s", s_rx_engine_names[uart_bridge_get_rx_engine(cli_bridge())]);
+}
+
+static esp_err_t apply_rx_engine(const char *input)
+{
+    int value = atoi(input);
+    if (value < 0 || value >= UART_BRIDGE_RX_ENGINE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return uart_bridge_set_rx_engine(cli_bridge(), (uart_bridge_rx_engine_t)value);
+}
+
+static const char *s_tcp_engine_names[UART_BRIDGE_TCP_ENGINE_MAX] = {
+    "sockets",
+    "lwip-raw",
+};
+
+static void format_tcp_engine(char *buf, size_t size)
+{
+    snprintf(buf, size, "%s", s_tcp_engine_names[uart_bridge_get_tcp_engine(cli_bridge())]);
+}
+
+static esp_err_t apply_tcp_engine(const char *input)
+{
+    int value = atoi(input);
+    if (value < 0 || value >= UART_BRIDGE_TCP_ENGINE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return uart_bridge_set_tcp_engine(cli_bridge(), (uart_bridge_tcp_engine_t)value);
+}
+
+static void format_rx_idle_chars(char *buf, size_t size)
+{
+    uart_bridge_rx_config_t rx = {0};
+    uart_bridge_get_rx_config(cli_bridge(), &rx);
+    snprintf(buf, size, "%d", rx.idle_chars);
+}
+
+static esp_err_t apply_rx_idle_chars(const char *input)
+{
+    uart_bridge_rx_config_t rx = {0};
+    uart_bridge_get_rx_config(cli_bridge(), &rx);
+
+    int value = atoi(input);
+    if (value < 1 || value > 100) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    rx.idle_chars = (uint8_t)value;
+    return uart_bridge_set_rx_config(cli_bridge(), &rx);
+}
+
+static void format_rx_fifo_thresh(char *buf, size_t size)
+{
+    uart_bridge_rx_config_t rx = {0};
+    uart_bridge_get_rx_config(cli_bridge(), &rx);
+    snprintf(buf, size, "%d", rx.fifo_full_thresh);
+}
+
+static esp_err_t apply_rx_fifo_thresh(const char *input)
+{
+    uart_bridge_rx_config_t rx = {0};
+    uart_bridge_get_rx_config(cli_bridge(), &rx);
+
+    int value = atoi(input);
+    if (value < 1 || value > 127) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    rx.fifo_full_thresh = (uint8_t)value;
+    return uart_bridge_set_rx_config(cli_bridge(), &rx);
+}
+
+static void format_rx_max_chunk(char *buf, size_t size)
+{
+    uart_bridge_rx_config_t rx = {0};
+    uart_bridge_get_rx_config(cli_bridge(), &rx);
+    snprintf(buf, size, "%d", rx.max_chunk);
+}
+
+static esp_err_t apply_rx_max_chunk(const char *input)
+{
+    uart_bridge_rx_config_t rx = {0};
+    uart_bridge_get_rx_config(cli_bridge(), &rx);
+
+    int value = atoi(input);
+    if (value < 1 || value > UART_BRIDGE_SEND_CHUNK_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    rx.max_chunk = (uint16_t)value;
+    return uart_bridge_set_rx_config(cli_bridge(), &rx);
+}
+
+static void format_rx_max_hold(char *buf, size_t size)
+{
+    uart_bridge_rx_config_t rx = {0};
+    uart_bridge_get_rx_config(cli_bridge(), &rx);
+    snprintf(buf, size, "%d", rx.max_hold_ms);
+}
+
+static esp_err_t apply_rx_max_hold(const char *input)
+{
+    uart_bridge_rx_config_t rx = {0};
+    uart_bridge_get_rx_config(cli_bridge(), &rx);
+
+    int value = atoi(input);
+    if (value < 1 || value > 1000) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    rx.max_hold_ms = (uint16_t)value;
+    return uart_bridge_set_rx_config(cli_bridge(), &rx);
+}
+
+static void format_buffer_size(char *buf, size_t size, uint32_t active, uint32_t override)
+{
+    snprintf(buf, size, "%" PRIu32 " (%s)", active, override ? "manual" : "auto");
+}
+
+/**
+ * @brief 解析缓冲区大小输入, 0表示自动
+ */
+static esp_err_t parse_buffer_size(const char *input, uart_bridge_buffer_info_t *info, uint32_t *value)
+{
+    int size = atoi(input);
+    if (size < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *value = (uint32_t)size;
+    return uart_bridge_get_buffer_info(cli_bridge(), info);
+}
+
+static void format_uart_rx_buffer(char *buf, size_t size)
+{
+    uart_bridge_buffer_info_t info;
+    uart_bridge_get_buffer_info(cli_bridge(), &info);
+    format_buffer_size(buf, size, info.active.uart_rx_size, info.override.uart_rx_size);
+}
+
+static esp_err_t apply_uart_rx_buffer(const char *input)
+{
+    uart_bridge_buffer_info_t info;
+    uint32_t value = 0;
+    esp_err_t ret = parse_buffer_size(input, &info, &value);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    info.override.uart_rx_size = value;
+    return uart_bridge_set_buffer_override(cli_bridge(), &info.override);
+}
+
+static void format_uart_tx_buffer(char *buf, size_t size)
+{
+    uart_bridge_buffer_info_t info;
+    uart_bridge_get_buffer_info(cli_bridge(), &info);
+    format_buffer_size(buf, size, info.active.uart_tx_size, info.override.uart_tx_size);
+}
+
+static esp_err_t apply_uart_tx_buffer(const char *input)
+{
+    uart_bridge_buffer_info_t info;
+    uint32_t value = 0;
+    esp_err_t ret = parse_buffer_size(input, &info, &value);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    info.override.uart_tx_size = value;
+    return uart_bridge_set_buffer_override(cli_bridge(), &info.override);
+}
+
+static void format_ring_buffer(char *buf, size_t size)
+{
+    uart_bridge_buffer_info_t info;
+    uart_bridge_get_buffer_info(cli_bridge(), &info);
+    format_buffer_size(buf, size, info.active.ring_size, info.override.ring_size);
+}
+
+static esp_err_t apply_ring_buffer(const char *input)
+{
+    uart_bridge_buffer_info_t info;
+    uint32_t value = 0;
+    esp_err_t ret = parse_buffer_size(input, &info, &value);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    info.override.ring_size = value;
+    return uart_bridge_set_buffer_override(cli_bridge(), &info.override);
+}
+
+// 与UART_BRIDGE_OUTAGE_BUF_MIN/MAX一致
+#if CONFIG_SPIRAM
+#define OUTAGE_BUFFER_RANGE "1024-4194304"
+#else
+#define OUTAGE_BUFFER_RANGE "1024-32768"
+#endif
+
+static void format_outage_buffer(char *buf, size_t size)
+{
+    const uint32_t saved = uart_bridge_get_outage_buffer(cli_bridge());
+    uart_bridge_buffer_info_t info;
+    uart_bridge_get_buffer_info(cli_bridge(), &info);
+
+    if (saved == 0) {
+        snprintf(buf, size, "off");
+    } else if (info.outage_size != saved) {
+        snprintf(buf, size, "%" PRIu32 " (alloc failed)", saved);
+    } else {
+        snprintf(buf, size, "%" PRIu32 "%s", saved, info.outage_psram ? " (psram)" : "");
+    }
+}
+
+static esp_err_t apply_outage_buffer(const char *input)
+{
+    return uart_bridge_set_outage_buffer(cli_bridge(), (uint32_t)strtoul(input, NULL, 10));
+}
+
+static const char *s_nodelay_names[UART_BRIDGE_NODELAY_MAX] = {
+    "profile", "off", "on"
+};
+
+static const char *s_evict_policy_names[UART_BRIDGE_EVICT_MAX] = {
+    "reject", "evict-oldest", "evict-idlest"
+};
+
+/**
+ * @brief 修改一项socket参数, 取值范围由uart_bridge检查
+ *
+ * @param input
+ * @param max 字段能表示的最大值
+ * @param opts 输出修改前的参数
+ * @param value
+ * @return esp_err_t
+ */
+static esp_err_t parse_sock_opt(const char *input, uint32_t max, uart_bridge_sock_opts_t *opts, uint32_t *value)
+{
+    char *end = NULL;
+    long parsed = strtol(input, &end, 10);
+    if (end == input || parsed < 0 || (uint32_t)parsed > max) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *value = (uint32_t)parsed;
+    return uart_bridge_get_sock_opts(cli_bridge(), opts);
+}
+
+static uart_bridge_sock_opts_t cli_sock_opts(void)
+{
+    uart_bridge_sock_opts_t opts = {0};
+    uart_bridge_get_sock_opts(cli_bridge(), &opts);
+    return opts;
+}
+
+static void format_tcp_nodelay(char *buf, size_t size)
+{
+    const uart_bridge_sock_opts_t opts = cli_sock_opts();
+    snprintf(buf, size, "%s", opts.nodelay < UART_BRIDGE_NODELAY_MAX ? s_nodelay_names[opts.nodelay] : "?");
+}
+
+static esp_err_t apply_tcp_nodelay(const char *input)
+{
+    uart_bridge_sock_opts_t opts;
+    uint32_t value = 0;
+    esp_err_t ret = parse_sock_opt(input, UINT8_MAX, &opts, &value);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    opts.nodelay = (uint8_t)value;
+    return uart_bridge_set_sock_opts(cli_bridge(), &opts);
+}
+
+static void format_evict_policy(char *buf, size_t size)
+{
+    const uart_bridge_sock_opts_t opts = cli_sock_opts();
+    snprintf(buf, size, "%s", opts.evict_policy < UART_BRIDGE_EVICT_MAX ? s_evict_policy_names[opts.evict_policy] : "?");
+}
+
+static esp_err_t apply_evict_policy(const char *input)
+{
+    uart_bridge_sock_opts_t opts;
+    uint32_t value = 0;
+    esp_err_t ret = parse_sock_opt(input, UINT8_MAX, &opts, &value);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    opts.evict_policy = (uint8_t)value;
+    return uart_bridge_set_sock_opts(cli_bridge(), &opts);
+}
+
+static void format_keepalive_idle(char *buf, size_t size)
+{
+    const uart_bridge_sock_opts_t opts = cli_sock_opts();
+    if (opts.keepalive_idle_s == 0) {
+        snprintf(buf, size, "off");
+    } else {
+        snprintf(buf, size, "%" PRIu16, opts.keepalive_idle_s);
+    }
+}
+
+static esp_err_t apply_keepalive_idle(const char *input)
+{
+    uart_bridge_sock_opts_t opts;
+    uint32_t value = 0;
+    esp_err_t ret = parse_sock_opt(input, UINT16_MAX, &opts, &value);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    opts.keepalive_idle_s = (uint16_t)value;
+    return uart_bridge_set_sock_opts(cli_bridge(), &opts);
+}
+
+static void format_keepalive_intvl(char *buf, size_t size)
+{
+    snprintf(buf, size, "%" PRIu16, cli_sock_opts().keepalive_intvl_s);
+}
+
+static esp_err_t apply_keepalive_intvl(const char *input)
+{
+    uart_bridge_sock_opts_t opts;
+    uint32_t value = 0;
+    esp_err_t ret = parse_sock_opt(input, UINT16_MAX, &opts, &value);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    opts.keepalive_intvl_s = (uint16_t)value;
+    return uart_bridge_set_sock_opts(cli_bridge(), &opts);
+}
+
+static void format_keepalive_count(char *buf, size_t size)
+{
+    snprintf(buf, size, "%d", cli_sock_opts().keepalive_count);
+}
+
+static esp_err_t apply_keepalive_count(const char *input)
+{
+    uart_bridge_sock_opts_t opts;
+    uint32_t value = 0;
+    esp_err_t ret = parse_sock_opt(input, UINT8_MAX, &opts, &value);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    opts.keepalive_count = (uint8_t)value;
+    return uart_bridge_set_sock_opts(cli_bridge(), &opts);
+}
+
+static void format_user_timeout(char *buf, size_t size)
+{
+    const uart_bridge_sock_opts_t opts = cli_sock_opts();
+    if (opts.user_timeout_ms == 0) {
+        snprintf(buf, size, "off");
+    } else {
+        snprintf(buf, size, "%" PRIu32, opts.user_timeout_ms);
+    }
+}
+
+static esp_err_t apply_user_timeout(const char *input)
+{
+    uart_bridge_sock_opts_t opts;
+    uint32_t value = 0;
+    esp_err_t ret = parse_sock_opt(input, UINT32_MAX, &opts, &value);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    opts.user_timeout_ms = value;
+    return uart_bridge_set_sock_opts(cli_bridge(), &opts);
+}
+
+static void format_send_buf(char *buf, size_t size)
+{
+    const uart_bridge_sock_opts_t opts = cli_sock_opts();
+    if (opts.send_buf == 0) {
+        snprintf(buf, size, "profile (%" PRIu32 ")", link_profile_params()->client_queue_bytes);
+    } else {
+        snprintf(buf, size, "%" PRIu32, opts.send_buf);
+    }
+}
+
+static esp_err_t apply_send_buf(const char *input)
+{
+    uart_bridge_sock_opts_t opts;
+    uint32_t value = 0;
+    esp_err_t ret = parse_sock_opt(input, UINT32_MAX, &opts, &value);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    opts.send_buf = value;
+    return uart_bridge_set_sock_opts(cli_bridge(), &opts);
+}
+
+static void format_recv_buf(char *buf, size_t size)
+{
+    const uart_bridge_sock_opts_t opts = cli_sock_opts();
+    if (opts.recv_buf == 0) {
+        snprintf(buf, size, "default");
+    } else {
+        snprintf(buf, size, "%" PRIu32, opts.recv_buf);
+    }
+}
+
+static esp_err_t apply_recv_buf(const char *input)
+{
+    uart_bridge_sock_opts_t opts;
+    uint32_t value = 0;
+    esp_err_t ret = parse_sock_opt(input, UINT32_MAX, &opts, &value);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    opts.recv_buf = value;
+    return uart_bridge_set_sock_opts(cli_bridge(), &opts);
+}
+
+static const cli_setting_item_t s_setting_items[] = {
+    { "Bridge Instance", "1-N, instance edited by this menu", format_bridge_instance, apply_bridge_instance },
+    { "Bridge Count", "1-max, reboot to apply", format_bridge_count, apply_bridge_count },
+    { "Task Profile", "0=default, 1=dual-core, reboot to apply", format_task_profile, apply_task_profile },
+    { "Link Profile", "0=balanced, 1=low-latency, 2=throughput, 3=low-power", format_link_profile, apply_link_profile },
+    { "WiFi Grace (s)", "0=off, 1-300, keep sessions after drop", format_wifi_grace, apply_wifi_grace },
+    { "Metrics Port", "0=off, 1-65535, http /metrics", format_metrics_port, apply_metrics_port },
+    { "Display Off (s)", "0=never, 10-3600, blank screen when no button is pressed", format_display_off, apply_display_off },
+    { "Slow Client Policy", "0=drop-oldest, 1=drop-newest, 2=disconnect", format_slow_client_policy, apply_slow_client_policy },
+    { "Stall Timeout (ms)", "100-60000, used by disconnect policy", format_stall_timeout, apply_stall_timeout },
+    { "TCP Nodelay", "0=by link profile, 1=off, 2=on", format_tcp_nodelay, apply_tcp_nodelay },
+    { "Server Full Policy", "0=reject, 1=evict-oldest, 2=evict-idlest", format_evict_policy, apply_evict_policy },
+    { "Keepalive Idle (s)", "0=off, 1-7200, probe idle clients", format_keepalive_idle, apply_keepalive_idle },
+    { "Keepalive Interval (s)", "1-75, between probes", format_keepalive_intvl, apply_keepalive_intvl },
+    { "Keepalive Count", "1-10, failed probes to close", format_keepalive_count, apply_keepalive_count },
+    { "User Timeout (ms)", "0=off, 1000-600000, close if no progress", format_user_timeout, apply_user_timeout },
+    { "Client Send Buffer", "0=by link profile, 1024-65536", format_send_buf, apply_send_buf },
+    { "Client Recv Buffer", "0=default, 1024-65536, SO_RCVBUF", format_recv_buf, apply_recv_buf },
+    { "UART TX Policy", "0=drop, 1=no-drop(tcp backpressure)", format_uart_tx_policy, apply_uart_tx_policy },
+    { "UART TX Arbiter", "0=direct, 1=fair(round-robin), 2=exclusive(first client)", format_tx_arbiter, apply_tx_arbiter },
+    { "Flow Control", "0=off, 1=rts/cts", format_flow_ctrl, apply_flow_ctrl },
+    { "RTS Threshold", "1-127, rx fifo bytes to assert rts", format_rts_thresh, apply_rts_thresh },
+    { "Transport", "0=tcp, 1=udp, 2=rfc2217, 3=modbus-tcp gateway", format_transport, apply_transport },
+    { "UDP Peer", "0=last sender, a.b.c.d[:port]", format_udp_peer, apply_udp_peer },
+    { "UDP Seq Header", "0=off, 1=on", format_udp_seq_header, apply_udp_seq_header },
+    { "RFC2217 Save", "0=runtime only, 1=save to nvs", format_rfc2217_persist, apply_rfc2217_persist },
+    { "RTU Framing", "0=off, 1=on, forward whole frames by 3.5 char gap", format_rtu_framing, apply_rtu_framing },
+    { "Modbus Timeout (ms)", "10-10000, gateway response timeout", format_modbus_timeout, apply_modbus_timeout },
+    { "Modbus Turnaround (ms)", "0-1000, gateway delay after broadcast", format_modbus_turnaround, apply_modbus_turnaround },
+    { "RX Engine", "0=driver, 1=dma, reboot to apply", format_rx_engine, apply_rx_engine },
+    { "TCP Engine", "0=sockets, 1=lwip-raw, clients reconnect", format_tcp_engine, apply_tcp_engine },
+    { "RX Idle Gap (chars)", "1-100, flush after line idle", format_rx_idle_chars, apply_rx_idle_chars },
+    { "RX FIFO Threshold", "1-127, hw fifo full interrupt", format_rx_fifo_thresh, apply_rx_fifo_thresh },
+    { "RX Max Chunk (bytes)", "1-2048, flush when reached", format_rx_max_chunk, apply_rx_max_chunk },
+    { "RX Max Hold (ms)", "1-1000, flush when reached", format_rx_max_hold, apply_rx_max_hold },
+    { "UART RX Buffer", "0=auto, 129-65536", format_uart_rx_buffer, apply_uart_rx_buffer },
+    { "UART TX Buffer", "0=auto, 129-65536", format_uart_tx_buffer, apply_uart_tx_buffer },
+    { "RX Ring Buffer", "0=auto, power of 2, 4096-65536", format_ring_buffer, apply_ring_buffer },
+    { "Outage Buffer", "0=off, " OUTAGE_BUFFER_RANGE ", replay after reconnect", format_outage_buffer, apply_outage_buffer },
+};
+
+static const int s_setting_items_count = sizeof(s_setting_items) / sizeof(s_setting_items[0]);
+
 // 前向声明
 static void show_main_menu(void);
 static void show_wifi_menu(void);
 static void show_about_menu(void);
 static void show_uart_baudrate_menu(void);
 static void show_status(void);
+static void show_settings_menu(void);
 
 static void active_auto_connect_once(void);
 static void start_wifi_scan_and_connect(void);
@@ -109,6 +961,7 @@ static void handle_wifi_networks(const char *input);
 static void handle_wifi_network_delete(const char *input);
 static void handle_wifi_network_add(const char *input);
 static void handle_statistics_debug_menu(const char *input);
+static void handle_settings_menu(const char *input);
 
 static void return_to_main_menu(const char *input);
 
@@ -196,6 +1049,9 @@ void cli_state_machine_input(const char *input)
         case CLI_STATE_ABOUT:
             return_to_main_menu(input);
             break;
+        case CLI_STATE_SETTINGS:
+            handle_settings_menu(input);
+            break;
         default:
             ESP_LOGE(TAG, "Invalid state: %d", sm->state);
             break;
@@ -239,6 +1095,7 @@ static void show_main_menu(void)
     printf("3. UART Baudrate\n");
     printf("4. Statistics & Debug\n");
     printf("5. About\n");
+    printf("6. Bridge Settings\n");
     printf("Please input: ");
     fflush(stdout);
 }
@@ -270,13 +1127,6 @@ static void show_status(void)
         return;
     }
 
-    uart_bridge_status_t bridge_status;
-    ret = uart_bridge_get_status(&bridge_status);
-    if (ret != ESP_OK) {
-        printf("***Failed to get uart-bridge status: %s\n", esp_err_to_name(ret));
-        return;
-    }
-
     // 如果未连接, 清空IP地址信息等
     if (wifi_status.state != WIFI_STATE_CONNECTED) {
         wifi_status.ip_addr = 0;
@@ -326,11 +1176,65 @@ static void show_status(void)
             (int)((wifi_status.dns1 >> 8) & 0xFF),
             (int)((wifi_status.dns1 >> 16) & 0xFF),
             (int)((wifi_status.dns1 >> 24) & 0xFF));    
-    printf("UART Bridge\n");
-    printf(" Port     : %" PRIu16 "\n", bridge_status.tcp_port);
-    printf(" Baudrate : %" PRIu32 "\n", bridge_status.uart_baudrate);
-    printf(" Clients  : %" PRIu16 "\n", bridge_status.tcp_client_num);
-    printf(" Service  : %s\n", bridge_status.forwarding ? "forwarding" : "standby");
+
+    wifi_resume_stats_t resume;
+    if (wifi_resume_get_stats(&resume) == ESP_OK) {
+        printf("WiFi Reconnect\n");
+        printf(" Drops    : %" PRIu32 " (resumed %" PRIu32 ", expired %" PRIu32 ")%s\n",
+               resume.disconnects, resume.resumed, resume.expired,
+               resume.sessions_kept ? ", sessions kept" : "");
+        printf(" Fast Path: %" PRIu32 " / %" PRIu32 " hit\n", resume.fast_hits, resume.fast_attempts);
+        printf(" Reconnect: %" PRIu32 " ms (max %" PRIu32 ")\n", resume.last_reconnect_ms, resume.max_reconnect_ms);
+        printf(" Outage   : %" PRIu32 " ms (max %" PRIu32 ")\n", resume.last_outage_ms, resume.max_outage_ms);
+    }
+
+    printf("Link Profile: %s, light sleep %s\n", link_profile_name(link_profile_get()),
+           link_profile_sleep_active() ? "on" : "off");
+
+    const uint16_t metrics_port = metrics_server_get_port();
+    if (metrics_port != 0) {
+        printf("Metrics: http://%d.%d.%d.%d:%" PRIu16 "/metrics, %" PRIu32 " scrapes\n",
+               (int)(wifi_status.ip_addr & 0xFF), (int)((wifi_status.ip_addr >> 8) & 0xFF),
+               (int)((wifi_status.ip_addr >> 16) & 0xFF), (int)((wifi_status.ip_addr >> 24) & 0xFF),
+               metrics_port, metrics_server_get_scrapes());
+    } else {
+        printf("Metrics: off\n");
+    }
+
+    for (uint8_t i = 0; i < UART_BRIDGE_MAX_INSTANCES; i++) {
+        uart_bridge_handle_t bridge = uart_bridge_get(i);
+        if (!bridge) {
+            continue;
+        }
+
+        uart_bridge_status_t bridge_status;
+        ret = uart_bridge_get_status(bridge, &bridge_status);
+        if (ret != ESP_OK) {
+            printf("***Failed to get uart-bridge status: %s\n", esp_err_to_name(ret));
+            continue;
+        }
+
+        printf("UART Bridge %d\n", bridge_status.index + 1);
+        printf(" Port     : %" PRIu16 " (%s)\n", bridge_status.tcp_port,
+               bridge_status.transport < UART_BRIDGE_TRANSPORT_MAX ? s_transport_names[bridge_status.transport] : "?");
+        printf(" Baudrate : %" PRIu32 "\n", bridge_status.uart_baudrate);
+        printf(" RX Engine: %s\n",
+               bridge_status.rx_engine < UART_BRIDGE_RX_ENGINE_MAX ? s_rx_engine_names[bridge_status.rx_engine] : "?");
+        printf(" TCP Eng  : %s\n",
+               bridge_status.tcp_engine < UART_BRIDGE_TCP_ENGINE_MAX ? s_tcp_engine_names[bridge_status.tcp_engine] : "?");
+        printf(" Clients  : %" PRIu16 "\n", bridge_status.tcp_client_num);
+        uart_bridge_sock_opts_t opts;
+        if (uart_bridge_get_sock_opts(bridge, &opts) == ESP_OK) {
+            printf(" Socket   : nodelay %s, %s, user timeout %" PRIu32 " ms\n",
+                   opts.nodelay < UART_BRIDGE_NODELAY_MAX ? s_nodelay_names[opts.nodelay] : "?",
+                   opts.evict_policy < UART_BRIDGE_EVICT_MAX ? s_evict_policy_names[opts.evict_policy] : "?",
+                   opts.user_timeout_ms);
+            printf(" Keepalive: idle %" PRIu16 " s, interval %" PRIu16 " s, count %d\n",
+                   opts.keepalive_idle_s, opts.keepalive_intvl_s, opts.keepalive_count);
+            printf(" Buffers  : send %" PRIu32 ", recv %" PRIu32 " (0=default)\n", opts.send_buf, opts.recv_buf);
+        }
+        printf(" Service  : %s\n", bridge_status.forwarding ? "forwarding" : "standby");
+    }
     printf("--------\n");
     printf("Input [Enter] to return\n");
     fflush(stdout);
@@ -338,10 +1242,10 @@ static void show_status(void)
 
 static void show_uart_baudrate_menu(void)
 {
-    printf("\n=== UART Baudrate ===\n");
+    printf("\n=== UART%d Baudrate ===\n", s_cli_sm.bridge_index + 1);
 
     uart_bridge_status_t bridge_status = {0};
-    uart_bridge_get_status(&bridge_status);
+    uart_bridge_get_status(cli_bridge(), &bridge_status);
 
     for (int i = 0; i < g_supported_baudrates_count; i++) {
         printf("%d. %" PRIu32 " %s\n", i + 1, g_supported_baudrates[i], bridge_status.uart_baudrate == g_supported_baudrates[i] ? "<" : "");
@@ -356,7 +1260,7 @@ static void show_uart_baudrate_menu(void)
 
 static void show_statistics_debug_menu(void)
 {
-    printf("\n=== Statistics & Debug ===\n");
+    printf("\n=== Statistics & Debug (UART%d) ===\n", s_cli_sm.bridge_index + 1);
     printf("1. Show Statistics\n");
     printf("2. Reset Statistics\n");
     printf("3. Uart TX Verbose\n");
@@ -365,13 +1269,269 @@ static void show_statistics_debug_menu(void)
     printf("6. TCP TX Verbose\n");
     printf("7. TCP RX Verbose\n");
     printf("8. TCP TX & RX Verbose\n");
+    printf("9. Client Statistics\n");
+    printf("10. Latency & Throughput\n");
+    printf("11. Task Layout\n");
+    printf("12. Task CPU & Stack\n");
+    printf("13. Capture to TCP\n");
+    printf("14. Stop Capture\n");
+    printf("15. Loopback Benchmark\n");
+    printf("16. Benchmark Results\n");
+    printf("--------\n");
+    printf("0. Exit\n");
+    printf("--------\n");
+    printf("Please input: ");
+    fflush(stdout);
+    s_cli_sm.sub_step = _SUB_STEP_CHOOSE_DEBUG;
+}
+
+
+static void show_settings_menu(void)
+{
+    printf("\n=== Bridge Settings (UART%d) ===\n", s_cli_sm.bridge_index + 1);
+
+    for (int i = 0; i < s_setting_items_count; i++) {
+        char value[32] = {0};
+        s_setting_items[i].format(value, sizeof(value));
+        printf("%d. %-22s: %s\n", i + 1, s_setting_items[i].name, value);
+    }
+
+    // 缓冲区内存占用
+    uart_bridge_buffer_info_t info;
+    if (uart_bridge_get_buffer_info(cli_bridge(), &info) == ESP_OK) {
+        printf("--------\n");
+        printf("Buffer RAM: %" PRIu32 " bytes\n", info.total_bytes);
+        printf(" UART RX/TX      : %" PRIu32 " / %" PRIu32 "\n", info.active.uart_rx_size, info.active.uart_tx_size);
+        printf(" RX Ring         : %" PRIu32 " (read chunk %" PRIu32 ")\n", info.active.ring_size, info.read_chunk);
+        printf(" Client Queues   : %" PRIu32 " (max)\n", info.client_queue_bytes);
+        if (info.inbound_queue_bytes > 0) {
+            printf(" Inbound Queues  : %" PRIu32 "\n", info.inbound_queue_bytes);
+        }
+        printf(" Task Stacks     : %" PRIu32 "\n", info.task_stack_bytes);
+        if (info.outage_size > 0) {
+            printf(" Outage Buffer   : %" PRIu32 "%s\n", info.outage_size, info.outage_psram ? " (psram, not counted)" : "");
+        }
+    }
+
     printf("--------\n");
     printf("0. Exit\n");
     printf("--------\n");
     printf("Please input: ");
     fflush(stdout);
+    s_cli_sm.sub_step = _SUB_STEP_CHOOSE_SETTING;
+}
+
+static void show_client_statistics(void)
+{
+    uart_bridge_client_stats_t stats[UART_BRIDGE_MAX_CLIENTS];
+    uint8_t count = UART_BRIDGE_MAX_CLIENTS;
+    esp_err_t ret = uart_bridge_get_client_stats(cli_bridge(), stats, &count);
+
+    printf("\n=== TCP Client Statistics ===\n");
+    if (ret != ESP_OK) {
+        printf("***Failed to get client statistics: %s\n", esp_err_to_name(ret));
+    } else if (count == 0) {
+        printf("No client connected\n");
+    } else {
+        for (uint8_t i = 0; i < count; i++) {
+            printf("Client %d (%s:%" PRIu16 "):\n", i + 1, stats[i].addr, stats[i].port);
+            printf(" TX Bytes        : %" PRIu32 "\n", stats[i].tx_bytes);
+            printf(" Drop Bytes      : %" PRIu32 "\n", stats[i].drop_bytes);
+            printf(" Drops           : %" PRIu32 "\n", stats[i].drop_count);
+            printf(" Queued / Peak   : %" PRIu32 " / %" PRIu32 "\n", stats[i].queued_bytes, stats[i].peak_queued_bytes);
+            printf(" Stalled         : %" PRIu32 " ms\n", stats[i].stalled_ms);
+        }
+    }
+
+    // TCP传输方式下, 每个客户端写入串口的情况
+    uart_bridge_inbound_stats_t inbound[UART_BRIDGE_MAX_CLIENTS];
+    count = UART_BRIDGE_MAX_CLIENTS;
+    if (uart_bridge_get_transport(cli_bridge()) == UART_BRIDGE_TRANSPORT_TCP &&
+        uart_bridge_get_inbound_stats(cli_bridge(), inbound, &count) == ESP_OK && count > 0) {
+        printf("--------\n");
+        printf("TCP -> UART (arbiter: %s):\n", s_tx_arbiter_names[uart_bridge_get_tx_arbiter(cli_bridge())]);
+        for (uint8_t i = 0; i < count; i++) {
+            printf("Client %d (%s:%" PRIu16 ")%s:\n", i + 1, inbound[i].addr, inbound[i].port,
+                   inbound[i].owner ? " [owner]" : "");
+            printf(" RX / Drop Bytes : %" PRIu32 " / %" PRIu32 "\n", inbound[i].rx_bytes, inbound[i].drop_bytes);
+            printf(" Queued / Peak   : %" PRIu32 " / %" PRIu32 "\n", inbound[i].queued_bytes, inbound[i].peak_queued_bytes);
+            printf(" Wait Last / Max : %" PRIu32 " / %" PRIu32 " us\n", inbound[i].wait_last_us, inbound[i].wait_max_us);
+        }
+    }
+    printf("--------\n");
+    printf("Input [Enter] to return\n");
+}
+
+static void show_perf_statistics(void)
+{
+    static const char *latency_names[UART_BRIDGE_LATENCY_MAX] = {
+        "UART RX -> Queue", "Queue -> Socket", "TCP RX -> UART TX"
+    };
+    uart_bridge_perf_t perf;
+    esp_err_t ret = uart_bridge_get_perf(cli_bridge(), &perf);
+
+    printf("\n=== Latency & Throughput ===\n");
+    printf("Task Profile: %s, Link Profile: %s\n", task_profile_name(task_profile_get_active()),
+           link_profile_name(link_profile_get()));
+    if (ret != ESP_OK) {
+        printf("***Failed to get statistics: %s\n", esp_err_to_name(ret));
+    } else {
+        printf("Latency (us)        Count      p50      p95      p99      max\n");
+        for (int i = 0; i < UART_BRIDGE_LATENCY_MAX; i++) {
+            const uart_bridge_latency_t *lat = &perf.latency[i];
+            printf(" %-17s %7" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 "\n", latency_names[i],
+                   lat->count, lat->p50_us, lat->p95_us, lat->p99_us, lat->max_us);
+        }
+        printf("Throughput (B/s)       1s      10s      60s     peak\n");
+        printf(" %-17s %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 "\n", "UART -> TCP",
+               perf.uart_to_tcp.rate_1s, perf.uart_to_tcp.rate_10s, perf.uart_to_tcp.rate_60s, perf.uart_to_tcp.peak_1s);
+        printf(" %-17s %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 "\n", "TCP -> UART",
+               perf.tcp_to_uart.rate_1s, perf.tcp_to_uart.rate_10s, perf.tcp_to_uart.rate_60s, perf.tcp_to_uart.peak_1s);
+    }
+    printf("--------\n");
+    printf("Input [Enter] to return\n");
+}
+
+static void show_task_layout(void)
+{
+    printf("\n=== Task Layout (%s) ===\n", task_profile_name(task_profile_get_active()));
+    printf("Role              Prio  Core\n");
+    for (int i = 0; i < TASK_ROLE_MAX; i++) {
+        const task_placement_t *placement = task_profile_placement((task_role_t)i);
+        if (placement->core == tskNO_AFFINITY) {
+            printf(" %-16s %4u   any\n", task_role_name((task_role_t)i), (unsigned)placement->priority);
+        } else {
+            printf(" %-16s %4u %5d\n", task_role_name((task_role_t)i), (unsigned)placement->priority, (int)placement->core);
+        }
+    }
+    // 以下由sdkconfig决定
+#if CONFIG_LWIP_TCPIP_TASK_AFFINITY == 0x7FFFFFFF
+    printf(" %-16s %4d   any\n", "lwIP", CONFIG_LWIP_TCPIP_TASK_PRIO);
+#else
+    printf(" %-16s %4d %5d\n", "lwIP", CONFIG_LWIP_TCPIP_TASK_PRIO, CONFIG_LWIP_TCPIP_TASK_AFFINITY);
+#endif
+#if defined(CONFIG_ESP_WIFI_TASK_PINNED_TO_CORE_1)
+    printf(" %-16s %4s %5d\n", "WiFi", "-", 1);
+#elif defined(CONFIG_ESP_WIFI_TASK_PINNED_TO_CORE_0)
+    printf(" %-16s %4s %5d\n", "WiFi", "-", 0);
+#endif
+    printf("--------\n");
+    printf("Input [Enter] to return\n");
+}
+
+static void show_capture_stats(void)
+{
+    traffic_capture_stats_t stats;
+    if (traffic_capture_get_stats(&stats) != ESP_OK || !stats.running) {
+        return;
+    }
+
+    printf("Capture (UART%d, %s)\n", stats.config.source + 1,
+           stats.config.sink == TRAFFIC_SINK_TCP ? "tcp" : "console");
+    if (stats.config.sink == TRAFFIC_SINK_TCP) {
+        printf(" Port            : %" PRIu16 " (%s)\n", stats.config.tcp_port,
+               stats.client_connected ? "connected" : "waiting");
+    }
+    printf(" Records         : %" PRIu32 " (%" PRIu32 " bytes)\n", stats.records, stats.bytes);
+    printf(" Truncated       : %" PRIu32 "\n", stats.truncated);
+    printf(" Overflow        : %" PRIu32 " (%" PRIu32 " bytes)\n", stats.dropped_records, stats.dropped_bytes);
+}
+
+static void show_bench_results(void)
+{
+    uart_bench_status_t status;
+    uart_bench_get_status(&status);
+
+    printf("\n=== Benchmark Results (UART%d) ===\n", status.bridge_index + 1);
+    if (status.step_count == 0) {
+        printf("No benchmark has been run\n");
+    } else {
+        printf("Client: %s, %d s per baudrate, tcp engine %s",
+               status.config.client == UART_BENCH_CLIENT_LOCAL ? "local" : "external", status.config.duration_sec,
+               status.tcp_engine < UART_BRIDGE_TCP_ENGINE_MAX ? s_tcp_engine_names[status.tcp_engine] : "?");
+        if (status.config.client == UART_BENCH_CLIENT_LOCAL) {
+            printf(", chunk %d bytes", status.config.chunk_size);
+        }
+        printf("\n%-8s %8s %8s %6s %8s %8s %8s %8s %8s\n",
+               "Baudrate", "Rate", "RX B/s", "Lost", "Drop", "p50(us)", "p99(us)", "max(us)", "CPU ms/MB");
+        for (uint8_t i = 0; i < status.step; i++) {
+            const uart_bench_result_t *r = &status.results[i];
+            const uint32_t drops = r->uart_tx_drop_bytes + r->ring_overrun_bytes + r->tcp_drop_bytes + r->corrupt_bytes;
+            printf("%-8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %6" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 "\n",
+                   r->baudrate, r->rate, r->throughput, r->lost_chunks, drops,
+                   r->latency.p50_us, r->latency.p99_us, r->latency.max_us, r->cpu_ms_per_mb);
+            if (r->fifo_overflows > 0) {
+                printf("         FIFO overflows: %" PRIu32 "\n", r->fifo_overflows);
+            }
+        }
+        if (status.running) {
+            printf("Running %d/%d ...\n", status.step + 1, status.step_count);
+        }
+    }
+    printf("--------\n");
+    printf("Input [Enter] to return\n");
+    fflush(stdout);
+}
+
+static void start_bench(const char *input)
+{
+    unsigned int chunk = UART_BENCH_DEFAULT_CHUNK;
+    unsigned int rate = 0;
+    unsigned int seconds = UART_BENCH_DEFAULT_SEC;
+    unsigned int client = UART_BENCH_CLIENT_LOCAL;
+
+    if (input && sscanf(input, "%u %u %u %u", &chunk, &rate, &seconds, &client) < 1) {
+        printf("***Invalid input: %s\n", input);
+        return;
+    }
+
+    const uart_bench_config_t config = {
+        .baudrates = g_supported_baudrates,
+        .baudrate_count = (uint8_t)g_supported_baudrates_count,
+        .chunk_size = (uint16_t)chunk,
+        .rate = rate,
+        .duration_sec = (uint16_t)seconds,
+        .client = (uart_bench_client_t)client,
+    };
+    esp_err_t ret = uart_bench_start(cli_bridge(), &config);
+    if (ret == ESP_OK) {
+        printf("Benchmark started, input 16 to see results, 15 to stop\n");
+    } else if (ret == ESP_ERR_INVALID_STATE) {
+        printf("***Benchmark needs TCP transport with network ready\n");
+    } else {
+        printf("***Failed to start benchmark: %s\n", esp_err_to_name(ret));
+    }
 }
 
+static void show_task_monitor(void)
+{
+    static task_monitor_snapshot_t snapshot;    // 较大, 不放在命令行任务栈上
+    esp_err_t ret = task_monitor_get_snapshot(&snapshot);
+
+    printf("\n=== Task CPU & Stack ===\n");
+    if (ret != ESP_OK) {
+        printf("***Failed to get task statistics: %s\n", esp_err_to_name(ret));
+    } else {
+        printf("Window   : %" PRIu32 " ms\n", snapshot.window_ms);
+        printf("CPU      : %d%%", snapshot.cpu_usage);
+        for (int i = 0; i < portNUM_PROCESSORS; i++) {
+            printf("  core%d %d%%", i, snapshot.core_usage[i]);
+        }
+        printf("\n");
+        printf("Task              Prio  Core   CPU%%  Stack Free\n");
+        for (uint8_t i = 0; i < snapshot.task_count; i++) {
+            const task_monitor_task_t *task = &snapshot.tasks[i];
+            char core[8] = "any";
+            if (task->core >= 0) {
+                snprintf(core, sizeof(core), "%d", task->core);
+            }
+            printf(" %-16s %4u %5s %3u.%u %11" PRIu32 "\n", task->name, (unsigned)task->priority, core,
+                   task->cpu_permille / 10, task->cpu_permille % 10, task->stack_free);
+        }
+    }
+    printf("--------\n");
+    printf("Input [Enter] to return\n");
+}
 
 static void show_about_menu(void)
 {
@@ -382,6 +1542,35 @@ static void show_about_menu(void)
     printf("Version  : %s\n", APP_VERSION);
     printf("Released : %s %s\n", __DATE__, __TIME__);
     printf("IDF      : %s\n", esp_get_idf_version());
+    printf("Boot Timeline (ms since power on)\n");
+    for (int i = 0; i < BOOT_PHASE_MAX; i++) {
+        const int64_t us = boot_timeline_get((boot_phase_t)i);
+        if (us < 0) {
+            printf(" %-15s: -\n", boot_phase_name((boot_phase_t)i));
+        } else {
+            printf(" %-15s: %" PRId64 "\n", boot_phase_name((boot_phase_t)i), us / 1000);
+        }
+    }
+
+    mem_arena_info_t mem;
+    mem_arena_get_info(&mem);
+    printf("Memory\n");
+    if (mem.enabled) {
+        printf(" Arena          : %" PRIu32 " / %" PRIu32 " bytes\n", mem.used, mem.size);
+        for (uint8_t i = 0; i < mem.owner_count; i++) {
+            printf("  %-14s: %" PRIu32 "\n", mem.owners[i].name, mem.owners[i].bytes);
+        }
+        for (uint8_t i = 0; i < mem.pool_count; i++) {
+            printf("  %-14s: %u / %u blocks, peak %u, exhausted %" PRIu32 "\n", mem.pools[i].name,
+                   mem.pools[i].used, mem.pools[i].count, mem.pools[i].peak, mem.pools[i].exhausted);
+        }
+        printf(" Heap Fallbacks : %" PRIu32 " (%" PRIu32 " bytes)\n", mem.fallbacks, mem.fallback_bytes);
+    } else {
+        printf(" Arena          : Disabled\n");
+    }
+    printf(" Heap Free      : %" PRIu32 "\n", mem.heap_free);
+    printf(" Heap Min Free  : %" PRIu32 "\n", mem.heap_min_free);
+    printf(" Largest Block  : %" PRIu32 "\n", mem.heap_largest_block);
     printf("--------\n");
     printf("Copyright (c) 2025 LiuChuansen\n");
     printf("All rights reserved.\n");
@@ -582,6 +1771,10 @@ static void handle_main_menu(const char *input)
             sm->state = CLI_STATE_ABOUT;
             show_about_menu();
             break;
+        case 6:
+            sm->state = CLI_STATE_SETTINGS;
+            show_settings_menu();
+            break;
         default:
             printf("***Invalid input: %s\n", input);
             show_main_menu();
@@ -909,7 +2102,7 @@ static void handle_set_uart_baudrate(const char *input)
     }
 
     if (menu_id > 0 && menu_id <= g_supported_baudrates_count) {
-        uart_bridge_set_baudrate(g_supported_baudrates[menu_id - 1]);
+        uart_bridge_set_baudrate(cli_bridge(), g_supported_baudrates[menu_id - 1]);
         printf("Set baudrate to %" PRIu32 " success\n", g_supported_baudrates[menu_id - 1]);
         sm->state = CLI_STATE_MAIN;
         show_main_menu();
@@ -924,6 +2117,13 @@ static void handle_statistics_debug_menu(const char *input)
 {
     cli_state_machine_t *sm = &s_cli_sm;
 
+    if (sm->sub_step == _SUB_STEP_INPUT_BENCH) {
+        // 直接回车使用默认参数
+        start_bench(input);
+        show_statistics_debug_menu();
+        return;
+    }
+
     if (!input) {
         show_statistics_debug_menu();
         return;
@@ -940,25 +2140,69 @@ static void handle_statistics_debug_menu(const char *input)
             // 显示统计信息
             {
                 uart_bridge_stats_t stats;
-                esp_err_t ret = uart_bridge_get_stats(&stats);
+                esp_err_t ret = uart_bridge_get_stats(cli_bridge(), &stats);
                 
                 printf("\n=== UART Bridge Statistics ===\n");
                 if (ret == ESP_OK) {
                     printf("UART Communication:\n");
-                    printf(" TX Bytes        : %" PRIu32 "\n", stats.uart_tx_bytes);
-                    printf(" RX Bytes        : %" PRIu32 "\n", stats.uart_rx_bytes);
-                    printf(" TX Drop Bytes   : %" PRIu32 "\n", stats.uart_tx_drop_bytes);
-                    printf(" TX Error Bytes  : %" PRIu32 "\n", stats.uart_tx_error_bytes);
+                    printf(" TX Bytes        : %" PRIu64 "\n", stats.uart_tx_bytes);
+                    printf(" RX Bytes        : %" PRIu64 "\n", stats.uart_rx_bytes);
+                    printf(" TX Drop Bytes   : %" PRIu64 "\n", stats.uart_tx_drop_bytes);
+                    printf(" TX Error Bytes  : %" PRIu64 "\n", stats.uart_tx_error_bytes);
+                    printf(" TX Waits        : %" PRIu64 " (%" PRIu64 " ms)\n", stats.uart_tx_wait_count, stats.uart_tx_wait_ms);
+                    printf(" FIFO Overflows  : %" PRIu64 "\n", stats.uart_fifo_ovf_count);
+                    printf(" RX Buffer Full  : %" PRIu64 "\n", stats.uart_buffer_full_count);
+                    printf(" RX DMA Transfers: %" PRIu64 "\n", stats.uart_rx_dma_count);
+                    printf(" RTS Asserted    : %" PRIu64 " (%" PRIu64 " ms)\n", stats.uart_rts_assert_count, stats.uart_rts_assert_ms);
+                    printf(" RX Flush I/S/H  : %" PRIu64 " / %" PRIu64 " / %" PRIu64 "\n",
+                           stats.rx_flush_idle_count, stats.rx_flush_size_count, stats.rx_flush_hold_count);
+                    printf(" RX Mark Overflow: %" PRIu64 "\n", stats.rx_mark_overflow_count);
+                    printf("RX Ring Buffer:\n");
+                    uart_bridge_buffer_info_t buffer_info;
+                    uart_bridge_get_buffer_info(cli_bridge(), &buffer_info);
+                    printf(" High Water      : %" PRIu64 " / %" PRIu32 "\n", stats.ring_high_water, buffer_info.active.ring_size);
+                    printf(" Overruns        : %" PRIu64 "\n", stats.ring_overrun_count);
+                    printf(" Overrun Bytes   : %" PRIu64 "\n", stats.ring_overrun_bytes);
+                    if (buffer_info.outage_size > 0) {
+                        printf("Outage Buffer:\n");
+                        printf(" Pending         : %" PRIu32 " / %" PRIu32 "\n", buffer_info.outage_used, buffer_info.outage_size);
+                        printf(" Buffered Bytes  : %" PRIu64 "\n", stats.outage_buffered_bytes);
+                        printf(" Replayed Bytes  : %" PRIu64 "\n", stats.outage_replayed_bytes);
+                        printf(" Lost Bytes      : %" PRIu64 "\n", stats.outage_lost_bytes);
+                    }
                     printf("TCP Communication:\n");
-                    printf(" TX Bytes        : %" PRIu32 "\n", stats.tcp_tx_bytes);
-                    printf(" RX Bytes        : %" PRIu32 "\n", stats.tcp_rx_bytes);
-                    printf(" TX Error Bytes  : %" PRIu32 "\n", stats.tcp_tx_error_bytes);
+                    printf(" TX Bytes        : %" PRIu64 "\n", stats.tcp_tx_bytes);
+                    printf(" RX Bytes        : %" PRIu64 "\n", stats.tcp_rx_bytes);
+                    printf(" TX Error Bytes  : %" PRIu64 "\n", stats.tcp_tx_error_bytes);
                     printf("Connection Statistics:\n");
-                    printf(" Connects        : %" PRIu32 "\n", stats.tcp_connect_count);
-                    printf(" Disconnects     : %" PRIu32 "\n", stats.tcp_disconnect_count);
+                    printf(" Connects        : %" PRIu64 "\n", stats.tcp_connect_count);
+                    printf(" Disconnects     : %" PRIu64 "\n", stats.tcp_disconnect_count);
+                    printf(" Evicted         : %" PRIu64 "\n", stats.tcp_evict_count);
+                    printf(" Rejected        : %" PRIu64 "\n", stats.tcp_reject_count);
+                    printf("UDP Communication:\n");
+                    printf(" TX Datagrams    : %" PRIu64 " (%" PRIu64 " bytes)\n", stats.udp_tx_datagrams, stats.udp_tx_bytes);
+                    printf(" TX Dropped      : %" PRIu64 "\n", stats.udp_tx_drop_count);
+                    printf(" RX Datagrams    : %" PRIu64 " (%" PRIu64 " bytes)\n", stats.udp_rx_datagrams, stats.udp_rx_bytes);
+                    printf(" RX Lost         : %" PRIu64 "\n", stats.udp_rx_lost);
+                    printf(" RX Reordered    : %" PRIu64 "\n", stats.udp_rx_reordered);
+                    printf(" RX Malformed    : %" PRIu64 "\n", stats.udp_rx_malformed);
+                    uart_bridge_modbus_stats_t modbus;
+                    if (uart_bridge_get_transport(cli_bridge()) == UART_BRIDGE_TRANSPORT_MODBUS &&
+                        uart_bridge_get_modbus_stats(cli_bridge(), &modbus) == ESP_OK) {
+                        printf("Modbus Gateway:\n");
+                        printf(" Requests        : %" PRIu32 " (%" PRIu32 " broadcast)\n", modbus.requests, modbus.broadcasts);
+                        printf(" Responses       : %" PRIu32 "\n", modbus.responses);
+                        printf(" Timeouts        : %" PRIu32 "\n", modbus.timeouts);
+                        printf(" CRC Errors      : %" PRIu32 "\n", modbus.crc_errors);
+                        printf(" Unexpected      : %" PRIu32 "\n", modbus.unexpected);
+                        printf(" Busy Rejects    : %" PRIu32 "\n", modbus.busy_rejects);
+                        printf(" Malformed       : %" PRIu32 "\n", modbus.malformed);
+                        printf(" Queue Peak      : %" PRIu32 "\n", modbus.queue_peak);
+                    }
                 } else {
                     printf("***Failed to get statistics: %s\n", esp_err_to_name(ret));
                 }
+                show_capture_stats();
                 printf("--------\n");
                 printf("Input [Enter] to return\n");
             }
@@ -966,7 +2210,7 @@ static void handle_statistics_debug_menu(const char *input)
         case 2:
             // 重置统计信息
             {
-                esp_err_t ret = uart_bridge_reset_stats();
+                esp_err_t ret = uart_bridge_reset_stats(cli_bridge());
                 if (ret == ESP_OK) {
                     printf("Statistics reset successfully\n");
                 } else {
@@ -978,7 +2222,7 @@ static void handle_statistics_debug_menu(const char *input)
         case 3:
             // Uart TX Verbose
             {
-                if (uart_bridge_set_uart_verbose(true, false)) {
+                if (uart_bridge_set_uart_verbose(cli_bridge(), true, false)) {
                     printf("UART TX verbose enabled\n");
                 } else {
                     printf("***Failed to set UART TX verbose\n");
@@ -989,7 +2233,7 @@ static void handle_statistics_debug_menu(const char *input)
         case 4:
             // Uart RX Verbose
             {
-                if (uart_bridge_set_uart_verbose(false, true)) {
+                if (uart_bridge_set_uart_verbose(cli_bridge(), false, true)) {
                     printf("UART RX verbose enabled\n");
                 } else {
                     printf("***Failed to set UART RX verbose\n");
@@ -1000,7 +2244,7 @@ static void handle_statistics_debug_menu(const char *input)
         case 5:
             // Uart TX & RX Verbose
             {
-                if (uart_bridge_set_uart_verbose(true, true)) {
+                if (uart_bridge_set_uart_verbose(cli_bridge(), true, true)) {
                     printf("UART TX & RX verbose enabled\n");
                 } else {
                     printf("***Failed to set UART TX & RX verbose\n");
@@ -1011,7 +2255,7 @@ static void handle_statistics_debug_menu(const char *input)
         case 6:
             // TCP TX Verbose
             {
-                if (uart_bridge_set_tcp_verbose(true, false)) {
+                if (uart_bridge_set_tcp_verbose(cli_bridge(), true, false)) {
                     printf("TCP TX verbose enabled\n");
                 } else {
                     printf("***Failed to set TCP TX verbose (TCP server may not be running)\n");
@@ -1022,7 +2266,7 @@ static void handle_statistics_debug_menu(const char *input)
         case 7:
             // TCP RX Verbose
             {
-                if (uart_bridge_set_tcp_verbose(false, true)) {
+                if (uart_bridge_set_tcp_verbose(cli_bridge(), false, true)) {
                     printf("TCP RX verbose enabled\n");
                 } else {
                     printf("***Failed to set TCP RX verbose (TCP server may not be running)\n");
@@ -1033,7 +2277,7 @@ static void handle_statistics_debug_menu(const char *input)
         case 8:
             // TCP TX & RX Verbose
             {
-                if (uart_bridge_set_tcp_verbose(true, true)) {
+                if (uart_bridge_set_tcp_verbose(cli_bridge(), true, true)) {
                     printf("TCP TX & RX verbose enabled\n");
                 } else {
                     printf("***Failed to set TCP TX & RX verbose (TCP server may not be running)\n");
@@ -1041,6 +2285,88 @@ static void handle_statistics_debug_menu(const char *input)
                 show_statistics_debug_menu();
             }
             break;
+        case 9:
+            // 显示客户端统计信息
+            show_client_statistics();
+            break;
+        case 10:
+            // 显示延迟和吞吐量统计
+            show_perf_statistics();
+            break;
+        case 11:
+            // 显示任务的优先级和核心分配
+            show_task_layout();
+            break;
+        case 12:
+            // 显示每个任务的CPU占用和栈剩余
+            show_task_monitor();
+            break;
+        case 13:
+            // 以pcap格式捕获收发数据, 输出到捕获端口
+            {
+                uart_bridge_status_t status;
+                esp_err_t ret = uart_bridge_get_status(cli_bridge(), &status);
+                if (ret == ESP_OK) {
+                    const traffic_capture_config_t config = {
+                        .source = s_cli_sm.bridge_index,
+                        .dir_mask = TRAFFIC_DIR_ALL,
+                        .sink = TRAFFIC_SINK_TCP,
+                        .tcp_port = status.tcp_port + TRAFFIC_CAPTURE_PORT_OFFSET,
+                        .snaplen = 0,
+                    };
+                    ret = traffic_capture_start(&config);
+                }
+                if (ret == ESP_OK) {
+                    printf("Capture started, connect to port %" PRIu16 " to receive pcap stream\n",
+                           (uint16_t)(status.tcp_port + TRAFFIC_CAPTURE_PORT_OFFSET));
+                } else {
+                    printf("***Failed to start capture: %s\n", esp_err_to_name(ret));
+                }
+                show_statistics_debug_menu();
+            }
+            break;
+        case 14:
+            // 停止捕获(包括串口数据显示)
+            {
+                traffic_capture_stats_t stats;
+                traffic_capture_get_stats(&stats);
+                esp_err_t ret = traffic_capture_stop();
+                if (ret == ESP_OK) {
+                    printf("Capture stopped, %" PRIu32 " records, %" PRIu32 " dropped\n",
+                           stats.records, stats.dropped_records);
+                } else {
+                    printf("***Failed to stop capture: %s\n", esp_err_to_name(ret));
+                }
+                show_statistics_debug_menu();
+            }
+            break;
+        case 15:
+            // 串口内部回环测试, 正在测试时停止
+            {
+                uart_bench_status_t status;
+                uart_bench_get_status(&status);
+                if (status.running) {
+                    esp_err_t ret = uart_bench_stop();
+                    if (ret == ESP_OK) {
+                        printf("Benchmark stopped\n");
+                    } else {
+                        printf("***Failed to stop benchmark: %s\n", esp_err_to_name(ret));
+                    }
+                    show_statistics_debug_menu();
+                } else {
+                    sm->sub_step = _SUB_STEP_INPUT_BENCH;
+                    printf("\nAll %d baudrates will be tested with UART internal loopback\n", g_supported_baudrates_count);
+                    printf("Input: chunk(%d-%d) rate(B/s, 0=auto) seconds(1-%d) client(0=local, 1=external)\n",
+                           UART_BENCH_MIN_CHUNK, UART_BENCH_MAX_CHUNK, UART_BENCH_MAX_SEC);
+                    printf("Please input (Enter for %d 0 %d 0): ", UART_BENCH_DEFAULT_CHUNK, UART_BENCH_DEFAULT_SEC);
+                    fflush(stdout);
+                }
+            }
+            break;
+        case 16:
+            // 显示回环测试结果
+            show_bench_results();
+            break;
         default:
             printf("***Invalid input: %s\n", input);
             show_statistics_debug_menu();
@@ -1049,6 +2375,51 @@ static void handle_statistics_debug_menu(const char *input)
 }
 
 
+static void handle_settings_menu(const char *input)
+{
+    cli_state_machine_t *sm = &s_cli_sm;
+
+    if (!input) {
+        if (sm->sub_step == _SUB_STEP_INPUT_SETTING) {
+            printf("Please input value (%s): ", s_setting_items[sm->input_index].hint);
+            fflush(stdout);
+        } else {
+            show_settings_menu();
+        }
+        return;
+    }
+
+    if (sm->sub_step == _SUB_STEP_INPUT_SETTING) {
+        const cli_setting_item_t *item = &s_setting_items[sm->input_index];
+        esp_err_t ret = item->apply(input);
+        if (ret == ESP_OK) {
+            printf("Set %s to %s success\n", item->name, input);
+        } else {
+            printf("***Failed to set %s: %s\n", item->name, esp_err_to_name(ret));
+        }
+        show_settings_menu();
+        return;
+    }
+
+    int menu_id = atoi(input);
+    if (menu_id == 0) {
+        return_to_main_menu(input);
+        return;
+    }
+
+    if (menu_id > 0 && menu_id <= s_setting_items_count) {
+        sm->input_index = menu_id - 1;
+        sm->sub_step = _SUB_STEP_INPUT_SETTING;
+        printf("\nSelected: %s\n", s_setting_items[sm->input_index].name);
+        printf("Please input value (%s): ", s_setting_items[sm->input_index].hint);
+        fflush(stdout);
+        return;
+    }
+
+    printf("***Invalid input: %s\n", input);
+    show_settings_menu();
+}
+
 static void return_to_main_menu(const char *input)
 {
     cli_state_machine_t *sm = &s_cli_sm;
@@ -12,6 +12,7 @@
 
 #include "cli_menu.h"
 #include "cli_impl.h"
+#include "task_profile.h"
 #include "wifi_station.h"
 #include <stdbool.h>
 #include <stdio.h>
@@ -92,7 +93,7 @@ esp_err_t cli_menu_start(void)
     s_cli_ctx.running = true;
 
     // 创建菜单任务
-    BaseType_t ret = xTaskCreate(command_line_task, "command_menu", 4096, NULL, 5, &s_cli_ctx.task_handle);
+    BaseType_t ret = task_profile_create_static(command_line_task, "command_menu", 4096, NULL, TASK_ROLE_CLI, &s_cli_ctx.task_handle);
     if (ret != pdPASS) {
         ESP_LOGE(TAG, "Failed to create command line menu task");
         return ESP_ERR_NO_MEM;
@@ -11,6 +11,9 @@
 #include "lcd_driver_i2c.h"
 #include "lcd_display.h"
 #include "uart_bridge.h"
+#include "task_profile.h"
+#include "link_profile.h"
+#include "task_monitor.h"
 #include "lcd_models.h"
 #include "lcd_fonts.h"
 #include "img_icons.h"
@@ -20,6 +23,7 @@
 #include "time.h"
 #include "uptime.h"
 #include "wifi_station.h"
+#include "nvs.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <stdint.h>
@@ -29,13 +33,51 @@
 
 static const char *TAG = "display";
 
+#define NVS_NAMESPACE              "display"
+#define NVS_KEY_OFF_TIMEOUT        "off_timeout"
+
 // 定义显示任务参数
 #define DISPLAY_TASK_STACK_SIZE    4096
-#define DISPLAY_TASK_PRIORITY      3
-#define DISPLAY_REFRESH_RATE_HZ    20  // 10Hz刷新率
 
-// 定义动画参数
-#define ANIMATION_UPDATE_MS        50 // 动画更新周期(ms)
+// 显示任务只在有事件或到期时运行, 没有变化时每秒检查一次信号, CPU使用率和收发字节数
+#define DISPLAY_IDLE_POLL_MS       1000
+// 有流量时收发字节数的刷新间隔, 多次变化合并为一次重画
+#define DISPLAY_TRAFFIC_REFRESH_MS 250
+// 收发字节数停止变化后继续按流量刷新的时间
+#define DISPLAY_TRAFFIC_HOLD_MS    2000
+// 网络页面检查扫描结果的间隔
+#define DISPLAY_SCAN_POLL_MS       250
+// 熄屏后按键唤醒, 这段时间内的按键事件只用于唤醒
+#define DISPLAY_WAKE_GUARD_MS      1500
+
+// 显示任务的通知位
+#define DISPLAY_NOTIFY_BUTTON      0x01
+#define DISPLAY_NOTIFY_BRIDGE      0x02
+#define DISPLAY_NOTIFY_WIFI        0x04
+#define DISPLAY_NOTIFY_CONFIG      0x08
+
+// 定义动画参数, 动画只在有流量时运行, 最高10Hz
+#define ANIMATION_UPDATE_MS        100 // 动画更新周期(ms)
+#define ANIMATION_STEP             2   // 每次移动的像素
+
+// 有多个桥接实例时, 主页轮流显示每个实例的时间(ms)
+#define BRIDGE_ROTATE_MS           3000
+
+// 主页控件, 只有数据变化的控件重画, 不需要清屏和重画整页
+#define HOME_WIDGET_SIGNAL         0x01    // 信号图标
+#define HOME_WIDGET_INFO           0x02    // 客户端数/端口/波特率
+#define HOME_WIDGET_STATS          0x04    // 收发字节数和动画线
+#define HOME_WIDGET_TITLE          0x08    // SSID, 重画时连同CPU使用率
+#define HOME_WIDGET_ADDRESS        0x10    // IP地址或连接状态
+#define HOME_WIDGET_CPU            0x20    // 右上角CPU使用率, 叠加在SSID上
+#define HOME_WIDGET_STATUS         (HOME_WIDGET_SIGNAL | HOME_WIDGET_TITLE | HOME_WIDGET_ADDRESS | HOME_WIDGET_CPU)
+// 各控件占用的区域, 与绘制坐标对应
+#define HOME_STATUS_TOP            0
+#define HOME_TITLE_X               16
+#define HOME_ADDRESS_TOP           18
+#define HOME_INFO_TOP              28
+#define HOME_STATS_TOP             54
+#define LCD_HEIGHT                 64
 
 // 定义内部按键事件队列
 #define DISPLAY_BUTTON_QUEUE_SIZE  8
@@ -89,13 +131,18 @@ typedef struct
     char ssid[32];
     char ip_address[16];
     uint32_t baudrate;
-    uint32_t rx_bytes;
-    uint32_t tx_bytes;
+    uint64_t rx_bytes;
+    uint64_t tx_bytes;
     uint8_t client_num;
     uint16_t ip_port;
     uint8_t cpu_usaged;
+    uint8_t bridge_index;   // 当前显示的桥接实例, 串口页面和清除统计也作用于该实例
+    uint8_t bridge_count;
+    uint8_t dirty_widgets;  // HOME_WIDGET_xxx, 需要重画的控件
 
     sys_tick_t cpu_usage_update_time;
+    sys_tick_t bridge_rotate_time;
+    sys_tick_t traffic_active_until;    // 收发字节数最近变化后的保持时间, 之前按流量刷新
 
     struct {
         uint8_t eraser_position;
@@ -181,7 +228,14 @@ typedef struct {
     } popup;
 
 
-    sys_tick_t data_update_time;
+    sys_tick_t status_update_time;      // 下一次轮询WiFi和桥接状态
+    sys_tick_t traffic_update_time;     // 下一次读取收发字节数
+
+    // 空闲熄屏
+    uint16_t off_timeout_s;             // 0表示不熄屏
+    bool screen_off;
+    sys_tick_t last_input_time;         // 最近一次按键的时间
+    sys_tick_t wake_guard_time;         // 唤醒后到这个时间之前的按键事件忽略
 }display_context_t;
 
 // 支持的波特率列表, 已在cli_impl.c中定义
@@ -191,12 +245,18 @@ extern const int g_supported_baudrates_count;
 // 显示上下文全局变量
 static display_context_t s_display_context = { 0 };
 
-// 更新显示数据
-static void display_update_data(display_context_t* ctx);
+// 更新WiFi和桥接状态
+static void display_update_status(display_context_t* ctx);
+
+// 更新收发字节数
+static void display_update_traffic(display_context_t* ctx);
 
 // 绘制主页
 static void draw_home_page(display_context_t* ctx);
 
+// 只重画主页上数据有变化的控件
+static void draw_home_widgets(display_context_t* ctx, uint8_t widgets);
+
 // 绘制串口页面
 static void draw_uart_page(display_context_t* ctx);
 
@@ -215,6 +275,13 @@ static void active_popup_msg(display_context_t* ctx, popup_msg_id_t msg_id);
 // 更新主页动画
 static bool update_home_animation(display_context_t* ctx);
 
+// 熄屏和唤醒
+static void display_screen_off(display_context_t* ctx);
+static void display_screen_wake(display_context_t* ctx, sys_tick_t now);
+
+// 计算下一次运行的等待时间
+static TickType_t display_next_wait(display_context_t* ctx, sys_tick_t now);
+
 // 处理按键事件（在显示任务中执行）
 static void handle_button_event(display_context_t* ctx, const display_button_event_t* button_event);
 
@@ -231,6 +298,28 @@ static inline display_context_t* get_context(void)
     return &s_display_context;
 }
 
+/**
+ * @brief 通知显示任务, 可以在任何任务中调用
+ * 
+ * @param ctx 
+ * @param bits DISPLAY_NOTIFY_xxx
+ */
+static void display_notify(display_context_t* ctx, uint32_t bits)
+{
+    TaskHandle_t task = ctx->task_handle;
+    if (task != NULL) {
+        xTaskNotify(task, bits, eSetBits);
+    }
+}
+
+/**
+ * @brief 桥接实例状态变化回调
+ */
+static void bridge_change_handler(uint8_t index, void *user_ctx)
+{
+    display_notify(get_context(), DISPLAY_NOTIFY_BRIDGE);
+}
+
 // 切换页面
 static void switch_page(display_context_t* ctx, display_page_t target)
 {
@@ -276,7 +365,28 @@ static void button_event_handler(void* handler_args, esp_event_base_t base, int3
         if (result != pdTRUE) {
             ESP_LOGW(TAG, "Button event queue full, dropping event");
         }
+        display_notify(ctx, DISPLAY_NOTIFY_BUTTON);
+    }
+}
+
+/**
+ * @brief 从NVS加载熄屏时间
+ * 
+ * @return uint16_t 
+ */
+static uint16_t display_load_off_timeout(void)
+{
+    uint16_t seconds = 0;
+    nvs_handle_t nvs_handle;
+
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) == ESP_OK) {
+        size_t required_size = sizeof(seconds);
+        if (nvs_get_blob(nvs_handle, NVS_KEY_OFF_TIMEOUT, &seconds, &required_size) != ESP_OK) {
+            seconds = 0;
+        }
+        nvs_close(nvs_handle);
     }
+    return seconds;
 }
 
 /**
@@ -293,6 +403,7 @@ esp_err_t display_init(void)
 
     // 清空显示上下文
     memset(&s_display_context, 0, sizeof(s_display_context));
+    s_display_context.off_timeout_s = display_load_off_timeout();
 
     ESP_LOGI(TAG, "Initializing display...");
     
@@ -382,6 +493,9 @@ esp_err_t display_task_start(void)
     ctx->page.home.tx_bytes = 0;
     ctx->page.home.client_num = 0;
     ctx->page.home.ip_port = 0;
+    ctx->page.home.bridge_index = 0;
+    ctx->page.home.bridge_count = 0;
+    ctx->page.home.bridge_rotate_time = uptime() + BRIDGE_ROTATE_MS;
     ctx->cpu_usage_enabled = false;
     ctx->page.home.cpu_usaged = 0;
     ctx->page.home.cpu_usage_update_time = uptime();
@@ -391,12 +505,12 @@ esp_err_t display_task_start(void)
     ctx->page.uart.baudrate_num = g_supported_baudrates_count;
 
     // 创建显示任务
-    BaseType_t task_ret = xTaskCreate(
+    BaseType_t task_ret = task_profile_create_static(
         display_task,
         "display_task",
         DISPLAY_TASK_STACK_SIZE,
         NULL,
-        DISPLAY_TASK_PRIORITY,
+        TASK_ROLE_DISPLAY,
         &ctx->task_handle
     );
     
@@ -404,6 +518,9 @@ esp_err_t display_task_start(void)
         ESP_LOGE(TAG, "Failed to create display task");
         return ESP_FAIL;
     }
+
+    // 客户端数和波特率变化时刷新, 不再定时查询
+    uart_bridge_set_change_callback(bridge_change_handler, NULL);
     
     ESP_LOGI(TAG, "Display task started successfully");
     return ESP_OK;
@@ -424,6 +541,7 @@ esp_err_t display_task_stop(void)
     }
     
     // 删除任务
+    uart_bridge_set_change_callback(NULL, NULL);
     vTaskDelete(ctx->task_handle);
     ctx->task_handle = NULL;
     
@@ -431,6 +549,47 @@ esp_err_t display_task_stop(void)
     return ESP_OK;
 }
 
+void display_notify_wifi(void)
+{
+    display_notify(get_context(), DISPLAY_NOTIFY_WIFI);
+}
+
+esp_err_t display_set_off_timeout(uint16_t seconds)
+{
+    display_context_t* ctx = get_context();
+
+    if (seconds != 0 && (seconds < DISPLAY_OFF_TIMEOUT_MIN || seconds > DISPLAY_OFF_TIMEOUT_MAX)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to open nvs namespace(%s)", esp_err_to_name(err));
+        return err;
+    }
+
+    err = nvs_set_blob(nvs_handle, NVS_KEY_OFF_TIMEOUT, &seconds, sizeof(seconds));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // 重新计时, 已经熄屏时由显示任务决定是否点亮
+    ctx->off_timeout_s = seconds;
+    display_notify(ctx, DISPLAY_NOTIFY_CONFIG);
+    ESP_LOGI(TAG, "set display off timeout(%u)", seconds);
+    return ESP_OK;
+}
+
+uint16_t display_get_off_timeout(void)
+{
+    return get_context()->off_timeout_s;
+}
+
 
 /**
  * @brief 显示任务函数
@@ -439,33 +598,70 @@ esp_err_t display_task_stop(void)
  */
 static void display_task(void *arg)
 {
-    TickType_t last_wake_time = xTaskGetTickCount();
-    const TickType_t refresh_period = pdMS_TO_TICKS(1000 / DISPLAY_REFRESH_RATE_HZ);
+    TickType_t wait_ticks = 0;
     
-    ESP_LOGI(TAG, "Display task started, refresh rate: %dHz", DISPLAY_REFRESH_RATE_HZ);
+    ESP_LOGI(TAG, "Display task started, idle poll: %dms", DISPLAY_IDLE_POLL_MS);
 
     display_context_t* ctx = get_context();
-    ctx->data_update_time = uptime();
+    ctx->status_update_time = uptime();
+    ctx->traffic_update_time = uptime();
+    ctx->last_input_time = uptime();
 
     while (1) {
+        uint32_t events = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &events, wait_ticks);
+
         sys_tick_t now = uptime();
         bool refresh = false;
 
-        // 处理按键事件队列
+        // 处理按键事件队列, 熄屏时按键只用于唤醒
         display_button_event_t button_event;
         while (xQueueReceive(ctx->button_queue, &button_event, 0) == pdTRUE) {
-            handle_button_event(ctx, &button_event);
+            ctx->last_input_time = now;
+            if (ctx->screen_off) {
+                display_screen_wake(ctx, now);
+            } else if (uptime_after(now, ctx->wake_guard_time)) {
+                handle_button_event(ctx, &button_event);
+            }
         }
 
-        // 刷新数据
-        if (uptime_after(now, ctx->data_update_time)) {
-            display_update_data(ctx);
-            ctx->data_update_time = now + 250;
+        // 关闭熄屏后立即点亮
+        if ((events & DISPLAY_NOTIFY_CONFIG) && ctx->screen_off && ctx->off_timeout_s == 0) {
+            display_screen_wake(ctx, now);
         }
 
-        // 更新动画状态
+        // 熄屏时不读取数据也不刷新, 只等待按键
+        if (ctx->screen_off) {
+            wait_ticks = portMAX_DELAY;
+            continue;
+        }
+
+        // WiFi和桥接状态在变化时立即更新, 信号强度等没有事件的数据每秒检查一次
+        page_home_data_t* home = &ctx->page.home;
+        if ((events & (DISPLAY_NOTIFY_BRIDGE | DISPLAY_NOTIFY_WIFI)) ||
+            uptime_after(now, ctx->status_update_time) ||
+            (home->bridge_count > 1 && ctx->page.current_page == PAGE_HOME && uptime_after(now, home->bridge_rotate_time))) {
+            const uint8_t bridge_index = home->bridge_index;
+            display_update_status(ctx);
+            ctx->status_update_time = now + DISPLAY_IDLE_POLL_MS;
+            if (home->bridge_index != bridge_index) {
+                // 切换实例后立即显示它的收发字节数
+                ctx->traffic_update_time = now;
+            }
+        }
+
+        // 收发字节数只在主页上显示, 有流量时按固定间隔合并刷新
+        if (uptime_after(now, ctx->traffic_update_time)) {
+            if (ctx->page.current_page == PAGE_HOME && !ctx->force_help_mode) {
+                display_update_traffic(ctx);
+            }
+            ctx->traffic_update_time = now + (uptime_after(home->traffic_active_until, now) ?
+                                              DISPLAY_TRAFFIC_REFRESH_MS : DISPLAY_IDLE_POLL_MS);
+        }
+
+        // 更新动画状态, 动画只影响最后一行
         if (update_home_animation(ctx)) {
-            ctx->page.dirty = true;
+            ctx->page.home.dirty_widgets |= HOME_WIDGET_STATS;
         }
 
         // 检查弹出框是否超时
@@ -592,6 +788,15 @@ static void display_task(void *arg)
             }
         }
 
+        // 弹出框盖在主页上, 控件变化时需要整页重画
+        if (ctx->page.home.dirty_widgets &&
+            (ctx->page.current_page != PAGE_HOME || ctx->popup.current_popup != POPUP_NONE)) {
+            ctx->page.home.dirty_widgets = 0;
+            if (ctx->page.current_page == PAGE_HOME) {
+                ctx->page.dirty = true;
+            }
+        }
+
         // 刷新显示
         if (ctx->page.dirty || ctx->popup.dirty) 
         {            
@@ -624,6 +829,11 @@ static void display_task(void *arg)
 
             ctx->page.dirty = false;
             ctx->popup.dirty = false;
+            ctx->page.home.dirty_widgets = 0;
+            refresh = true;
+        } else if (ctx->page.home.dirty_widgets) {
+            draw_home_widgets(ctx, ctx->page.home.dirty_widgets);
+            ctx->page.home.dirty_widgets = 0;
             refresh = true;
         }
 
@@ -631,105 +841,109 @@ static void display_task(void *arg)
         if (refresh) {
             lcd_refresh(ctx->lcd_handle);
         }
-        
-        // 每个周期延时，保证固定刷新率
-        vTaskDelayUntil(&last_wake_time, refresh_period);
+
+        // 空闲超时熄屏, 没有配网时一直显示帮助页
+        if (ctx->off_timeout_s != 0 && !ctx->force_help_mode &&
+            uptime_after(now, ctx->last_input_time + (sys_tick_t)ctx->off_timeout_s * 1000)) {
+            display_screen_off(ctx);
+            wait_ticks = portMAX_DELAY;
+            continue;
+        }
+
+        wait_ticks = display_next_wait(ctx, now);
     }
 }
 
-#if !defined(CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS)
-#error "Please enable CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS in sdkconfig"
-#endif
+/**
+ * @brief 熄屏, 清空屏幕后停止刷新
+ * 
+ * lcd_display组件没有提供关闭面板的接口, OLED像素全部熄灭时功耗接近关闭, 之后不再占用I2C总线.
+ * 
+ * @param ctx 
+ */
+static void display_screen_off(display_context_t* ctx)
+{
+    ESP_LOGI(TAG, "display idle for %us, screen off", ctx->off_timeout_s);
+    lcd_fill(ctx->lcd_handle, 0x00);
+    lcd_refresh(ctx->lcd_handle);
+    ctx->screen_off = true;
+}
 
-// CPU使用率统计静态变量
-static struct {
-    configRUN_TIME_COUNTER_TYPE last_run_time;
-    configRUN_TIME_COUNTER_TYPE last_idle_time;
-    bool initialized;
-} cpu_usage_context = {0};
-
-// CPU使用率统计函数
-static uint8_t get_cpu_usage(void) {
-    TaskStatus_t *pxTaskStatusArray = NULL;
-    UBaseType_t uxArraySize;
-    configRUN_TIME_COUNTER_TYPE current_run_time, current_idle_time = 0;
-    uint8_t cpu_usage = 0;
-    
-    // 获取任务数量，添加一些缓冲
-    uxArraySize = uxTaskGetNumberOfTasks() + 4;
-    
-    // 分配内存存储任务状态
-    pxTaskStatusArray = pvPortMalloc(uxArraySize * sizeof(TaskStatus_t));
-    if (pxTaskStatusArray == NULL) {
-        ESP_LOGW(TAG, "Failed to allocate memory for CPU usage calculation");
-        return 0;
-    }
-    
-    // 获取当前系统状态
-    uxArraySize = uxTaskGetSystemState(pxTaskStatusArray, uxArraySize, &current_run_time);
-    if (uxArraySize == 0) {
-        vPortFree(pxTaskStatusArray);
-        return 0;
+/**
+ * @brief 点亮屏幕, 重新读取所有数据并重画整页
+ * 
+ * @param ctx 
+ * @param now 
+ */
+static void display_screen_wake(display_context_t* ctx, sys_tick_t now)
+{
+    ESP_LOGI(TAG, "screen on");
+    ctx->screen_off = false;
+    ctx->wake_guard_time = now + DISPLAY_WAKE_GUARD_MS;
+    ctx->last_input_time = now;
+    ctx->status_update_time = now;
+    ctx->traffic_update_time = now;
+    ctx->page.dirty = true;
+}
+
+/**
+ * @brief 取较早的到期时间
+ */
+static inline void deadline_min(sys_tick_t* next, sys_tick_t deadline)
+{
+    if (uptime_after(*next, deadline)) {
+        *next = deadline;
     }
-    
-    // 计算IDLE任务的运行时间（通常IDLE任务名为"IDLE"或"IDLE0"、"IDLE1"等）
-    ESP_LOGD(TAG, "Task list (%d tasks):", uxArraySize);
-    for (UBaseType_t i = 0; i < uxArraySize; i++) {
-        ESP_LOGD(TAG, "  %s: runtime=%"PRIu32, pxTaskStatusArray[i].pcTaskName, pxTaskStatusArray[i].ulRunTimeCounter);
-        if (strncmp(pxTaskStatusArray[i].pcTaskName, "IDLE", 4) == 0) {
-            current_idle_time += pxTaskStatusArray[i].ulRunTimeCounter;
+}
+
+/**
+ * @brief 计算显示任务下一次需要运行的时间
+ * 
+ * @param ctx 
+ * @param now 
+ * @return TickType_t 等待的时间, 期间有事件时提前运行
+ */
+static TickType_t display_next_wait(display_context_t* ctx, sys_tick_t now)
+{
+    page_home_data_t* home = &ctx->page.home;
+    sys_tick_t next = ctx->status_update_time;
+
+    deadline_min(&next, ctx->traffic_update_time);
+    if (ctx->page.current_page == PAGE_HOME) {
+        if (uptime_after(home->traffic_active_until, now)) {
+            deadline_min(&next, home->animation_line.last_update_time);
+        } else if (home->animation_line.eraser_position != 0) {
+            // 流量停止后收起动画
+            deadline_min(&next, now);
         }
-    }
-    ESP_LOGD(TAG, "Current total runtime: %"PRIu32", idle time: %"PRIu32, current_run_time, current_idle_time);
-    
-    // 如果是第一次调用，只保存当前值，不计算CPU使用率
-    if (!cpu_usage_context.initialized) {
-        cpu_usage_context.last_run_time = current_run_time;
-        cpu_usage_context.last_idle_time = current_idle_time;
-        cpu_usage_context.initialized = true;
-        cpu_usage = 0;
-        ESP_LOGD(TAG, "First call, initializing with total=%"PRIu32", idle=%"PRIu32, current_run_time, current_idle_time);
-    } else {
-        // 计算时间差
-        configRUN_TIME_COUNTER_TYPE total_elapsed_time = current_run_time - cpu_usage_context.last_run_time;
-        configRUN_TIME_COUNTER_TYPE idle_elapsed_time = current_idle_time - cpu_usage_context.last_idle_time;
-        
-        ESP_LOGD(TAG, "Time diff: total=%"PRIu32", idle=%"PRIu32, total_elapsed_time, idle_elapsed_time);
-        
-        if (total_elapsed_time > 0) {
-            // CPU使用率 = (总时间 - 空闲时间) / 总时间 * 100
-            // 考虑多核情况，除以核心数
-            uint32_t used_time = total_elapsed_time - idle_elapsed_time;
-            uint32_t adjusted_total = total_elapsed_time / CONFIG_FREERTOS_NUMBER_OF_CORES;
-            uint32_t usage_percentage = (used_time * 100) / adjusted_total;
-            
-            ESP_LOGD(TAG, "CPU calc: used=%"PRIu32", adjusted_total=%"PRIu32", percentage=%"PRIu32"%%", 
-                used_time, adjusted_total, usage_percentage);
-            
-            // 限制在0-100%范围内
-            if (usage_percentage > 100) {
-                usage_percentage = 100;
-            }
-            
-            cpu_usage = (uint8_t)usage_percentage;
+        if (home->bridge_count > 1) {
+            deadline_min(&next, home->bridge_rotate_time);
         }
-        
-        // 更新上一次的值
-        cpu_usage_context.last_run_time = current_run_time;
-        cpu_usage_context.last_idle_time = current_idle_time;
     }
-    
-    // 释放内存
-    vPortFree(pxTaskStatusArray);
-    
-    return cpu_usage;
+    if (ctx->popup.current_popup != POPUP_NONE) {
+        deadline_min(&next, ctx->popup.popup_expried_time);
+    }
+    if (!ctx->force_help_mode && ctx->page.current_page != PAGE_HOME) {
+        deadline_min(&next, ctx->page.page_expried_time);
+    }
+    if (ctx->page.current_page == PAGE_NETWORK && ctx->page.network.state == PAGE_STATE_CHECK_SCAN_RESULT) {
+        deadline_min(&next, now + DISPLAY_SCAN_POLL_MS);
+    }
+    if (ctx->off_timeout_s != 0 && !ctx->force_help_mode) {
+        deadline_min(&next, ctx->last_input_time + (sys_tick_t)ctx->off_timeout_s * 1000);
+    }
+
+    // 到期判断不包括到期时间本身, 多等1ms; 至少等待一个tick
+    const int32_t wait_ms = (int32_t)(next - now) + 1;
+    const TickType_t ticks = wait_ms > 0 ? pdMS_TO_TICKS(wait_ms) : 0;
+    return ticks > 0 ? ticks : 1;
 }
 
-static void display_update_data(display_context_t* ctx)
+static void display_update_status(display_context_t* ctx)
 {
     page_home_data_t* home = &ctx->page.home;
     wifi_connection_status_t wifi_status = {0};
-    bool need_refresh = false;
+    uint8_t dirty_widgets = 0;
     sys_tick_t now = uptime();
 
     // 在强制帮助页模式下，定期检查网络数量变化
@@ -754,10 +968,13 @@ static void display_update_data(display_context_t* ctx)
     if (ctx->cpu_usage_enabled) {
         if (uptime_after(now, home->cpu_usage_update_time)) {
             home->cpu_usage_update_time = now + 1000;
-            uint8_t cpu_usaged = get_cpu_usage();
+            uint8_t cpu_usaged = task_monitor_get_cpu_usage();
             if (cpu_usaged != home->cpu_usaged) {
+                // 位数变化时文字变窄会露出旧的字符, 连同SSID一起重画
+                bool width_changed = (cpu_usaged >= 10) != (home->cpu_usaged >= 10) ||
+                                     (cpu_usaged >= 100) != (home->cpu_usaged >= 100);
                 home->cpu_usaged = cpu_usaged;
-                need_refresh = true;
+                dirty_widgets |= width_changed ? HOME_WIDGET_TITLE : HOME_WIDGET_CPU;
             }
         }
     }
@@ -771,7 +988,7 @@ static void display_update_data(display_context_t* ctx)
         // 更新WiFi连接状态
         if (home->wifi_state != wifi_status.state) {
             home->wifi_state = wifi_status.state;
-            need_refresh = true;
+            dirty_widgets |= HOME_WIDGET_TITLE | HOME_WIDGET_ADDRESS;
 
             // set sysled 闪烁
             if (wifi_status.state == WIFI_STATE_CONNECTED) {
@@ -789,7 +1006,7 @@ static void display_update_data(display_context_t* ctx)
         // 更新SSID
         if (strcmp(home->ssid, wifi_status.ssid) != 0) {
             strncpy(home->ssid, wifi_status.ssid, sizeof(home->ssid) - 1);
-            need_refresh = true;
+            dirty_widgets |= HOME_WIDGET_TITLE;
         }
 
         // 更新IP地址
@@ -802,7 +1019,7 @@ static void display_update_data(display_context_t* ctx)
         );
         if (strcmp(home->ip_address, ip_str) != 0) {
             strncpy(home->ip_address, ip_str, sizeof(home->ip_address) - 1);
-            need_refresh = true;
+            dirty_widgets |= HOME_WIDGET_ADDRESS;
         }
 
         // 更新信号强度等级
@@ -821,13 +1038,37 @@ static void display_update_data(display_context_t* ctx)
 
         if (home->signal_level != signal_level) {
             home->signal_level = signal_level;
-            need_refresh = true;
+            dirty_widgets |= HOME_WIDGET_SIGNAL;
+        }
+    }
+
+    // 统计桥接实例, 有多个实例时定时切换到下一个
+    uint8_t bridge_count = 0;
+    for (uint8_t i = 0; i < UART_BRIDGE_MAX_INSTANCES; i++) {
+        if (uart_bridge_get(i)) {
+            bridge_count++;
+        }
+    }
+    if (home->bridge_count != bridge_count) {
+        home->bridge_count = bridge_count;
+        dirty_widgets |= HOME_WIDGET_STATS;
+    }
+    if (bridge_count > 1 && ctx->page.current_page == PAGE_HOME && uptime_after(now, home->bridge_rotate_time)) {
+        home->bridge_rotate_time = now + BRIDGE_ROTATE_MS;
+        for (uint8_t i = 1; i <= UART_BRIDGE_MAX_INSTANCES; i++) {
+            uint8_t next = (home->bridge_index + i) % UART_BRIDGE_MAX_INSTANCES;
+            if (uart_bridge_get(next)) {
+                home->bridge_index = next;
+                dirty_widgets |= HOME_WIDGET_INFO | HOME_WIDGET_STATS;
+                break;
+            }
         }
     }
+    uart_bridge_handle_t bridge = uart_bridge_get(home->bridge_index);
 
     // 更新UART状态
     uart_bridge_status_t uart_status = {0};
-    if (uart_bridge_get_status(&uart_status) == ESP_OK) {
+    if (uart_bridge_get_status(bridge, &uart_status) == ESP_OK) {
 
         if ((home->client_num != uart_status.tcp_client_num)
             || (home->ip_port != uart_status.tcp_port)
@@ -835,24 +1076,30 @@ static void display_update_data(display_context_t* ctx)
             home->client_num = uart_status.tcp_client_num;
             home->ip_port = uart_status.tcp_port;
             home->baudrate = uart_status.uart_baudrate;
-            need_refresh = true;
+            dirty_widgets |= HOME_WIDGET_INFO;
         }        
     }
 
-    // 更新RX/TX字节数
-    uart_bridge_stats_t stats = {0};
-    if (uart_bridge_get_stats(&stats) == ESP_OK) {
-        if ((home->rx_bytes != stats.uart_rx_bytes)
-            || (home->tx_bytes != stats.uart_tx_bytes)) {
-            home->rx_bytes = stats.uart_rx_bytes;
-            home->tx_bytes = stats.uart_tx_bytes;
-            need_refresh = true;
-        }
+    // 主页数据只在主页上显示, 其它页面由页面自己的事件刷新
+    home->dirty_widgets |= dirty_widgets;
+}
+
+static void display_update_traffic(display_context_t* ctx)
+{
+    page_home_data_t* home = &ctx->page.home;
+    uint64_t rx_bytes = 0;
+    uint64_t tx_bytes = 0;
+
+    // 不加锁读取, 不影响转发任务
+    if (uart_bridge_get_traffic(uart_bridge_get(home->bridge_index), &rx_bytes, &tx_bytes) != ESP_OK) {
+        return;
     }
 
-    // 如果有数据更新，设置页面需要刷新
-    if (need_refresh) {
-        ctx->page.dirty = true;
+    if ((home->rx_bytes != rx_bytes) || (home->tx_bytes != tx_bytes)) {
+        home->rx_bytes = rx_bytes;
+        home->tx_bytes = tx_bytes;
+        home->traffic_active_until = uptime() + DISPLAY_TRAFFIC_HOLD_MS;
+        home->dirty_widgets |= HOME_WIDGET_STATS;
     }
 }
 
@@ -873,10 +1120,19 @@ static bool update_home_animation(display_context_t* ctx)
         return false;
     }
 
+    // 没有流量时停止动画, 显示完整的线
+    if (!uptime_after(home->traffic_active_until, now)) {
+        if (home->animation_line.eraser_position == 0) {
+            return false;
+        }
+        home->animation_line.eraser_position = 0;
+        return true;
+    }
+
     // 检查是否需要更新动画
     if (uptime_after(now, home->animation_line.last_update_time)) {
         home->animation_line.last_update_time = now + ANIMATION_UPDATE_MS;
-        home->animation_line.eraser_position++;
+        home->animation_line.eraser_position += ANIMATION_STEP;
         if (home->animation_line.eraser_position >= 64) {
             home->animation_line.eraser_position = 0;
         }
@@ -886,10 +1142,36 @@ static bool update_home_animation(display_context_t* ctx)
     return false;
 }
 
-static void draw_home_page(display_context_t* ctx)
+/**
+ * @brief 格式化字节数, 超过4位数时使用K/M/G/T单位, 最多5个字符
+ * 
+ * @param buf 
+ * @param size 
+ * @param bytes 
+ */
+static void format_byte_count(char *buf, size_t size, uint64_t bytes)
+{
+    static const char units[] = { 'K', 'M', 'G', 'T' };
+    int unit = -1;
+
+    while (bytes >= 10000 && unit < (int)sizeof(units) - 1) {
+        bytes /= 1024;
+        unit++;
+    }
+
+    if (unit < 0) {
+        snprintf(buf, size, "%" PRIu64, bytes);
+    } else {
+        snprintf(buf, size, "%" PRIu64 "%c", bytes, units[unit]);
+    }
+}
+
+static void draw_home_signal(display_context_t* ctx)
 {
     page_home_data_t* home = &ctx->page.home;
 
+    lcd_clear_area(ctx->lcd_handle, 0, HOME_STATUS_TOP, HOME_TITLE_X, HOME_ADDRESS_TOP - HOME_STATUS_TOP);
+
     // 初始化显示内容
     const lcd_mono_img_t* signal_img = NULL;
 
@@ -914,19 +1196,49 @@ static void draw_home_page(display_context_t* ctx)
 
     // 显示信号图标
     lcd_display_mono_img(ctx->lcd_handle, 0, 0, signal_img, false);
+}
+
+#define LINE1_TEXT_X 20
+#define LINE1_TEXT_Y 0
+
+#define LINE2_TEXT_X 20
+#define LINE2_TEXT_Y 18
 
-    #define LINE1_TEXT_X 20
-    #define LINE1_TEXT_Y 0
+static void draw_home_title(display_context_t* ctx)
+{
+    page_home_data_t* home = &ctx->page.home;
 
-    #define LINE2_TEXT_X 20
-    #define LINE2_TEXT_Y 18
+    lcd_clear_area(ctx->lcd_handle, HOME_TITLE_X, HOME_STATUS_TOP, 128 - HOME_TITLE_X, HOME_ADDRESS_TOP - HOME_STATUS_TOP);
 
-    // 显示SSID
+    // 显示SSID, 中文需要从hzk16字库查找字模, 只在SSID或连接状态变化时重画
     if (home->wifi_state == WIFI_STATE_CONNECTED || home->wifi_state == WIFI_STATE_CONNECTING) {
         lcd_display_text(ctx->lcd_handle, LINE1_TEXT_X, LINE1_TEXT_Y, home->ssid, false);
     } /* else {
         lcd_display_ascii_string(ctx->lcd_handle, LINE1_TEXT_X, LINE1_TEXT_Y, "N/A", LCD_FONT(ascii_8x16), false);
     }*/
+}
+
+static void draw_home_cpu(display_context_t* ctx)
+{
+    page_home_data_t* home = &ctx->page.home;
+
+    // 显示CPU使用率
+    if (ctx->cpu_usage_enabled) {
+        char cpu_usage_str[8];
+        snprintf(cpu_usage_str, sizeof(cpu_usage_str), "%" PRIu8, home->cpu_usaged);
+        int text_width = strlen(cpu_usage_str) * 8;
+        // 显示在右上角, 需要根据长度计算X坐标
+        int x = (text_width > 128) ? 0 : (128 - text_width);
+        lcd_clear_area(ctx->lcd_handle, x, 0, text_width, 8);
+        lcd_display_ascii_string(ctx->lcd_handle, x, 0, cpu_usage_str, LCD_FONT(ascii_8x8), false);
+    }
+}
+
+static void draw_home_address(display_context_t* ctx)
+{
+    page_home_data_t* home = &ctx->page.home;
+
+    lcd_clear_area(ctx->lcd_handle, 0, HOME_ADDRESS_TOP, 128, HOME_INFO_TOP - HOME_ADDRESS_TOP);
 
     // 显示状态信息, 如果是离线,显示OFFLINE, 如果是已连接,显示IP地址.
 
@@ -940,7 +1252,12 @@ static void draw_home_page(display_context_t* ctx)
     } else {
         lcd_display_ascii_string(ctx->lcd_handle, 0, LINE2_TEXT_Y, "NO NETWORK", LCD_FONT(ascii_8x8), false);
     }
+}
+static void draw_home_stats(display_context_t* ctx)
+{
+    page_home_data_t* home = &ctx->page.home;
 
+    lcd_clear_area(ctx->lcd_handle, 0, HOME_STATS_TOP, 128, LCD_HEIGHT - HOME_STATS_TOP);
 
     // 在最后一行显示 收发字节数
     #define LINE4_TOP_Y  (64 - 8) - 2
@@ -948,15 +1265,22 @@ static void draw_home_page(display_context_t* ctx)
     // 显示一个行, 行高为1
     lcd_draw_horizontal_line(ctx->lcd_handle, 0, LINE4_TOP_Y, 128, 1, false);
 
+    char rx_str[8];
+    char tx_str[8];
     char stat_str[32];
-    snprintf(stat_str, sizeof(stat_str), "%" PRIu32 "/%" PRIu32, home->rx_bytes, home->tx_bytes);
+    format_byte_count(rx_str, sizeof(rx_str), home->rx_bytes);
+    format_byte_count(tx_str, sizeof(tx_str), home->tx_bytes);
+    snprintf(stat_str, sizeof(stat_str), "%s/%s", rx_str, tx_str);
     // 右对齐显示, 需要根据长度计算X坐标
     int text_width = strlen(stat_str) * 8; // ascii_8x16字体宽度为8
     int x = (text_width > 128) ? 0 : (128 - text_width);
     lcd_display_ascii_string(ctx->lcd_handle, x, LINE4_TEXT_Y, stat_str, LCD_FONT(ascii_8x8), false);
 
-    // 最后一行, 右对齐显示统计信息, 左侧有空间才显示标题 
-    const char *stats_title = "R/T";
+    // 最后一行, 右对齐显示统计信息, 左侧有空间才显示标题, 多个实例时显示实例序号
+    char stats_title[8] = "R/T";
+    if (home->bridge_count > 1) {
+        snprintf(stats_title, sizeof(stats_title), "U%d", home->bridge_index + 1);
+    }
     text_width = strlen(stats_title) * 8;
     if (x >= text_width) {
         lcd_display_ascii_string(ctx->lcd_handle, 0, LINE4_TEXT_Y, stats_title, LCD_FONT(ascii_8x8), false);
@@ -983,6 +1307,15 @@ static void draw_home_page(display_context_t* ctx)
         }
     }
 
+}
+
+static void draw_home_info(display_context_t* ctx)
+{
+    page_home_data_t* home = &ctx->page.home;
+    int text_width;
+
+    lcd_clear_area(ctx->lcd_handle, 0, HOME_INFO_TOP, 128, HOME_STATS_TOP - HOME_INFO_TOP);
+
     // 显示客户端数量, 端口号, 波特率 
     // 可用区域, Y=[26,53] 总共27个像素(上下预留一个空像素, 所以可用区域为25个像素), x=0-127
     #define INFO_AREA_START_Y 29
@@ -1066,16 +1399,33 @@ static void draw_home_page(display_context_t* ctx)
     lcd_display_ascii_string(ctx->lcd_handle, text_x + 1, text_y, baudrate_str, LCD_FONT(ascii_8x8), true);
 
     #endif  
+}
 
-    // 显示CPU使用率
-    if (ctx->cpu_usage_enabled) {
-        char cpu_usage_str[8];
-        snprintf(cpu_usage_str, sizeof(cpu_usage_str), "%" PRIu8, home->cpu_usaged);
-        text_width = strlen(cpu_usage_str) * 8;
-        // 显示在右上角, 需要根据长度计算X坐标
-        int x = (text_width > 128) ? 0 : (128 - text_width);
-        lcd_display_ascii_string(ctx->lcd_handle, x, 0, cpu_usage_str, LCD_FONT(ascii_8x8), false);
+static void draw_home_widgets(display_context_t* ctx, uint8_t widgets)
+{
+    if (widgets & HOME_WIDGET_SIGNAL) {
+        draw_home_signal(ctx);
+    }
+    if (widgets & HOME_WIDGET_TITLE) {
+        draw_home_title(ctx);
+    }
+    if (widgets & HOME_WIDGET_ADDRESS) {
+        draw_home_address(ctx);
+    }
+    if (widgets & (HOME_WIDGET_TITLE | HOME_WIDGET_CPU)) {
+        draw_home_cpu(ctx);
+    }
+    if (widgets & HOME_WIDGET_INFO) {
+        draw_home_info(ctx);
     }
+    if (widgets & HOME_WIDGET_STATS) {
+        draw_home_stats(ctx);
+    }
+}
+
+static void draw_home_page(display_context_t* ctx)
+{
+    draw_home_widgets(ctx, HOME_WIDGET_STATUS | HOME_WIDGET_INFO | HOME_WIDGET_STATS);
 }
 
 #define POPUP_WIDTH     108
@@ -1256,6 +1606,10 @@ static void draw_uart_page(display_context_t* ctx)
     const int icon_x = (left_width - 16) / 2;  // 16是图标宽度，水平居中
     const int icon_y = (64 - 16) / 2;  // 垂直居中显示图标
     lcd_display_mono_img(ctx->lcd_handle, icon_x, icon_y, LCD_IMG(serial), false);
+
+    // 图标下方显示链路方案简称
+    lcd_display_ascii_string(ctx->lcd_handle, (left_width - 16) / 2, 52,
+                             link_profile_short_name(link_profile_get()), LCD_FONT(ascii_8x8), false);
     
     // 绘制分隔线
     lcd_draw_vertical_line(ctx->lcd_handle, left_width, 0, 64, divider_width, false);
@@ -1468,7 +1822,7 @@ static void handle_button_event(display_context_t* ctx, const display_button_eve
                 if (ctx->page.current_page == PAGE_HOME && ctx->popup.current_popup != POPUP_MENU) 
                 {
                     // 清除统计信息
-                    uart_bridge_reset_stats();
+                    uart_bridge_reset_stats(uart_bridge_get(ctx->page.home.bridge_index));
                     // 显示弹出框, 显示已清除.
                     active_popup_msg(ctx, MSG_ID_STATISTICS_CLEARED);
                 }
@@ -1585,7 +1939,7 @@ static void handle_button_event(display_context_t* ctx, const display_button_eve
                     ctx->page.home.baudrate = g_supported_baudrates[ctx->page.uart.selected_index];
 
                     // 设置波特率
-                    uart_bridge_set_baudrate(ctx->page.home.baudrate);
+                    uart_bridge_set_baudrate(uart_bridge_get(ctx->page.home.bridge_index), ctx->page.home.baudrate);
 
                     // 返回主页
                     switch_page(ctx, PAGE_HOME);
@@ -1639,6 +1993,7 @@ static void handle_button_event(display_context_t* ctx, const display_button_eve
                     ctx->page.home.cpu_usaged = 0;
                     ctx->page.home.cpu_usage_update_time = uptime();
                 } 
+                ctx->page.home.dirty_widgets |= HOME_WIDGET_TITLE;
 
                 ESP_LOGI(TAG, "CPU usage display %s", ctx->cpu_usage_enabled ? "enabled" : "disabled");
             }
@@ -8,10 +8,20 @@
  * @date 2025-05-24
  */
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief 串口硬件流控引脚, 没有引出时为-1(UART_PIN_NO_CHANGE)
+ */
+typedef struct {
+    int rts_pin;
+    int cts_pin;
+} board_uart_flow_pins_t;
+
 /**
  * @brief 板级初始化
  * 
@@ -19,6 +29,14 @@ extern "C" {
  */
 int board_init(void);
 
+/**
+ * @brief 获取串口硬件流控引脚
+ * 
+ * @param uart_id 
+ * @return const board_uart_flow_pins_t* NULL: 该串口不支持硬件流控
+ */
+const board_uart_flow_pins_t *board_uart_flow_pins_get(uint8_t uart_id);
+
 
 #ifdef __cplusplus
 }
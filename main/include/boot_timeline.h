@@ -0,0 +1,61 @@
+#ifndef __BOOT_TIMELINE_H__
+#define __BOOT_TIMELINE_H__
+
+/**
+ * @file boot_timeline.h
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 启动阶段计时
+ * @version 0.1
+ * @date 2025-11-05
+ *
+ * 每个阶段只记录第一次到达的时间(开机以来的微秒数), WiFi重连不会覆盖.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    BOOT_PHASE_APP_START = 0,       // 进入app_main, 之前是引导和系统启动
+    BOOT_PHASE_NVS_READY,
+    BOOT_PHASE_UART_READY,          // 桥接串口开始接收
+    BOOT_PHASE_WIFI_STARTED,
+    BOOT_PHASE_CLI_READY,
+    BOOT_PHASE_WIFI_CONNECTED,
+    BOOT_PHASE_GOT_IP,
+    BOOT_PHASE_FORWARDING,          // 网络服务开始监听, 可以转发
+    BOOT_PHASE_FONTS_READY,
+    BOOT_PHASE_DISPLAY_READY,
+    BOOT_PHASE_MAX,
+} boot_phase_t;
+
+/**
+ * @brief 记录到达某个阶段, 只有第一次有效
+ *
+ * @param phase
+ */
+void boot_timeline_mark(boot_phase_t phase);
+
+/**
+ * @brief 某个阶段的到达时间
+ *
+ * @param phase
+ * @return int64_t 开机以来的微秒数, 还没有到达时返回-1
+ */
+int64_t boot_timeline_get(boot_phase_t phase);
+
+/**
+ * @brief 阶段名称
+ *
+ * @param phase
+ * @return const char*
+ */
+const char *boot_phase_name(boot_phase_t phase);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __BOOT_TIMELINE_H__
@@ -16,6 +16,10 @@ extern "C" {
 #include "freertos/task.h"
 #include "esp_err.h"
 
+// 空闲熄屏时间范围(秒), 0表示不熄屏
+#define DISPLAY_OFF_TIMEOUT_MIN     10
+#define DISPLAY_OFF_TIMEOUT_MAX     3600
+
 /**
  * @brief 初始化显示模块
  * 
@@ -38,6 +42,28 @@ esp_err_t display_task_start(void);
  */
 esp_err_t display_task_stop(void);
 
+/**
+ * @brief 通知显示任务WiFi状态变化, 可以在任何任务中调用
+ */
+void display_notify_wifi(void);
+
+/**
+ * @brief 设置空闲熄屏时间, 保存到NVS
+ * 
+ * 没有按键超过该时间后关闭屏幕显示, 停止刷新, 按键唤醒. 没有配网时不熄屏.
+ * 
+ * @param seconds 0表示不熄屏, DISPLAY_OFF_TIMEOUT_MIN-DISPLAY_OFF_TIMEOUT_MAX
+ * @return esp_err_t 
+ */
+esp_err_t display_set_off_timeout(uint16_t seconds);
+
+/**
+ * @brief 获取空闲熄屏时间
+ * 
+ * @return uint16_t 秒, 0表示不熄屏
+ */
+uint16_t display_get_off_timeout(void);
+
 #ifdef __cplusplus
 }
 #endif
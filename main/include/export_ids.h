@@ -19,8 +19,10 @@ enum GPIO_IDS {
     GPIO_BUTTON,
 };
 
+// 串口ID同时也是桥接实例序号
 enum UART_IDS {
     UART_PRIMARY = 0,
+    UART_SECONDARY,
 };
 
 
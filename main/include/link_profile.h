@@ -0,0 +1,116 @@
+#ifndef __LINK_PROFILE_H__
+#define __LINK_PROFILE_H__
+
+/**
+ * @file link_profile.h
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 链路方案, 统一调整串口分包, TCP发送和WiFi省电参数
+ * @version 0.1
+ * @date 2025-11-07
+ *
+ * 方案保存在NVS中, 所有桥接实例共用. 切换方案时立即生效的部分:
+ * WiFi省电模式, TCP_NODELAY, 每个客户端的发送队列长度, 以及写入各实例的串口分包参数
+ * (之后仍可以在设置菜单中单独调整分包参数).
+ * 自动浅睡眠和串口时钟源在启动时配置, 需要重启生效.
+ * lwIP的TCP窗口和发送缓冲区是编译期配置(sdkconfig), 不随方案变化.
+ */
+
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+#include "uart_bridge.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    LINK_PROFILE_BALANCED = 0,      // 默认, 与之前的行为相同
+    LINK_PROFILE_LOW_LATENCY,       // 关闭WiFi省电, 小分包, 立即发送
+    LINK_PROFILE_THROUGHPUT,        // 大分包, 合并发送, 更长的客户端队列
+    LINK_PROFILE_LOW_POWER,         // WiFi最大省电, 空闲时自动浅睡眠, 串口唤醒
+    LINK_PROFILE_MAX,
+} link_profile_t;
+
+typedef struct {
+    wifi_ps_type_t wifi_ps;
+    bool tcp_nodelay;               // 关闭Nagle算法
+    uint32_t client_queue_bytes;    // 每个客户端最多排队的字节数
+    uart_bridge_rx_config_t rx;     // 切换方案时写入各实例的分包参数
+    bool light_sleep;               // 自动浅睡眠, 需要CONFIG_PM_ENABLE, 重启生效
+} link_profile_params_t;
+
+/**
+ * @brief 从NVS加载链路方案并配置电源管理, 需要在uart_bridge_init_all之前调用
+ *
+ * @return esp_err_t
+ */
+esp_err_t link_profile_init(void);
+
+/**
+ * @brief 当前的链路方案
+ *
+ * @return link_profile_t
+ */
+link_profile_t link_profile_get(void);
+
+/**
+ * @brief 当前方案的参数
+ *
+ * @return const link_profile_params_t*
+ */
+const link_profile_params_t *link_profile_params(void);
+
+/**
+ * @brief 设置链路方案并保存到NVS, 除浅睡眠外立即生效
+ *
+ * @param profile
+ * @return esp_err_t
+ */
+esp_err_t link_profile_set(link_profile_t profile);
+
+/**
+ * @brief 本次启动是否启用了自动浅睡眠
+ *
+ * @return true
+ * @return false
+ */
+bool link_profile_sleep_active(void);
+
+/**
+ * @brief 切换方案后浅睡眠设置与本次启动不同, 需要重启
+ *
+ * @return true
+ * @return false
+ */
+bool link_profile_reboot_pending(void);
+
+/**
+ * @brief 应用WiFi省电模式, WiFi连接后调用
+ *
+ * @return esp_err_t
+ */
+esp_err_t link_profile_apply_wifi(void);
+
+/**
+ * @brief 方案名称
+ *
+ * @param profile
+ * @return const char*
+ */
+const char *link_profile_name(link_profile_t profile);
+
+/**
+ * @brief 方案的两字符简称, 用于屏幕显示
+ *
+ * @param profile
+ * @return const char*
+ */
+const char *link_profile_short_name(link_profile_t profile);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __LINK_PROFILE_H__
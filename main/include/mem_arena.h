@@ -0,0 +1,167 @@
+#ifndef __MEM_ARENA_H__
+#define __MEM_ARENA_H__
+
+/**
+ * @file mem_arena.h
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 静态内存区, 启动时分配桥接缓冲区和任务栈, 转发过程中不使用堆
+ * @version 0.1
+ * @date 2025-11-11
+ *
+ * 开启CONFIG_UART2WIFI_STATIC_MEMORY后, 环形缓冲区, 客户端数据块池, 公平仲裁的接收队列
+ * 以及常驻任务的栈从一块静态内存中顺序分配, 分配后不再释放.
+ * 内存区放不下时改用堆内存, 记入失败次数, 不影响功能.
+ * 没有开启时, mem_arena_malloc等同于malloc, 内存报告中只有堆的信息.
+ */
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CONFIG_UART2WIFI_STATIC_MEMORY
+#define MEM_ARENA_ENABLED       1
+#define MEM_ARENA_SIZE          CONFIG_UART2WIFI_ARENA_SIZE
+#define MEM_ARENA_CHUNK_BLOCKS  CONFIG_UART2WIFI_CHUNK_POOL_BLOCKS
+#else
+#define MEM_ARENA_ENABLED       0
+#define MEM_ARENA_SIZE          0
+#define MEM_ARENA_CHUNK_BLOCKS  0
+#endif
+
+// 内存报告中按用途统计的项数, 超出的用途合并到最后一项
+#define MEM_ARENA_MAX_OWNERS    8
+#define MEM_ARENA_MAX_POOLS     4
+
+/**
+ * @brief 固定大小的内存块池, 从内存区分配, 可以在任何任务中获取和归还
+ */
+typedef struct mem_pool {
+    const char *name;
+    uint8_t *base;
+    size_t block_size;
+    uint16_t count;
+    uint16_t used;
+    uint16_t peak;
+    uint32_t exhausted;         // 没有空闲块的次数
+    void *free_list;
+    portMUX_TYPE lock;
+} mem_pool_t;
+
+typedef struct {
+    const char *name;
+    uint32_t bytes;
+} mem_arena_owner_t;
+
+typedef struct {
+    const char *name;
+    uint32_t block_size;
+    uint16_t count;
+    uint16_t used;
+    uint16_t peak;
+    uint32_t exhausted;
+} mem_arena_pool_info_t;
+
+typedef struct {
+    bool enabled;
+    uint32_t size;
+    uint32_t used;
+    uint32_t fallbacks;         // 放不下而改用堆内存的次数
+    uint32_t fallback_bytes;
+    uint8_t owner_count;
+    mem_arena_owner_t owners[MEM_ARENA_MAX_OWNERS];
+    uint8_t pool_count;
+    mem_arena_pool_info_t pools[MEM_ARENA_MAX_POOLS];
+    // 内部RAM
+    uint32_t heap_free;
+    uint32_t heap_min_free;
+    uint32_t heap_largest_block;
+} mem_arena_info_t;
+
+/**
+ * @brief 从内存区分配, 不会释放
+ *
+ * @param size
+ * @param owner 用途, 用于内存报告, 必须是常量字符串
+ * @return void* NULL表示没有开启或放不下
+ */
+void *mem_arena_alloc(size_t size, const char *owner);
+
+/**
+ * @brief 优先从内存区分配, 没有开启或放不下时使用堆内存
+ *
+ * @param size
+ * @param owner
+ * @return void*
+ */
+void *mem_arena_malloc(size_t size, const char *owner);
+
+/**
+ * @brief 释放mem_arena_malloc分配的内存, 内存区中的内存不释放
+ *
+ * @param ptr
+ */
+void mem_arena_free(void *ptr);
+
+/**
+ * @brief 是否是内存区中的内存
+ *
+ * @param ptr
+ * @return true
+ * @return false
+ */
+bool mem_arena_owns(const void *ptr);
+
+/**
+ * @brief 从内存区分配内存块池
+ *
+ * @param pool
+ * @param name 必须是常量字符串
+ * @param block_size
+ * @param count
+ * @return esp_err_t ESP_ERR_NOT_SUPPORTED 没有开启, ESP_ERR_NO_MEM 放不下
+ */
+esp_err_t mem_pool_init(mem_pool_t *pool, const char *name, size_t block_size, uint16_t count);
+
+/**
+ * @brief 获取一个内存块
+ *
+ * @param pool
+ * @return void* NULL表示没有空闲块
+ */
+void *mem_pool_get(mem_pool_t *pool);
+
+/**
+ * @brief 归还内存块
+ *
+ * @param pool
+ * @param block
+ */
+void mem_pool_put(mem_pool_t *pool, void *block);
+
+/**
+ * @brief 空闲块数量
+ *
+ * @param pool
+ * @return uint16_t
+ */
+uint16_t mem_pool_available(const mem_pool_t *pool);
+
+/**
+ * @brief 获取内存报告
+ *
+ * @param info
+ */
+void mem_arena_get_info(mem_arena_info_t *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __MEM_ARENA_H__
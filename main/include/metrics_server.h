@@ -0,0 +1,60 @@
+#ifndef __METRICS_SERVER_H__
+#define __METRICS_SERVER_H__
+
+/**
+ * @file metrics_server.h
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 通过HTTP导出运行统计(Prometheus文本格式)
+ * @version 0.1
+ * @date 2025-11-09
+ *
+ * GET /metrics 返回所有桥接实例的统计, 每个客户端的队列计数, 延迟百分位数,
+ * 内存和任务栈余量, WiFi信号强度, 重连次数和运行时间.
+ * 只读取各模块已有的计数器: 统计分片和延迟直方图无锁读取, 客户端计数不获取分发器的锁,
+ * 输出使用静态缓冲区分段发送, 转发路径上不增加任何锁和内存申请.
+ * 端口保存在NVS中, 0表示关闭.
+ */
+
+#include "esp_err.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define METRICS_SERVER_DEFAULT_PORT     9100
+
+/**
+ * @brief 加载端口并启动HTTP服务, 端口为0时不启动
+ *
+ * @return esp_err_t
+ */
+esp_err_t metrics_server_init(void);
+
+/**
+ * @brief 修改并保存端口, 立即重启HTTP服务
+ *
+ * @param port 0表示关闭
+ * @return esp_err_t
+ */
+esp_err_t metrics_server_set_port(uint16_t port);
+
+/**
+ * @brief 获取保存的端口
+ *
+ * @return uint16_t 0表示关闭
+ */
+uint16_t metrics_server_get_port(void);
+
+/**
+ * @brief 已经响应的请求数
+ *
+ * @return uint32_t
+ */
+uint32_t metrics_server_get_scrapes(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __METRICS_SERVER_H__
@@ -0,0 +1,179 @@
+#ifndef __MODBUS_GW_H__
+#define __MODBUS_GW_H__
+
+/**
+ * @file modbus_gw.h
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief Modbus TCP转Modbus RTU网关
+ * @version 0.1
+ * @date 2025-11-09
+ *
+ * 每个客户端的MBAP报文单独重组, 完整的请求按到达顺序进入事务队列,
+ * 同一时间总线上只有一个请求: 收到匹配的回复(CRC/站号/功能码)后按原来的事务号
+ * 回复给发起请求的客户端, 超时回复异常码0x0B, 然后发出下一个请求.
+ * 广播(站号0)没有回复, 发出后等待turnaround_ms再发下一个请求.
+ *
+ * 只包含协议逻辑, 不访问串口和网络, 调用者负责加锁.
+ */
+
+#include "esp_err.h"
+#include "tcp_server.h"
+#include "uart_bridge.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// RTU帧最大长度: 站号 + PDU(253) + CRC
+#define MODBUS_RTU_MAX_ADU          256
+#define MODBUS_MBAP_LEN             7
+// MBAP头 + PDU
+#define MODBUS_TCP_MAX_ADU          (MODBUS_MBAP_LEN + 253)
+// 最多排队的事务数, 所有客户端共用
+#define MODBUS_GW_QUEUE_LEN         16
+// 允许断开已有客户端时会多接受一个连接
+#define MODBUS_GW_MAX_CLIENTS       (UART_BRIDGE_MAX_CLIENTS + 1)
+
+// 异常码
+#define MODBUS_EXC_SERVER_BUSY      0x06
+#define MODBUS_EXC_TARGET_NO_REPLY  0x0B
+
+// modbus_gw_poll没有需要等待的事件
+#define MODBUS_GW_NO_DEADLINE       UINT32_MAX
+
+typedef struct {
+    // 把RTU请求写入串口
+    void (*send_rtu)(const uint8_t *frame, size_t len, void *ctx);
+    // 把Modbus TCP回复发给客户端
+    void (*send_tcp)(tcp_client_t *client, const uint8_t *data, size_t len, void *ctx);
+    void *ctx;
+} modbus_gw_ops_t;
+
+// 客户端的MBAP重组缓冲区
+typedef struct {
+    tcp_client_t *client;       // NULL表示空闲
+    uint16_t len;
+    uint8_t buf[MODBUS_TCP_MAX_ADU];
+} modbus_gw_rx_t;
+
+// 排队的事务
+typedef struct {
+    tcp_client_t *client;       // 发起请求的客户端, 断开后为NULL, 不再发出或回复
+    uint16_t tid;               // MBAP事务号
+    uint8_t unit;
+    uint8_t pdu_len;
+    uint8_t pdu[MODBUS_RTU_MAX_ADU - 3];
+} modbus_gw_txn_t;
+
+typedef struct {
+    modbus_gw_rx_t *rx;         // MODBUS_GW_MAX_CLIENTS个, modbus_gw_init时分配
+    modbus_gw_txn_t *queue;     // MODBUS_GW_QUEUE_LEN个
+    uint8_t head;
+    uint8_t count;
+    bool busy;                  // 队首的请求已经发出, 等待回复
+    int64_t deadline_us;        // 等待回复的截止时间, 或广播后可以发下一个请求的时间
+    uint32_t response_timeout_ms;
+    uint32_t turnaround_ms;
+    uint32_t char_us;           // 一个字符的传输时间
+    uart_bridge_modbus_stats_t stats;
+} modbus_gw_t;
+
+/**
+ * @brief 分配重组缓冲区和事务队列
+ *
+ * @param gw
+ * @return esp_err_t
+ */
+esp_err_t modbus_gw_init(modbus_gw_t *gw);
+
+/**
+ * @brief 释放缓冲区
+ *
+ * @param gw
+ */
+void modbus_gw_deinit(modbus_gw_t *gw);
+
+/**
+ * @brief 缓冲区是否已分配
+ *
+ * @param gw
+ * @return true
+ * @return false
+ */
+bool modbus_gw_ready(const modbus_gw_t *gw);
+
+/**
+ * @brief 设置超时参数, 下一个请求开始生效
+ *
+ * @param gw
+ * @param config
+ * @param baudrate 用于计算请求的发送时间
+ */
+void modbus_gw_set_timing(modbus_gw_t *gw, const uart_bridge_modbus_config_t *config, uint32_t baudrate);
+
+/**
+ * @brief 丢弃所有排队的事务和未完成的报文, 网络服务停止时调用
+ *
+ * @param gw
+ */
+void modbus_gw_reset(modbus_gw_t *gw);
+
+/**
+ * @brief 客户端断开, 丢弃它的未完成报文和排队的事务, 已发出的请求的回复被丢弃
+ *
+ * @param gw
+ * @param client
+ */
+void modbus_gw_remove_client(modbus_gw_t *gw, tcp_client_t *client);
+
+/**
+ * @brief 处理客户端发来的数据, 完整的请求进入事务队列, 队列满时回复异常码0x06
+ *
+ * @param gw
+ * @param client
+ * @param data
+ * @param len
+ * @param ops
+ */
+void modbus_gw_tcp_input(modbus_gw_t *gw, tcp_client_t *client, const uint8_t *data, size_t len,
+                         const modbus_gw_ops_t *ops);
+
+/**
+ * @brief 处理串口收到的一个RTU帧
+ *
+ * @param gw
+ * @param frame
+ * @param len
+ * @param now_us
+ * @param ops
+ */
+void modbus_gw_rtu_input(modbus_gw_t *gw, const uint8_t *frame, size_t len, int64_t now_us,
+                         const modbus_gw_ops_t *ops);
+
+/**
+ * @brief 处理回复超时, 总线空闲时发出下一个请求
+ *
+ * @param gw
+ * @param now_us
+ * @param ops
+ * @return uint32_t 距离下一个截止时间的毫秒数, MODBUS_GW_NO_DEADLINE表示没有需要等待的事件
+ */
+uint32_t modbus_gw_poll(modbus_gw_t *gw, int64_t now_us, const modbus_gw_ops_t *ops);
+
+/**
+ * @brief 计算Modbus RTU的CRC16
+ *
+ * @param data
+ * @param len
+ * @return uint16_t 低字节在前发送
+ */
+uint16_t modbus_crc16(const uint8_t *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __MODBUS_GW_H__
@@ -0,0 +1,89 @@
+#ifndef __OUTAGE_BUFFER_H__
+#define __OUTAGE_BUFFER_H__
+
+/**
+ * @file outage_buffer.h
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 断网缓存, 没有客户端时保存最近的串口数据, 满时覆盖最旧的数据
+ * @version 0.1
+ * @date 2025-11-06
+ *
+ * 只由桥接的发送任务访问, 不加锁. 有PSRAM时优先放在PSRAM中.
+ */
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint8_t *buffer;
+    uint32_t size;          // 0表示未启用
+    uint32_t head;          // 最旧数据的位置
+    uint32_t used;
+    bool psram;             // 缓冲区在PSRAM中
+} outage_buffer_t;
+
+/**
+ * @brief 分配缓存
+ *
+ * @param ob
+ * @param size 0表示不启用, 不分配内存
+ * @return esp_err_t ESP_ERR_NO_MEM 内存不足
+ */
+esp_err_t outage_buffer_init(outage_buffer_t *ob, uint32_t size);
+
+/**
+ * @brief 释放缓存, 丢弃其中的数据
+ *
+ * @param ob
+ */
+void outage_buffer_deinit(outage_buffer_t *ob);
+
+/**
+ * @brief 写入数据, 放不下时覆盖最旧的数据
+ *
+ * @param ob
+ * @param data
+ * @param len
+ * @return uint32_t 被覆盖(丢失)的字节数, 包括超过缓存大小而直接丢弃的部分
+ */
+uint32_t outage_buffer_write(outage_buffer_t *ob, const uint8_t *data, size_t len);
+
+/**
+ * @brief 获取最旧的一段连续数据
+ *
+ * @param ob
+ * @param span 输出数据地址
+ * @return size_t 连续数据长度, 0表示没有数据
+ */
+size_t outage_buffer_read_span(const outage_buffer_t *ob, const uint8_t **span);
+
+/**
+ * @brief 释放已经发出的数据
+ *
+ * @param ob
+ * @param len 不能超过outage_buffer_read_span返回的长度
+ */
+void outage_buffer_consume(outage_buffer_t *ob, size_t len);
+
+/**
+ * @brief 缓存中的数据量
+ *
+ * @param ob
+ * @return uint32_t
+ */
+static inline uint32_t outage_buffer_used(const outage_buffer_t *ob)
+{
+    return ob->used;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __OUTAGE_BUFFER_H__
@@ -0,0 +1,96 @@
+#ifndef __PERF_METRICS_H__
+#define __PERF_METRICS_H__
+
+/**
+ * @file perf_metrics.h
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 延迟直方图和滚动吞吐量统计
+ * @version 0.1
+ * @date 2025-10-28
+ *
+ * 两者都只允许一个任务写入, 其它任务可以随时读取(读到的是近似值).
+ * 延迟按2的幂分桶(微秒), 百分位数在桶内线性插值.
+ * 吞吐量按秒分桶, 保留最近60秒.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 延迟分桶数量, 桶i的范围为[2^(i-1), 2^i)微秒, 最后一个桶包含所有更大的值
+#define LATENCY_HIST_BUCKETS    26
+// 吞吐量窗口(秒), 另外多保留一个桶给当前秒
+#define RATE_METER_WINDOW_SEC   60
+#define RATE_METER_SLOTS        (RATE_METER_WINDOW_SEC + 1)
+
+typedef struct {
+    uint32_t buckets[LATENCY_HIST_BUCKETS];
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t sum_us;                    // 所有样本之和, 用于计算平均值
+} latency_hist_t;
+
+typedef struct {
+    uint32_t bytes[RATE_METER_SLOTS];
+    uint32_t second[RATE_METER_SLOTS];  // 每个桶对应的秒数, 用于判断桶是否过期
+    uint32_t peak_1s;                   // 单秒最大字节数
+} rate_meter_t;
+
+/**
+ * @brief 清空直方图
+ *
+ * @param hist
+ */
+void latency_hist_reset(latency_hist_t *hist);
+
+/**
+ * @brief 记录一次延迟
+ *
+ * @param hist
+ * @param latency_us
+ */
+void latency_hist_record(latency_hist_t *hist, uint32_t latency_us);
+
+/**
+ * @brief 计算百分位数
+ *
+ * @param hist
+ * @param percent 百分位, 0-100
+ * @return uint32_t 延迟(微秒), 没有数据时返回0
+ */
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint32_t percent);
+
+/**
+ * @brief 清空吞吐量统计
+ *
+ * @param meter
+ */
+void rate_meter_reset(rate_meter_t *meter);
+
+/**
+ * @brief 记录传输的字节数
+ *
+ * @param meter
+ * @param bytes
+ * @param now_us 当前时间, esp_timer_get_time()
+ */
+void rate_meter_add(rate_meter_t *meter, uint32_t bytes, int64_t now_us);
+
+/**
+ * @brief 计算最近若干秒(不含当前秒)的平均速率
+ *
+ * @param meter
+ * @param window_sec 1-RATE_METER_WINDOW_SEC
+ * @param now_us 当前时间, esp_timer_get_time()
+ * @return uint32_t 字节/秒
+ */
+uint32_t rate_meter_rate(const rate_meter_t *meter, uint32_t window_sec, int64_t now_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __PERF_METRICS_H__
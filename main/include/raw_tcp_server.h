@@ -0,0 +1,113 @@
+#ifndef __RAW_TCP_SERVER_H__
+#define __RAW_TCP_SERVER_H__
+
+/**
+ * @file raw_tcp_server.h
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 基于lwIP raw API的TCP服务器, 接口与tcp_server组件相同
+ * @version 0.1
+ * @date 2025-11-08
+ *
+ * 连接直接在lwIP的tcpip线程中处理, 不经过socket层:
+ * 收到的pbuf交给服务器任务, 接收回调直接使用pbuf的数据, 回调返回后才确认接收窗口,
+ * 串口写入阻塞时客户端的TCP窗口同样会关闭;
+ * 发送时tcp_write直接引用分发器的数据块(不拷贝), 收到ACK后释放引用.
+ * 从其它任务调用lwIP需要CONFIG_LWIP_TCPIP_CORE_LOCKING, 没有启用时创建返回ESP_ERR_NOT_SUPPORTED.
+ *
+ * 客户端的sock字段固定为-1, 发送, 设置连接参数和断开使用raw_tcp_server_fanout_io.
+ *
+ * 设置了raw_tcp_server_set_recv_callback时, 回调可以只接收一部分数据, 剩下的数据留在服务器中,
+ * 只关闭这个连接的接收窗口, 其它连接照常处理; raw_tcp_server_resume后重新交付.
+ */
+
+#include "esp_err.h"
+#include "tcp_server.h"
+#include "tcp_fanout.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct raw_tcp_server *raw_tcp_server_handle_t;
+
+// 分发器使用的连接操作
+extern const tcp_fanout_io_t raw_tcp_server_fanout_io;
+
+/**
+ * @brief 可以暂停交付的接收回调, 在服务器任务中调用, 不能阻塞
+ *
+ * @return size_t 接收的字节数, 少于len时剩下的数据暂停交付, 不确认接收窗口
+ */
+typedef size_t (*raw_tcp_server_recv_cb_t)(tcp_client_t *client, const uint8_t *data, size_t len, void *user_ctx);
+
+/**
+ * @brief 当前固件是否支持raw引擎
+ *
+ * @return true
+ * @return false
+ */
+bool raw_tcp_server_supported(void);
+
+/**
+ * @brief 创建服务器, 使用config中的端口, 客户端上限, 回调和任务参数, verbose不使用
+ *
+ * @param config
+ * @param err 输出错误码
+ * @return raw_tcp_server_handle_t 失败返回NULL
+ */
+raw_tcp_server_handle_t raw_tcp_server_create(const tcp_server_config_t *config, esp_err_t *err);
+
+/**
+ * @brief 设置可以暂停交付的接收回调, 代替config中的recv_callback, 需要在开始监听之前调用
+ *
+ * @param server
+ * @param callback
+ * @return esp_err_t
+ */
+esp_err_t raw_tcp_server_set_recv_callback(raw_tcp_server_handle_t server, raw_tcp_server_recv_cb_t callback);
+
+/**
+ * @brief 唤醒服务器任务, 重新交付暂停的数据, 可以在任意任务中调用, 不阻塞
+ *
+ * @param server
+ */
+void raw_tcp_server_resume(raw_tcp_server_handle_t server);
+
+/**
+ * @brief 开始监听
+ *
+ * @param server
+ * @return esp_err_t
+ */
+esp_err_t raw_tcp_server_start(raw_tcp_server_handle_t server);
+
+/**
+ * @brief 停止监听并断开所有客户端, 返回前已经为每个客户端调用了断开回调
+ *
+ * @param server
+ * @return esp_err_t
+ */
+esp_err_t raw_tcp_server_stop(raw_tcp_server_handle_t server);
+
+/**
+ * @brief 销毁服务器, 正在运行时先停止
+ *
+ * @param server
+ * @return esp_err_t
+ */
+esp_err_t raw_tcp_server_destroy(raw_tcp_server_handle_t server);
+
+/**
+ * @brief 获取客户端数量
+ *
+ * @param server
+ * @return int
+ */
+int raw_tcp_server_get_client_count(raw_tcp_server_handle_t server);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __RAW_TCP_SERVER_H__
@@ -0,0 +1,167 @@
+#ifndef __RFC2217_H__
+#define __RFC2217_H__
+
+/**
+ * @file rfc2217.h
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief RFC 2217(Telnet COM-PORT-OPTION)协议解析
+ * @version 0.1
+ * @date 2025-10-30
+ *
+ * 每个TCP客户端一个会话, 解析Telnet命令和串口参数子协商.
+ * 普通数据不拷贝, 以连续片段的形式直接回调给上层(指向输入缓冲区).
+ * 模块本身不访问串口和网络, 通过rfc2217_ops_t回调完成.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RFC2217_IAC                 255
+#define RFC2217_DONT                254
+#define RFC2217_DO                  253
+#define RFC2217_WONT                252
+#define RFC2217_WILL                251
+#define RFC2217_SB                  250
+#define RFC2217_SE                  240
+
+#define RFC2217_OPT_BINARY          0
+#define RFC2217_OPT_SGA             3
+#define RFC2217_OPT_COM_PORT        44
+
+// 客户端命令, 服务器回复的命令字为客户端命令+100
+#define RFC2217_SIGNATURE           0
+#define RFC2217_SET_BAUDRATE        1
+#define RFC2217_SET_DATASIZE        2
+#define RFC2217_SET_PARITY          3
+#define RFC2217_SET_STOPSIZE        4
+#define RFC2217_SET_CONTROL         5
+#define RFC2217_NOTIFY_LINESTATE    6
+#define RFC2217_NOTIFY_MODEMSTATE   7
+#define RFC2217_SET_LINESTATE_MASK  10
+#define RFC2217_SET_MODEMSTATE_MASK 11
+#define RFC2217_PURGE_DATA          12
+#define RFC2217_SERVER_OFFSET       100
+
+// SET-PARITY取值
+#define RFC2217_PARITY_NONE         1
+#define RFC2217_PARITY_ODD          2
+#define RFC2217_PARITY_EVEN         3
+#define RFC2217_PARITY_MARK         4
+#define RFC2217_PARITY_SPACE        5
+
+// SET-STOPSIZE取值
+#define RFC2217_STOPSIZE_1          1
+#define RFC2217_STOPSIZE_2          2
+#define RFC2217_STOPSIZE_1_5        3
+
+// SET-CONTROL取值
+#define RFC2217_CONTROL_FLOW_QUERY  0
+#define RFC2217_CONTROL_FLOW_NONE   1
+#define RFC2217_CONTROL_FLOW_XONXOFF 2
+#define RFC2217_CONTROL_FLOW_HW     3
+#define RFC2217_CONTROL_BREAK_QUERY 4
+#define RFC2217_CONTROL_BREAK_ON    5
+#define RFC2217_CONTROL_BREAK_OFF   6
+#define RFC2217_CONTROL_DTR_QUERY   7
+#define RFC2217_CONTROL_DTR_ON      8
+#define RFC2217_CONTROL_DTR_OFF     9
+#define RFC2217_CONTROL_RTS_QUERY   10
+#define RFC2217_CONTROL_RTS_ON      11
+#define RFC2217_CONTROL_RTS_OFF     12
+
+// NOTIFY-LINESTATE位
+#define RFC2217_LINESTATE_OVERRUN   0x02
+#define RFC2217_LINESTATE_PARITY    0x04
+#define RFC2217_LINESTATE_FRAMING   0x08
+#define RFC2217_LINESTATE_BREAK     0x10
+
+// NOTIFY-MODEMSTATE位
+#define RFC2217_MODEMSTATE_CTS      0x10
+#define RFC2217_MODEMSTATE_DSR      0x20
+#define RFC2217_MODEMSTATE_CD       0x80
+
+// 子协商最大长度, 足够容纳所有COM-PORT-OPTION命令
+#define RFC2217_SB_MAX              16
+// 回复帧最大长度(全部转义时)
+#define RFC2217_FRAME_MAX           (6 + 2 * RFC2217_SB_MAX)
+
+typedef struct {
+    // 收到的串口数据(已去除Telnet命令), 直接指向输入缓冲区
+    void (*data)(const uint8_t *data, size_t len, void *ctx);
+    // 需要发给客户端的数据(协商回复/通知)
+    void (*reply)(const uint8_t *data, size_t len, void *ctx);
+    // 处理SET-BAUDRATE/DATASIZE/PARITY/STOPSIZE/CONTROL/PURGE-DATA, value为0表示查询, 返回实际生效的值
+    uint32_t (*control)(uint8_t command, uint32_t value, void *ctx);
+    // 当前的modem状态, RFC2217_MODEMSTATE_xxx
+    uint8_t (*modem_state)(void *ctx);
+    void *ctx;
+} rfc2217_ops_t;
+
+typedef struct {
+    uint8_t state;              // 解析状态
+    uint8_t verb;               // WILL/WONT/DO/DONT
+    uint8_t sb_len;
+    bool sb_overflow;
+    uint8_t sb_buf[RFC2217_SB_MAX];
+    uint8_t local_opts;         // 本端已启用的选项
+    uint8_t remote_opts;        // 对端已启用的选项
+    uint8_t linestate_mask;
+    uint8_t modemstate_mask;
+} rfc2217_session_t;
+
+/**
+ * @brief 初始化会话
+ *
+ * @param session
+ */
+void rfc2217_session_init(rfc2217_session_t *session);
+
+/**
+ * @brief 处理客户端发来的数据
+ *
+ * @param session
+ * @param data
+ * @param len
+ * @param ops
+ */
+void rfc2217_input(rfc2217_session_t *session, const uint8_t *data, size_t len, const rfc2217_ops_t *ops);
+
+/**
+ * @brief 生成NOTIFY-LINESTATE通知, 按客户端设置的掩码过滤
+ *
+ * @param session
+ * @param line_state RFC2217_LINESTATE_xxx
+ * @param frame 输出, 至少RFC2217_FRAME_MAX字节
+ * @return size_t 帧长度, 0表示不需要通知
+ */
+size_t rfc2217_notify_linestate(const rfc2217_session_t *session, uint8_t line_state, uint8_t *frame);
+
+/**
+ * @brief 统计数据中需要转义的IAC字节数
+ *
+ * @param data
+ * @param len
+ * @return size_t
+ */
+size_t rfc2217_count_iac(const uint8_t *data, size_t len);
+
+/**
+ * @brief 复制数据并把IAC转义为两个IAC, dst至少len+rfc2217_count_iac()字节
+ *
+ * @param dst
+ * @param src
+ * @param len
+ * @return size_t 写入的字节数
+ */
+size_t rfc2217_escape_copy(uint8_t *dst, const uint8_t *src, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __RFC2217_H__
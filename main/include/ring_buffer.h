@@ -0,0 +1,126 @@
+#ifndef __RING_BUFFER_H__
+#define __RING_BUFFER_H__
+
+/**
+ * @file ring_buffer.h
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 单生产者/单消费者(SPSC)无锁字节环形缓冲区
+ * @version 0.1
+ * @date 2025-10-25
+ *
+ * 生产者只修改head, 消费者只修改tail, 不需要任何锁.
+ * 读写都以连续区间(span)为单位, 生产者可以直接把数据读入缓冲区,
+ * 消费者也可以直接把缓冲区中的数据发送出去, 避免中间拷贝.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint8_t *buffer;
+    size_t size;            // 缓冲区大小, 必须是2的幂
+    atomic_size_t head;     // 写位置(只由生产者修改), 单调递增
+    atomic_size_t tail;     // 读位置(只由消费者修改), 单调递增
+} ring_buffer_t;
+
+/**
+ * @brief 初始化环形缓冲区
+ *
+ * @param rb 环形缓冲区
+ * @param buffer 缓冲区内存
+ * @param size 缓冲区大小, 必须是2的幂
+ * @return true 成功
+ * @return false 参数错误
+ */
+bool ring_buffer_init(ring_buffer_t *rb, uint8_t *buffer, size_t size);
+
+/**
+ * @brief 清空缓冲区, 只有在生产者和消费者都停止时才能调用
+ *
+ * @param rb
+ */
+void ring_buffer_reset(ring_buffer_t *rb);
+
+/**
+ * @brief 获取已使用的字节数
+ *
+ * @param rb
+ * @return size_t
+ */
+size_t ring_buffer_used(const ring_buffer_t *rb);
+
+/**
+ * @brief 获取空闲的字节数
+ *
+ * @param rb
+ * @return size_t
+ */
+size_t ring_buffer_free(const ring_buffer_t *rb);
+
+/**
+ * @brief (生产者)获取可写入的连续区间
+ *
+ * @param rb
+ * @param span 输出, 连续区间的起始地址
+ * @return size_t 连续区间的长度, 0表示缓冲区已满
+ */
+size_t ring_buffer_write_span(ring_buffer_t *rb, uint8_t **span);
+
+/**
+ * @brief (生产者)提交已写入的数据
+ *
+ * @param rb
+ * @param len 已写入的长度, 不能超过ring_buffer_write_span返回的长度
+ */
+void ring_buffer_commit(ring_buffer_t *rb, size_t len);
+
+/**
+ * @brief (消费者)获取可读取的连续区间
+ *
+ * @param rb
+ * @param span 输出, 连续区间的起始地址
+ * @return size_t 连续区间的长度, 0表示缓冲区为空
+ */
+size_t ring_buffer_read_span(ring_buffer_t *rb, const uint8_t **span);
+
+/**
+ * @brief (消费者)释放已处理的数据
+ *
+ * @param rb
+ * @param len 已处理的长度, 不能超过ring_buffer_read_span返回的长度
+ */
+void ring_buffer_consume(ring_buffer_t *rb, size_t len);
+
+/**
+ * @brief (生产者)在写位置之后offset处写入数据, 自动处理回绕, 写完后需要ring_buffer_commit
+ * 
+ * 用于写入不可分割的记录, 调用者需要先用ring_buffer_free确认空间足够.
+ *
+ * @param rb
+ * @param offset 相对写位置的偏移
+ * @param data
+ * @param len
+ */
+void ring_buffer_put(ring_buffer_t *rb, size_t offset, const void *data, size_t len);
+
+/**
+ * @brief (消费者)从读位置之后offset处复制数据, 自动处理回绕, 不释放空间
+ *
+ * @param rb
+ * @param offset 相对读位置的偏移
+ * @param data
+ * @param len 调用者需要先用ring_buffer_used确认数据足够
+ */
+void ring_buffer_peek(ring_buffer_t *rb, size_t offset, void *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __RING_BUFFER_H__
@@ -0,0 +1,95 @@
+#ifndef __TASK_MONITOR_H__
+#define __TASK_MONITOR_H__
+
+/**
+ * @file task_monitor.h
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 任务CPU占用和栈使用统计
+ * @version 0.1
+ * @date 2025-11-02
+ *
+ * 定时器每秒采样一次所有任务的运行时间, 按最近TASK_MONITOR_WINDOW_SEC秒的滑动窗口
+ * 计算每个任务的CPU占用. 采样缓冲区全部静态分配, 运行期间不申请内存.
+ * 需要开启CONFIG_FREERTOS_USE_TRACE_FACILITY和CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS.
+ */
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 最多统计的任务数, 超出的任务不显示
+#define TASK_MONITOR_MAX_TASKS      32
+// 滑动窗口长度(秒)
+#define TASK_MONITOR_WINDOW_SEC     5
+#define TASK_MONITOR_PERIOD_MS      1000
+
+typedef struct {
+    char name[configMAX_TASK_NAME_LEN];
+    UBaseType_t priority;
+    int8_t core;                    // -1表示不绑定核心
+    uint32_t stack_free;            // 启动以来最小剩余栈(字节)
+    uint16_t cpu_permille;          // 窗口内占用一个核心的千分比
+} task_monitor_task_t;
+
+typedef struct {
+    uint32_t window_ms;             // 实际的窗口长度, 刚启动时小于TASK_MONITOR_WINDOW_SEC
+    uint8_t cpu_usage;              // 所有核心的平均使用率(%)
+    uint8_t core_usage[portNUM_PROCESSORS];
+    uint8_t task_count;
+    task_monitor_task_t tasks[TASK_MONITOR_MAX_TASKS];
+} task_monitor_snapshot_t;
+
+// 某一时刻的运行时间计数, 用于测量一段时间内的CPU占用
+typedef struct {
+    configRUN_TIME_COUNTER_TYPE total;
+    configRUN_TIME_COUNTER_TYPE idle[portNUM_PROCESSORS];
+} task_monitor_mark_t;
+
+/**
+ * @brief 启动采样定时器
+ *
+ * @return esp_err_t
+ */
+esp_err_t task_monitor_start(void);
+
+/**
+ * @brief 获取最近一次采样的结果
+ *
+ * @param snapshot
+ * @return esp_err_t ESP_ERR_INVALID_STATE 还没有完成两次采样
+ */
+esp_err_t task_monitor_get_snapshot(task_monitor_snapshot_t *snapshot);
+
+/**
+ * @brief 获取最近一次采样的CPU使用率
+ *
+ * @return uint8_t 所有核心的平均使用率(%)
+ */
+uint8_t task_monitor_get_cpu_usage(void);
+
+/**
+ * @brief 记录当前的运行时间计数, 不依赖采样定时器
+ *
+ * @param mark
+ */
+void task_monitor_mark(task_monitor_mark_t *mark);
+
+/**
+ * @brief 从mark到现在所有核心非空闲时间的合计, 计数器回绕前(约71分钟)有效
+ *
+ * @param mark
+ * @return uint32_t 微秒
+ */
+uint32_t task_monitor_busy_us_since(const task_monitor_mark_t *mark);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __TASK_MONITOR_H__
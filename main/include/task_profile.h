@@ -0,0 +1,139 @@
+#ifndef __TASK_PROFILE_H__
+#define __TASK_PROFILE_H__
+
+/**
+ * @file task_profile.h
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 任务调度方案, 统一分配各任务的优先级和运行核心
+ * @version 0.1
+ * @date 2025-11-01
+ *
+ * 方案保存在NVS中, 重启后生效. 各模块创建任务时按角色查表,
+ * 不再各自写死优先级.
+ * 双核方案: 串口读取和TCP发送固定在核1, WiFi和lwIP在核0(见sdkconfig.esp32s3),
+ * 显示和命令行使用最低优先级, 不绑定核心.
+ */
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    TASK_PROFILE_DEFAULT = 0,       // 不绑定核心, 与单核相同
+    TASK_PROFILE_DUAL_CORE,         // 数据通路独占一个核心, 只在双核芯片上可用
+    TASK_PROFILE_MAX,
+} task_profile_t;
+
+typedef enum {
+    TASK_ROLE_UART_READER = 0,
+    TASK_ROLE_SENDER,
+    TASK_ROLE_TCP_SERVER,           // tcp_server组件只能指定优先级, raw引擎的任务同时绑核
+    TASK_ROLE_UDP_RX,
+    TASK_ROLE_DISPLAY,
+    TASK_ROLE_CLI,
+    TASK_ROLE_CAPTURE,              // 数据捕获输出
+    TASK_ROLE_BENCH,                // 回环测试的本地客户端
+    TASK_ROLE_METRICS,              // 统计导出的HTTP服务
+    TASK_ROLE_MAX,
+} task_role_t;
+
+typedef struct {
+    UBaseType_t priority;
+    BaseType_t core;                // tskNO_AFFINITY表示不绑定
+} task_placement_t;
+
+/**
+ * @brief 从NVS加载调度方案, 需要在创建任何任务之前调用
+ *
+ * @return esp_err_t
+ */
+esp_err_t task_profile_init(void);
+
+/**
+ * @brief 当前生效的调度方案
+ *
+ * @return task_profile_t
+ */
+task_profile_t task_profile_get_active(void);
+
+/**
+ * @brief 保存调度方案, 重启后生效
+ *
+ * @param profile
+ * @return esp_err_t ESP_ERR_NOT_SUPPORTED 单核芯片不支持双核方案
+ */
+esp_err_t task_profile_set(task_profile_t profile);
+
+/**
+ * @brief 获取保存的调度方案(重启后生效的方案)
+ *
+ * @return task_profile_t
+ */
+task_profile_t task_profile_get_saved(void);
+
+/**
+ * @brief 获取某个角色在当前方案下的优先级和核心
+ *
+ * @param role
+ * @return const task_placement_t*
+ */
+const task_placement_t *task_profile_placement(task_role_t role);
+
+/**
+ * @brief 按角色创建任务
+ *
+ * @param task
+ * @param name
+ * @param stack_size
+ * @param arg
+ * @param role
+ * @param handle
+ * @return BaseType_t 与xTaskCreate相同
+ */
+BaseType_t task_profile_create(TaskFunction_t task, const char *name, uint32_t stack_size,
+                               void *arg, task_role_t role, TaskHandle_t *handle);
+
+/**
+ * @brief 按角色创建常驻任务, 开启静态内存时栈和任务控制块从内存区分配
+ *
+ * 内存区中的栈不会回收, 只用于启动时创建, 之后不会删除的任务.
+ * 没有开启或内存区放不下时与task_profile_create相同.
+ *
+ * @param task
+ * @param name
+ * @param stack_size
+ * @param arg
+ * @param role
+ * @param handle
+ * @return BaseType_t 与xTaskCreate相同
+ */
+BaseType_t task_profile_create_static(TaskFunction_t task, const char *name, uint32_t stack_size,
+                                      void *arg, task_role_t role, TaskHandle_t *handle);
+
+/**
+ * @brief 方案名称
+ *
+ * @param profile
+ * @return const char*
+ */
+const char *task_profile_name(task_profile_t profile);
+
+/**
+ * @brief 角色名称
+ *
+ * @param role
+ * @return const char*
+ */
+const char *task_role_name(task_role_t role);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __TASK_PROFILE_H__
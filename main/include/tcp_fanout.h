@@ -0,0 +1,265 @@
+#ifndef __TCP_FANOUT_H__
+#define __TCP_FANOUT_H__
+
+/**
+ * @file tcp_fanout.h
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief TCP多客户端分发, 每个客户端独立的有界发送队列
+ * @version 0.1
+ * @date 2025-10-26
+ *
+ * 每个串口数据块只拷贝一次, 以引用计数的方式挂到所有客户端的发送队列上.
+ * 发送使用非阻塞方式, 一个慢客户端不会阻塞其它客户端.
+ * 发送, 设置连接参数和断开通过tcp_fanout_io_t完成, 同时支持socket和lwIP raw两种服务器.
+ * 开启静态内存时, 数据块从固定大小的块池中获取, 串口数据按块大小拆分后广播.
+ */
+
+#include "esp_err.h"
+#include "tcp_server.h"
+#include "uart_bridge.h"
+#include "perf_metrics.h"
+#include "mem_arena.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 每个客户端队列最多挂载的数据块数量
+#define TCP_FANOUT_QUEUE_LEN        16
+// 静态内存下块池中每个数据块的最大数据长度
+#define TCP_FANOUT_POOL_BLOCK_SIZE  512
+
+/**
+ * @brief 引用计数的数据块, 所有客户端共享
+ */
+typedef struct {
+    atomic_int refs;
+    mem_pool_t *pool;           // 来自块池时归还到这里, NULL表示堆内存
+    uint16_t len;
+    int64_t queued_us;          // 挂到客户端队列的时间(esp_timer), 0表示控制数据, 不统计延迟
+    uint8_t data[];
+} tcp_fanout_chunk_t;
+
+struct tcp_fanout_config;
+
+/**
+ * @brief 客户端连接的操作接口, 由TCP服务器实现
+ */
+typedef struct {
+    // 非阻塞发送数据块中[offset, offset + len)的部分, 返回接受的字节数, 0表示发送缓冲区满, -1表示连接出错.
+    // 实现可以用tcp_fanout_chunk_retain持有数据块直到发送完成, 不需要拷贝
+    int (*write)(tcp_client_t *client, tcp_fanout_chunk_t *chunk, uint16_t offset, uint16_t len);
+    void (*apply_opts)(tcp_client_t *client, const struct tcp_fanout_config *config);
+    // 主动断开, 连接关闭后由服务器的断开回调移除客户端
+    void (*close)(tcp_client_t *client);
+} tcp_fanout_io_t;
+
+// tcp_server组件的socket连接
+extern const tcp_fanout_io_t tcp_fanout_socket_io;
+
+/**
+ * @brief 客户端发送队列
+ */
+typedef struct {
+    bool used;
+    bool closing;               // 已经主动断开, 等待tcp_server回调移除
+    tcp_client_t *client;
+    char addr[40];
+    uint16_t port;
+    // 发送队列
+    tcp_fanout_chunk_t *queue[TCP_FANOUT_QUEUE_LEN];
+    uint8_t head;
+    uint8_t count;
+    uint16_t offset;            // 队首数据块已发送的字节数
+    uint32_t queued_bytes;
+    TickType_t stall_since;     // 队列非空且没有进展的起始时间
+    TickType_t connected_at;
+    TickType_t last_active;     // 最近一次发送有进展或收到数据的时间
+    // 统计
+    uint32_t tx_bytes;
+    uint32_t drop_bytes;
+    uint32_t drop_count;
+    uint32_t peak_queued_bytes;
+} tcp_fanout_slot_t;
+
+typedef struct tcp_fanout_config {
+    const tcp_fanout_io_t *io;  // NULL表示tcp_fanout_socket_io, 只在没有客户端时修改
+    uart_bridge_slow_client_policy_t policy;
+    uint32_t stall_timeout_ms;  // DISCONNECT策略下, 停滞多久断开
+    uint32_t queue_bytes;       // 每个客户端最多排队的字节数
+    bool escape_iac;            // RFC2217模式, 广播的数据中0xFF转义为两个0xFF
+    bool nodelay;               // 客户端socket设置TCP_NODELAY
+    uint32_t user_timeout_ms;   // 任何策略下, 有数据待发送但停滞多久断开, 0表示不启用
+    uart_bridge_evict_policy_t evict_policy;
+    // 新连接和参数变化时设置到客户端socket
+    uint16_t keepalive_idle_s;  // 0表示不启用保活
+    uint16_t keepalive_intvl_s;
+    uint8_t keepalive_count;
+    uint32_t recv_buf;          // SO_RCVBUF, 0表示使用lwIP默认值
+} tcp_fanout_config_t;
+
+typedef struct {
+    tcp_fanout_config_t config;
+    SemaphoreHandle_t mutex;
+    tcp_fanout_slot_t slots[UART_BRIDGE_MAX_CLIENTS];
+    uint8_t client_num;
+    bool use_pool;              // 块池分配成功, 广播不再使用堆内存
+    mem_pool_t pool;
+} tcp_fanout_t;
+
+/**
+ * @brief 增加数据块的引用
+ *
+ * @param chunk
+ */
+void tcp_fanout_chunk_retain(tcp_fanout_chunk_t *chunk);
+
+/**
+ * @brief 释放数据块的引用, 最后一个引用释放时回收内存
+ *
+ * @param chunk
+ */
+void tcp_fanout_chunk_release(tcp_fanout_chunk_t *chunk);
+
+/**
+ * @brief 初始化分发器
+ *
+ * @param fanout
+ * @param config
+ * @return esp_err_t
+ */
+esp_err_t tcp_fanout_init(tcp_fanout_t *fanout, const tcp_fanout_config_t *config);
+
+/**
+ * @brief 反初始化分发器, 释放所有排队的数据
+ *
+ * @param fanout
+ */
+void tcp_fanout_deinit(tcp_fanout_t *fanout);
+
+/**
+ * @brief 更新慢客户端策略和socket参数, socket参数同时应用到已连接的客户端
+ *
+ * @param fanout
+ * @param config
+ */
+void tcp_fanout_set_config(tcp_fanout_t *fanout, const tcp_fanout_config_t *config);
+
+/**
+ * @brief 添加客户端, 在tcp_server连接回调中调用
+ *
+ * 没有空闲的队列时按evict_policy断开一个已有的客户端, 腾出队列给新客户端.
+ * 被断开的客户端立即从分发器移除, 之后tcp_server的断开回调找不到它, 直接返回.
+ *
+ * @param fanout
+ * @param client
+ * @param evicted 输出被断开的客户端, 没有时为NULL
+ * @return esp_err_t ESP_ERR_NO_MEM 没有空闲的队列
+ */
+esp_err_t tcp_fanout_add_client(tcp_fanout_t *fanout, tcp_client_t *client, tcp_client_t **evicted);
+
+/**
+ * @brief 收到客户端数据时调用, 更新最近活动时间
+ *
+ * @param fanout
+ * @param client
+ * @return true 客户端在分发器中
+ * @return false 客户端已经被断开或没有加入, 数据应该丢弃
+ */
+bool tcp_fanout_touch(tcp_fanout_t *fanout, tcp_client_t *client);
+
+/**
+ * @brief 移除客户端, 在tcp_server断开回调中调用
+ *
+ * @param fanout
+ * @param client
+ */
+void tcp_fanout_remove_client(tcp_fanout_t *fanout, tcp_client_t *client);
+
+/**
+ * @brief 移除所有客户端, 在停止tcp_server之前调用
+ *
+ * @param fanout
+ */
+void tcp_fanout_remove_all(tcp_fanout_t *fanout);
+
+/**
+ * @brief 获取客户端数量
+ *
+ * @param fanout
+ * @return uint8_t
+ */
+uint8_t tcp_fanout_client_count(tcp_fanout_t *fanout);
+
+/**
+ * @brief 所有客户端的发送队列是否都还能放下一个数据块, 不会触发丢弃
+ *
+ * @param fanout
+ * @param len 数据块长度(转义前)
+ * @return true 至少有一个客户端, 并且都能放下, 使用块池时还要有足够的空闲块
+ * @return false
+ */
+bool tcp_fanout_can_accept(tcp_fanout_t *fanout, size_t len);
+
+/**
+ * @brief 把数据挂到所有客户端的发送队列(只拷贝一次, 需要时在拷贝的同时转义)
+ *
+ * 使用块池时数据拆分为多个数据块, 没有空闲块时剩余的数据丢弃.
+ *
+ * @param fanout
+ * @param data
+ * @param len 不能超过UINT16_MAX
+ * @param drop_bytes 输出, 因队列满而丢弃的字节数(所有客户端合计)
+ * @return int 接收该数据块的客户端数量
+ */
+int tcp_fanout_broadcast(tcp_fanout_t *fanout, const uint8_t *data, size_t len, uint32_t *drop_bytes);
+
+/**
+ * @brief 把数据挂到指定客户端的发送队列, 用于协议回复, 不做转义
+ *
+ * @param fanout
+ * @param client
+ * @param data
+ * @param len
+ * @return esp_err_t ESP_ERR_NOT_FOUND 客户端不存在
+ */
+esp_err_t tcp_fanout_send_to(tcp_fanout_t *fanout, tcp_client_t *client, const uint8_t *data, size_t len);
+
+/**
+ * @brief 以非阻塞方式发送所有客户端队列中的数据
+ *
+ * @param fanout
+ * @param sent_bytes 输出, 本次发送成功的字节数(所有客户端合计)
+ * @param drop_bytes 输出, 因发送错误或断开而丢弃的字节数
+ * @param latency 数据块从入队到全部交给socket的延迟, 每个客户端记录一次, 可以为NULL
+ * @return true 仍有数据在排队
+ * @return false 所有队列已清空
+ */
+bool tcp_fanout_service(tcp_fanout_t *fanout, uint32_t *sent_bytes, uint32_t *drop_bytes, latency_hist_t *latency);
+
+/**
+ * @brief 获取所有客户端的统计信息
+ *
+ * @param fanout
+ * @param stats 统计信息数组
+ * @param count 输入数组大小, 输出实际数量
+ */
+void tcp_fanout_get_client_stats(tcp_fanout_t *fanout, uart_bridge_client_stats_t *stats, uint8_t *count);
+
+/**
+ * @brief 不加锁读取所有客户端的统计信息, 不会阻塞发送任务, 读到的是近似值
+ *
+ * @param fanout
+ * @param stats 统计信息数组
+ * @param count 输入数组大小, 输出实际数量
+ */
+void tcp_fanout_peek_client_stats(tcp_fanout_t *fanout, uart_bridge_client_stats_t *stats, uint8_t *count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __TCP_FANOUT_H__
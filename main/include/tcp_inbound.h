@@ -0,0 +1,223 @@
+#ifndef __TCP_INBOUND_H__
+#define __TCP_INBOUND_H__
+
+/**
+ * @file tcp_inbound.h
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief TCP到串口方向的客户端仲裁, 每个客户端独立的有界接收队列
+ * @version 0.1
+ * @date 2025-11-10
+ *
+ * 公平方式下, 接收回调只把数据放入客户端自己的队列, 发送任务按差额轮询(DRR)
+ * 每轮从每个客户端最多取TCP_INBOUND_QUANTUM字节写入串口, 一个大量发送的客户端
+ * 不会占满串口发送缓冲区, 其它客户端的命令最多等待一轮.
+ * 独占方式下, 只有最早连接的客户端可以写入串口, 其它客户端只接收数据.
+ *
+ * 队列只由接收回调写入, 发送任务读出; 写入串口时不持有锁, 断开后的队列由连接序号识别.
+ * 接收回调不等待队列空间: 放不下的数据丢弃, 或者留给调用者(raw引擎暂停这个连接的交付),
+ * 队列有空间后通过恢复回调通知调用者重新交付.
+ */
+
+#include "esp_err.h"
+#include "tcp_server.h"
+#include "uart_bridge.h"
+#include "perf_metrics.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 正在写入串口的队列不能立即分配给新客户端, 多留一个
+#define TCP_INBOUND_MAX_CLIENTS     (UART_BRIDGE_MAX_CLIENTS + 1)
+// 每个客户端的接收队列, 必须是2的幂
+#define TCP_INBOUND_QUEUE_BYTES     1024
+// 每轮每个客户端最多写入串口的字节数
+#define TCP_INBOUND_QUANTUM         256
+// 每个队列记录到达时间的数据段数, 超出时合并到最后一段
+#define TCP_INBOUND_MARKS           8
+
+typedef struct {
+    uint32_t end;               // 数据段结束时的累计写入位置
+    int64_t received_us;
+} tcp_inbound_mark_t;
+
+typedef struct {
+    tcp_client_t *client;       // NULL表示空闲
+    char addr[40];
+    uint16_t port;
+    uint32_t seq;               // 连接序号, 独占方式下序号最小的客户端写入串口
+    // 接收队列, 累计位置
+    uint32_t head;
+    uint32_t tail;
+    uint32_t deficit;           // 本轮还可以写入的字节数
+    tcp_inbound_mark_t marks[TCP_INBOUND_MARKS];
+    uint8_t mark_head;
+    uint8_t mark_count;
+    // 统计
+    uint32_t rx_bytes;
+    uint32_t drop_bytes;
+    uint32_t peak_queued_bytes;
+    uint32_t wait_last_us;
+    uint32_t wait_max_us;
+} tcp_inbound_slot_t;
+
+// 队列有空间时调用, 持有队列的锁, 不能阻塞
+typedef void (*tcp_inbound_resume_cb_t)(void *ctx);
+
+typedef struct {
+    SemaphoreHandle_t mutex;
+    tcp_inbound_resume_cb_t resume_cb;
+    void *resume_ctx;
+    bool held;                  // 有数据因队列满留给了调用者, 释放空间时调用resume_cb
+    uart_bridge_tx_arbiter_t mode;
+    uint8_t *pool;              // 公平方式下分配, TCP_INBOUND_MAX_CLIENTS个队列
+    tcp_inbound_slot_t slots[TCP_INBOUND_MAX_CLIENTS];
+    uint32_t next_seq;
+    uint8_t cursor;             // 轮询位置
+    int8_t busy;                // 发送任务正在写入串口的队列, -1表示没有
+    volatile uint32_t queued_bytes;
+} tcp_inbound_t;
+
+// 发送任务取出的一段连续数据
+typedef struct {
+    uint8_t index;
+    uint32_t seq;
+    const uint8_t *data;
+    size_t len;
+} tcp_inbound_span_t;
+
+/**
+ * @brief 初始化, 不分配队列
+ *
+ * @param inbound
+ * @return esp_err_t
+ */
+esp_err_t tcp_inbound_init(tcp_inbound_t *inbound);
+
+/**
+ * @brief 释放队列和锁
+ *
+ * @param inbound
+ */
+void tcp_inbound_deinit(tcp_inbound_t *inbound);
+
+/**
+ * @brief 设置仲裁方式, 排队中的数据丢弃
+ *
+ * 切换到公平方式时分配队列, 离开时释放(内存区中的队列保留), 调用者需要保证发送任务没有在读取队列.
+ *
+ * @param inbound
+ * @param mode
+ * @return esp_err_t ESP_ERR_NO_MEM 队列分配失败, 方式不变
+ */
+esp_err_t tcp_inbound_set_mode(tcp_inbound_t *inbound, uart_bridge_tx_arbiter_t mode);
+
+/**
+ * @brief 设置恢复回调, 传入NULL取消; 返回后不会再调用之前的回调
+ *
+ * @param inbound
+ * @param cb
+ * @param ctx
+ */
+void tcp_inbound_set_resume(tcp_inbound_t *inbound, tcp_inbound_resume_cb_t cb, void *ctx);
+
+/**
+ * @brief 添加客户端
+ *
+ * @param inbound
+ * @param client
+ */
+void tcp_inbound_add_client(tcp_inbound_t *inbound, tcp_client_t *client);
+
+/**
+ * @brief 移除客户端, 丢弃排队的数据, 通知留有数据的调用者
+ *
+ * @param inbound
+ * @param client
+ */
+void tcp_inbound_remove_client(tcp_inbound_t *inbound, tcp_client_t *client);
+
+/**
+ * @brief 移除所有客户端
+ *
+ * @param inbound
+ */
+void tcp_inbound_remove_all(tcp_inbound_t *inbound);
+
+/**
+ * @brief 直接写入或独占方式下, 判断客户端的数据是否可以写入串口, 同时统计接收字节数
+ *
+ * @param inbound
+ * @param client
+ * @param len
+ * @return true 可以写入
+ * @return false 不是独占的客户端, 数据计入丢弃
+ */
+bool tcp_inbound_admit(tcp_inbound_t *inbound, tcp_client_t *client, size_t len);
+
+/**
+ * @brief 公平方式下, 把数据放入客户端的队列
+ *
+ * @param inbound
+ * @param client
+ * @param data
+ * @param len
+ * @param now_us 收到数据的时间
+ * @param hold true: 队列满时放不下的部分留给调用者, 不计入接收和丢弃, 有空间后调用恢复回调;
+ *             false: 丢弃放不下的部分
+ * @param held 输出, 是否有数据留给了调用者, 可以为NULL. 客户端没有队列时数据总是丢弃
+ * @return size_t 放入队列的字节数
+ */
+size_t tcp_inbound_push(tcp_inbound_t *inbound, tcp_client_t *client, const uint8_t *data, size_t len,
+                        int64_t now_us, bool hold, bool *held);
+
+/**
+ * @brief 按轮询顺序取出下一段要写入串口的数据, 数据留在队列中直到tcp_inbound_consume
+ *
+ * @param inbound
+ * @param limit 最多取出的字节数
+ * @param span 输出
+ * @return true 有数据
+ * @return false 所有队列为空
+ */
+bool tcp_inbound_next(tcp_inbound_t *inbound, size_t limit, tcp_inbound_span_t *span);
+
+/**
+ * @brief 释放已经写入串口的数据, 记录每段数据的等待时间
+ *
+ * @param inbound
+ * @param span tcp_inbound_next取出的数据
+ * @param written 实际写入串口的字节数
+ * @param now_us
+ * @param latency 等待时间同时记录到直方图, 可以为NULL
+ */
+void tcp_inbound_consume(tcp_inbound_t *inbound, const tcp_inbound_span_t *span, size_t written,
+                         int64_t now_us, latency_hist_t *latency);
+
+/**
+ * @brief 是否有数据在排队, 不加锁
+ *
+ * @param inbound
+ * @return true
+ * @return false
+ */
+bool tcp_inbound_pending(const tcp_inbound_t *inbound);
+
+/**
+ * @brief 获取所有客户端的统计信息
+ *
+ * @param inbound
+ * @param stats 统计信息数组
+ * @param count 输入数组大小, 输出实际数量
+ */
+void tcp_inbound_get_stats(tcp_inbound_t *inbound, uart_bridge_inbound_stats_t *stats, uint8_t *count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __TCP_INBOUND_H__
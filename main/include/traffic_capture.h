@@ -0,0 +1,112 @@
+#ifndef __TRAFFIC_CAPTURE_H__
+#define __TRAFFIC_CAPTURE_H__
+
+/**
+ * @file traffic_capture.h
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 串口收发数据捕获, 替代转发路径上直接调用hex_dump
+ * @version 0.1
+ * @date 2025-11-03
+ *
+ * 转发路径只把带时间戳的记录追加到无锁环形缓冲区, 缓冲区满时丢弃并计数, 从不阻塞.
+ * 低优先级的捕获任务把记录按时间顺序输出到控制台(十六进制),
+ * 或者以pcap格式发给连接到捕获端口的TCP客户端(如 nc <IP> <端口> | wireshark -k -i -).
+ *
+ * 每个方向一个SPSC环形缓冲区, 同一时间只捕获一个桥接实例:
+ * 串口接收方向的生产者是该实例的发送任务, 串口发送方向的生产者是其TCP服务器或UDP接收任务.
+ *
+ * pcap链路类型为LINKTYPE_USER0(147), 每个报文前有2字节伪头: 实例序号, 方向(0=串口接收, 1=串口发送).
+ */
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 每个方向的捕获缓冲区大小, 必须是2的幂
+#define TRAFFIC_CAPTURE_RING_SIZE       (16 * 1024)
+// 每条记录最多保存的数据长度
+#define TRAFFIC_CAPTURE_MAX_RECORD      2048
+// 控制台输出默认截断长度, 避免输出太慢
+#define TRAFFIC_CAPTURE_CONSOLE_SNAPLEN 128
+// TCP捕获端口相对于桥接端口的偏移
+#define TRAFFIC_CAPTURE_PORT_OFFSET     100
+#define TRAFFIC_CAPTURE_STACK_SIZE      4096
+
+typedef enum {
+    TRAFFIC_DIR_UART_RX = 0,    // 串口收到, 发往网络
+    TRAFFIC_DIR_UART_TX,        // 网络收到, 写入串口
+    TRAFFIC_DIR_MAX,
+} traffic_dir_t;
+
+#define TRAFFIC_DIR_BIT(dir)    (1u << (dir))
+#define TRAFFIC_DIR_ALL         (TRAFFIC_DIR_BIT(TRAFFIC_DIR_UART_RX) | TRAFFIC_DIR_BIT(TRAFFIC_DIR_UART_TX))
+
+typedef enum {
+    TRAFFIC_SINK_CONSOLE = 0,
+    TRAFFIC_SINK_TCP,
+    TRAFFIC_SINK_MAX,
+} traffic_sink_t;
+
+typedef struct {
+    uint8_t source;             // 捕获的桥接实例序号
+    uint8_t dir_mask;           // TRAFFIC_DIR_BIT()组合
+    traffic_sink_t sink;
+    uint16_t tcp_port;          // TRAFFIC_SINK_TCP的监听端口
+    uint16_t snaplen;           // 每条记录最多保存的字节数, 0表示TRAFFIC_CAPTURE_MAX_RECORD
+} traffic_capture_config_t;
+
+typedef struct {
+    bool running;
+    bool client_connected;      // TCP输出时是否有客户端连接
+    traffic_capture_config_t config;
+    uint32_t records;           // 已输出的记录数
+    uint32_t bytes;             // 已输出的数据字节数(截断后)
+    uint32_t truncated;         // 被截断的记录数
+    uint32_t dropped_records;   // 缓冲区满丢弃的记录数
+    uint32_t dropped_bytes;
+} traffic_capture_stats_t;
+
+/**
+ * @brief 开始捕获, 已经在捕获时先停止
+ *
+ * @param config
+ * @return esp_err_t
+ */
+esp_err_t traffic_capture_start(const traffic_capture_config_t *config);
+
+/**
+ * @brief 停止捕获, 释放缓冲区
+ *
+ * @return esp_err_t
+ */
+esp_err_t traffic_capture_stop(void);
+
+/**
+ * @brief 获取捕获状态和计数
+ *
+ * @param stats
+ * @return esp_err_t
+ */
+esp_err_t traffic_capture_get_stats(traffic_capture_stats_t *stats);
+
+/**
+ * @brief (转发路径)追加一条记录, 没有在捕获该实例/方向时立即返回
+ *
+ * @param source 桥接实例序号
+ * @param dir
+ * @param data
+ * @param len
+ */
+void traffic_capture_record(uint8_t source, traffic_dir_t dir, const uint8_t *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __TRAFFIC_CAPTURE_H__
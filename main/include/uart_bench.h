@@ -0,0 +1,115 @@
+#ifndef __UART_BENCH_H__
+#define __UART_BENCH_H__
+
+/**
+ * @file uart_bench.h
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 串口内部回环测试, 在设备上测量吞吐量和延迟
+ * @version 0.1
+ * @date 2025-11-04
+ *
+ * 测试期间串口切换到内部回环, 数据经过真实的转发路径:
+ * TCP接收 -> send_data_to_uart -> 串口 -> 读取任务 -> 发送任务 -> TCP客户端.
+ *
+ * 本地客户端: 测试任务通过127.0.0.1连接桥接端口, 按设定的块大小和速率发送带序号和时间戳的数据块,
+ * 收回后计算往返延迟和丢失的块数.
+ * 外部客户端: 只打开回环并切换波特率, 由外部工具(如test/test_tcp.py -S)收发数据,
+ * 设备只统计转发计数和延迟.
+ *
+ * 测试会切换波特率并清零该实例的统计信息, 结束后恢复原来的波特率.
+ * 每个波特率同时记录每MB数据消耗的CPU时间, 用于比较不同的TCP服务器引擎.
+ */
+
+#include "uart_bridge.h"
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 最多测试的波特率数量
+#define UART_BENCH_MAX_STEPS        16
+// 数据块头: 标记(4) + 序号(4) + 发送时间(8)
+#define UART_BENCH_HEADER_LEN       16
+#define UART_BENCH_MIN_CHUNK        UART_BENCH_HEADER_LEN
+#define UART_BENCH_MAX_CHUNK        1024
+#define UART_BENCH_DEFAULT_CHUNK    256
+#define UART_BENCH_DEFAULT_SEC      5
+#define UART_BENCH_MAX_SEC          60
+// 自动速率为波特率对应字节速率的百分比
+#define UART_BENCH_AUTO_RATE_PERCENT 80
+#define UART_BENCH_STACK_SIZE       4096
+
+typedef enum {
+    UART_BENCH_CLIENT_LOCAL = 0,    // 设备自己作为TCP客户端收发
+    UART_BENCH_CLIENT_EXTERNAL,     // 外部客户端收发, 设备只打开回环
+    UART_BENCH_CLIENT_MAX,
+} uart_bench_client_t;
+
+typedef struct {
+    const uint32_t *baudrates;      // 依次测试的波特率
+    uint8_t baudrate_count;         // 最多UART_BENCH_MAX_STEPS
+    uint16_t chunk_size;            // 每个数据块的字节数(本地客户端)
+    uint32_t rate;                  // 发送速率(字节/秒), 0表示按波特率自动计算
+    uint16_t duration_sec;          // 每个波特率的测试时间
+    uart_bench_client_t client;
+} uart_bench_config_t;
+
+typedef struct {
+    uint32_t baudrate;
+    uint32_t duration_ms;           // 实际测试时间
+    uint32_t rate;                  // 设定的发送速率(字节/秒), 外部客户端为0
+    uint32_t tx_bytes;              // 发出的字节数(外部客户端为串口发送字节数)
+    uint32_t rx_bytes;              // 收回的字节数(外部客户端为串口接收字节数)
+    uint32_t throughput;            // 收回方向的持续速率(字节/秒)
+    uint32_t lost_chunks;           // 根据序号推算丢失的数据块
+    uint32_t corrupt_bytes;         // 无法识别而跳过的字节数
+    uint32_t uart_tx_drop_bytes;    // 转发路径上的丢弃计数, 来自桥接统计
+    uint32_t ring_overrun_bytes;
+    uint32_t fifo_overflows;
+    uint32_t tcp_drop_bytes;
+    uint32_t cpu_ms_per_mb;         // 每收回1MB数据所有任务(包括本地客户端)消耗的CPU时间, 所有核心合计
+    uart_bridge_latency_t latency;  // 本地客户端为往返延迟, 外部客户端为串口接收延迟
+} uart_bench_result_t;
+
+typedef struct {
+    bool running;
+    uint8_t bridge_index;
+    uint8_t step;                   // 正在测试的序号
+    uint8_t step_count;
+    uint8_t tcp_engine;             // 测试时的TCP服务器引擎, uart_bridge_tcp_engine_t
+    uart_bench_config_t config;
+    uart_bench_result_t results[UART_BENCH_MAX_STEPS];  // 前step个已完成
+} uart_bench_status_t;
+
+/**
+ * @brief 开始测试, 测试在后台任务中进行
+ *
+ * @param bridge 需要使用TCP传输方式, 并且网络服务已经就绪
+ * @param config
+ * @return esp_err_t ESP_ERR_INVALID_STATE 已经在测试或桥接服务未就绪
+ */
+esp_err_t uart_bench_start(uart_bridge_handle_t bridge, const uart_bench_config_t *config);
+
+/**
+ * @brief 停止测试, 等待测试任务恢复串口设置后返回
+ *
+ * @return esp_err_t
+ */
+esp_err_t uart_bench_stop(void);
+
+/**
+ * @brief 获取测试进度和已完成的结果
+ *
+ * @param status
+ * @return esp_err_t
+ */
+esp_err_t uart_bench_get_status(uart_bench_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UART_BENCH_H__
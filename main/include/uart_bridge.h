@@ -14,6 +14,8 @@
 
 #include "esp_err.h"
 #include "esp_types.h"
+#include "soc/soc_caps.h"
+#include "sdkconfig.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -25,116 +27,832 @@ extern "C" {
 #define UART_BRIDGE_BUFFER_SIZE        1024
 #define UART_BRIDGE_MAX_CLIENTS        5
 #define UART_BRIDGE_TASK_STACK_SIZE    4096
-#define UART_BRIDGE_TASK_PRIORITY      5
+
+// 缓冲区大小根据波特率自动计算, 以下是可以缓存的数据时长及上下限
+// 串口驱动收发缓冲区
+#define UART_BRIDGE_UART_BUF_MS        50
+#define UART_BRIDGE_UART_RX_BUF_MIN    256
+#define UART_BRIDGE_UART_TX_BUF_MIN    2048 // 至少能放下一个完整的TCP报文
+#define UART_BRIDGE_UART_BUF_MAX       (8 * 1024)
+// 串口接收环形缓冲区(必须是2的幂), 用于隔离串口读取和TCP发送
+#define UART_BRIDGE_RING_MS            500
+#define UART_BRIDGE_RING_MIN           (4 * 1024)
+#define UART_BRIDGE_RING_MAX           (32 * 1024)
+// 每次从串口驱动读取的最大长度
+#define UART_BRIDGE_READ_CHUNK_MIN     128
+#define UART_BRIDGE_READ_CHUNK_MAX     2048
+// 手动指定缓冲区大小时允许的上限
+#define UART_BRIDGE_BUF_OVERRIDE_MAX   (64 * 1024)
+// TCP发送任务每次发送的最大数据长度
+#define UART_BRIDGE_SEND_CHUNK_SIZE    2048
+#define UART_BRIDGE_SENDER_STACK_SIZE  4096
+#define UART_BRIDGE_TCP_STACK_SIZE     4096
+// 每个TCP客户端最多排队的字节数
+#define UART_BRIDGE_CLIENT_QUEUE_BYTES (8 * 1024)
+// 慢客户端默认停滞超时(DISCONNECT策略)
+#define UART_BRIDGE_DEFAULT_STALL_MS   3000
+// 客户端socket参数默认值, 空闲10秒后开始保活探测, 约16秒发现消失的客户端
+#define UART_BRIDGE_DEFAULT_KEEPALIVE_IDLE_S    10
+#define UART_BRIDGE_DEFAULT_KEEPALIVE_INTVL_S   2
+#define UART_BRIDGE_DEFAULT_KEEPALIVE_COUNT     3
+#define UART_BRIDGE_DEFAULT_USER_TIMEOUT_MS     30000
+// 客户端发送队列和SO_RCVBUF可以设置的范围
+#define UART_BRIDGE_SOCK_BUF_MIN       1024
+#define UART_BRIDGE_SOCK_BUF_MAX       (64 * 1024)
+// 断网缓存, 没有客户端时保存最近的串口数据, 有PSRAM时放在PSRAM中
+#define UART_BRIDGE_OUTAGE_BUF_MIN     1024
+#if CONFIG_SPIRAM
+#define UART_BRIDGE_OUTAGE_BUF_MAX     (4 * 1024 * 1024)
+#else
+#define UART_BRIDGE_OUTAGE_BUF_MAX     (32 * 1024)
+#endif
+
+// 串口接收分包默认参数, 满足任一条件即把数据交给TCP发送
+#define UART_BRIDGE_DEFAULT_RX_IDLE_CHARS   10   // 空闲间隔(字符时间), 即硬件接收超时
+#define UART_BRIDGE_DEFAULT_RX_FIFO_THRESH  120  // 硬件FIFO满中断阈值(字节)
+#define UART_BRIDGE_DEFAULT_RX_MAX_CHUNK    UART_BRIDGE_BUFFER_SIZE // 最大分包长度(字节)
+#define UART_BRIDGE_DEFAULT_RX_MAX_HOLD_MS  20   // 最长缓存时间(毫秒)
+// 硬件流控默认RTS阈值, 接收FIFO达到该字节数时拉高RTS
+#define UART_BRIDGE_DEFAULT_RTS_THRESH      100
+// 串口驱动事件队列长度
+#define UART_BRIDGE_EVENT_QUEUE_SIZE        20
+// Modbus网关默认参数
+#define UART_BRIDGE_DEFAULT_MODBUS_TIMEOUT_MS     1000
+#define UART_BRIDGE_DEFAULT_MODBUS_TURNAROUND_MS  100
+// 最多桥接实例数, UART0用作控制台
+#define UART_BRIDGE_MAX_INSTANCES           (SOC_UART_HP_NUM - 1)
+// 默认启用的实例数
+#define UART_BRIDGE_DEFAULT_INSTANCES       1
+
+// 桥接实例句柄, 每个实例有独立的串口/端口/缓冲区/统计和任务
+typedef struct uart_bridge *uart_bridge_handle_t;
+
+// 慢客户端处理策略(客户端发送队列满时)
+typedef enum {
+    UART_BRIDGE_SLOW_CLIENT_DROP_OLDEST = 0, // 丢弃最旧的数据
+    UART_BRIDGE_SLOW_CLIENT_DROP_NEWEST,     // 丢弃最新的数据
+    UART_BRIDGE_SLOW_CLIENT_DISCONNECT,      // 停滞超时后断开连接
+    UART_BRIDGE_SLOW_CLIENT_MAX,
+} uart_bridge_slow_client_policy_t;
+
+// 客户端已满时新连接的处理策略
+typedef enum {
+    UART_BRIDGE_EVICT_NONE = 0,     // 拒绝新连接
+    UART_BRIDGE_EVICT_OLDEST,       // 断开连接时间最早的客户端
+    UART_BRIDGE_EVICT_IDLEST,       // 断开最久没有收发数据的客户端
+    UART_BRIDGE_EVICT_MAX,
+} uart_bridge_evict_policy_t;
+
+// 客户端TCP_NODELAY设置
+typedef enum {
+    UART_BRIDGE_NODELAY_PROFILE = 0,    // 按链路方案
+    UART_BRIDGE_NODELAY_OFF,
+    UART_BRIDGE_NODELAY_ON,
+    UART_BRIDGE_NODELAY_MAX,
+} uart_bridge_nodelay_t;
+
+// 客户端socket参数, 每个桥接实例独立
+typedef struct {
+    uint8_t nodelay;            // uart_bridge_nodelay_t
+    uint8_t evict_policy;       // uart_bridge_evict_policy_t
+    uint16_t keepalive_idle_s;  // 空闲多久开始保活探测, 0表示不启用, 1-7200
+    uint16_t keepalive_intvl_s; // 保活探测间隔, 1-75
+    uint8_t keepalive_count;    // 保活探测失败多少次断开, 1-10
+    uint32_t user_timeout_ms;   // 有数据待发送但没有进展多久断开, 0表示不启用, 1000-600000
+    uint32_t send_buf;          // 每个客户端的发送队列, 0表示按链路方案
+    uint32_t recv_buf;          // SO_RCVBUF, 0表示使用lwIP默认值
+} uart_bridge_sock_opts_t;
+
+// TCP转串口策略(串口发送缓冲区满时)
+typedef enum {
+    UART_BRIDGE_UART_TX_DROP = 0,   // 丢弃放不下的数据
+    UART_BRIDGE_UART_TX_NO_DROP,    // 不丢弃, 暂停读取TCP数据, 由TCP接收窗口限制发送方
+    UART_BRIDGE_UART_TX_MAX,
+} uart_bridge_uart_tx_policy_t;
+
+// 多个TCP客户端写入串口时的仲裁方式, 只用于TCP传输方式
+typedef enum {
+    UART_BRIDGE_TX_ARBITER_DIRECT = 0, // 收到数据直接写入串口, 按到达顺序
+    UART_BRIDGE_TX_ARBITER_FAIR,       // 每个客户端独立的有界队列, 发送任务轮询写入串口
+    UART_BRIDGE_TX_ARBITER_EXCLUSIVE,  // 只有最早连接的客户端可以写入, 其它客户端只接收
+    UART_BRIDGE_TX_ARBITER_MAX,
+} uart_bridge_tx_arbiter_t;
+
+// 缓冲区大小, 0表示根据波特率自动计算
+typedef struct {
+    uint32_t uart_rx_size;      // 串口驱动接收缓冲区
+    uint32_t uart_tx_size;      // 串口驱动发送缓冲区
+    uint32_t ring_size;         // 串口接收环形缓冲区, 必须是2的幂
+} uart_bridge_buffer_sizes_t;
+
+// 缓冲区及内存占用信息
+typedef struct {
+    uart_bridge_buffer_sizes_t active;   // 当前使用的大小
+    uart_bridge_buffer_sizes_t override; // 用户指定的大小, 0表示自动
+    uint32_t read_chunk;                 // 每次从串口驱动读取的最大长度
+    uint32_t client_queue_bytes;         // 所有客户端发送队列最多占用的内存
+    uint32_t inbound_queue_bytes;        // 公平仲裁的客户端接收队列, 0表示未启用
+    uint32_t task_stack_bytes;           // 桥接相关任务栈
+    uint32_t outage_size;                // 断网缓存大小, 0表示未启用
+    uint32_t outage_used;                // 断网缓存中等待补发的字节数
+    bool outage_psram;                   // 断网缓存在PSRAM中, 不计入合计
+    uint32_t total_bytes;                // 合计(内部RAM)
+} uart_bridge_buffer_info_t;
+
+// 串口硬件流控模式
+typedef enum {
+    UART_BRIDGE_FLOW_CTRL_NONE = 0,
+    UART_BRIDGE_FLOW_CTRL_RTS_CTS,
+    UART_BRIDGE_FLOW_CTRL_MAX,
+} uart_bridge_flow_ctrl_t;
+
+// 串口接收分包配置
+typedef struct {
+    uint8_t idle_chars;         // 空闲间隔(字符时间), 1-100
+    uint8_t fifo_full_thresh;   // 硬件FIFO满中断阈值, 1-(FIFO长度-1)
+    uint16_t max_chunk;         // 最大分包长度, 1-UART_BRIDGE_SEND_CHUNK_SIZE
+    uint16_t max_hold_ms;       // 最长缓存时间, 1-1000
+} uart_bridge_rx_config_t;
+
+// 网络传输方式
+typedef enum {
+    UART_BRIDGE_TRANSPORT_TCP = 0,  // TCP服务器, 支持多个客户端
+    UART_BRIDGE_TRANSPORT_UDP,      // UDP, 一个分包一个数据报
+    UART_BRIDGE_TRANSPORT_RFC2217,  // TCP服务器, 使用RFC2217(Telnet COM-PORT-OPTION)协议
+    UART_BRIDGE_TRANSPORT_MODBUS,   // Modbus TCP服务器, 转换为Modbus RTU, 多个客户端的请求排队发到总线
+    UART_BRIDGE_TRANSPORT_MAX,
+} uart_bridge_transport_t;
+
+// 串口接收引擎
+typedef enum {
+    UART_BRIDGE_RX_ENGINE_DRIVER = 0,   // 串口驱动接收(中断逐段读出FIFO)
+    UART_BRIDGE_RX_ENGINE_DMA,          // UHCI/GDMA直接写入环形缓冲区
+    UART_BRIDGE_RX_ENGINE_MAX,
+} uart_bridge_rx_engine_t;
+
+// TCP服务器引擎
+typedef enum {
+    UART_BRIDGE_TCP_ENGINE_SOCKET = 0,  // tcp_server组件(socket)
+    UART_BRIDGE_TCP_ENGINE_RAW,         // lwIP raw API, 不经过socket层和mailbox
+    UART_BRIDGE_TCP_ENGINE_MAX,
+} uart_bridge_tcp_engine_t;
+
+// UDP传输配置
+typedef struct {
+    uint32_t peer_addr;         // 对端IPv4地址(网络字节序), 0表示发给最后一个发来数据的地址
+    uint16_t peer_port;         // 对端端口, 0表示与本地端口相同
+    uint8_t seq_header;         // 是否在数据报前添加4字节序号
+} uart_bridge_udp_config_t;
+
+// Modbus网关配置
+typedef struct {
+    uint16_t response_timeout_ms;   // 请求发送完成后等待回复的时间, 10-10000
+    uint16_t turnaround_ms;         // 广播请求后等待多久发下一个请求, 0-1000
+} uart_bridge_modbus_config_t;
+
+// Modbus网关统计
+typedef struct {
+    uint32_t requests;          // 发到总线的请求数, 包括广播
+    uint32_t responses;         // 转发给客户端的回复数
+    uint32_t broadcasts;        // 广播请求数(站号0, 没有回复)
+    uint32_t timeouts;          // 超时没有回复, 回复异常码0x0B
+    uint32_t crc_errors;        // CRC错误或长度错误的RTU帧
+    uint32_t unexpected;        // 没有等待中的请求, 或站号/功能码不匹配的RTU帧
+    uint32_t busy_rejects;      // 队列满, 回复异常码0x06
+    uint32_t malformed;         // MBAP头错误而丢弃的报文
+    uint32_t queue_peak;        // 最多同时排队的事务数
+} uart_bridge_modbus_stats_t;
 
 
 // TCP转串口桥接状态结构体
 typedef struct {
-    bool tcp_standby; // TCP服务是否就绪
+    bool tcp_standby; // 网络服务(TCP或UDP)是否就绪
     bool uart_opened; // 串口是否打开
     bool forwarding; // 是否转发数据
     uint32_t uart_baudrate; // 串口波特率
     uint16_t tcp_port;     // TCP端口
     uint16_t tcp_client_num; // TCP客户端数量
+    uint8_t transport;       // 网络传输方式, uart_bridge_transport_t
+    uint8_t rx_engine;       // 当前使用的串口接收引擎, uart_bridge_rx_engine_t
+    uint8_t tcp_engine;      // TCP服务器引擎, uart_bridge_tcp_engine_t
+    uint8_t index;           // 实例序号, 与串口ID相同
 }uart_bridge_status_t;
 
-// 统计信息结构体
+// 统计信息结构体, 只能包含uint64_t计数器
 typedef struct {
-    uint32_t uart_tx_bytes;     // 串口发送字节数
-    uint32_t uart_rx_bytes;     // 串口接收字节数
-    uint32_t uart_tx_drop_bytes;     // 串口发送丢弃字节数(缓冲区不可用)
-    //uint32_t uart_rx_drop_bytes;     // 串口接收丢弃字节数(缓冲区不可用)
-    uint32_t uart_tx_error_bytes;    // 串口发送错误字节数
-    //uint32_t uart_rx_error_bytes;    // 串口接收错误字节数
-    uint32_t tcp_tx_bytes;      // TCP发送字节数
-    uint32_t tcp_tx_error_bytes; // TCP发送错误字节数
-    uint32_t tcp_rx_bytes;      // TCP接收字节数  
-    //uint32_t tcp_rx_error_bytes; // TCP接收错误字节数
-    uint32_t tcp_connect_count; // TCP连接次数
-    uint32_t tcp_disconnect_count; // TCP断开次数
-    //uint32_t buffer_overflow;   // 缓冲区溢出次数
+    uint64_t uart_tx_bytes;     // 串口发送字节数
+    uint64_t uart_rx_bytes;     // 串口接收字节数
+    uint64_t uart_tx_drop_bytes;     // 串口发送丢弃字节数(缓冲区不可用)
+    //uint64_t uart_rx_drop_bytes;     // 串口接收丢弃字节数(缓冲区不可用)
+    uint64_t uart_tx_error_bytes;    // 串口发送错误字节数
+    uint64_t uart_tx_wait_count;     // 串口发送缓冲区满而等待的次数(NO_DROP策略), 包括公平方式下暂停交付的次数
+    uint64_t uart_tx_wait_ms;        // 串口发送缓冲区满而等待的总时间(NO_DROP策略)
+    //uint64_t uart_rx_error_bytes;    // 串口接收错误字节数
+    uint64_t tcp_tx_bytes;      // TCP发送字节数(所有客户端合计)
+    uint64_t tcp_tx_error_bytes; // TCP发送错误/丢弃字节数(所有客户端合计)
+    uint64_t tcp_rx_bytes;      // TCP接收字节数  
+    //uint64_t tcp_rx_error_bytes; // TCP接收错误字节数
+    uint64_t tcp_connect_count; // TCP连接次数
+    uint64_t tcp_disconnect_count; // TCP断开次数
+    uint64_t tcp_evict_count;   // 客户端已满时断开已有客户端的次数
+    uint64_t tcp_reject_count;  // 客户端已满时拒绝新连接的次数
+    //uint64_t buffer_overflow;   // 缓冲区溢出次数
+    uint64_t ring_high_water;   // 环形缓冲区最高使用量(字节)
+    uint64_t ring_overrun_count; // 环形缓冲区溢出次数
+    uint64_t ring_overrun_bytes; // 环形缓冲区溢出丢弃字节数
+    uint64_t uart_fifo_ovf_count;    // 串口硬件FIFO溢出次数
+    uint64_t uart_buffer_full_count; // 串口驱动接收缓冲区满次数
+    uint64_t rx_flush_idle_count;    // 因空闲间隔提交的分包数
+    uint64_t rx_flush_size_count;    // 因达到最大长度提交的分包数
+    uint64_t rx_flush_hold_count;    // 因达到最长缓存时间提交的分包数
+    uint64_t rx_mark_overflow_count; // 分包时间戳队列满的次数, 分帧方式下读取任务等待发送任务取走帧
+    uint64_t uart_rts_assert_count;  // 接收被节流(RTS拉高)的次数, 只在开启流控时统计
+    uint64_t uart_rts_assert_ms;     // 接收被节流(RTS拉高)的总时间
+    uint64_t udp_tx_datagrams;       // UDP发送数据报数
+    uint64_t udp_tx_bytes;           // UDP发送字节数(不含序号头)
+    uint64_t udp_tx_drop_count;      // 发送失败或没有对端而丢弃的数据报数
+    uint64_t udp_rx_datagrams;       // UDP接收数据报数
+    uint64_t udp_rx_bytes;           // UDP接收字节数(不含序号头)
+    uint64_t udp_rx_lost;            // 根据序号推算的丢失数据报数
+    uint64_t udp_rx_reordered;       // 乱序或重复的数据报数
+    uint64_t udp_rx_malformed;       // 比序号头还短的数据报数
+    uint64_t uart_rx_dma_count;      // 启动的DMA接收传输次数
+    uint64_t outage_buffered_bytes;  // 没有客户端时存入断网缓存的字节数
+    uint64_t outage_replayed_bytes;  // 客户端连接后补发的字节数
+    uint64_t outage_lost_bytes;      // 断网缓存满而覆盖的字节数
 } uart_bridge_stats_t;
 
+// 延迟统计点
+typedef enum {
+    UART_BRIDGE_LATENCY_UART_RX = 0,   // 串口收到数据 -> 挂到客户端发送队列(分包+环形缓冲区)
+    UART_BRIDGE_LATENCY_TCP_TX,        // 挂到客户端发送队列 -> 全部交给socket(WiFi/TCP)
+    UART_BRIDGE_LATENCY_UART_TX,       // TCP收到数据 -> 写入串口驱动完成
+    UART_BRIDGE_LATENCY_MAX,
+} uart_bridge_latency_point_t;
+
+// 延迟统计(微秒)
+typedef struct {
+    uint32_t count;
+    uint32_t p50_us;
+    uint32_t p95_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+} uart_bridge_latency_t;
+
+// 吞吐量统计(字节/秒)
+typedef struct {
+    uint32_t rate_1s;
+    uint32_t rate_10s;
+    uint32_t rate_60s;
+    uint32_t peak_1s;
+} uart_bridge_rate_t;
+
+// 性能统计
+typedef struct {
+    uart_bridge_latency_t latency[UART_BRIDGE_LATENCY_MAX];
+    uart_bridge_rate_t uart_to_tcp;    // 串口接收方向
+    uart_bridge_rate_t tcp_to_uart;    // 串口发送方向
+} uart_bridge_perf_t;
+
+// TCP客户端统计信息
+typedef struct {
+    char addr[40];              // 客户端地址
+    uint16_t port;              // 客户端端口
+    uint32_t tx_bytes;          // 发送成功字节数
+    uint32_t drop_bytes;        // 丢弃字节数
+    uint32_t drop_count;        // 丢弃次数
+    uint32_t queued_bytes;      // 当前排队字节数
+    uint32_t peak_queued_bytes; // 最大排队字节数
+    uint32_t stalled_ms;        // 当前已停滞的时间
+} uart_bridge_client_stats_t;
+
+// TCP客户端写入串口方向的统计信息
+typedef struct {
+    char addr[40];              // 客户端地址
+    uint16_t port;              // 客户端端口
+    bool owner;                 // 独占方式下是否是写入串口的客户端
+    uint32_t rx_bytes;          // 从客户端收到的字节数
+    uint32_t drop_bytes;        // 没有写入串口的字节数(队列满或不是独占的客户端)
+    uint32_t queued_bytes;      // 当前排队字节数, 只在公平方式下使用
+    uint32_t peak_queued_bytes; // 最大排队字节数
+    uint32_t wait_last_us;      // 最近一段数据从收到到写入串口的时间
+    uint32_t wait_max_us;       // 最长等待时间
+} uart_bridge_inbound_stats_t;
+
+
+/**
+ * @brief 初始化一个TCP转串口桥接实例
+ * 
+ * 实例序号与串口ID相同, 实例0的配置保存在原来的NVS命名空间中.
+ * 
+ * @param uart_id 串口ID, 见export_ids.h
+ * @param bridge 输出实例句柄, 可以为NULL
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_init(uint8_t uart_id, uart_bridge_handle_t *bridge);
+
+/**
+ * @brief 按NVS中保存的实例数初始化所有桥接实例
+ * 
+ * 第一个实例失败时返回错误, 其它实例失败时只记录日志.
+ * 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_init_all(void);
+
+/**
+ * @brief 获取桥接实例
+ * 
+ * @param index 实例序号, 0-(UART_BRIDGE_MAX_INSTANCES-1)
+ * @return uart_bridge_handle_t NULL表示该实例未初始化
+ */
+uart_bridge_handle_t uart_bridge_get(uint8_t index);
 
 /**
- * @brief 初始化TCP转串口桥接模块
+ * @brief 设置启动时创建的实例数, 保存到NVS, 重启后生效
  * 
+ * @param count 1-UART_BRIDGE_MAX_INSTANCES
  * @return esp_err_t 
  */
-esp_err_t uart_bridge_init(uint8_t port_id);
+esp_err_t uart_bridge_set_instance_count(uint8_t count);
+
+/**
+ * @brief 获取保存的实例数
+ * 
+ * @return uint8_t 
+ */
+uint8_t uart_bridge_get_instance_count(void);
+
+/**
+ * @brief 启动所有实例的网络服务
+ * 
+ * @return esp_err_t 第一个失败的错误码
+ */
+esp_err_t uart_bridge_start_all(void);
+
+/**
+ * @brief 停止所有实例的网络服务
+ */
+void uart_bridge_stop_all(void);
+
+/**
+ * @brief 实例状态变化回调, 在发生变化的任务中调用, 不能阻塞
+ *
+ * @param index 实例序号
+ * @param user_ctx
+ */
+typedef void (*uart_bridge_change_cb_t)(uint8_t index, void *user_ctx);
+
+/**
+ * @brief 设置状态变化回调, 客户端连接/断开, 网络服务停止和波特率变化时调用, 所有实例共用
+ *
+ * @param callback NULL表示取消
+ * @param user_ctx
+ */
+void uart_bridge_set_change_callback(uart_bridge_change_cb_t callback, void *user_ctx);
 
 /**
  * @brief 反初始化TCP转串口桥接模块
  * 
+ * @param bridge 
  * @return esp_err_t 
  */
-esp_err_t uart_bridge_deinit(void);
+esp_err_t uart_bridge_deinit(uart_bridge_handle_t bridge);
 
 /**
  * @brief 获取桥接状态
  * 
+ * @param bridge 
  * @param status 桥接状态结构体指针
  * @return esp_err_t 
  */
-esp_err_t uart_bridge_get_status(uart_bridge_status_t *status);
+esp_err_t uart_bridge_get_status(uart_bridge_handle_t bridge, uart_bridge_status_t *status);
 
 /**
  * @brief 获取统计信息
  * 
+ * @param bridge 
  * @param stats 统计信息结构体指针
  * @return esp_err_t 
  */
-esp_err_t uart_bridge_get_stats(uart_bridge_stats_t *stats);
+esp_err_t uart_bridge_get_stats(uart_bridge_handle_t bridge, uart_bridge_stats_t *stats);
+
+/**
+ * @brief 不加锁读取串口收发字节数, 用于频繁刷新的显示, 与重置统计同时调用时读到的是近似值
+ *
+ * @param bridge
+ * @param rx_bytes 输出, 同uart_rx_bytes
+ * @param tx_bytes 输出, 同uart_tx_bytes
+ * @return esp_err_t
+ */
+esp_err_t uart_bridge_get_traffic(uart_bridge_handle_t bridge, uint64_t *rx_bytes, uint64_t *tx_bytes);
+
+/**
+ * @brief 获取延迟和吞吐量统计, 由uart_bridge_reset_stats一起重置
+ * 
+ * @param bridge 
+ * @param perf 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_get_perf(uart_bridge_handle_t bridge, uart_bridge_perf_t *perf);
 
 /**
  * @brief 重置统计信息
  * 
+ * @param bridge 
  * @return esp_err_t 
  */
-esp_err_t uart_bridge_reset_stats(void);
+esp_err_t uart_bridge_reset_stats(uart_bridge_handle_t bridge);
 
 /**
  * @brief 从NVS加载配置
  * 
+ * @param bridge 
  * @param config 配置结构体指针
  * @return esp_err_t 
  */
-esp_err_t uart_bridge_set_baudrate(uint32_t baudrate);
+esp_err_t uart_bridge_set_baudrate(uart_bridge_handle_t bridge, uint32_t baudrate);
+
+
+/**
+ * @brief 指定缓冲区大小, 立即生效并保存到NVS
+ * 
+ * 字段为0表示根据波特率自动计算. 调整期间会短暂停止串口收发.
+ * 
+ * @param bridge 
+ * @param override 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_buffer_override(uart_bridge_handle_t bridge, const uart_bridge_buffer_sizes_t *override);
+
+/**
+ * @brief 设置断网缓存大小, 立即生效并保存到NVS
+ * 
+ * 没有TCP客户端(或网络服务已停止)时, 串口数据存入断网缓存, 满时覆盖最旧的数据;
+ * 客户端连接后先补发缓存的数据, 再发送新数据. 修改大小会丢弃缓存中的数据.
+ * 
+ * @param bridge 
+ * @param size 0表示不启用, UART_BRIDGE_OUTAGE_BUF_MIN-UART_BRIDGE_OUTAGE_BUF_MAX
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_outage_buffer(uart_bridge_handle_t bridge, uint32_t size);
+
+/**
+ * @brief 获取保存的断网缓存大小
+ * 
+ * @param bridge 
+ * @return uint32_t 
+ */
+uint32_t uart_bridge_get_outage_buffer(uart_bridge_handle_t bridge);
+
+/**
+ * @brief 获取缓冲区大小及内存占用
+ * 
+ * @param bridge 
+ * @param info 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_get_buffer_info(uart_bridge_handle_t bridge, uart_bridge_buffer_info_t *info);
+
+/**
+ * @brief 设置慢客户端处理策略, 并保存到NVS
+ * 
+ * @param bridge 
+ * @param policy 处理策略
+ * @param stall_timeout_ms DISCONNECT策略下, 停滞多久断开连接
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_slow_client_policy(uart_bridge_handle_t bridge, uart_bridge_slow_client_policy_t policy, uint32_t stall_timeout_ms);
+
+/**
+ * @brief 获取慢客户端处理策略
+ * 
+ * @param bridge 
+ * @param policy 
+ * @param stall_timeout_ms 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_get_slow_client_policy(uart_bridge_handle_t bridge, uart_bridge_slow_client_policy_t *policy, uint32_t *stall_timeout_ms);
 
+/**
+ * @brief 设置客户端socket参数, 并保存到NVS
+ * 
+ * 已连接的客户端立即使用新的参数. 开启或关闭断开策略时重新启动网络服务.
+ * 
+ * @param bridge 
+ * @param opts 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_sock_opts(uart_bridge_handle_t bridge, const uart_bridge_sock_opts_t *opts);
 
 /**
- * @brief 启动TCP服务器
+ * @brief 获取客户端socket参数
  * 
+ * @param bridge 
+ * @param opts 
  * @return esp_err_t 
  */
-esp_err_t uart_bridge_start_tcp_server(void);
+esp_err_t uart_bridge_get_sock_opts(uart_bridge_handle_t bridge, uart_bridge_sock_opts_t *opts);
 
 /**
- * @brief 停止TCP服务器
+ * @brief 设置TCP转串口策略, 并保存到NVS
  * 
+ * @param bridge 
+ * @param policy 
  * @return esp_err_t 
  */
-esp_err_t uart_bridge_stop_tcp_server(void);
+esp_err_t uart_bridge_set_uart_tx_policy(uart_bridge_handle_t bridge, uart_bridge_uart_tx_policy_t policy);
+
+/**
+ * @brief 获取TCP转串口策略
+ * 
+ * @param bridge 
+ * @return uart_bridge_uart_tx_policy_t 
+ */
+uart_bridge_uart_tx_policy_t uart_bridge_get_uart_tx_policy(uart_bridge_handle_t bridge);
+
+/**
+ * @brief 设置多个TCP客户端写入串口的仲裁方式, 立即生效并保存到NVS
+ * 
+ * 切换时排队中的数据丢弃. 公平方式下每个客户端的队列满时按TCP转串口策略处理:
+ * 丢弃放不下的数据, 或暂停读取该客户端的数据.
+ * 
+ * @param bridge 
+ * @param arbiter 
+ * @return esp_err_t ESP_ERR_NO_MEM 队列分配失败
+ */
+esp_err_t uart_bridge_set_tx_arbiter(uart_bridge_handle_t bridge, uart_bridge_tx_arbiter_t arbiter);
+
+/**
+ * @brief 获取多个TCP客户端写入串口的仲裁方式
+ * 
+ * @param bridge 
+ * @return uart_bridge_tx_arbiter_t 
+ */
+uart_bridge_tx_arbiter_t uart_bridge_get_tx_arbiter(uart_bridge_handle_t bridge);
+
+/**
+ * @brief 设置串口硬件流控, 立即生效并保存到NVS
+ * 
+ * @param bridge 
+ * @param mode 
+ * @param rts_thresh 接收FIFO达到该字节数时拉高RTS, 1-(FIFO长度-1)
+ * @return esp_err_t ESP_ERR_NOT_SUPPORTED 板子没有引出流控引脚
+ */
+esp_err_t uart_bridge_set_flow_ctrl(uart_bridge_handle_t bridge, uart_bridge_flow_ctrl_t mode, uint8_t rts_thresh);
+
+/**
+ * @brief 获取串口硬件流控设置
+ * 
+ * @param bridge 
+ * @param mode 
+ * @param rts_thresh 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_get_flow_ctrl(uart_bridge_handle_t bridge, uart_bridge_flow_ctrl_t *mode, uint8_t *rts_thresh);
+
+/**
+ * @brief 设置串口接收分包参数, 立即生效并保存到NVS
+ * 
+ * @param bridge 
+ * @param config 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_rx_config(uart_bridge_handle_t bridge, const uart_bridge_rx_config_t *config);
+
+/**
+ * @brief 获取串口接收分包参数
+ * 
+ * @param bridge 
+ * @param config 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_get_rx_config(uart_bridge_handle_t bridge, uart_bridge_rx_config_t *config);
+
+/**
+ * @brief 链路方案变化后, 重新应用客户端队列长度和TCP_NODELAY
+ * 
+ * @param bridge 
+ */
+void uart_bridge_refresh_link_profile(uart_bridge_handle_t bridge);
+
+/**
+ * @brief 设置网络传输方式并保存到NVS, 服务正在运行时立即切换
+ * 
+ * @param bridge 
+ * @param transport 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_transport(uart_bridge_handle_t bridge, uart_bridge_transport_t transport);
+
+/**
+ * @brief 获取网络传输方式
+ * 
+ * @param bridge 
+ * @return uart_bridge_transport_t 
+ */
+uart_bridge_transport_t uart_bridge_get_transport(uart_bridge_handle_t bridge);
+
+/**
+ * @brief 设置RTU分帧并保存到NVS, 立即生效
+ * 
+ * 开启后按3.5个字符的空闲间隔识别帧边界, 每个帧作为一个TCP段或UDP数据报发出,
+ * 不会被最大分包长度, 最长缓存时间或环形缓冲区回绕拆开. RFC2217方式下不使用,
+ * Modbus网关方式始终开启.
+ * 
+ * @param bridge 
+ * @param enable 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_rtu_framing(uart_bridge_handle_t bridge, bool enable);
+
+/**
+ * @brief 获取RTU分帧设置
+ * 
+ * @param bridge 
+ * @return true 
+ * @return false 
+ */
+bool uart_bridge_get_rtu_framing(uart_bridge_handle_t bridge);
+
+/**
+ * @brief 设置Modbus网关参数并保存到NVS, 下一个请求开始生效
+ * 
+ * @param bridge 
+ * @param config 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_modbus_config(uart_bridge_handle_t bridge, const uart_bridge_modbus_config_t *config);
+
+/**
+ * @brief 获取Modbus网关参数
+ * 
+ * @param bridge 
+ * @param config 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_get_modbus_config(uart_bridge_handle_t bridge, uart_bridge_modbus_config_t *config);
+
+/**
+ * @brief 获取Modbus网关统计, 由uart_bridge_reset_stats一起重置
+ * 
+ * @param bridge 
+ * @param stats 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_get_modbus_stats(uart_bridge_handle_t bridge, uart_bridge_modbus_stats_t *stats);
+
+/**
+ * @brief 设置UDP传输参数并保存到NVS, UDP正在运行时立即生效
+ * 
+ * @param bridge 
+ * @param config 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_udp_config(uart_bridge_handle_t bridge, const uart_bridge_udp_config_t *config);
+
+/**
+ * @brief 获取UDP传输参数
+ * 
+ * @param bridge 
+ * @param config 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_get_udp_config(uart_bridge_handle_t bridge, uart_bridge_udp_config_t *config);
+
+/**
+ * @brief 设置RFC2217客户端修改的串口参数是否保存到NVS
+ * 
+ * 不保存时, 参数只在当前连接期间有效, 最后一个客户端断开后恢复.
+ * 
+ * @param bridge 
+ * @param persist 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_rfc2217_persist(uart_bridge_handle_t bridge, bool persist);
+
+/**
+ * @brief 获取RFC2217客户端修改的串口参数是否保存
+ * 
+ * @param bridge 
+ * @return true 
+ * @return false 
+ */
+bool uart_bridge_get_rfc2217_persist(uart_bridge_handle_t bridge);
+
+/**
+ * @brief 设置串口接收引擎并保存到NVS, 重启后生效
+ * 
+ * @param bridge 
+ * @param engine 
+ * @return esp_err_t ESP_ERR_NOT_SUPPORTED 芯片不支持DMA接收
+ */
+esp_err_t uart_bridge_set_rx_engine(uart_bridge_handle_t bridge, uart_bridge_rx_engine_t engine);
+
+/**
+ * @brief 获取保存的串口接收引擎, 实际使用的引擎见uart_bridge_status_t
+ * 
+ * @param bridge 
+ * @return uart_bridge_rx_engine_t 
+ */
+uart_bridge_rx_engine_t uart_bridge_get_rx_engine(uart_bridge_handle_t bridge);
+
+/**
+ * @brief 设置TCP服务器引擎并保存到NVS, 服务正在运行时立即重新启动
+ * 
+ * @param bridge 
+ * @param engine 
+ * @return esp_err_t ESP_ERR_NOT_SUPPORTED 固件没有启用CONFIG_LWIP_TCPIP_CORE_LOCKING
+ */
+esp_err_t uart_bridge_set_tcp_engine(uart_bridge_handle_t bridge, uart_bridge_tcp_engine_t engine);
+
+/**
+ * @brief 获取TCP服务器引擎
+ * 
+ * @param bridge 
+ * @return uart_bridge_tcp_engine_t 
+ */
+uart_bridge_tcp_engine_t uart_bridge_get_tcp_engine(uart_bridge_handle_t bridge);
+
+/**
+ * @brief 获取所有TCP客户端的统计信息
+ * 
+ * @param bridge 
+ * @param stats 统计信息数组
+ * @param count 输入数组大小, 输出实际客户端数量
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_get_client_stats(uart_bridge_handle_t bridge, uart_bridge_client_stats_t *stats, uint8_t *count);
+
+/**
+ * @brief 不加锁获取所有TCP客户端的统计信息, 用于远程监控, 不影响转发
+ * 
+ * @param bridge 
+ * @param stats 统计信息数组
+ * @param count 输入数组大小, 输出实际客户端数量
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_peek_client_stats(uart_bridge_handle_t bridge, uart_bridge_client_stats_t *stats, uint8_t *count);
+
+/**
+ * @brief 获取所有TCP客户端写入串口方向的统计信息
+ * 
+ * @param bridge 
+ * @param stats 统计信息数组
+ * @param count 输入数组大小, 输出实际客户端数量
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_get_inbound_stats(uart_bridge_handle_t bridge, uart_bridge_inbound_stats_t *stats, uint8_t *count);
+
+/**
+ * @brief 启动网络服务, 根据传输方式启动TCP服务器或UDP
+ * 
+ * @param bridge 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_start_tcp_server(uart_bridge_handle_t bridge);
+
+/**
+ * @brief 停止网络服务(TCP服务器或UDP)
+ * 
+ * @param bridge 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_stop_tcp_server(uart_bridge_handle_t bridge);
 
 /**
  * @brief 设置TCP数据显示
  * 
+ * @param bridge 
  * @param tx_verbose 
  * @param rx_verbose 
  * @return true 
  * @return false 
  */
-bool uart_bridge_set_tcp_verbose(bool tx_verbose, bool rx_verbose);
+bool uart_bridge_set_tcp_verbose(uart_bridge_handle_t bridge, bool tx_verbose, bool rx_verbose);
 
 /**
  * @brief 设置串口数据显示
  * 
+ * @param bridge 
  * @param tx_verbose 
  * @param rx_verbose 
  * @return true 
  * @return false 
  */
-bool uart_bridge_set_uart_verbose(bool tx_verbose, bool rx_verbose);
+bool uart_bridge_set_uart_verbose(uart_bridge_handle_t bridge, bool tx_verbose, bool rx_verbose);
+
+/**
+ * @brief 设置串口内部回环(TXD接到RXD), 用于测试, 不保存
+ * 
+ * 开启后写入串口的数据直接回到接收方向, 外部引脚上的数据被忽略.
+ * 
+ * @param bridge 
+ * @param enable 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_loopback(uart_bridge_handle_t bridge, bool enable);
 
 
 #ifdef __cplusplus
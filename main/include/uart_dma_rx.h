@@ -0,0 +1,100 @@
+#ifndef __UART_DMA_RX_H__
+#define __UART_DMA_RX_H__
+
+/**
+ * @file uart_dma_rx.h
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 基于UHCI/GDMA的串口接收引擎
+ * @version 0.1
+ * @date 2025-10-31
+ *
+ * DMA直接把串口数据写入调用者提供的缓冲区(即接收环形缓冲区的空闲区间),
+ * 不再经过驱动的接收缓冲区和逐字节的中断处理.
+ * 中断回调只累计接收到的字节数并通知处理任务, 数据的提交由任务完成.
+ * 不支持UHCI的芯片上所有接口返回ESP_ERR_NOT_SUPPORTED, 调用者应使用driver/uart接收.
+ */
+
+#include "esp_err.h"
+#include "driver/uart.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "soc/soc_caps.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#if SOC_UHCI_SUPPORTED
+#include "driver/uhci.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 不使用UHCI发送, 只分配最小的发送链表
+#define UART_DMA_TX_UNUSED_SIZE 64
+// DMA链表覆盖的最大长度
+#define UART_DMA_RX_NODE_MEM    4096
+
+typedef struct {
+#if SOC_UHCI_SUPPORTED
+    uhci_controller_handle_t uhci;
+#endif
+    TaskHandle_t notify_task;   // 收到数据时通知的任务
+    atomic_size_t received;     // 当前传输已接收的字节数, 中断中累加
+    atomic_bool done;           // 当前传输已结束(空闲或缓冲区满)
+    size_t taken;               // 任务已取走的字节数
+    bool armed;                 // 是否有进行中的传输
+} uart_dma_rx_t;
+
+/**
+ * @brief 当前芯片是否支持DMA接收
+ *
+ * @return true
+ * @return false
+ */
+bool uart_dma_rx_supported(void);
+
+/**
+ * @brief 创建UHCI控制器并连接到串口
+ *
+ * 串口驱动可以继续用于发送, 但需要关闭驱动的接收中断.
+ *
+ * @param dma
+ * @param port
+ * @param notify_task
+ * @return esp_err_t ESP_ERR_NOT_SUPPORTED 芯片不支持
+ */
+esp_err_t uart_dma_rx_open(uart_dma_rx_t *dma, uart_port_t port, TaskHandle_t notify_task);
+
+/**
+ * @brief 删除UHCI控制器, 进行中的传输被放弃
+ *
+ * @param dma
+ */
+void uart_dma_rx_close(uart_dma_rx_t *dma);
+
+/**
+ * @brief 启动一次传输, 数据依次写入buffer
+ *
+ * @param dma
+ * @param buffer 必须是DMA可访问的内存
+ * @param size
+ * @return esp_err_t
+ */
+esp_err_t uart_dma_rx_arm(uart_dma_rx_t *dma, uint8_t *buffer, size_t size);
+
+/**
+ * @brief 取出上次调用以来新接收的字节数
+ *
+ * @param dma
+ * @param done 输出, 当前传输是否已结束, 结束后需要重新调用uart_dma_rx_arm
+ * @return size_t
+ */
+size_t uart_dma_rx_take(uart_dma_rx_t *dma, bool *done);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UART_DMA_RX_H__
@@ -0,0 +1,134 @@
+#ifndef __UDP_TRANSPORT_H__
+#define __UDP_TRANSPORT_H__
+
+/**
+ * @file udp_transport.h
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief UDP传输, 串口分包以数据报的形式发给对端
+ * @version 0.1
+ * @date 2025-10-29
+ *
+ * 对端可以是配置的固定地址, 也可以是最后一个发来数据的地址.
+ * 开启序号头时, 每个数据报前加4字节大端序号, 接收方据此统计丢包和乱序.
+ * 发送由桥接的发送任务调用, 接收在模块自己的任务中完成.
+ */
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "lwip/sockets.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 单个数据报的最大长度(以太网MTU减去IP/UDP头)
+#define UDP_TRANSPORT_MAX_DATAGRAM  1472
+// 序号头长度
+#define UDP_TRANSPORT_SEQ_HEADER_LEN 4
+// 数据报最大负载
+#define UDP_TRANSPORT_MAX_PAYLOAD   (UDP_TRANSPORT_MAX_DATAGRAM - UDP_TRANSPORT_SEQ_HEADER_LEN)
+// 序号跳变超过该值时认为对端重启, 重新同步而不计入丢包
+#define UDP_TRANSPORT_SEQ_RESYNC    1024
+
+#define UDP_TRANSPORT_STACK_SIZE    4096
+
+/**
+ * @brief 收到一个数据报时的附加信息
+ */
+typedef struct {
+    uint32_t lost;              // 根据序号推算的丢失数据报数
+    bool reordered;             // 序号比期望的小(乱序或重复)
+    bool malformed;             // 开启序号头时, 数据报比序号头还短
+} udp_transport_rx_info_t;
+
+/**
+ * @brief 接收回调, 在接收任务中调用
+ */
+typedef void (*udp_transport_recv_cb_t)(const uint8_t *data, size_t len,
+                                        const udp_transport_rx_info_t *info, void *user_ctx);
+
+typedef struct {
+    uint16_t port;              // 本地端口
+    uint32_t peer_addr;         // 对端IPv4地址(网络字节序), 0表示发给最后一个发来数据的地址
+    uint16_t peer_port;         // 对端端口, 0表示与本地端口相同
+    bool seq_header;            // 是否添加/解析序号头
+    udp_transport_recv_cb_t recv_callback;
+    void *user_ctx;
+    UBaseType_t task_priority;  // 接收任务优先级
+    BaseType_t task_core;       // 接收任务核心, tskNO_AFFINITY表示不绑定
+} udp_transport_config_t;
+
+typedef struct {
+    udp_transport_config_t config;
+    SemaphoreHandle_t mutex;    // 保护sock和peer, 发送任务和接收任务共用
+    int sock;
+    struct sockaddr_in peer;
+    bool peer_valid;
+    uint32_t tx_seq;            // 只由发送任务访问
+    uint32_t rx_expected_seq;   // 只由接收任务访问
+    bool rx_seq_synced;
+    volatile bool running;
+    TaskHandle_t task_handle;
+    uint8_t rx_buf[UDP_TRANSPORT_MAX_DATAGRAM];
+} udp_transport_t;
+
+/**
+ * @brief 初始化
+ *
+ * @param udp
+ * @return esp_err_t
+ */
+esp_err_t udp_transport_init(udp_transport_t *udp);
+
+/**
+ * @brief 释放资源, 调用前需要先停止
+ *
+ * @param udp
+ */
+void udp_transport_deinit(udp_transport_t *udp);
+
+/**
+ * @brief 创建套接字并启动接收任务
+ *
+ * @param udp
+ * @param config
+ * @return esp_err_t
+ */
+esp_err_t udp_transport_start(udp_transport_t *udp, const udp_transport_config_t *config);
+
+/**
+ * @brief 停止接收任务并关闭套接字
+ *
+ * @param udp
+ * @return esp_err_t
+ */
+esp_err_t udp_transport_stop(udp_transport_t *udp);
+
+/**
+ * @brief 是否正在运行
+ *
+ * @param udp
+ * @return true
+ * @return false
+ */
+bool udp_transport_is_running(const udp_transport_t *udp);
+
+/**
+ * @brief 发送一个数据报(非阻塞)
+ *
+ * @param udp
+ * @param data
+ * @param len 不超过UDP_TRANSPORT_MAX_PAYLOAD
+ * @return esp_err_t ESP_ERR_NOT_FOUND 还没有对端地址
+ */
+esp_err_t udp_transport_send(udp_transport_t *udp, const uint8_t *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UDP_TRANSPORT_H__
@@ -0,0 +1,115 @@
+#ifndef __WIFI_RESUME_H__
+#define __WIFI_RESUME_H__
+
+/**
+ * @file wifi_resume.h
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief WiFi短时断开时保留会话, 并用缓存的BSSID和信道快速重连
+ * @version 0.1
+ * @date 2025-11-06
+ *
+ * 断开后进入宽限期, 网络服务的监听端口和客户端连接都保留, 在宽限期内重新获取到
+ * 相同的IP时客户端不需要重连. 宽限期到期或IP变化时才关闭网络服务.
+ * 宽限期内桥接照常工作, 发往客户端的数据由各自的发送策略处理.
+ *
+ * 每次获取IP后记录当前AP的BSSID和信道(按SSID保存, 最多WIFI_RESUME_MAX_APS个),
+ * 断开后在STA配置中指定缓存的AP, wifi_station重连时不需要全信道扫描; 再次失败或连上AP后
+ * 清除指定的BSSID, 恢复正常扫描.
+ */
+
+#include "esp_err.h"
+#include "wifi_station.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 缓存BSSID和信道的网络数量, 超出时替换最久没有使用的
+#define WIFI_RESUME_MAX_APS             5
+#define WIFI_RESUME_DEFAULT_GRACE_SEC   15
+#define WIFI_RESUME_MAX_GRACE_SEC       300
+
+typedef struct {
+    uint32_t disconnects;           // 断开次数
+    uint32_t resumed;               // 宽限期内恢复, 会话保留
+    uint32_t expired;               // 宽限期到期或IP变化, 关闭了网络服务
+    uint32_t fast_attempts;         // 使用缓存的BSSID和信道重连的次数
+    uint32_t fast_hits;             // 快速重连成功的次数
+    uint32_t last_reconnect_ms;     // 最近一次断开到重新连接AP的时间
+    uint32_t max_reconnect_ms;
+    uint32_t last_outage_ms;        // 最近一次断开到重新获取IP的时间
+    uint32_t max_outage_ms;
+    bool in_outage;                 // 正在断开中
+    bool sessions_kept;             // 网络服务仍在宽限期内保留
+} wifi_resume_stats_t;
+
+/**
+ * @brief 加载宽限期设置和AP缓存, 需要在wifi_station_init之前调用
+ *
+ * @return esp_err_t
+ */
+esp_err_t wifi_resume_init(void);
+
+/**
+ * @brief WiFi连接AP后调用, 统计重连时间, 取消指定的BSSID
+ *
+ * @param status
+ */
+void wifi_resume_on_connected(const wifi_connection_status_t *status);
+
+/**
+ * @brief 获取IP后调用, 更新AP缓存和断开时长
+ *
+ * @param status
+ * @return true 宽限期内IP发生了变化, 保留的连接已经无效, 需要重新启动网络服务
+ * @return false
+ */
+bool wifi_resume_on_got_ip(const wifi_connection_status_t *status);
+
+/**
+ * @brief 断开后调用, 开始宽限期并指定快速重连的AP, 连接仍由wifi_station发起
+ *
+ * @param status
+ * @return true 网络服务在宽限期内保留, 到期后自动关闭
+ * @return false 宽限期为0, 需要立即关闭网络服务
+ */
+bool wifi_resume_on_disconnected(const wifi_connection_status_t *status);
+
+/**
+ * @brief 检查宽限期是否到期, 到期后关闭网络服务. 在主任务中每秒调用
+ *
+ * 关闭TCP服务器需要等待服务器任务退出, 不放在定时器回调中执行.
+ * 关闭期间WiFi事件回调在wifi_resume_on_connected中等待, 关闭完成后再启动服务.
+ */
+void wifi_resume_poll(void);
+
+/**
+ * @brief 设置宽限期并保存到NVS
+ *
+ * @param seconds 0表示断开后立即关闭网络服务
+ * @return esp_err_t
+ */
+esp_err_t wifi_resume_set_grace(uint16_t seconds);
+
+/**
+ * @brief 获取宽限期
+ *
+ * @return uint16_t
+ */
+uint16_t wifi_resume_get_grace(void);
+
+/**
+ * @brief 获取统计信息
+ *
+ * @param stats
+ * @return esp_err_t
+ */
+esp_err_t wifi_resume_get_stats(wifi_resume_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __WIFI_RESUME_H__
@@ -0,0 +1,212 @@
+/**
+ * @file link_profile.c
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 链路方案
+ * @version 0.1
+ * @date 2025-11-07
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "link_profile.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_wifi.h"
+#include "esp_pm.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+
+static const char *TAG = "link_profile";
+
+#define NVS_NAMESPACE       "link_profile"
+#define NVS_KEY_PROFILE     "profile"
+
+static const link_profile_params_t s_params[LINK_PROFILE_MAX] = {
+    [LINK_PROFILE_BALANCED] = {
+        .wifi_ps = WIFI_PS_MIN_MODEM,
+        .tcp_nodelay = false,
+        .client_queue_bytes = UART_BRIDGE_CLIENT_QUEUE_BYTES,
+        .rx = { UART_BRIDGE_DEFAULT_RX_IDLE_CHARS, UART_BRIDGE_DEFAULT_RX_FIFO_THRESH,
+                UART_BRIDGE_DEFAULT_RX_MAX_CHUNK, UART_BRIDGE_DEFAULT_RX_MAX_HOLD_MS },
+        .light_sleep = false,
+    },
+    [LINK_PROFILE_LOW_LATENCY] = {
+        // 每个小包立即发出, 队列短一些, 慢客户端尽早按策略处理
+        .wifi_ps = WIFI_PS_NONE,
+        .tcp_nodelay = true,
+        .client_queue_bytes = UART_BRIDGE_CLIENT_QUEUE_BYTES / 2,
+        .rx = { 2, 32, 256, 2 },
+        .light_sleep = false,
+    },
+    [LINK_PROFILE_THROUGHPUT] = {
+        // 保留Nagle算法, 让lwIP把小段合并成整包
+        .wifi_ps = WIFI_PS_NONE,
+        .tcp_nodelay = false,
+        .client_queue_bytes = UART_BRIDGE_CLIENT_QUEUE_BYTES * 2,
+        .rx = { 20, 120, UART_BRIDGE_SEND_CHUNK_SIZE, 50 },
+        .light_sleep = false,
+    },
+    [LINK_PROFILE_LOW_POWER] = {
+        // 浅睡眠要求WiFi工作在modem sleep模式
+        .wifi_ps = WIFI_PS_MAX_MODEM,
+        .tcp_nodelay = false,
+        .client_queue_bytes = UART_BRIDGE_CLIENT_QUEUE_BYTES,
+        .rx = { UART_BRIDGE_DEFAULT_RX_IDLE_CHARS, UART_BRIDGE_DEFAULT_RX_FIFO_THRESH,
+                UART_BRIDGE_DEFAULT_RX_MAX_CHUNK, 50 },
+        .light_sleep = true,
+    },
+};
+
+static const char *s_profile_names[LINK_PROFILE_MAX] = {
+    "balanced", "low-latency", "throughput", "low-power"
+};
+
+static const char *s_profile_short_names[LINK_PROFILE_MAX] = {
+    "BL", "LL", "TP", "LP"
+};
+
+static link_profile_t s_current = LINK_PROFILE_BALANCED;
+static bool s_sleep_active = false;
+
+static link_profile_t load_profile(void)
+{
+    uint8_t profile = LINK_PROFILE_BALANCED;
+    nvs_handle_t nvs_handle;
+
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) == ESP_OK) {
+        size_t required_size = sizeof(profile);
+        if (nvs_get_blob(nvs_handle, NVS_KEY_PROFILE, &profile, &required_size) != ESP_OK) {
+            profile = LINK_PROFILE_BALANCED;
+        }
+        nvs_close(nvs_handle);
+    }
+
+    if (profile >= LINK_PROFILE_MAX) {
+        profile = LINK_PROFILE_BALANCED;
+    }
+    return (link_profile_t)profile;
+}
+
+/**
+ * @brief 配置电源管理, 只在启动时调用
+ *
+ * 不需要浅睡眠时固定在默认频率, 避免动态调频增加串口和网络的延迟.
+ */
+static void configure_pm(bool light_sleep)
+{
+#if CONFIG_PM_ENABLE
+    const esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = light_sleep ? CONFIG_XTAL_FREQ : CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .light_sleep_enable = light_sleep,
+    };
+    esp_err_t ret = esp_pm_configure(&pm_config);
+    if (ret != ESP_OK) {
+        // 没有启用CONFIG_FREERTOS_USE_TICKLESS_IDLE时不支持浅睡眠
+        ESP_LOGW(TAG, "failed to configure power management: %s", esp_err_to_name(ret));
+        s_sleep_active = false;
+        return;
+    }
+    s_sleep_active = light_sleep;
+#else
+    if (light_sleep) {
+        ESP_LOGW(TAG, "light sleep requires CONFIG_PM_ENABLE");
+    }
+    s_sleep_active = false;
+#endif
+}
+
+esp_err_t link_profile_init(void)
+{
+    s_current = load_profile();
+    configure_pm(s_params[s_current].light_sleep);
+    ESP_LOGI(TAG, "link profile: %s, light sleep(%s)", s_profile_names[s_current], s_sleep_active ? "on" : "off");
+    return ESP_OK;
+}
+
+link_profile_t link_profile_get(void)
+{
+    return s_current;
+}
+
+const link_profile_params_t *link_profile_params(void)
+{
+    return &s_params[s_current];
+}
+
+bool link_profile_sleep_active(void)
+{
+    return s_sleep_active;
+}
+
+bool link_profile_reboot_pending(void)
+{
+    return s_params[s_current].light_sleep != s_sleep_active;
+}
+
+esp_err_t link_profile_apply_wifi(void)
+{
+    esp_err_t ret = esp_wifi_set_ps(s_params[s_current].wifi_ps);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "failed to set wifi power save: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+esp_err_t link_profile_set(link_profile_t profile)
+{
+    if (profile >= LINK_PROFILE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to open nvs namespace(%s)", esp_err_to_name(err));
+        return err;
+    }
+
+    const uint8_t value = (uint8_t)profile;
+    err = nvs_set_blob(nvs_handle, NVS_KEY_PROFILE, &value, sizeof(value));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    s_current = profile;
+    const link_profile_params_t *params = &s_params[profile];
+
+    // 分包参数保存在各实例的配置中, 队列长度和TCP_NODELAY从方案读取
+    for (uint8_t i = 0; i < UART_BRIDGE_MAX_INSTANCES; i++) {
+        uart_bridge_handle_t bridge = uart_bridge_get(i);
+        if (!bridge) {
+            continue;
+        }
+        esp_err_t ret = uart_bridge_set_rx_config(bridge, &params->rx);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "bridge(%d) failed to set rx config: %s", i, esp_err_to_name(ret));
+        }
+        uart_bridge_refresh_link_profile(bridge);
+    }
+
+    // WiFi还没有初始化时, 连接后再设置
+    link_profile_apply_wifi();
+
+    ESP_LOGI(TAG, "set link profile(%s)%s", s_profile_names[profile],
+             link_profile_reboot_pending() ? ", light sleep effective after reboot" : "");
+    return ESP_OK;
+}
+
+const char *link_profile_name(link_profile_t profile)
+{
+    return profile < LINK_PROFILE_MAX ? s_profile_names[profile] : "?";
+}
+
+const char *link_profile_short_name(link_profile_t profile)
+{
+    return profile < LINK_PROFILE_MAX ? s_profile_short_names[profile] : "?";
+}
@@ -0,0 +1,211 @@
+/**
+ * @file mem_arena.c
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 静态内存区
+ * @version 0.1
+ * @date 2025-11-11
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "mem_arena.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_system.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "mem_arena";
+
+// 按指针大小和64位计数器对齐
+#define ARENA_ALIGN     8
+
+typedef struct {
+    portMUX_TYPE lock;
+    size_t used;
+    uint32_t fallbacks;
+    uint32_t fallback_bytes;
+    uint8_t owner_count;
+    mem_arena_owner_t owners[MEM_ARENA_MAX_OWNERS];
+    uint8_t pool_count;
+    mem_pool_t *pools[MEM_ARENA_MAX_POOLS];
+} arena_state_t;
+
+#if MEM_ARENA_ENABLED
+// 放在.bss中, 启动时不从堆中分配
+static uint8_t s_arena[MEM_ARENA_SIZE] __attribute__((aligned(ARENA_ALIGN)));
+#endif
+
+static arena_state_t s_state = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static uint8_t *arena_base(void)
+{
+#if MEM_ARENA_ENABLED
+    return s_arena;
+#else
+    return NULL;
+#endif
+}
+
+/**
+ * @brief 按用途累计, 需要持有锁
+ */
+static void owner_add(const char *owner, size_t size)
+{
+    for (uint8_t i = 0; i < s_state.owner_count; i++) {
+        if (strcmp(s_state.owners[i].name, owner) == 0) {
+            s_state.owners[i].bytes += size;
+            return;
+        }
+    }
+
+    if (s_state.owner_count < MEM_ARENA_MAX_OWNERS) {
+        s_state.owners[s_state.owner_count].name = owner;
+        s_state.owners[s_state.owner_count].bytes = size;
+        s_state.owner_count++;
+    } else {
+        s_state.owners[MEM_ARENA_MAX_OWNERS - 1].name = "other";
+        s_state.owners[MEM_ARENA_MAX_OWNERS - 1].bytes += size;
+    }
+}
+
+void *mem_arena_alloc(size_t size, const char *owner)
+{
+    void *ptr = NULL;
+
+    if (!MEM_ARENA_ENABLED || size == 0) {
+        return NULL;
+    }
+
+    const size_t aligned = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    portENTER_CRITICAL(&s_state.lock);
+    if (aligned <= MEM_ARENA_SIZE - s_state.used) {
+        ptr = arena_base() + s_state.used;
+        s_state.used += aligned;
+        owner_add(owner, aligned);
+    } else {
+        s_state.fallbacks++;
+        s_state.fallback_bytes += size;
+    }
+    portEXIT_CRITICAL(&s_state.lock);
+
+    if (!ptr) {
+        ESP_LOGW(TAG, "arena full, %s(%u) needs heap", owner, (unsigned)size);
+    }
+    return ptr;
+}
+
+void *mem_arena_malloc(size_t size, const char *owner)
+{
+    void *ptr = mem_arena_alloc(size, owner);
+    return ptr ? ptr : malloc(size);
+}
+
+bool mem_arena_owns(const void *ptr)
+{
+    const uint8_t *base = arena_base();
+    return base && (const uint8_t *)ptr >= base && (const uint8_t *)ptr < base + MEM_ARENA_SIZE;
+}
+
+void mem_arena_free(void *ptr)
+{
+    if (ptr && !mem_arena_owns(ptr)) {
+        free(ptr);
+    }
+}
+
+esp_err_t mem_pool_init(mem_pool_t *pool, const char *name, size_t block_size, uint16_t count)
+{
+    if (!MEM_ARENA_ENABLED) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    memset(pool, 0, sizeof(mem_pool_t));
+    // 空闲块的开头存放下一个空闲块的指针
+    block_size = (block_size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    pool->base = mem_arena_alloc(block_size * count, name);
+    if (!pool->base) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    pool->name = name;
+    pool->block_size = block_size;
+    pool->count = count;
+    pool->lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+    for (int i = count - 1; i >= 0; i--) {
+        void *block = pool->base + (size_t)i * block_size;
+        *(void **)block = pool->free_list;
+        pool->free_list = block;
+    }
+
+    portENTER_CRITICAL(&s_state.lock);
+    if (s_state.pool_count < MEM_ARENA_MAX_POOLS) {
+        s_state.pools[s_state.pool_count++] = pool;
+    }
+    portEXIT_CRITICAL(&s_state.lock);
+    return ESP_OK;
+}
+
+void *mem_pool_get(mem_pool_t *pool)
+{
+    portENTER_CRITICAL(&pool->lock);
+    void *block = pool->free_list;
+    if (block) {
+        pool->free_list = *(void **)block;
+        pool->used++;
+        if (pool->used > pool->peak) {
+            pool->peak = pool->used;
+        }
+    } else {
+        pool->exhausted++;
+    }
+    portEXIT_CRITICAL(&pool->lock);
+    return block;
+}
+
+void mem_pool_put(mem_pool_t *pool, void *block)
+{
+    portENTER_CRITICAL(&pool->lock);
+    *(void **)block = pool->free_list;
+    pool->free_list = block;
+    pool->used--;
+    portEXIT_CRITICAL(&pool->lock);
+}
+
+uint16_t mem_pool_available(const mem_pool_t *pool)
+{
+    return pool->count - pool->used;
+}
+
+void mem_arena_get_info(mem_arena_info_t *info)
+{
+    memset(info, 0, sizeof(mem_arena_info_t));
+
+    portENTER_CRITICAL(&s_state.lock);
+    info->enabled = MEM_ARENA_ENABLED;
+    info->size = MEM_ARENA_SIZE;
+    info->used = s_state.used;
+    info->fallbacks = s_state.fallbacks;
+    info->fallback_bytes = s_state.fallback_bytes;
+    info->owner_count = s_state.owner_count;
+    memcpy(info->owners, s_state.owners, sizeof(info->owners));
+    info->pool_count = s_state.pool_count;
+    for (uint8_t i = 0; i < s_state.pool_count; i++) {
+        const mem_pool_t *pool = s_state.pools[i];
+        info->pools[i].name = pool->name;
+        info->pools[i].block_size = pool->block_size;
+        info->pools[i].count = pool->count;
+        info->pools[i].used = pool->used;
+        info->pools[i].peak = pool->peak;
+        info->pools[i].exhausted = pool->exhausted;
+    }
+    portEXIT_CRITICAL(&s_state.lock);
+
+    info->heap_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    info->heap_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    info->heap_largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+}
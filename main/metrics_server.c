@@ -0,0 +1,495 @@
+/**
+ * @file metrics_server.c
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 通过HTTP导出运行统计
+ * @version 0.1
+ * @date 2025-11-09
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "metrics_server.h"
+#include "uart_bridge.h"
+#include "task_monitor.h"
+#include "task_profile.h"
+#include "wifi_station.h"
+#include "wifi_resume.h"
+#include "esp_http_server.h"
+#include "esp_heap_caps.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "metrics";
+
+#define NVS_NAMESPACE       "metrics"
+#define NVS_KEY_PORT        "port"
+
+// 每次调用httpd_resp_send_chunk发送的最大长度
+#define METRICS_CHUNK_SIZE  1024
+#define METRICS_PREFIX      "uart2wifi_"
+
+typedef struct {
+    const char *name;
+    const char *help;
+    uint16_t offset;            // 在统计结构体中的偏移
+    bool gauge;
+} stat_metric_t;
+
+#define STAT_COUNTER(field, help)   { #field "_total", help, offsetof(uart_bridge_stats_t, field), false }
+#define STAT_GAUGE(field, help)     { #field, help, offsetof(uart_bridge_stats_t, field), true }
+
+static const stat_metric_t s_stat_metrics[] = {
+    STAT_COUNTER(uart_tx_bytes, "Bytes written to the UART"),
+    STAT_COUNTER(uart_rx_bytes, "Bytes read from the UART"),
+    STAT_COUNTER(uart_tx_drop_bytes, "Bytes dropped before the UART, buffer unavailable"),
+    STAT_COUNTER(uart_tx_error_bytes, "Bytes the UART driver failed to write"),
+    STAT_COUNTER(uart_tx_wait_count, "Waits for UART TX buffer or client queue space (no-drop policy)"),
+    STAT_COUNTER(uart_tx_wait_ms, "Milliseconds spent waiting for UART TX buffer space"),
+    STAT_COUNTER(uart_fifo_ovf_count, "UART hardware FIFO overflows"),
+    STAT_COUNTER(uart_buffer_full_count, "UART driver RX buffer full events"),
+    STAT_COUNTER(uart_rx_dma_count, "UART RX DMA transfers started"),
+    STAT_COUNTER(uart_rts_assert_count, "Times RTS throttled the sender"),
+    STAT_COUNTER(uart_rts_assert_ms, "Milliseconds with RTS asserted"),
+    STAT_COUNTER(rx_flush_idle_count, "RX packets flushed by the idle gap"),
+    STAT_COUNTER(rx_flush_size_count, "RX packets flushed by max chunk"),
+    STAT_COUNTER(rx_flush_hold_count, "RX packets flushed by max hold"),
+    STAT_COUNTER(rx_mark_overflow_count, "RX packet mark queue full events"),
+    STAT_GAUGE(ring_high_water, "RX ring buffer high water mark in bytes"),
+    STAT_COUNTER(ring_overrun_count, "RX ring buffer overruns"),
+    STAT_COUNTER(ring_overrun_bytes, "Bytes lost to RX ring buffer overruns"),
+    STAT_COUNTER(tcp_tx_bytes, "Bytes sent to TCP clients, all clients"),
+    STAT_COUNTER(tcp_tx_error_bytes, "Bytes dropped or failed towards TCP clients"),
+    STAT_COUNTER(tcp_rx_bytes, "Bytes received from TCP clients"),
+    STAT_COUNTER(tcp_connect_count, "TCP client connections"),
+    STAT_COUNTER(tcp_disconnect_count, "TCP client disconnections"),
+    STAT_COUNTER(tcp_evict_count, "TCP clients evicted to admit a new one"),
+    STAT_COUNTER(tcp_reject_count, "TCP connections rejected, server full"),
+    STAT_COUNTER(udp_tx_datagrams, "UDP datagrams sent"),
+    STAT_COUNTER(udp_tx_bytes, "UDP payload bytes sent"),
+    STAT_COUNTER(udp_tx_drop_count, "UDP datagrams dropped"),
+    STAT_COUNTER(udp_rx_datagrams, "UDP datagrams received"),
+    STAT_COUNTER(udp_rx_bytes, "UDP payload bytes received"),
+    STAT_COUNTER(udp_rx_lost, "UDP datagrams lost by sequence number"),
+    STAT_COUNTER(udp_rx_reordered, "UDP datagrams reordered or duplicated"),
+    STAT_COUNTER(udp_rx_malformed, "UDP datagrams shorter than the sequence header"),
+    STAT_COUNTER(outage_buffered_bytes, "Bytes stored in the outage buffer"),
+    STAT_COUNTER(outage_replayed_bytes, "Bytes replayed from the outage buffer"),
+    STAT_COUNTER(outage_lost_bytes, "Bytes overwritten in the outage buffer"),
+};
+
+// 每个客户端的计数, 都是uint32_t
+static const stat_metric_t s_client_metrics[] = {
+    { "client_tx_bytes_total", "Bytes sent to the client", offsetof(uart_bridge_client_stats_t, tx_bytes), false },
+    { "client_drop_bytes_total", "Bytes dropped for the client by the slow client policy",
+      offsetof(uart_bridge_client_stats_t, drop_bytes), false },
+    { "client_drop_total", "Drop events for the client", offsetof(uart_bridge_client_stats_t, drop_count), false },
+    { "client_queued_bytes", "Bytes waiting in the client send queue", offsetof(uart_bridge_client_stats_t, queued_bytes), true },
+    { "client_peak_queued_bytes", "Largest client send queue in bytes",
+      offsetof(uart_bridge_client_stats_t, peak_queued_bytes), true },
+    { "client_stalled_ms", "Time the client send queue has made no progress",
+      offsetof(uart_bridge_client_stats_t, stalled_ms), true },
+};
+
+static const char *s_transport_names[UART_BRIDGE_TRANSPORT_MAX] = {
+    "tcp", "udp", "rfc2217", "modbus-gw"
+};
+
+static const char *s_latency_names[UART_BRIDGE_LATENCY_MAX] = {
+    "uart_rx", "tcp_tx", "uart_tx"
+};
+
+static struct {
+    httpd_handle_t httpd;
+    uint16_t port;
+    uint32_t scrapes;
+} s_metrics;
+
+// 只在httpd任务中使用, 静态分配, 不占用httpd任务的栈
+static struct {
+    httpd_req_t *req;
+    esp_err_t err;
+    size_t len;
+    char buf[METRICS_CHUNK_SIZE];
+    uint8_t bridge_count;
+    uart_bridge_status_t status[UART_BRIDGE_MAX_INSTANCES];
+    uart_bridge_stats_t stats[UART_BRIDGE_MAX_INSTANCES];
+    uart_bridge_perf_t perf[UART_BRIDGE_MAX_INSTANCES];
+    uint8_t client_count[UART_BRIDGE_MAX_INSTANCES];
+    uart_bridge_client_stats_t clients[UART_BRIDGE_MAX_INSTANCES][UART_BRIDGE_MAX_CLIENTS];
+    task_monitor_snapshot_t tasks;
+} s_out;
+
+static void out_flush(void)
+{
+    if (s_out.err == ESP_OK && s_out.len > 0) {
+        s_out.err = httpd_resp_send_chunk(s_out.req, s_out.buf, s_out.len);
+    }
+    s_out.len = 0;
+}
+
+static void out_printf(const char *fmt, ...)
+{
+    va_list args;
+    int n;
+
+    if (s_out.err != ESP_OK) {
+        return;
+    }
+
+    va_start(args, fmt);
+    n = vsnprintf(s_out.buf + s_out.len, sizeof(s_out.buf) - s_out.len, fmt, args);
+    va_end(args);
+    if (n < 0) {
+        return;
+    }
+
+    if ((size_t)n >= sizeof(s_out.buf) - s_out.len) {
+        // 剩余空间放不下, 先发出已有的行再重新格式化
+        out_flush();
+        va_start(args, fmt);
+        n = vsnprintf(s_out.buf, sizeof(s_out.buf), fmt, args);
+        va_end(args);
+        if (n < 0) {
+            return;
+        }
+        if ((size_t)n >= sizeof(s_out.buf)) {
+            n = sizeof(s_out.buf) - 1;
+        }
+    }
+    s_out.len += n;
+}
+
+static void out_family(const char *name, const char *type, const char *help)
+{
+    out_printf("# HELP " METRICS_PREFIX "%s %s\n# TYPE " METRICS_PREFIX "%s %s\n", name, help, name, type);
+}
+
+static void write_system(void)
+{
+    out_family("uptime_seconds", "gauge", "Seconds since boot");
+    out_printf(METRICS_PREFIX "uptime_seconds %" PRId64 "\n", esp_timer_get_time() / 1000000);
+
+    out_family("heap_free_bytes", "gauge", "Free heap in bytes");
+    out_printf(METRICS_PREFIX "heap_free_bytes %" PRIu32 "\n", esp_get_free_heap_size());
+    out_family("heap_min_free_bytes", "gauge", "Lowest free heap since boot in bytes");
+    out_printf(METRICS_PREFIX "heap_min_free_bytes %" PRIu32 "\n", esp_get_minimum_free_heap_size());
+    out_family("heap_internal_free_bytes", "gauge", "Free internal RAM in bytes");
+    out_printf(METRICS_PREFIX "heap_internal_free_bytes %u\n",
+               (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    out_family("heap_largest_free_block_bytes", "gauge", "Largest allocatable internal block in bytes");
+    out_printf(METRICS_PREFIX "heap_largest_free_block_bytes %u\n",
+               (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+
+    if (task_monitor_get_snapshot(&s_out.tasks) != ESP_OK) {
+        return;
+    }
+
+    out_family("cpu_usage_percent", "gauge", "CPU usage averaged over all cores");
+    out_printf(METRICS_PREFIX "cpu_usage_percent %u\n", s_out.tasks.cpu_usage);
+
+    out_family("task_stack_free_bytes", "gauge", "Lowest free stack of the task since it started");
+    for (uint8_t i = 0; i < s_out.tasks.task_count; i++) {
+        out_printf(METRICS_PREFIX "task_stack_free_bytes{task=\"%s\"} %" PRIu32 "\n",
+                   s_out.tasks.tasks[i].name, s_out.tasks.tasks[i].stack_free);
+    }
+    out_family("task_cpu_permille", "gauge", "CPU time of the task in the sampling window, per mille of one core");
+    for (uint8_t i = 0; i < s_out.tasks.task_count; i++) {
+        out_printf(METRICS_PREFIX "task_cpu_permille{task=\"%s\"} %u\n",
+                   s_out.tasks.tasks[i].name, s_out.tasks.tasks[i].cpu_permille);
+    }
+}
+
+static void write_wifi(void)
+{
+    wifi_connection_status_t status;
+    if (wifi_station_get_status(&status) == ESP_OK) {
+        const bool connected = (status.state == WIFI_STATE_CONNECTED);
+        out_family("wifi_connected", "gauge", "1 when associated with an AP");
+        out_printf(METRICS_PREFIX "wifi_connected %d\n", connected ? 1 : 0);
+        if (connected) {
+            out_family("wifi_rssi_dbm", "gauge", "Signal strength of the current AP");
+            out_printf(METRICS_PREFIX "wifi_rssi_dbm %d\n", status.rssi);
+            out_family("wifi_connected_seconds", "gauge", "Seconds since the current connection was made");
+            out_printf(METRICS_PREFIX "wifi_connected_seconds %" PRIu32 "\n", status.connected_time);
+        }
+    }
+
+    wifi_resume_stats_t resume;
+    if (wifi_resume_get_stats(&resume) != ESP_OK) {
+        return;
+    }
+    out_family("wifi_disconnects_total", "counter", "WiFi disconnections");
+    out_printf(METRICS_PREFIX "wifi_disconnects_total %" PRIu32 "\n", resume.disconnects);
+    out_family("wifi_resumed_total", "counter", "Disconnections recovered within the grace period");
+    out_printf(METRICS_PREFIX "wifi_resumed_total %" PRIu32 "\n", resume.resumed);
+    out_family("wifi_expired_total", "counter", "Disconnections that closed the network services");
+    out_printf(METRICS_PREFIX "wifi_expired_total %" PRIu32 "\n", resume.expired);
+    out_family("wifi_fast_reconnect_attempts_total", "counter", "Reconnects using the cached BSSID and channel");
+    out_printf(METRICS_PREFIX "wifi_fast_reconnect_attempts_total %" PRIu32 "\n", resume.fast_attempts);
+    out_family("wifi_fast_reconnect_hits_total", "counter", "Successful reconnects using the cached BSSID and channel");
+    out_printf(METRICS_PREFIX "wifi_fast_reconnect_hits_total %" PRIu32 "\n", resume.fast_hits);
+    out_family("wifi_last_reconnect_ms", "gauge", "Last disconnect to AP association time");
+    out_printf(METRICS_PREFIX "wifi_last_reconnect_ms %" PRIu32 "\n", resume.last_reconnect_ms);
+    out_family("wifi_last_outage_ms", "gauge", "Last disconnect to IP time");
+    out_printf(METRICS_PREFIX "wifi_last_outage_ms %" PRIu32 "\n", resume.last_outage_ms);
+}
+
+static void collect_bridges(void)
+{
+    s_out.bridge_count = 0;
+    for (uint8_t i = 0; i < UART_BRIDGE_MAX_INSTANCES; i++) {
+        uart_bridge_handle_t bridge = uart_bridge_get(i);
+        const uint8_t n = s_out.bridge_count;
+        if (!bridge || uart_bridge_get_stats(bridge, &s_out.stats[n]) != ESP_OK) {
+            continue;
+        }
+        uart_bridge_get_status(bridge, &s_out.status[n]);
+        if (uart_bridge_get_perf(bridge, &s_out.perf[n]) != ESP_OK) {
+            memset(&s_out.perf[n], 0, sizeof(uart_bridge_perf_t));
+        }
+        s_out.client_count[n] = UART_BRIDGE_MAX_CLIENTS;
+        if (uart_bridge_peek_client_stats(bridge, s_out.clients[n], &s_out.client_count[n]) != ESP_OK) {
+            s_out.client_count[n] = 0;
+        }
+        s_out.bridge_count++;
+    }
+}
+
+static void write_bridges(void)
+{
+    // 同一个指标的所有样本必须连续输出, 所以先取出所有实例的数据
+    collect_bridges();
+
+    out_family("bridge_info", "gauge", "Bridge instance, the value is always 1");
+    for (uint8_t b = 0; b < s_out.bridge_count; b++) {
+        const uart_bridge_status_t *status = &s_out.status[b];
+        out_printf(METRICS_PREFIX "bridge_info{bridge=\"%u\",transport=\"%s\",port=\"%u\"} 1\n",
+                   status->index,
+                   status->transport < UART_BRIDGE_TRANSPORT_MAX ? s_transport_names[status->transport] : "?",
+                   status->tcp_port);
+    }
+    out_family("bridge_baudrate", "gauge", "UART baudrate");
+    for (uint8_t b = 0; b < s_out.bridge_count; b++) {
+        out_printf(METRICS_PREFIX "bridge_baudrate{bridge=\"%u\"} %" PRIu32 "\n",
+                   s_out.status[b].index, s_out.status[b].uart_baudrate);
+    }
+    out_family("bridge_forwarding", "gauge", "1 when the UART and the network service are both up");
+    for (uint8_t b = 0; b < s_out.bridge_count; b++) {
+        out_printf(METRICS_PREFIX "bridge_forwarding{bridge=\"%u\"} %d\n",
+                   s_out.status[b].index, s_out.status[b].forwarding ? 1 : 0);
+    }
+
+    for (size_t m = 0; m < sizeof(s_stat_metrics) / sizeof(s_stat_metrics[0]); m++) {
+        const stat_metric_t *metric = &s_stat_metrics[m];
+        out_family(metric->name, metric->gauge ? "gauge" : "counter", metric->help);
+        for (uint8_t b = 0; b < s_out.bridge_count; b++) {
+            const uint64_t value = *(const uint64_t *)((const uint8_t *)&s_out.stats[b] + metric->offset);
+            out_printf(METRICS_PREFIX "%s{bridge=\"%u\"} %" PRIu64 "\n", metric->name, s_out.status[b].index, value);
+        }
+    }
+
+    out_family("latency_seconds", "summary", "Forwarding latency since the last statistics reset");
+    for (uint8_t b = 0; b < s_out.bridge_count; b++) {
+        for (int i = 0; i < UART_BRIDGE_LATENCY_MAX; i++) {
+            const uart_bridge_latency_t *lat = &s_out.perf[b].latency[i];
+            out_printf(METRICS_PREFIX "latency_seconds{bridge=\"%u\",path=\"%s\",quantile=\"0.5\"} %.6f\n",
+                       s_out.status[b].index, s_latency_names[i], lat->p50_us / 1e6);
+            out_printf(METRICS_PREFIX "latency_seconds{bridge=\"%u\",path=\"%s\",quantile=\"0.95\"} %.6f\n",
+                       s_out.status[b].index, s_latency_names[i], lat->p95_us / 1e6);
+            out_printf(METRICS_PREFIX "latency_seconds{bridge=\"%u\",path=\"%s\",quantile=\"0.99\"} %.6f\n",
+                       s_out.status[b].index, s_latency_names[i], lat->p99_us / 1e6);
+            out_printf(METRICS_PREFIX "latency_seconds_sum{bridge=\"%u\",path=\"%s\"} %.6f\n",
+                       s_out.status[b].index, s_latency_names[i], lat->sum_us / 1e6);
+            out_printf(METRICS_PREFIX "latency_seconds_count{bridge=\"%u\",path=\"%s\"} %" PRIu32 "\n",
+                       s_out.status[b].index, s_latency_names[i], lat->count);
+        }
+    }
+    out_family("latency_max_seconds", "gauge", "Largest forwarding latency since the last statistics reset");
+    for (uint8_t b = 0; b < s_out.bridge_count; b++) {
+        for (int i = 0; i < UART_BRIDGE_LATENCY_MAX; i++) {
+            out_printf(METRICS_PREFIX "latency_max_seconds{bridge=\"%u\",path=\"%s\"} %.6f\n",
+                       s_out.status[b].index, s_latency_names[i], s_out.perf[b].latency[i].max_us / 1e6);
+        }
+    }
+
+    out_family("rate_bytes_per_second", "gauge", "Rolling throughput");
+    for (uint8_t b = 0; b < s_out.bridge_count; b++) {
+        const uart_bridge_rate_t *rates[2] = { &s_out.perf[b].uart_to_tcp, &s_out.perf[b].tcp_to_uart };
+        const char *directions[2] = { "uart_to_net", "net_to_uart" };
+        for (int d = 0; d < 2; d++) {
+            out_printf(METRICS_PREFIX "rate_bytes_per_second{bridge=\"%u\",direction=\"%s\",window=\"1s\"} %" PRIu32 "\n",
+                       s_out.status[b].index, directions[d], rates[d]->rate_1s);
+            out_printf(METRICS_PREFIX "rate_bytes_per_second{bridge=\"%u\",direction=\"%s\",window=\"10s\"} %" PRIu32 "\n",
+                       s_out.status[b].index, directions[d], rates[d]->rate_10s);
+            out_printf(METRICS_PREFIX "rate_bytes_per_second{bridge=\"%u\",direction=\"%s\",window=\"60s\"} %" PRIu32 "\n",
+                       s_out.status[b].index, directions[d], rates[d]->rate_60s);
+        }
+    }
+
+    out_family("clients", "gauge", "Connected TCP clients");
+    for (uint8_t b = 0; b < s_out.bridge_count; b++) {
+        out_printf(METRICS_PREFIX "clients{bridge=\"%u\"} %u\n", s_out.status[b].index, s_out.client_count[b]);
+    }
+
+    for (size_t m = 0; m < sizeof(s_client_metrics) / sizeof(s_client_metrics[0]); m++) {
+        const stat_metric_t *metric = &s_client_metrics[m];
+        out_family(metric->name, metric->gauge ? "gauge" : "counter", metric->help);
+        for (uint8_t b = 0; b < s_out.bridge_count; b++) {
+            for (uint8_t c = 0; c < s_out.client_count[b]; c++) {
+                const uart_bridge_client_stats_t *client = &s_out.clients[b][c];
+                const uint32_t value = *(const uint32_t *)((const uint8_t *)client + metric->offset);
+                out_printf(METRICS_PREFIX "%s{bridge=\"%u\",client=\"%s:%u\"} %" PRIu32 "\n",
+                           metric->name, s_out.status[b].index, client->addr, client->port, value);
+            }
+        }
+    }
+}
+
+static esp_err_t metrics_get_handler(httpd_req_t *req)
+{
+    // httpd只有一个任务, 同一时间只处理一个请求
+    s_out.req = req;
+    s_out.err = ESP_OK;
+    s_out.len = 0;
+
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+
+    write_system();
+    write_wifi();
+    write_bridges();
+    out_flush();
+
+    if (s_out.err != ESP_OK) {
+        ESP_LOGW(TAG, "failed to send metrics: %s", esp_err_to_name(s_out.err));
+        return s_out.err;
+    }
+    s_metrics.scrapes++;
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+static uint16_t load_port(void)
+{
+    uint16_t port = METRICS_SERVER_DEFAULT_PORT;
+    nvs_handle_t nvs_handle;
+
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) == ESP_OK) {
+        size_t required_size = sizeof(port);
+        if (nvs_get_blob(nvs_handle, NVS_KEY_PORT, &port, &required_size) != ESP_OK) {
+            port = METRICS_SERVER_DEFAULT_PORT;
+        }
+        nvs_close(nvs_handle);
+    }
+    return port;
+}
+
+static esp_err_t metrics_server_start(void)
+{
+    if (s_metrics.httpd || s_metrics.port == 0) {
+        return ESP_OK;
+    }
+
+    const task_placement_t *placement = task_profile_placement(TASK_ROLE_METRICS);
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = s_metrics.port;
+    config.task_priority = placement->priority;
+    config.core_id = placement->core;
+    config.stack_size = 4096;
+    // 抓取是顺序进行的, 一个连接就够了, 节省socket
+    config.max_open_sockets = 1;
+    config.max_uri_handlers = 1;
+    config.lru_purge_enable = true;
+
+    esp_err_t ret = httpd_start(&s_metrics.httpd, &config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "failed to start http server on port %u: %s", s_metrics.port, esp_err_to_name(ret));
+        s_metrics.httpd = NULL;
+        return ret;
+    }
+
+    const httpd_uri_t uri = {
+        .uri = "/metrics",
+        .method = HTTP_GET,
+        .handler = metrics_get_handler,
+        .user_ctx = NULL,
+    };
+    ret = httpd_register_uri_handler(s_metrics.httpd, &uri);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "failed to register handler: %s", esp_err_to_name(ret));
+        httpd_stop(s_metrics.httpd);
+        s_metrics.httpd = NULL;
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "metrics on http port %u", s_metrics.port);
+    return ESP_OK;
+}
+
+static void metrics_server_stop(void)
+{
+    if (s_metrics.httpd) {
+        httpd_stop(s_metrics.httpd);
+        s_metrics.httpd = NULL;
+    }
+}
+
+esp_err_t metrics_server_init(void)
+{
+    s_metrics.port = load_port();
+    return metrics_server_start();
+}
+
+esp_err_t metrics_server_set_port(uint16_t port)
+{
+    if (port == s_metrics.port) {
+        return ESP_OK;
+    }
+
+    for (uint8_t i = 0; i < UART_BRIDGE_MAX_INSTANCES; i++) {
+        uart_bridge_handle_t bridge = uart_bridge_get(i);
+        uart_bridge_status_t status;
+        if (port != 0 && bridge && uart_bridge_get_status(bridge, &status) == ESP_OK && status.tcp_port == port) {
+            // 与桥接实例的端口冲突
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to open nvs namespace(%s)", esp_err_to_name(err));
+        return err;
+    }
+
+    err = nvs_set_blob(nvs_handle, NVS_KEY_PORT, &port, sizeof(port));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    metrics_server_stop();
+    s_metrics.port = port;
+    ESP_LOGI(TAG, "set metrics port(%u)", port);
+    return metrics_server_start();
+}
+
+uint16_t metrics_server_get_port(void)
+{
+    return s_metrics.port;
+}
+
+uint32_t metrics_server_get_scrapes(void)
+{
+    return s_metrics.scrapes;
+}
@@ -0,0 +1,343 @@
+/**
+ * @file modbus_gw.c
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief Modbus TCP转Modbus RTU网关
+ * @version 0.1
+ * @date 2025-11-09
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "modbus_gw.h"
+#include <stdlib.h>
+#include <string.h>
+
+// MBAP长度字段: 站号 + PDU
+#define MBAP_LENGTH_MIN     2
+#define MBAP_LENGTH_MAX     (1 + 253)
+// 站号 + 功能码 + CRC
+#define RTU_FRAME_MIN       4
+
+uint16_t modbus_crc16(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? ((crc >> 1) ^ 0xA001) : (crc >> 1);
+        }
+    }
+    return crc;
+}
+
+esp_err_t modbus_gw_init(modbus_gw_t *gw)
+{
+    memset(gw, 0, sizeof(modbus_gw_t));
+    gw->rx = calloc(MODBUS_GW_MAX_CLIENTS, sizeof(modbus_gw_rx_t));
+    gw->queue = calloc(MODBUS_GW_QUEUE_LEN, sizeof(modbus_gw_txn_t));
+    if (!gw->rx || !gw->queue) {
+        modbus_gw_deinit(gw);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void modbus_gw_deinit(modbus_gw_t *gw)
+{
+    free(gw->rx);
+    free(gw->queue);
+    gw->rx = NULL;
+    gw->queue = NULL;
+    gw->count = 0;
+    gw->busy = false;
+}
+
+bool modbus_gw_ready(const modbus_gw_t *gw)
+{
+    return gw->rx != NULL && gw->queue != NULL;
+}
+
+void modbus_gw_set_timing(modbus_gw_t *gw, const uart_bridge_modbus_config_t *config, uint32_t baudrate)
+{
+    gw->response_timeout_ms = config->response_timeout_ms;
+    gw->turnaround_ms = config->turnaround_ms;
+    // 按11位计算(8E1或8N2), 不会低估发送时间
+    gw->char_us = baudrate ? (11 * 1000000 + baudrate - 1) / baudrate : 0;
+}
+
+void modbus_gw_reset(modbus_gw_t *gw)
+{
+    if (!modbus_gw_ready(gw)) {
+        return;
+    }
+    memset(gw->rx, 0, MODBUS_GW_MAX_CLIENTS * sizeof(modbus_gw_rx_t));
+    gw->head = 0;
+    gw->count = 0;
+    gw->busy = false;
+    gw->deadline_us = 0;
+}
+
+void modbus_gw_remove_client(modbus_gw_t *gw, tcp_client_t *client)
+{
+    if (!modbus_gw_ready(gw)) {
+        return;
+    }
+
+    for (int i = 0; i < MODBUS_GW_MAX_CLIENTS; i++) {
+        if (gw->rx[i].client == client) {
+            gw->rx[i].client = NULL;
+            gw->rx[i].len = 0;
+        }
+    }
+
+    // 已经发出的请求仍然等待回复或超时, 保证总线上的时序不变
+    for (uint8_t i = 0; i < gw->count; i++) {
+        modbus_gw_txn_t *txn = &gw->queue[(gw->head + i) % MODBUS_GW_QUEUE_LEN];
+        if (txn->client == client) {
+            txn->client = NULL;
+        }
+    }
+}
+
+static modbus_gw_rx_t *rx_find(modbus_gw_t *gw, tcp_client_t *client)
+{
+    modbus_gw_rx_t *idle = NULL;
+
+    for (int i = 0; i < MODBUS_GW_MAX_CLIENTS; i++) {
+        if (gw->rx[i].client == client) {
+            return &gw->rx[i];
+        }
+        if (!idle && gw->rx[i].client == NULL) {
+            idle = &gw->rx[i];
+        }
+    }
+
+    if (idle) {
+        idle->client = client;
+        idle->len = 0;
+    }
+    return idle;
+}
+
+/**
+ * @brief 生成MBAP头
+ *
+ * @param out 至少MODBUS_MBAP_LEN字节
+ * @param tid
+ * @param unit
+ * @param pdu_len
+ */
+static void mbap_header(uint8_t *out, uint16_t tid, uint8_t unit, size_t pdu_len)
+{
+    const uint16_t length = (uint16_t)(pdu_len + 1);
+
+    out[0] = (uint8_t)(tid >> 8);
+    out[1] = (uint8_t)tid;
+    out[2] = 0;
+    out[3] = 0;
+    out[4] = (uint8_t)(length >> 8);
+    out[5] = (uint8_t)length;
+    out[6] = unit;
+}
+
+static void reply_exception(tcp_client_t *client, uint16_t tid, uint8_t unit, uint8_t function, uint8_t code,
+                            const modbus_gw_ops_t *ops)
+{
+    uint8_t frame[MODBUS_MBAP_LEN + 2];
+
+    if (!client) {
+        return;
+    }
+    mbap_header(frame, tid, unit, 2);
+    frame[MODBUS_MBAP_LEN] = function | 0x80;
+    frame[MODBUS_MBAP_LEN + 1] = code;
+    ops->send_tcp(client, frame, sizeof(frame), ops->ctx);
+}
+
+/**
+ * @brief 完整的请求进入事务队列
+ *
+ * @param adu MBAP头 + PDU
+ */
+static void enqueue_request(modbus_gw_t *gw, tcp_client_t *client, const uint8_t *adu, size_t pdu_len,
+                            const modbus_gw_ops_t *ops)
+{
+    const uint16_t tid = ((uint16_t)adu[0] << 8) | adu[1];
+    const uint8_t unit = adu[6];
+    const uint8_t *pdu = adu + MODBUS_MBAP_LEN;
+
+    if (gw->count >= MODBUS_GW_QUEUE_LEN) {
+        gw->stats.busy_rejects++;
+        reply_exception(client, tid, unit, pdu[0], MODBUS_EXC_SERVER_BUSY, ops);
+        return;
+    }
+
+    modbus_gw_txn_t *txn = &gw->queue[(gw->head + gw->count) % MODBUS_GW_QUEUE_LEN];
+    txn->client = client;
+    txn->tid = tid;
+    txn->unit = unit;
+    txn->pdu_len = (uint8_t)pdu_len;
+    memcpy(txn->pdu, pdu, pdu_len);
+    gw->count++;
+    if (gw->count > gw->stats.queue_peak) {
+        gw->stats.queue_peak = gw->count;
+    }
+}
+
+void modbus_gw_tcp_input(modbus_gw_t *gw, tcp_client_t *client, const uint8_t *data, size_t len,
+                         const modbus_gw_ops_t *ops)
+{
+    if (!modbus_gw_ready(gw)) {
+        return;
+    }
+
+    modbus_gw_rx_t *rx = rx_find(gw, client);
+    if (!rx) {
+        return;
+    }
+
+    while (len > 0) {
+        const size_t n = (len < sizeof(rx->buf) - rx->len) ? len : (sizeof(rx->buf) - rx->len);
+        memcpy(rx->buf + rx->len, data, n);
+        rx->len += n;
+        data += n;
+        len -= n;
+
+        // 一个TCP段中可能有多个请求, 也可能只有半个
+        while (rx->len >= MODBUS_MBAP_LEN) {
+            const uint16_t protocol = ((uint16_t)rx->buf[2] << 8) | rx->buf[3];
+            const uint16_t length = ((uint16_t)rx->buf[4] << 8) | rx->buf[5];
+
+            if (protocol != 0 || length < MBAP_LENGTH_MIN || length > MBAP_LENGTH_MAX) {
+                // 无法再找到报文边界, 丢弃已缓存的数据
+                gw->stats.malformed++;
+                rx->len = 0;
+                break;
+            }
+
+            const size_t adu_len = 6 + length;
+            if (rx->len < adu_len) {
+                break;
+            }
+
+            enqueue_request(gw, client, rx->buf, length - 1, ops);
+            rx->len -= adu_len;
+            memmove(rx->buf, rx->buf + adu_len, rx->len);
+        }
+    }
+}
+
+/**
+ * @brief 释放队首的事务
+ */
+static void dequeue(modbus_gw_t *gw)
+{
+    gw->head = (gw->head + 1) % MODBUS_GW_QUEUE_LEN;
+    gw->count--;
+    gw->busy = false;
+}
+
+void modbus_gw_rtu_input(modbus_gw_t *gw, const uint8_t *frame, size_t len, int64_t now_us,
+                         const modbus_gw_ops_t *ops)
+{
+    if (!modbus_gw_ready(gw) || !gw->busy) {
+        gw->stats.unexpected++;
+        return;
+    }
+
+    if (len < RTU_FRAME_MIN || len > MODBUS_RTU_MAX_ADU) {
+        gw->stats.crc_errors++;
+        return;
+    }
+
+    const uint16_t crc = (uint16_t)frame[len - 2] | ((uint16_t)frame[len - 1] << 8);
+    if (modbus_crc16(frame, len - 2) != crc) {
+        // 继续等待, 从站可能重发, 否则按超时处理
+        gw->stats.crc_errors++;
+        return;
+    }
+
+    const modbus_gw_txn_t *txn = &gw->queue[gw->head];
+    if (frame[0] != txn->unit || (frame[1] & 0x7F) != txn->pdu[0]) {
+        gw->stats.unexpected++;
+        return;
+    }
+
+    // 站号 + PDU, 去掉CRC
+    const size_t pdu_len = len - 3;
+    if (txn->client) {
+        uint8_t reply[MODBUS_TCP_MAX_ADU];
+        mbap_header(reply, txn->tid, txn->unit, pdu_len);
+        memcpy(reply + MODBUS_MBAP_LEN, frame + 1, pdu_len);
+        ops->send_tcp(txn->client, reply, MODBUS_MBAP_LEN + pdu_len, ops->ctx);
+    }
+
+    gw->stats.responses++;
+    dequeue(gw);
+    // 回复之后的帧间隔已经由分包检测到, 可以立即发出下一个请求
+    gw->deadline_us = now_us;
+}
+
+/**
+ * @brief 发出队首的请求
+ */
+static void dispatch(modbus_gw_t *gw, int64_t now_us, const modbus_gw_ops_t *ops)
+{
+    const modbus_gw_txn_t *txn = &gw->queue[gw->head];
+    uint8_t frame[MODBUS_RTU_MAX_ADU];
+    const size_t len = 1 + txn->pdu_len;
+
+    frame[0] = txn->unit;
+    memcpy(frame + 1, txn->pdu, txn->pdu_len);
+    const uint16_t crc = modbus_crc16(frame, len);
+    frame[len] = (uint8_t)crc;
+    frame[len + 1] = (uint8_t)(crc >> 8);
+    ops->send_rtu(frame, len + 2, ops->ctx);
+    gw->stats.requests++;
+
+    // 超时从请求发送完成开始计算
+    const int64_t tx_us = (int64_t)(len + 2) * gw->char_us;
+    if (txn->unit == 0) {
+        gw->stats.broadcasts++;
+        dequeue(gw);
+        gw->deadline_us = now_us + tx_us + (int64_t)gw->turnaround_ms * 1000;
+        return;
+    }
+
+    gw->busy = true;
+    gw->deadline_us = now_us + tx_us + (int64_t)gw->response_timeout_ms * 1000;
+}
+
+uint32_t modbus_gw_poll(modbus_gw_t *gw, int64_t now_us, const modbus_gw_ops_t *ops)
+{
+    if (!modbus_gw_ready(gw)) {
+        return MODBUS_GW_NO_DEADLINE;
+    }
+
+    if (gw->busy && now_us >= gw->deadline_us) {
+        const modbus_gw_txn_t *txn = &gw->queue[gw->head];
+        gw->stats.timeouts++;
+        reply_exception(txn->client, txn->tid, txn->unit, txn->pdu[0], MODBUS_EXC_TARGET_NO_REPLY, ops);
+        dequeue(gw);
+        gw->deadline_us = now_us;
+    }
+
+    if (!gw->busy) {
+        // 发起请求的客户端已经断开
+        while (gw->count > 0 && gw->queue[gw->head].client == NULL) {
+            dequeue(gw);
+        }
+        if (gw->count > 0 && now_us >= gw->deadline_us) {
+            dispatch(gw, now_us, ops);
+        }
+    }
+
+    if (!gw->busy && gw->count == 0) {
+        return MODBUS_GW_NO_DEADLINE;
+    }
+
+    const int64_t remaining_us = gw->deadline_us - now_us;
+    return remaining_us > 0 ? (uint32_t)((remaining_us + 999) / 1000) : 0;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file outage_buffer.c
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 断网缓存, 没有客户端时保存最近的串口数据, 满时覆盖最旧的数据
+ * @version 0.1
+ * @date 2025-11-06
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "outage_buffer.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+esp_err_t outage_buffer_init(outage_buffer_t *ob, uint32_t size)
+{
+    memset(ob, 0, sizeof(*ob));
+    if (size == 0) {
+        return ESP_OK;
+    }
+
+#if CONFIG_SPIRAM
+    // 补发速度受网络限制, PSRAM的访问速度足够
+    ob->buffer = (uint8_t*) heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    ob->psram = (ob->buffer != NULL);
+#endif
+    if (!ob->buffer) {
+        ob->buffer = (uint8_t*) heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (!ob->buffer) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    ob->size = size;
+    return ESP_OK;
+}
+
+void outage_buffer_deinit(outage_buffer_t *ob)
+{
+    heap_caps_free(ob->buffer);
+    memset(ob, 0, sizeof(*ob));
+}
+
+uint32_t outage_buffer_write(outage_buffer_t *ob, const uint8_t *data, size_t len)
+{
+    uint32_t lost = 0;
+
+    if (ob->size == 0) {
+        return len;
+    }
+
+    // 比缓存还长时只保留最后的部分
+    if (len > ob->size) {
+        lost += len - ob->size;
+        data += len - ob->size;
+        len = ob->size;
+    }
+
+    // 覆盖最旧的数据
+    const uint32_t free_space = ob->size - ob->used;
+    if (len > free_space) {
+        const uint32_t overwrite = len - free_space;
+        ob->head = (ob->head + overwrite) % ob->size;
+        ob->used -= overwrite;
+        lost += overwrite;
+    }
+
+    uint32_t tail = (ob->head + ob->used) % ob->size;
+    const size_t first = MIN(len, ob->size - tail);
+    memcpy(ob->buffer + tail, data, first);
+    memcpy(ob->buffer, data + first, len - first);
+    ob->used += len;
+
+    return lost;
+}
+
+size_t outage_buffer_read_span(const outage_buffer_t *ob, const uint8_t **span)
+{
+    if (ob->used == 0) {
+        *span = NULL;
+        return 0;
+    }
+
+    *span = ob->buffer + ob->head;
+    return MIN(ob->used, ob->size - ob->head);
+}
+
+void outage_buffer_consume(outage_buffer_t *ob, size_t len)
+{
+    len = MIN(len, ob->used);
+    ob->head = (ob->head + len) % ob->size;
+    ob->used -= len;
+    if (ob->used == 0) {
+        // 清空后从头开始, 下次补发的第一段更长
+        ob->head = 0;
+    }
+}
@@ -0,0 +1,128 @@
+/**
+ * @file perf_metrics.c
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 延迟直方图和滚动吞吐量统计
+ * @version 0.1
+ * @date 2025-10-28
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "perf_metrics.h"
+#include <string.h>
+
+static int latency_bucket(uint32_t latency_us)
+{
+    int bucket = 0;
+    while (latency_us > 0 && bucket < LATENCY_HIST_BUCKETS - 1) {
+        latency_us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void latency_hist_reset(latency_hist_t *hist)
+{
+    memset(hist, 0, sizeof(latency_hist_t));
+}
+
+void latency_hist_record(latency_hist_t *hist, uint32_t latency_us)
+{
+    hist->buckets[latency_bucket(latency_us)]++;
+    hist->count++;
+    hist->sum_us += latency_us;
+    if (latency_us > hist->max_us) {
+        hist->max_us = latency_us;
+    }
+}
+
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint32_t percent)
+{
+    // 写入者可能正在更新, 以各个桶的合计为准
+    uint32_t buckets[LATENCY_HIST_BUCKETS];
+    uint32_t total = 0;
+
+    for (int i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        buckets[i] = hist->buckets[i];
+        total += buckets[i];
+    }
+
+    if (total == 0) {
+        return 0;
+    }
+
+    // 第rank个样本(从1开始)
+    uint64_t rank = ((uint64_t)total * percent + 99) / 100;
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint32_t seen = 0;
+    for (int i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        if (buckets[i] == 0) {
+            continue;
+        }
+
+        if (seen + buckets[i] >= rank) {
+            if (i == 0) {
+                return 0;
+            }
+
+            // 在桶内线性插值
+            uint32_t low = 1u << (i - 1);
+            uint32_t high = (i == LATENCY_HIST_BUCKETS - 1) ? hist->max_us : (1u << i);
+            if (high < low) {
+                high = low;
+            }
+            uint64_t offset = (uint64_t)(high - low) * (rank - seen) / buckets[i];
+            return low + (uint32_t)offset;
+        }
+        seen += buckets[i];
+    }
+
+    return hist->max_us;
+}
+
+void rate_meter_reset(rate_meter_t *meter)
+{
+    memset(meter, 0, sizeof(rate_meter_t));
+}
+
+void rate_meter_add(rate_meter_t *meter, uint32_t bytes, int64_t now_us)
+{
+    // 秒数从1开始, 0表示桶为空
+    uint32_t second = (uint32_t)(now_us / 1000000) + 1;
+    int index = second % RATE_METER_SLOTS;
+
+    if (meter->second[index] != second) {
+        // 桶已过期, 重新计数
+        meter->bytes[index] = 0;
+        meter->second[index] = second;
+    }
+    meter->bytes[index] += bytes;
+
+    if (meter->bytes[index] > meter->peak_1s) {
+        meter->peak_1s = meter->bytes[index];
+    }
+}
+
+uint32_t rate_meter_rate(const rate_meter_t *meter, uint32_t window_sec, int64_t now_us)
+{
+    uint32_t current = (uint32_t)(now_us / 1000000) + 1;
+    uint64_t total = 0;
+
+    if (window_sec == 0 || window_sec > RATE_METER_WINDOW_SEC) {
+        window_sec = RATE_METER_WINDOW_SEC;
+    }
+
+    for (uint32_t i = 1; i <= window_sec; i++) {
+        uint32_t second = current - i;
+        int index = second % RATE_METER_SLOTS;
+        if (meter->second[index] == second) {
+            total += meter->bytes[index];
+        }
+    }
+
+    return (uint32_t)(total / window_sec);
+}
@@ -0,0 +1,705 @@
+/**
+ * @file raw_tcp_server.c
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 基于lwIP raw API的TCP服务器
+ * @version 0.1
+ * @date 2025-11-08
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "raw_tcp_server.h"
+#include "sdkconfig.h"
+#include "task_profile.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "lwip/tcp.h"
+#include "lwip/tcpip.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+
+static const char *TAG = "raw_tcp";
+
+#if CONFIG_LWIP_TCPIP_CORE_LOCKING
+
+// 允许断开已有客户端时多接受一个连接
+#define RAW_TCP_MAX_CLIENTS         (UART_BRIDGE_MAX_CLIENTS + 1)
+#define RAW_TCP_EVENT_QUEUE_LEN     16
+// 每个客户端已交给lwIP但还没有确认的数据块数量
+#define RAW_TCP_INFLIGHT_LEN        (TCP_FANOUT_QUEUE_LEN * 2)
+#define RAW_TCP_POLL_MS             100
+
+typedef enum {
+    RAW_EVENT_CONNECTED = 0,
+    RAW_EVENT_DATA,
+    RAW_EVENT_WAKE,             // 有客户端关闭或服务器停止
+} raw_event_type_t;
+
+struct raw_tcp_server;
+
+typedef struct {
+    tcp_client_t base;          // 必须是第一个成员, 回调和分发器使用它
+    struct raw_tcp_server *server;
+    bool reported;              // 已经调用了连接回调, 只由服务器任务访问
+    struct pbuf *held;          // 接收回调暂停交付的数据, 只由服务器任务访问, 释放时需要TCPIP核心锁
+    // 以下字段只在持有TCPIP核心锁时访问
+    struct tcp_pcb *pcb;        // NULL表示连接已经关闭
+    bool used;                  // 断开回调执行后才释放
+    bool close_pending;         // 连接已经关闭, 等待服务器任务调用断开回调
+    tcp_fanout_chunk_t *inflight[RAW_TCP_INFLIGHT_LEN];
+    uint16_t inflight_len[RAW_TCP_INFLIGHT_LEN];   // 每个数据块还没有确认的字节数
+    uint8_t inflight_head;
+    uint8_t inflight_count;
+} raw_tcp_client_t;
+
+typedef struct {
+    uint8_t type;
+    raw_tcp_client_t *client;
+    struct pbuf *p;
+} raw_event_t;
+
+struct raw_tcp_server {
+    tcp_server_config_t config;
+    raw_tcp_server_recv_cb_t recv_callback;
+    struct tcp_pcb *listen_pcb;
+    QueueHandle_t events;
+    TaskHandle_t task;
+    TaskHandle_t stop_waiter;
+    volatile bool stopping;
+    atomic_int client_count;
+    raw_tcp_client_t clients[RAW_TCP_MAX_CLIENTS];
+};
+
+static void inflight_push(raw_tcp_client_t *client, tcp_fanout_chunk_t *chunk, uint16_t len)
+{
+    const uint8_t index = (client->inflight_head + client->inflight_count) % RAW_TCP_INFLIGHT_LEN;
+    tcp_fanout_chunk_retain(chunk);
+    client->inflight[index] = chunk;
+    client->inflight_len[index] = len;
+    client->inflight_count++;
+}
+
+/**
+ * @brief 按确认的字节数释放数据块, 一个数据块可能分多次写入, 按写入顺序确认
+ *
+ * @param client
+ * @param len
+ */
+static void inflight_ack(raw_tcp_client_t *client, uint32_t len)
+{
+    while (len > 0 && client->inflight_count > 0) {
+        const uint8_t head = client->inflight_head;
+        const uint16_t n = (len < client->inflight_len[head]) ? len : client->inflight_len[head];
+        client->inflight_len[head] -= n;
+        len -= n;
+        if (client->inflight_len[head] == 0) {
+            tcp_fanout_chunk_release(client->inflight[head]);
+            client->inflight[head] = NULL;
+            client->inflight_head = (head + 1) % RAW_TCP_INFLIGHT_LEN;
+            client->inflight_count--;
+        }
+    }
+}
+
+/**
+ * @brief 释放所有未确认的数据块, 只能在pcb已经释放之后调用
+ *
+ * @param client
+ */
+static void inflight_release_all(raw_tcp_client_t *client)
+{
+    while (client->inflight_count > 0) {
+        const uint8_t head = client->inflight_head;
+        tcp_fanout_chunk_release(client->inflight[head]);
+        client->inflight[head] = NULL;
+        client->inflight_head = (head + 1) % RAW_TCP_INFLIGHT_LEN;
+        client->inflight_count--;
+    }
+}
+
+static void client_mark_closed(raw_tcp_client_t *client)
+{
+    client->close_pending = true;
+    // 队列满时服务器任务一定会被唤醒, 可以忽略失败
+    raw_event_t evt = { .type = RAW_EVENT_WAKE, .client = client, .p = NULL };
+    xQueueSend(client->server->events, &evt, 0);
+}
+
+/**
+ * @brief 关闭连接并解除回调, 需要持有TCPIP核心锁
+ *
+ * 还有未确认的数据时lwIP仍引用着数据块, 直接复位连接, 之后就可以释放数据块.
+ *
+ * @param client
+ * @return true 调用了tcp_abort, 在lwIP回调中需要返回ERR_ABRT
+ * @return false
+ */
+static bool client_close_pcb(raw_tcp_client_t *client)
+{
+    struct tcp_pcb *pcb = client->pcb;
+    if (!pcb) {
+        return false;
+    }
+
+    tcp_arg(pcb, NULL);
+    tcp_recv(pcb, NULL);
+    tcp_sent(pcb, NULL);
+    tcp_err(pcb, NULL);
+    client->pcb = NULL;
+
+    if (client->inflight_count == 0 && tcp_close(pcb) == ERR_OK) {
+        return false;
+    }
+    tcp_abort(pcb);
+    return true;
+}
+
+static err_t on_sent(void *arg, struct tcp_pcb *pcb, u16_t len)
+{
+    raw_tcp_client_t *client = (raw_tcp_client_t *)arg;
+    if (client) {
+        inflight_ack(client, len);
+    }
+    return ERR_OK;
+}
+
+static err_t on_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+    raw_tcp_client_t *client = (raw_tcp_client_t *)arg;
+
+    if (!client) {
+        if (p) {
+            pbuf_free(p);
+        }
+        return ERR_OK;
+    }
+
+    if (!p) {
+        // 对端关闭
+        const bool aborted = client_close_pcb(client);
+        client_mark_closed(client);
+        return aborted ? ERR_ABRT : ERR_OK;
+    }
+
+    if (err != ERR_OK) {
+        pbuf_free(p);
+        return ERR_OK;
+    }
+
+    // 服务器任务处理完之后才确认接收窗口
+    raw_event_t evt = { .type = RAW_EVENT_DATA, .client = client, .p = p };
+    if (xQueueSend(client->server->events, &evt, 0) != pdTRUE) {
+        // lwIP保留这些数据, 稍后重新交付
+        return ERR_MEM;
+    }
+    return ERR_OK;
+}
+
+static void on_error(void *arg, err_t err)
+{
+    raw_tcp_client_t *client = (raw_tcp_client_t *)arg;
+    if (!client) {
+        return;
+    }
+
+    // pcb已经被lwIP释放
+    ESP_LOGD(TAG, "client(%s:%d) error(%d)", ipaddr_ntoa(&client->base.ip_addr), client->base.port, err);
+    client->pcb = NULL;
+    client_mark_closed(client);
+}
+
+static err_t on_accept(void *arg, struct tcp_pcb *newpcb, err_t err)
+{
+    struct raw_tcp_server *server = (struct raw_tcp_server *)arg;
+    raw_tcp_client_t *client = NULL;
+
+    if (err != ERR_OK || !newpcb) {
+        return ERR_VAL;
+    }
+
+    const int limit = (server->config.max_clients < RAW_TCP_MAX_CLIENTS) ? server->config.max_clients : RAW_TCP_MAX_CLIENTS;
+    for (int i = 0; i < limit; i++) {
+        if (!server->clients[i].used) {
+            client = &server->clients[i];
+            break;
+        }
+    }
+
+    if (!client || server->stopping) {
+        tcp_abort(newpcb);
+        return ERR_ABRT;
+    }
+
+    memset(client, 0, sizeof(raw_tcp_client_t));
+    client->server = server;
+    client->base.sock = -1;
+    ip_addr_copy(client->base.ip_addr, newpcb->remote_ip);
+    client->base.port = newpcb->remote_port;
+
+    raw_event_t evt = { .type = RAW_EVENT_CONNECTED, .client = client, .p = NULL };
+    if (xQueueSend(server->events, &evt, 0) != pdTRUE) {
+        tcp_abort(newpcb);
+        return ERR_ABRT;
+    }
+
+    client->pcb = newpcb;
+    client->used = true;
+    tcp_arg(newpcb, client);
+    tcp_recv(newpcb, on_recv);
+    tcp_sent(newpcb, on_sent);
+    tcp_err(newpcb, on_error);
+    atomic_fetch_add(&server->client_count, 1);
+    return ERR_OK;
+}
+
+/**
+ * @brief 把暂停的数据交给接收回调, 确认已经接收的部分, 在服务器任务中调用
+ *
+ * 直接使用pbuf中的数据, 不拷贝. 回调没有全部接收时保留剩下的数据, 这个连接的接收窗口保持关闭.
+ *
+ * @param server
+ * @param client
+ */
+static void client_deliver(struct raw_tcp_server *server, raw_tcp_client_t *client)
+{
+    size_t accepted = 0;
+
+    for (struct pbuf *q = client->held; q; q = q->next) {
+        if (q->len == 0) {
+            continue;
+        }
+        const uint8_t *data = (const uint8_t *)q->payload;
+        if (server->recv_callback) {
+            const size_t n = server->recv_callback(&client->base, data, q->len, server->config.user_ctx);
+            accepted += n;
+            if (n < q->len) {
+                break;
+            }
+        } else {
+            if (server->config.recv_callback) {
+                server->config.recv_callback(&client->base, data, q->len, server->config.user_ctx);
+            }
+            accepted += q->len;
+        }
+    }
+
+    LOCK_TCPIP_CORE();
+    if (client->pcb && accepted > 0) {
+        tcp_recved(client->pcb, accepted);
+    }
+    // 释放已经接收的pbuf, 全部接收时返回NULL
+    if (accepted > 0) {
+        client->held = pbuf_free_header(client->held, (u16_t)accepted);
+    }
+    UNLOCK_TCPIP_CORE();
+}
+
+static void handle_event(struct raw_tcp_server *server, const raw_event_t *evt)
+{
+    raw_tcp_client_t *client = evt->client;
+
+    switch (evt->type) {
+    case RAW_EVENT_CONNECTED:
+        client->reported = true;
+        if (server->config.connect_callback) {
+            server->config.connect_callback(&client->base, server->config.user_ctx);
+        }
+        break;
+    case RAW_EVENT_DATA:
+        // 排在暂停的数据之后, 保持顺序
+        if (client->held) {
+            LOCK_TCPIP_CORE();
+            pbuf_cat(client->held, evt->p);
+            UNLOCK_TCPIP_CORE();
+        } else {
+            client->held = evt->p;
+        }
+        client_deliver(server, client);
+        break;
+    default:
+        break;
+    }
+}
+
+static void handle_closed(struct raw_tcp_server *server, const bool *closed)
+{
+    for (int i = 0; i < RAW_TCP_MAX_CLIENTS; i++) {
+        raw_tcp_client_t *client = &server->clients[i];
+        if (!closed[i]) {
+            continue;
+        }
+
+        if (client->reported && server->config.disconnect_callback) {
+            server->config.disconnect_callback(&client->base, server->config.user_ctx);
+        }
+
+        LOCK_TCPIP_CORE();
+        // 连接已经关闭, 暂停的数据不再交付
+        if (client->held) {
+            pbuf_free(client->held);
+            client->held = NULL;
+        }
+        inflight_release_all(client);
+        client->close_pending = false;
+        client->used = false;
+        UNLOCK_TCPIP_CORE();
+        atomic_fetch_sub(&server->client_count, 1);
+    }
+}
+
+static void raw_server_task(void *arg)
+{
+    struct raw_tcp_server *server = (struct raw_tcp_server *)arg;
+    bool closed[RAW_TCP_MAX_CLIENTS];
+    raw_event_t evt;
+
+    while (1) {
+        // 先记下已经关闭的客户端, 处理完关闭之前收到的数据再调用断开回调
+        LOCK_TCPIP_CORE();
+        for (int i = 0; i < RAW_TCP_MAX_CLIENTS; i++) {
+            closed[i] = server->clients[i].used && server->clients[i].close_pending;
+        }
+        UNLOCK_TCPIP_CORE();
+
+        while (xQueueReceive(server->events, &evt, 0) == pdTRUE) {
+            handle_event(server, &evt);
+        }
+        // 被唤醒或者超时后重试暂停的数据, 队列空间的通知丢失时最多延迟一个轮询周期
+        for (int i = 0; i < RAW_TCP_MAX_CLIENTS; i++) {
+            if (server->clients[i].held && !closed[i]) {
+                client_deliver(server, &server->clients[i]);
+            }
+        }
+        handle_closed(server, closed);
+
+        if (server->stopping) {
+            break;
+        }
+        xQueuePeek(server->events, &evt, pdMS_TO_TICKS(RAW_TCP_POLL_MS));
+    }
+
+    // 停止时所有连接已经关闭, 丢弃剩下的事件, 为已经通知过连接的客户端调用断开回调
+    while (xQueueReceive(server->events, &evt, 0) == pdTRUE) {
+        if (evt.type == RAW_EVENT_DATA) {
+            LOCK_TCPIP_CORE();
+            pbuf_free(evt.p);
+            UNLOCK_TCPIP_CORE();
+        }
+    }
+    LOCK_TCPIP_CORE();
+    for (int i = 0; i < RAW_TCP_MAX_CLIENTS; i++) {
+        closed[i] = server->clients[i].used;
+    }
+    UNLOCK_TCPIP_CORE();
+    handle_closed(server, closed);
+
+    TaskHandle_t waiter = server->stop_waiter;
+    server->task = NULL;
+    xTaskNotifyGive(waiter);
+    vTaskDelete(NULL);
+}
+
+static int raw_io_write(tcp_client_t *base, tcp_fanout_chunk_t *chunk, uint16_t offset, uint16_t len)
+{
+    raw_tcp_client_t *client = (raw_tcp_client_t *)base;
+    int written = 0;
+
+    LOCK_TCPIP_CORE();
+    struct tcp_pcb *pcb = client->pcb;
+    if (!pcb) {
+        written = -1;
+    } else if (client->inflight_count < RAW_TCP_INFLIGHT_LEN && tcp_sndqueuelen(pcb) < TCP_SND_QUEUELEN) {
+        const uint16_t space = tcp_sndbuf(pcb);
+        const uint16_t n = (len < space) ? len : space;
+        if (n > 0) {
+            // 不设置TCP_WRITE_FLAG_COPY, 数据块在确认之前一直持有引用
+            err_t err = tcp_write(pcb, chunk->data + offset, n, 0);
+            if (err == ERR_OK) {
+                inflight_push(client, chunk, n);
+                tcp_output(pcb);
+                written = n;
+            } else if (err != ERR_MEM) {
+                ESP_LOGW(TAG, "client(%s:%d) write failed: %d", ipaddr_ntoa(&base->ip_addr), base->port, err);
+                written = -1;
+            }
+        }
+    }
+    UNLOCK_TCPIP_CORE();
+
+    return written;
+}
+
+static void raw_io_apply_opts(tcp_client_t *base, const tcp_fanout_config_t *config)
+{
+    raw_tcp_client_t *client = (raw_tcp_client_t *)base;
+
+    LOCK_TCPIP_CORE();
+    struct tcp_pcb *pcb = client->pcb;
+    if (pcb) {
+        if (config->nodelay) {
+            tcp_nagle_disable(pcb);
+        } else {
+            tcp_nagle_enable(pcb);
+        }
+
+        if (config->keepalive_idle_s > 0) {
+            ip_set_option(pcb, SOF_KEEPALIVE);
+            pcb->keep_idle = (u32_t)config->keepalive_idle_s * 1000;
+#if LWIP_TCP_KEEPALIVE
+            pcb->keep_intvl = (u32_t)config->keepalive_intvl_s * 1000;
+            pcb->keep_cnt = config->keepalive_count;
+#endif
+        } else {
+            ip_reset_option(pcb, SOF_KEEPALIVE);
+        }
+        // 接收窗口由lwIP编译期配置决定, recv_buf不使用
+    }
+    UNLOCK_TCPIP_CORE();
+}
+
+static void raw_io_close(tcp_client_t *base)
+{
+    raw_tcp_client_t *client = (raw_tcp_client_t *)base;
+
+    LOCK_TCPIP_CORE();
+    if (client->pcb) {
+        client_close_pcb(client);
+        client_mark_closed(client);
+    }
+    UNLOCK_TCPIP_CORE();
+}
+
+const tcp_fanout_io_t raw_tcp_server_fanout_io = {
+    .write = raw_io_write,
+    .apply_opts = raw_io_apply_opts,
+    .close = raw_io_close,
+};
+
+bool raw_tcp_server_supported(void)
+{
+    return true;
+}
+
+raw_tcp_server_handle_t raw_tcp_server_create(const tcp_server_config_t *config, esp_err_t *err)
+{
+    if (!config || config->max_clients == 0) {
+        *err = ESP_ERR_INVALID_ARG;
+        return NULL;
+    }
+
+    struct raw_tcp_server *server = (struct raw_tcp_server *)calloc(1, sizeof(struct raw_tcp_server));
+    if (!server) {
+        *err = ESP_ERR_NO_MEM;
+        return NULL;
+    }
+
+    server->config = *config;
+    atomic_init(&server->client_count, 0);
+    server->events = xQueueCreate(RAW_TCP_EVENT_QUEUE_LEN, sizeof(raw_event_t));
+    if (!server->events) {
+        free(server);
+        *err = ESP_ERR_NO_MEM;
+        return NULL;
+    }
+
+    *err = ESP_OK;
+    return server;
+}
+
+esp_err_t raw_tcp_server_start(raw_tcp_server_handle_t server)
+{
+    if (!server) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (server->task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    server->stopping = false;
+    if (task_profile_create(raw_server_task, "raw_tcp", server->config.stack_size, server,
+                            TASK_ROLE_TCP_SERVER, &server->task) != pdPASS) {
+        server->task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = ESP_OK;
+    LOCK_TCPIP_CORE();
+    struct tcp_pcb *pcb = tcp_new_ip_type(IPADDR_TYPE_ANY);
+    if (!pcb) {
+        ret = ESP_ERR_NO_MEM;
+    } else {
+        ip_set_option(pcb, SOF_REUSEADDR);
+        if (tcp_bind(pcb, IP_ANY_TYPE, server->config.port) != ERR_OK) {
+            tcp_abort(pcb);
+            ret = ESP_FAIL;
+        } else {
+            // 成功时原来的pcb已经释放
+            struct tcp_pcb *listen_pcb = tcp_listen_with_backlog(pcb, server->config.max_clients);
+            if (!listen_pcb) {
+                tcp_abort(pcb);
+                ret = ESP_ERR_NO_MEM;
+            } else {
+                server->listen_pcb = listen_pcb;
+                tcp_arg(listen_pcb, server);
+                tcp_accept(listen_pcb, on_accept);
+            }
+        }
+    }
+    UNLOCK_TCPIP_CORE();
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "failed to listen on port(%d): %s", server->config.port, esp_err_to_name(ret));
+        raw_tcp_server_stop(server);
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "listening on port(%d)", server->config.port);
+    return ESP_OK;
+}
+
+esp_err_t raw_tcp_server_stop(raw_tcp_server_handle_t server)
+{
+    if (!server) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!server->task) {
+        return ESP_OK;
+    }
+
+    LOCK_TCPIP_CORE();
+    server->stopping = true;
+    if (server->listen_pcb) {
+        tcp_arg(server->listen_pcb, NULL);
+        tcp_accept(server->listen_pcb, NULL);
+        tcp_close(server->listen_pcb);
+        server->listen_pcb = NULL;
+    }
+    for (int i = 0; i < RAW_TCP_MAX_CLIENTS; i++) {
+        raw_tcp_client_t *client = &server->clients[i];
+        if (client->used && client->pcb) {
+            client_close_pcb(client);
+            client->close_pending = true;
+        }
+    }
+    UNLOCK_TCPIP_CORE();
+
+    // 服务器任务处理完剩下的事件和断开回调后退出
+    server->stop_waiter = xTaskGetCurrentTaskHandle();
+    raw_event_t evt = { .type = RAW_EVENT_WAKE, .client = NULL, .p = NULL };
+    xQueueSend(server->events, &evt, portMAX_DELAY);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    ESP_LOGI(TAG, "stopped on port(%d)", server->config.port);
+    return ESP_OK;
+}
+
+esp_err_t raw_tcp_server_destroy(raw_tcp_server_handle_t server)
+{
+    if (!server) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    raw_tcp_server_stop(server);
+    vQueueDelete(server->events);
+    free(server);
+    return ESP_OK;
+}
+
+esp_err_t raw_tcp_server_set_recv_callback(raw_tcp_server_handle_t server, raw_tcp_server_recv_cb_t callback)
+{
+    if (!server) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (server->task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    server->recv_callback = callback;
+    return ESP_OK;
+}
+
+void raw_tcp_server_resume(raw_tcp_server_handle_t server)
+{
+    if (!server) {
+        return;
+    }
+
+    // 队列满时服务器任务一定会被唤醒, 可以忽略失败
+    raw_event_t evt = { .type = RAW_EVENT_WAKE, .client = NULL, .p = NULL };
+    xQueueSend(server->events, &evt, 0);
+}
+
+int raw_tcp_server_get_client_count(raw_tcp_server_handle_t server)
+{
+    return server ? atomic_load(&server->client_count) : 0;
+}
+
+#else
+
+static int raw_io_write(tcp_client_t *client, tcp_fanout_chunk_t *chunk, uint16_t offset, uint16_t len)
+{
+    return -1;
+}
+
+static void raw_io_apply_opts(tcp_client_t *client, const tcp_fanout_config_t *config)
+{
+}
+
+static void raw_io_close(tcp_client_t *client)
+{
+}
+
+const tcp_fanout_io_t raw_tcp_server_fanout_io = {
+    .write = raw_io_write,
+    .apply_opts = raw_io_apply_opts,
+    .close = raw_io_close,
+};
+
+bool raw_tcp_server_supported(void)
+{
+    return false;
+}
+
+raw_tcp_server_handle_t raw_tcp_server_create(const tcp_server_config_t *config, esp_err_t *err)
+{
+    ESP_LOGE(TAG, "raw tcp engine requires CONFIG_LWIP_TCPIP_CORE_LOCKING");
+    *err = ESP_ERR_NOT_SUPPORTED;
+    return NULL;
+}
+
+esp_err_t raw_tcp_server_start(raw_tcp_server_handle_t server)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t raw_tcp_server_stop(raw_tcp_server_handle_t server)
+{
+    return ESP_OK;
+}
+
+esp_err_t raw_tcp_server_destroy(raw_tcp_server_handle_t server)
+{
+    return ESP_OK;
+}
+
+esp_err_t raw_tcp_server_set_recv_callback(raw_tcp_server_handle_t server, raw_tcp_server_recv_cb_t callback)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void raw_tcp_server_resume(raw_tcp_server_handle_t server)
+{
+}
+
+int raw_tcp_server_get_client_count(raw_tcp_server_handle_t server)
+{
+    return 0;
+}
+
+#endif // CONFIG_LWIP_TCPIP_CORE_LOCKING
@@ -0,0 +1,330 @@
+/**
+ * @file rfc2217.c
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief RFC 2217(Telnet COM-PORT-OPTION)协议解析
+ * @version 0.1
+ * @date 2025-10-30
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "rfc2217.h"
+#include <string.h>
+
+// 设备签名, 回复SIGNATURE查询
+#define RFC2217_SIGNATURE_TEXT  "uart2wifi"
+
+// 解析状态
+enum {
+    STATE_DATA = 0,
+    STATE_IAC,
+    STATE_OPTION,
+    STATE_SB,
+    STATE_SB_IAC,
+};
+
+/**
+ * @brief 支持的Telnet选项, 返回在local_opts/remote_opts中的位
+ *
+ * @param option
+ * @return uint8_t 0表示不支持
+ */
+static uint8_t option_bit(uint8_t option)
+{
+    switch (option) {
+    case RFC2217_OPT_BINARY:
+        return 0x01;
+    case RFC2217_OPT_SGA:
+        return 0x02;
+    case RFC2217_OPT_COM_PORT:
+        return 0x04;
+    default:
+        return 0;
+    }
+}
+
+static void send_verb(const rfc2217_ops_t *ops, uint8_t verb, uint8_t option)
+{
+    const uint8_t frame[3] = { RFC2217_IAC, verb, option };
+    ops->reply(frame, sizeof(frame), ops->ctx);
+}
+
+/**
+ * @brief 生成COM-PORT-OPTION子协商帧
+ *
+ * @return size_t 帧长度
+ */
+static size_t build_frame(uint8_t *frame, uint8_t command, const uint8_t *payload, size_t len)
+{
+    size_t n = 0;
+
+    frame[n++] = RFC2217_IAC;
+    frame[n++] = RFC2217_SB;
+    frame[n++] = RFC2217_OPT_COM_PORT;
+    frame[n++] = command;
+    n += rfc2217_escape_copy(&frame[n], payload, len);
+    frame[n++] = RFC2217_IAC;
+    frame[n++] = RFC2217_SE;
+    return n;
+}
+
+static void send_frame(const rfc2217_ops_t *ops, uint8_t command, const uint8_t *payload, size_t len)
+{
+    uint8_t frame[RFC2217_FRAME_MAX];
+
+    if (len > RFC2217_SB_MAX) {
+        return;
+    }
+    ops->reply(frame, build_frame(frame, command, payload, len), ops->ctx);
+}
+
+/**
+ * @brief 处理WILL/WONT/DO/DONT, 只在状态变化时回复, 避免协商循环
+ *
+ * @param session
+ * @param option
+ * @param ops
+ */
+static void handle_option(rfc2217_session_t *session, uint8_t option, const rfc2217_ops_t *ops)
+{
+    const uint8_t bit = option_bit(option);
+
+    switch (session->verb) {
+    case RFC2217_DO:
+        if (!bit) {
+            send_verb(ops, RFC2217_WONT, option);
+        } else if (!(session->local_opts & bit)) {
+            session->local_opts |= bit;
+            send_verb(ops, RFC2217_WILL, option);
+        }
+        break;
+    case RFC2217_DONT:
+        if (session->local_opts & bit) {
+            session->local_opts &= ~bit;
+            send_verb(ops, RFC2217_WONT, option);
+        }
+        break;
+    case RFC2217_WILL:
+        if (!bit) {
+            send_verb(ops, RFC2217_DONT, option);
+        } else if (!(session->remote_opts & bit)) {
+            session->remote_opts |= bit;
+            send_verb(ops, RFC2217_DO, option);
+        }
+        break;
+    case RFC2217_WONT:
+        if (session->remote_opts & bit) {
+            session->remote_opts &= ~bit;
+            send_verb(ops, RFC2217_DONT, option);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief 处理一个完整的COM-PORT-OPTION子协商
+ *
+ * @param session
+ * @param ops
+ */
+static void handle_subnegotiation(rfc2217_session_t *session, const rfc2217_ops_t *ops)
+{
+    if (session->sb_overflow || session->sb_len < 2 || session->sb_buf[0] != RFC2217_OPT_COM_PORT) {
+        return;
+    }
+
+    const uint8_t command = session->sb_buf[1];
+    const uint8_t *payload = &session->sb_buf[2];
+    const size_t len = session->sb_len - 2;
+    const uint8_t reply = command + RFC2217_SERVER_OFFSET;
+
+    switch (command) {
+    case RFC2217_SIGNATURE:
+        // 带内容的是客户端的签名, 不需要回复
+        if (len == 0) {
+            send_frame(ops, reply, (const uint8_t *)RFC2217_SIGNATURE_TEXT, strlen(RFC2217_SIGNATURE_TEXT));
+        }
+        break;
+    case RFC2217_SET_BAUDRATE:
+        if (len == 4) {
+            uint32_t value = ((uint32_t)payload[0] << 24) | ((uint32_t)payload[1] << 16) |
+                             ((uint32_t)payload[2] << 8) | payload[3];
+            value = ops->control(command, value, ops->ctx);
+            const uint8_t out[4] = {
+                (uint8_t)(value >> 24), (uint8_t)(value >> 16), (uint8_t)(value >> 8), (uint8_t)value
+            };
+            send_frame(ops, reply, out, sizeof(out));
+        }
+        break;
+    case RFC2217_SET_DATASIZE:
+    case RFC2217_SET_PARITY:
+    case RFC2217_SET_STOPSIZE:
+    case RFC2217_SET_CONTROL:
+    case RFC2217_PURGE_DATA:
+        if (len == 1) {
+            const uint8_t out = (uint8_t)ops->control(command, payload[0], ops->ctx);
+            send_frame(ops, reply, &out, 1);
+        }
+        break;
+    case RFC2217_SET_LINESTATE_MASK:
+        if (len == 1) {
+            session->linestate_mask = payload[0];
+            send_frame(ops, reply, payload, 1);
+        }
+        break;
+    case RFC2217_SET_MODEMSTATE_MASK:
+        if (len == 1) {
+            session->modemstate_mask = payload[0];
+            send_frame(ops, reply, payload, 1);
+            // 立即通知一次当前的modem状态, 客户端不需要等到状态变化
+            const uint8_t state = ops->modem_state(ops->ctx) & session->modemstate_mask;
+            send_frame(ops, RFC2217_NOTIFY_MODEMSTATE + RFC2217_SERVER_OFFSET, &state, 1);
+        }
+        break;
+    default:
+        // FLOWCONTROL-SUSPEND/RESUME等命令不需要回复
+        break;
+    }
+}
+
+void rfc2217_session_init(rfc2217_session_t *session)
+{
+    memset(session, 0, sizeof(rfc2217_session_t));
+    session->state = STATE_DATA;
+    session->modemstate_mask = 0xFF;
+}
+
+void rfc2217_input(rfc2217_session_t *session, const uint8_t *data, size_t len, const rfc2217_ops_t *ops)
+{
+    size_t i = 0;
+
+    while (i < len) {
+        switch (session->state) {
+        case STATE_DATA: {
+            // 连续的普通数据一次交给上层
+            const uint8_t *iac = memchr(&data[i], RFC2217_IAC, len - i);
+            size_t run = iac ? (size_t)(iac - &data[i]) : (len - i);
+            if (run > 0) {
+                ops->data(&data[i], run, ops->ctx);
+                i += run;
+            }
+            if (iac) {
+                session->state = STATE_IAC;
+                i++;
+            }
+            break;
+        }
+        case STATE_IAC:
+            switch (data[i]) {
+            case RFC2217_IAC:
+                // 转义的0xFF, 第二个字节就是数据本身
+                ops->data(&data[i], 1, ops->ctx);
+                session->state = STATE_DATA;
+                break;
+            case RFC2217_WILL:
+            case RFC2217_WONT:
+            case RFC2217_DO:
+            case RFC2217_DONT:
+                session->verb = data[i];
+                session->state = STATE_OPTION;
+                break;
+            case RFC2217_SB:
+                session->sb_len = 0;
+                session->sb_overflow = false;
+                session->state = STATE_SB;
+                break;
+            default:
+                // NOP/AYT等命令忽略
+                session->state = STATE_DATA;
+                break;
+            }
+            i++;
+            break;
+        case STATE_OPTION:
+            handle_option(session, data[i], ops);
+            session->state = STATE_DATA;
+            i++;
+            break;
+        case STATE_SB:
+            if (data[i] == RFC2217_IAC) {
+                session->state = STATE_SB_IAC;
+            } else if (session->sb_len < RFC2217_SB_MAX) {
+                session->sb_buf[session->sb_len++] = data[i];
+            } else {
+                session->sb_overflow = true;
+            }
+            i++;
+            break;
+        case STATE_SB_IAC:
+            if (data[i] == RFC2217_IAC) {
+                if (session->sb_len < RFC2217_SB_MAX) {
+                    session->sb_buf[session->sb_len++] = RFC2217_IAC;
+                } else {
+                    session->sb_overflow = true;
+                }
+                session->state = STATE_SB;
+            } else {
+                if (data[i] == RFC2217_SE) {
+                    handle_subnegotiation(session, ops);
+                }
+                session->state = STATE_DATA;
+            }
+            i++;
+            break;
+        default:
+            session->state = STATE_DATA;
+            break;
+        }
+    }
+}
+
+size_t rfc2217_notify_linestate(const rfc2217_session_t *session, uint8_t line_state, uint8_t *frame)
+{
+    const uint8_t state = line_state & session->linestate_mask;
+
+    if (state == 0 || !(session->remote_opts & option_bit(RFC2217_OPT_COM_PORT))) {
+        return 0;
+    }
+
+    return build_frame(frame, RFC2217_NOTIFY_LINESTATE + RFC2217_SERVER_OFFSET, &state, 1);
+}
+
+size_t rfc2217_count_iac(const uint8_t *data, size_t len)
+{
+    size_t count = 0;
+    const uint8_t *end = data + len;
+
+    while (data < end) {
+        const uint8_t *iac = memchr(data, RFC2217_IAC, end - data);
+        if (!iac) {
+            break;
+        }
+        count++;
+        data = iac + 1;
+    }
+
+    return count;
+}
+
+size_t rfc2217_escape_copy(uint8_t *dst, const uint8_t *src, size_t len)
+{
+    size_t n = 0;
+    const uint8_t *end = src + len;
+
+    // 按IAC分段整块复制
+    while (src < end) {
+        const uint8_t *iac = memchr(src, RFC2217_IAC, end - src);
+        size_t run = iac ? (size_t)(iac - src) + 1 : (size_t)(end - src);
+        memcpy(&dst[n], src, run);
+        n += run;
+        src += run;
+        if (iac) {
+            dst[n++] = RFC2217_IAC;
+        }
+    }
+
+    return n;
+}
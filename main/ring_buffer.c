@@ -0,0 +1,107 @@
+/**
+ * @file ring_buffer.c
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 单生产者/单消费者(SPSC)无锁字节环形缓冲区
+ * @version 0.1
+ * @date 2025-10-25
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "ring_buffer.h"
+#include <string.h>
+
+bool ring_buffer_init(ring_buffer_t *rb, uint8_t *buffer, size_t size)
+{
+    if (!rb || !buffer || size == 0 || (size & (size - 1)) != 0) {
+        return false;
+    }
+
+    rb->buffer = buffer;
+    rb->size = size;
+    atomic_init(&rb->head, 0);
+    atomic_init(&rb->tail, 0);
+    return true;
+}
+
+void ring_buffer_reset(ring_buffer_t *rb)
+{
+    atomic_store(&rb->head, 0);
+    atomic_store(&rb->tail, 0);
+}
+
+size_t ring_buffer_used(const ring_buffer_t *rb)
+{
+    size_t head = atomic_load_explicit(&rb->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    return head - tail;
+}
+
+size_t ring_buffer_free(const ring_buffer_t *rb)
+{
+    return rb->size - ring_buffer_used(rb);
+}
+
+size_t ring_buffer_write_span(ring_buffer_t *rb, uint8_t **span)
+{
+    // head只由生产者修改, 可以宽松读取; tail需要与消费者同步
+    size_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    size_t free = rb->size - (head - tail);
+    size_t offset = head & (rb->size - 1);
+    size_t contiguous = rb->size - offset;
+
+    *span = rb->buffer + offset;
+    return (free < contiguous) ? free : contiguous;
+}
+
+void ring_buffer_commit(ring_buffer_t *rb, size_t len)
+{
+    size_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+    // release保证数据写入先于head更新对消费者可见
+    atomic_store_explicit(&rb->head, head + len, memory_order_release);
+}
+
+size_t ring_buffer_read_span(ring_buffer_t *rb, const uint8_t **span)
+{
+    size_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&rb->head, memory_order_acquire);
+    size_t used = head - tail;
+    size_t offset = tail & (rb->size - 1);
+    size_t contiguous = rb->size - offset;
+
+    *span = rb->buffer + offset;
+    return (used < contiguous) ? used : contiguous;
+}
+
+void ring_buffer_consume(ring_buffer_t *rb, size_t len)
+{
+    size_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+    // release保证数据读取完成后, 生产者才能覆盖这段空间
+    atomic_store_explicit(&rb->tail, tail + len, memory_order_release);
+}
+
+void ring_buffer_put(ring_buffer_t *rb, size_t offset, const void *data, size_t len)
+{
+    size_t pos = (atomic_load_explicit(&rb->head, memory_order_relaxed) + offset) & (rb->size - 1);
+    size_t first = rb->size - pos;
+
+    if (first > len) {
+        first = len;
+    }
+    memcpy(rb->buffer + pos, data, first);
+    memcpy(rb->buffer, (const uint8_t *)data + first, len - first);
+}
+
+void ring_buffer_peek(ring_buffer_t *rb, size_t offset, void *data, size_t len)
+{
+    size_t pos = (atomic_load_explicit(&rb->tail, memory_order_relaxed) + offset) & (rb->size - 1);
+    size_t first = rb->size - pos;
+
+    if (first > len) {
+        first = len;
+    }
+    memcpy(data, rb->buffer + pos, first);
+    memcpy((uint8_t *)data + first, rb->buffer, len - first);
+}
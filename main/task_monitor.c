@@ -0,0 +1,252 @@
+/**
+ * @file task_monitor.c
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 任务CPU占用和栈使用统计
+ * @version 0.1
+ * @date 2025-11-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "task_monitor.h"
+#include "esp_log.h"
+#include "freertos/timers.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#include <string.h>
+
+#if !defined(CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS)
+#error "Please enable CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS in sdkconfig"
+#endif
+
+static const char *TAG = "task_monitor";
+
+// 保存窗口两端的运行时间, 需要多一个采样点
+#define HISTORY_LEN     (TASK_MONITOR_WINDOW_SEC + 1)
+
+typedef struct {
+    TaskHandle_t handle;            // NULL表示空闲槽
+    UBaseType_t number;             // 任务编号, 句柄可能被新任务复用
+    configRUN_TIME_COUNTER_TYPE runtime[HISTORY_LEN];
+    bool seen;                      // 本次采样中是否存在
+} task_slot_t;
+
+static struct {
+    TimerHandle_t timer;
+    SemaphoreHandle_t mutex;        // 保护snapshot
+    TaskStatus_t status[TASK_MONITOR_MAX_TASKS];
+    task_slot_t slots[TASK_MONITOR_MAX_TASKS];
+    configRUN_TIME_COUNTER_TYPE total[HISTORY_LEN];
+    uint8_t head;                   // 最新采样点
+    uint8_t samples;                // 有效采样点数, 最多HISTORY_LEN
+    task_monitor_snapshot_t snapshot;
+    bool valid;
+} s_monitor;
+
+static task_slot_t *find_slot(const TaskStatus_t *status)
+{
+    task_slot_t *free_slot = NULL;
+
+    for (int i = 0; i < TASK_MONITOR_MAX_TASKS; i++) {
+        task_slot_t *slot = &s_monitor.slots[i];
+        if (slot->handle == status->xHandle && slot->number == status->xTaskNumber) {
+            return slot;
+        }
+        if (!slot->handle && !free_slot) {
+            free_slot = slot;
+        }
+    }
+
+    if (free_slot) {
+        // 新任务从当前运行时间开始计算
+        free_slot->handle = status->xHandle;
+        free_slot->number = status->xTaskNumber;
+        for (int i = 0; i < HISTORY_LEN; i++) {
+            free_slot->runtime[i] = status->ulRunTimeCounter;
+        }
+    }
+    return free_slot;
+}
+
+static int8_t idle_core(TaskHandle_t handle)
+{
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        if (xTaskGetIdleTaskHandleForCore(core) == handle) {
+            return (int8_t)core;
+        }
+    }
+    return -1;
+}
+
+static uint8_t usage_percent(configRUN_TIME_COUNTER_TYPE idle, configRUN_TIME_COUNTER_TYPE elapsed)
+{
+    if (elapsed == 0 || idle >= elapsed) {
+        return 0;
+    }
+    return (uint8_t)(((uint64_t)(elapsed - idle) * 100) / elapsed);
+}
+
+static void monitor_sample(TimerHandle_t timer)
+{
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    const UBaseType_t count = uxTaskGetSystemState(s_monitor.status, TASK_MONITOR_MAX_TASKS, &total);
+    if (count == 0) {
+        // 任务数超过缓冲区, 扩大TASK_MONITOR_MAX_TASKS
+        ESP_LOGW(TAG, "more than %d tasks, skip sample", TASK_MONITOR_MAX_TASKS);
+        return;
+    }
+
+    const uint8_t head = (s_monitor.samples == 0) ? 0 : (s_monitor.head + 1) % HISTORY_LEN;
+    if (s_monitor.samples < HISTORY_LEN) {
+        s_monitor.samples++;
+    }
+    const uint8_t oldest = (s_monitor.samples < HISTORY_LEN) ? 0 : (head + 1) % HISTORY_LEN;
+    s_monitor.head = head;
+    s_monitor.total[head] = total;
+
+    for (int i = 0; i < TASK_MONITOR_MAX_TASKS; i++) {
+        s_monitor.slots[i].seen = false;
+    }
+
+    // 结果先在本地计算, 只在复制时加锁
+    static task_monitor_snapshot_t result;
+    configRUN_TIME_COUNTER_TYPE idle[portNUM_PROCESSORS] = {0};
+    const configRUN_TIME_COUNTER_TYPE elapsed = total - s_monitor.total[oldest];
+
+    memset(&result, 0, sizeof(result));
+    for (UBaseType_t i = 0; i < count; i++) {
+        const TaskStatus_t *status = &s_monitor.status[i];
+        task_slot_t *slot = find_slot(status);
+        if (!slot) {
+            continue;
+        }
+        slot->seen = true;
+        slot->runtime[head] = status->ulRunTimeCounter;
+
+        const configRUN_TIME_COUNTER_TYPE used = slot->runtime[head] - slot->runtime[oldest];
+        const int8_t core = idle_core(status->xHandle);
+        if (core >= 0) {
+            idle[core] = used;
+        }
+
+        task_monitor_task_t *task = &result.tasks[result.task_count++];
+        strncpy(task->name, status->pcTaskName, sizeof(task->name) - 1);
+        task->priority = status->uxCurrentPriority;
+#if CONFIG_FREERTOS_VTASKLIST_INCLUDE_COREID
+        task->core = (status->xCoreID == tskNO_AFFINITY) ? -1 : (int8_t)status->xCoreID;
+#else
+        task->core = (core >= 0) ? core : -1;
+#endif
+        task->stack_free = status->usStackHighWaterMark;
+        task->cpu_permille = elapsed ? (uint16_t)(((uint64_t)used * 1000) / elapsed) : 0;
+    }
+
+    // 已删除的任务释放槽位
+    for (int i = 0; i < TASK_MONITOR_MAX_TASKS; i++) {
+        if (!s_monitor.slots[i].seen) {
+            s_monitor.slots[i].handle = NULL;
+        }
+    }
+
+    configRUN_TIME_COUNTER_TYPE idle_total = 0;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        result.core_usage[core] = usage_percent(idle[core], elapsed);
+        idle_total += idle[core];
+    }
+    result.cpu_usage = usage_percent(idle_total, elapsed * portNUM_PROCESSORS);
+    result.window_ms = (uint32_t)((s_monitor.samples - 1) * TASK_MONITOR_PERIOD_MS);
+
+    // 在定时器任务中运行, 不能等待读取者; 锁被占用时放弃本次结果, 采样历史已经更新, 下次照常发布
+    if (xSemaphoreTake(s_monitor.mutex, 0) != pdTRUE) {
+        ESP_LOGD(TAG, "snapshot busy, skip publish");
+        return;
+    }
+    memcpy(&s_monitor.snapshot, &result, sizeof(result));
+    s_monitor.valid = (s_monitor.samples > 1);
+    xSemaphoreGive(s_monitor.mutex);
+}
+
+esp_err_t task_monitor_start(void)
+{
+    if (s_monitor.timer) {
+        return ESP_OK;
+    }
+
+    s_monitor.mutex = xSemaphoreCreateMutex();
+    if (!s_monitor.mutex) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_monitor.timer = xTimerCreate("task_monitor", pdMS_TO_TICKS(TASK_MONITOR_PERIOD_MS), pdTRUE, NULL, monitor_sample);
+    if (!s_monitor.timer) {
+        vSemaphoreDelete(s_monitor.mutex);
+        s_monitor.mutex = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (xTimerStart(s_monitor.timer, 0) != pdPASS) {
+        xTimerDelete(s_monitor.timer, 0);
+        s_monitor.timer = NULL;
+        vSemaphoreDelete(s_monitor.mutex);
+        s_monitor.mutex = NULL;
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "task monitor started, window %d s", TASK_MONITOR_WINDOW_SEC);
+    return ESP_OK;
+}
+
+esp_err_t task_monitor_get_snapshot(task_monitor_snapshot_t *snapshot)
+{
+    if (!snapshot) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_monitor.mutex) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_monitor.mutex, portMAX_DELAY);
+    const bool valid = s_monitor.valid;
+    memcpy(snapshot, &s_monitor.snapshot, sizeof(task_monitor_snapshot_t));
+    xSemaphoreGive(s_monitor.mutex);
+
+    return valid ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+void task_monitor_mark(task_monitor_mark_t *mark)
+{
+    mark->total = portGET_RUN_TIME_COUNTER_VALUE();
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        mark->idle[core] = ulTaskGetRunTimeCounter(xTaskGetIdleTaskHandleForCore(core));
+    }
+}
+
+uint32_t task_monitor_busy_us_since(const task_monitor_mark_t *mark)
+{
+    task_monitor_mark_t now;
+    task_monitor_mark(&now);
+
+    // 运行时间计数使用esp_timer, 单位为微秒
+    const configRUN_TIME_COUNTER_TYPE elapsed = now.total - mark->total;
+    uint64_t busy = 0;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        const configRUN_TIME_COUNTER_TYPE idle = now.idle[core] - mark->idle[core];
+        if (idle < elapsed) {
+            busy += elapsed - idle;
+        }
+    }
+    return (busy > UINT32_MAX) ? UINT32_MAX : (uint32_t)busy;
+}
+
+uint8_t task_monitor_get_cpu_usage(void)
+{
+    uint8_t usage = 0;
+
+    if (s_monitor.mutex) {
+        xSemaphoreTake(s_monitor.mutex, portMAX_DELAY);
+        usage = s_monitor.valid ? s_monitor.snapshot.cpu_usage : 0;
+        xSemaphoreGive(s_monitor.mutex);
+    }
+    return usage;
+}
@@ -0,0 +1,187 @@
+/**
+ * @file task_profile.c
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 任务调度方案
+ * @version 0.1
+ * @date 2025-11-01
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "task_profile.h"
+#include "mem_arena.h"
+#include "esp_log.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+
+static const char *TAG = "task_profile";
+
+#define NVS_NAMESPACE       "task_profile"
+#define NVS_KEY_PROFILE     "profile"
+
+// 数据通路所在的核心, WiFi和lwIP固定在另一个核心
+#define DATA_PATH_CORE      1
+#define NETWORK_CORE        0
+
+static const task_placement_t s_profiles[TASK_PROFILE_MAX][TASK_ROLE_MAX] = {
+    [TASK_PROFILE_DEFAULT] = {
+        [TASK_ROLE_UART_READER] = { 5, tskNO_AFFINITY },
+        [TASK_ROLE_SENDER]      = { 5, tskNO_AFFINITY },
+        [TASK_ROLE_TCP_SERVER]  = { 5, tskNO_AFFINITY },
+        [TASK_ROLE_UDP_RX]      = { 5, tskNO_AFFINITY },
+        [TASK_ROLE_DISPLAY]     = { 3, tskNO_AFFINITY },
+        [TASK_ROLE_CLI]         = { 5, tskNO_AFFINITY },
+        [TASK_ROLE_CAPTURE]     = { 2, tskNO_AFFINITY },
+        [TASK_ROLE_BENCH]       = { 5, tskNO_AFFINITY },
+        [TASK_ROLE_METRICS]     = { 2, tskNO_AFFINITY },
+    },
+    [TASK_PROFILE_DUAL_CORE] = {
+        // 读取任务优先于发送任务, 保证串口FIFO及时取走
+        [TASK_ROLE_UART_READER] = { 12, DATA_PATH_CORE },
+        [TASK_ROLE_SENDER]      = { 11, DATA_PATH_CORE },
+        // 接收方向靠近lwIP, 仍低于lwIP(CONFIG_LWIP_TCPIP_TASK_PRIO)
+        [TASK_ROLE_TCP_SERVER]  = { 10, tskNO_AFFINITY },
+        [TASK_ROLE_UDP_RX]      = { 10, NETWORK_CORE },
+        // 显示和命令行只使用空闲的CPU时间
+        [TASK_ROLE_DISPLAY]     = { 1, tskNO_AFFINITY },
+        [TASK_ROLE_CLI]         = { 1, tskNO_AFFINITY },
+        [TASK_ROLE_CAPTURE]     = { 1, tskNO_AFFINITY },
+        // 模拟网络侧的客户端, 与接收任务相同
+        [TASK_ROLE_BENCH]       = { 10, NETWORK_CORE },
+        [TASK_ROLE_METRICS]     = { 1, NETWORK_CORE },
+    },
+};
+
+static const char *s_profile_names[TASK_PROFILE_MAX] = {
+    "default", "dual-core"
+};
+
+static const char *s_role_names[TASK_ROLE_MAX] = {
+    "UART Reader", "TCP Sender", "TCP Server", "UDP RX", "Display", "CLI", "Capture", "Bench", "Metrics"
+};
+
+static task_profile_t s_active = TASK_PROFILE_DEFAULT;
+
+static bool profile_supported(task_profile_t profile)
+{
+    if (profile >= TASK_PROFILE_MAX) {
+        return false;
+    }
+    return profile != TASK_PROFILE_DUAL_CORE || portNUM_PROCESSORS > 1;
+}
+
+static task_profile_t load_profile(void)
+{
+    uint8_t profile = TASK_PROFILE_DEFAULT;
+    nvs_handle_t nvs_handle;
+
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) == ESP_OK) {
+        size_t required_size = sizeof(profile);
+        if (nvs_get_blob(nvs_handle, NVS_KEY_PROFILE, &profile, &required_size) != ESP_OK) {
+            profile = TASK_PROFILE_DEFAULT;
+        }
+        nvs_close(nvs_handle);
+    }
+
+    if (!profile_supported((task_profile_t)profile)) {
+        profile = TASK_PROFILE_DEFAULT;
+    }
+    return (task_profile_t)profile;
+}
+
+esp_err_t task_profile_init(void)
+{
+    s_active = load_profile();
+    ESP_LOGI(TAG, "task profile: %s", s_profile_names[s_active]);
+    return ESP_OK;
+}
+
+task_profile_t task_profile_get_active(void)
+{
+    return s_active;
+}
+
+esp_err_t task_profile_set(task_profile_t profile)
+{
+    if (profile >= TASK_PROFILE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!profile_supported(profile)) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to open nvs namespace(%s)", esp_err_to_name(err));
+        return err;
+    }
+
+    const uint8_t value = (uint8_t)profile;
+    err = nvs_set_blob(nvs_handle, NVS_KEY_PROFILE, &value, sizeof(value));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "set task profile(%s), effective after reboot", s_profile_names[profile]);
+    }
+    return err;
+}
+
+task_profile_t task_profile_get_saved(void)
+{
+    return load_profile();
+}
+
+const task_placement_t *task_profile_placement(task_role_t role)
+{
+    if (role >= TASK_ROLE_MAX) {
+        role = TASK_ROLE_CLI;
+    }
+    return &s_profiles[s_active][role];
+}
+
+BaseType_t task_profile_create(TaskFunction_t task, const char *name, uint32_t stack_size,
+                               void *arg, task_role_t role, TaskHandle_t *handle)
+{
+    const task_placement_t *placement = task_profile_placement(role);
+
+    return xTaskCreatePinnedToCore(task, name, stack_size, arg, placement->priority, handle, placement->core);
+}
+
+BaseType_t task_profile_create_static(TaskFunction_t task, const char *name, uint32_t stack_size,
+                                      void *arg, task_role_t role, TaskHandle_t *handle)
+{
+    const task_placement_t *placement = task_profile_placement(role);
+    StaticTask_t *tcb = NULL;
+    StackType_t *stack = NULL;
+
+    if (MEM_ARENA_ENABLED) {
+        tcb = mem_arena_alloc(sizeof(StaticTask_t), "task stacks");
+        stack = tcb ? mem_arena_alloc(stack_size, "task stacks") : NULL;
+    }
+    if (!stack) {
+        // 控制块已经分配时只浪费很少的空间
+        return task_profile_create(task, name, stack_size, arg, role, handle);
+    }
+
+    TaskHandle_t created = xTaskCreateStaticPinnedToCore(task, name, stack_size, arg, placement->priority,
+                                                         stack, tcb, placement->core);
+    if (handle) {
+        *handle = created;
+    }
+    return created ? pdPASS : pdFAIL;
+}
+
+const char *task_profile_name(task_profile_t profile)
+{
+    return profile < TASK_PROFILE_MAX ? s_profile_names[profile] : "?";
+}
+
+const char *task_role_name(task_role_t role)
+{
+    return role < TASK_ROLE_MAX ? s_role_names[role] : "?";
+}
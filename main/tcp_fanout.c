@@ -0,0 +1,726 @@
+/**
+ * @file tcp_fanout.c
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief TCP多客户端分发, 每个客户端独立的有界发送队列
+ * @version 0.1
+ * @date 2025-10-26
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "tcp_fanout.h"
+#include "rfc2217.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include <string.h>
+#include <errno.h>
+#include <sys/param.h>
+
+static const char *TAG = "tcp_fanout";
+
+static int socket_io_write(tcp_client_t *client, tcp_fanout_chunk_t *chunk, uint16_t offset, uint16_t len)
+{
+    int n = send(client->sock, chunk->data + offset, len, MSG_DONTWAIT);
+    if (n >= 0) {
+        return n;
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        // 发送缓冲区已满, 等下次再发
+        return 0;
+    }
+    ESP_LOGW(TAG, "socket(%d) send failed: errno %d", client->sock, errno);
+    return -1;
+}
+
+static void socket_io_apply_opts(tcp_client_t *client, const tcp_fanout_config_t *config)
+{
+    int opt = config->nodelay ? 1 : 0;
+    setsockopt(client->sock, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+
+    opt = (config->keepalive_idle_s > 0) ? 1 : 0;
+    setsockopt(client->sock, SOL_SOCKET, SO_KEEPALIVE, &opt, sizeof(opt));
+    if (opt) {
+        opt = config->keepalive_idle_s;
+        setsockopt(client->sock, IPPROTO_TCP, TCP_KEEPIDLE, &opt, sizeof(opt));
+        opt = config->keepalive_intvl_s;
+        setsockopt(client->sock, IPPROTO_TCP, TCP_KEEPINTVL, &opt, sizeof(opt));
+        opt = config->keepalive_count;
+        setsockopt(client->sock, IPPROTO_TCP, TCP_KEEPCNT, &opt, sizeof(opt));
+    }
+
+#if LWIP_SO_RCVBUF
+    if (config->recv_buf > 0) {
+        opt = (int)config->recv_buf;
+        setsockopt(client->sock, SOL_SOCKET, SO_RCVBUF, &opt, sizeof(opt));
+    }
+#endif
+}
+
+static void socket_io_close(tcp_client_t *client)
+{
+    // 只关闭连接, socket由tcp_server在断开回调之后关闭
+    shutdown(client->sock, SHUT_RDWR);
+}
+
+const tcp_fanout_io_t tcp_fanout_socket_io = {
+    .write = socket_io_write,
+    .apply_opts = socket_io_apply_opts,
+    .close = socket_io_close,
+};
+
+static inline const tcp_fanout_io_t *fanout_io(const tcp_fanout_config_t *config)
+{
+    return config->io ? config->io : &tcp_fanout_socket_io;
+}
+
+void tcp_fanout_chunk_retain(tcp_fanout_chunk_t *chunk)
+{
+    atomic_fetch_add(&chunk->refs, 1);
+}
+
+void tcp_fanout_chunk_release(tcp_fanout_chunk_t *chunk)
+{
+    if (atomic_fetch_sub(&chunk->refs, 1) == 1) {
+        if (chunk->pool) {
+            mem_pool_put(chunk->pool, chunk);
+        } else {
+            free(chunk);
+        }
+    }
+}
+
+/**
+ * @brief 分配数据块, 放得下时优先使用块池
+ *
+ * @param fanout
+ * @param len 数据长度
+ * @param heap 块池不可用时是否使用堆内存
+ * @return tcp_fanout_chunk_t* NULL表示分配失败
+ */
+static tcp_fanout_chunk_t *chunk_alloc(tcp_fanout_t *fanout, size_t len, bool heap)
+{
+    tcp_fanout_chunk_t *chunk = NULL;
+    mem_pool_t *pool = NULL;
+
+    if (fanout->use_pool && len <= TCP_FANOUT_POOL_BLOCK_SIZE) {
+        chunk = (tcp_fanout_chunk_t*) mem_pool_get(&fanout->pool);
+        pool = chunk ? &fanout->pool : NULL;
+    }
+    if (!chunk && heap) {
+        chunk = (tcp_fanout_chunk_t*) malloc(sizeof(tcp_fanout_chunk_t) + len);
+    }
+    if (chunk) {
+        atomic_init(&chunk->refs, 1);
+        chunk->pool = pool;
+        chunk->len = len;
+    }
+
+    return chunk;
+}
+
+/**
+ * @brief 丢弃队首的数据块
+ *
+ * @param slot
+ * @return uint32_t 丢弃的字节数(未发送的部分)
+ */
+static uint32_t slot_drop_head(tcp_fanout_slot_t *slot)
+{
+    tcp_fanout_chunk_t *chunk = slot->queue[slot->head];
+    uint32_t dropped = chunk->len - slot->offset;
+
+    slot->queue[slot->head] = NULL;
+    slot->head = (slot->head + 1) % TCP_FANOUT_QUEUE_LEN;
+    slot->count--;
+    slot->offset = 0;
+    slot->queued_bytes -= dropped;
+    tcp_fanout_chunk_release(chunk);
+    return dropped;
+}
+
+/**
+ * @brief 丢弃最旧的还没有开始发送的数据块
+ *
+ * 队首已经发出一部分时不能截断, 否则客户端收到半个数据块, 可能拆开转义的0xFF或协议帧,
+ * 这时丢弃第二个数据块, 之后的数据块前移. 调用者需要保证队首之后还有数据块.
+ *
+ * @param slot
+ * @return uint32_t 丢弃的字节数
+ */
+static uint32_t slot_drop_oldest(tcp_fanout_slot_t *slot)
+{
+    if (slot->offset == 0) {
+        return slot_drop_head(slot);
+    }
+
+    tcp_fanout_chunk_t *chunk = slot->queue[(slot->head + 1) % TCP_FANOUT_QUEUE_LEN];
+    const uint32_t len = chunk->len;
+    for (uint8_t i = 1; i + 1 < slot->count; i++) {
+        slot->queue[(slot->head + i) % TCP_FANOUT_QUEUE_LEN] = slot->queue[(slot->head + i + 1) % TCP_FANOUT_QUEUE_LEN];
+    }
+    slot->queue[(slot->head + slot->count - 1) % TCP_FANOUT_QUEUE_LEN] = NULL;
+    slot->count--;
+    slot->queued_bytes -= len;
+    // 释放后数据块可能已经被其它任务取走, 不能再访问
+    tcp_fanout_chunk_release(chunk);
+    return len;
+}
+
+static uint32_t slot_drop_all(tcp_fanout_slot_t *slot)
+{
+    uint32_t dropped = 0;
+    while (slot->count > 0) {
+        dropped += slot_drop_head(slot);
+    }
+    return dropped;
+}
+
+/**
+ * @brief 主动断开客户端, 由tcp_server检测到连接关闭后回调移除
+ *
+ * @param slot
+ * @return uint32_t 丢弃的字节数
+ */
+static uint32_t slot_close(tcp_fanout_slot_t *slot, const tcp_fanout_config_t *config)
+{
+    uint32_t dropped = slot_drop_all(slot);
+    if (dropped > 0) {
+        slot->drop_bytes += dropped;
+        slot->drop_count++;
+    }
+    slot->closing = true;
+    fanout_io(config)->close(slot->client);
+    return dropped;
+}
+
+static bool slot_is_full(const tcp_fanout_slot_t *slot, const tcp_fanout_config_t *config, size_t len)
+{
+    return (slot->count >= TCP_FANOUT_QUEUE_LEN) ||
+           (slot->queued_bytes + len > config->queue_bytes);
+}
+
+/**
+ * @brief 把数据块挂到客户端队列
+ *
+ * @return uint32_t 丢弃的字节数
+ */
+static uint32_t slot_enqueue(tcp_fanout_slot_t *slot, const tcp_fanout_config_t *config, tcp_fanout_chunk_t *chunk)
+{
+    uint32_t dropped = 0;
+
+    if (slot_is_full(slot, config, chunk->len)) {
+        if (config->policy != UART_BRIDGE_SLOW_CLIENT_DROP_OLDEST) {
+            // 丢弃最新的数据, DISCONNECT策略在停滞超时之前也是如此
+            slot->drop_bytes += chunk->len;
+            slot->drop_count++;
+            return chunk->len;
+        }
+
+        // 丢弃最旧的数据, 直到有足够的空间; 已经发出一部分的队首保留
+        while (slot->count > 0 && slot_is_full(slot, config, chunk->len)) {
+            if (slot->offset > 0 && slot->count == 1) {
+                // 只剩发送了一半的队首, 新数据仍然放不下, 只能断开
+                // 队首剩余的部分由slot_close计入丢弃次数
+                slot->drop_bytes += dropped + chunk->len;
+                ESP_LOGW(TAG, "client(%s:%d) queue full with a partly sent chunk, closing", slot->addr, slot->port);
+                return dropped + chunk->len + slot_close(slot, config);
+            }
+            dropped += slot_drop_oldest(slot);
+        }
+        slot->drop_bytes += dropped;
+        slot->drop_count++;
+    }
+
+    if (slot->count == 0) {
+        slot->stall_since = xTaskGetTickCount();
+    }
+
+    atomic_fetch_add(&chunk->refs, 1);
+    slot->queue[(slot->head + slot->count) % TCP_FANOUT_QUEUE_LEN] = chunk;
+    slot->count++;
+    slot->queued_bytes += chunk->len;
+    if (slot->queued_bytes > slot->peak_queued_bytes) {
+        slot->peak_queued_bytes = slot->queued_bytes;
+    }
+
+    return dropped;
+}
+
+/**
+ * @brief 非阻塞发送客户端队列中的数据
+ *
+ * @return uint32_t 丢弃的字节数
+ */
+static uint32_t slot_service(tcp_fanout_slot_t *slot, const tcp_fanout_config_t *config, uint32_t *sent_bytes,
+                             latency_hist_t *latency)
+{
+    const tcp_fanout_io_t *io = fanout_io(config);
+    TickType_t now = xTaskGetTickCount();
+
+    while (slot->count > 0) {
+        tcp_fanout_chunk_t *chunk = slot->queue[slot->head];
+        int n = io->write(slot->client, chunk, slot->offset, chunk->len - slot->offset);
+        if (n > 0) {
+            slot->offset += n;
+            slot->queued_bytes -= n;
+            slot->tx_bytes += n;
+            slot->stall_since = now;
+            slot->last_active = now;
+            *sent_bytes += n;
+            if (slot->offset >= chunk->len) {
+                if (latency && chunk->queued_us != 0) {
+                    latency_hist_record(latency, (uint32_t)(esp_timer_get_time() - chunk->queued_us));
+                }
+                slot->offset = 0;
+                slot->queue[slot->head] = NULL;
+                slot->head = (slot->head + 1) % TCP_FANOUT_QUEUE_LEN;
+                slot->count--;
+                tcp_fanout_chunk_release(chunk);
+            }
+        } else if (n == 0) {
+            // 发送缓冲区已满, 等下次再发
+            break;
+        } else {
+            ESP_LOGW(TAG, "client(%s:%d) send failed, closing", slot->addr, slot->port);
+            return slot_close(slot, config);
+        }
+    }
+
+    if (slot->count > 0 && config->policy == UART_BRIDGE_SLOW_CLIENT_DISCONNECT &&
+        (now - slot->stall_since) > pdMS_TO_TICKS(config->stall_timeout_ms)) {
+        ESP_LOGW(TAG, "client(%s:%d) stalled over %" PRIu32 "ms with %" PRIu32 " bytes queued, closing",
+                 slot->addr, slot->port, config->stall_timeout_ms, slot->queued_bytes);
+        return slot_close(slot, config);
+    }
+
+    // 对端消失时没有FIN, 重传要几分钟才超时, 不等lwIP
+    if (slot->count > 0 && config->user_timeout_ms > 0 &&
+        (now - slot->stall_since) > pdMS_TO_TICKS(config->user_timeout_ms)) {
+        ESP_LOGW(TAG, "client(%s:%d) no progress over %" PRIu32 "ms, closing",
+                 slot->addr, slot->port, config->user_timeout_ms);
+        return slot_close(slot, config);
+    }
+
+    return 0;
+}
+
+esp_err_t tcp_fanout_init(tcp_fanout_t *fanout, const tcp_fanout_config_t *config)
+{
+    if (!fanout || !config) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 块池从内存区分配后不能释放, 再次初始化时沿用
+    const mem_pool_t pool = fanout->pool;
+    memset(fanout, 0, sizeof(tcp_fanout_t));
+    fanout->pool = pool;
+    fanout->config = *config;
+    fanout->mutex = xSemaphoreCreateMutex();
+    if (!fanout->mutex) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (fanout->pool.base) {
+        fanout->use_pool = true;
+    } else if (MEM_ARENA_ENABLED) {
+        esp_err_t ret = mem_pool_init(&fanout->pool, "client chunks",
+                                      sizeof(tcp_fanout_chunk_t) + TCP_FANOUT_POOL_BLOCK_SIZE,
+                                      MEM_ARENA_CHUNK_BLOCKS);
+        if (ret == ESP_OK) {
+            fanout->use_pool = true;
+        } else {
+            ESP_LOGW(TAG, "chunk pool not available, using heap");
+        }
+    }
+
+    return ESP_OK;
+}
+
+void tcp_fanout_deinit(tcp_fanout_t *fanout)
+{
+    if (!fanout->mutex) {
+        return;
+    }
+
+    for (int i = 0; i < UART_BRIDGE_MAX_CLIENTS; i++) {
+        slot_drop_all(&fanout->slots[i]);
+    }
+
+    vSemaphoreDelete(fanout->mutex);
+    fanout->mutex = NULL;
+}
+
+static bool sockopts_equal(const tcp_fanout_config_t *a, const tcp_fanout_config_t *b)
+{
+    return a->nodelay == b->nodelay && a->keepalive_idle_s == b->keepalive_idle_s &&
+           a->keepalive_intvl_s == b->keepalive_intvl_s && a->keepalive_count == b->keepalive_count &&
+           a->recv_buf == b->recv_buf;
+}
+
+/**
+ * @brief 选择要断开的客户端, 已经在关闭的客户端优先
+ *
+ * @return int 队列序号, -1表示不断开
+ */
+static int slot_pick_evict(const tcp_fanout_t *fanout)
+{
+    const TickType_t now = xTaskGetTickCount();
+    int pick = -1;
+
+    if (fanout->config.evict_policy == UART_BRIDGE_EVICT_NONE) {
+        return -1;
+    }
+
+    for (int i = 0; i < UART_BRIDGE_MAX_CLIENTS; i++) {
+        const tcp_fanout_slot_t *slot = &fanout->slots[i];
+        if (!slot->used) {
+            continue;
+        }
+        if (slot->closing) {
+            return i;
+        }
+        if (pick < 0) {
+            pick = i;
+            continue;
+        }
+        // 按经过的时间比较, TickType_t回绕时也正确
+        const tcp_fanout_slot_t *best = &fanout->slots[pick];
+        if (fanout->config.evict_policy == UART_BRIDGE_EVICT_OLDEST) {
+            if ((now - slot->connected_at) > (now - best->connected_at)) {
+                pick = i;
+            }
+        } else if ((now - slot->last_active) > (now - best->last_active)) {
+            pick = i;
+        }
+    }
+    return pick;
+}
+
+void tcp_fanout_set_config(tcp_fanout_t *fanout, const tcp_fanout_config_t *config)
+{
+    xSemaphoreTake(fanout->mutex, portMAX_DELAY);
+    const bool sockopts_changed = !sockopts_equal(&fanout->config, config);
+    fanout->config = *config;
+    if (sockopts_changed) {
+        for (int i = 0; i < UART_BRIDGE_MAX_CLIENTS; i++) {
+            if (fanout->slots[i].used && !fanout->slots[i].closing) {
+                fanout_io(config)->apply_opts(fanout->slots[i].client, config);
+            }
+        }
+    }
+    xSemaphoreGive(fanout->mutex);
+}
+
+esp_err_t tcp_fanout_add_client(tcp_fanout_t *fanout, tcp_client_t *client, tcp_client_t **evicted)
+{
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    int free_index = -1;
+
+    *evicted = NULL;
+
+    xSemaphoreTake(fanout->mutex, portMAX_DELAY);
+    for (int i = 0; i < UART_BRIDGE_MAX_CLIENTS; i++) {
+        if (!fanout->slots[i].used) {
+            free_index = i;
+            break;
+        }
+    }
+
+    if (free_index < 0) {
+        free_index = slot_pick_evict(fanout);
+        if (free_index >= 0) {
+            tcp_fanout_slot_t *slot = &fanout->slots[free_index];
+            ESP_LOGW(TAG, "server full, evicting client(%s:%d)", slot->addr, slot->port);
+            slot_close(slot, &fanout->config);
+            slot->used = false;
+            fanout->client_num--;
+            *evicted = slot->client;
+        }
+    }
+
+    if (free_index >= 0) {
+        tcp_fanout_slot_t *slot = &fanout->slots[free_index];
+        memset(slot, 0, sizeof(tcp_fanout_slot_t));
+        slot->used = true;
+        slot->client = client;
+        slot->port = client->port;
+        slot->connected_at = xTaskGetTickCount();
+        slot->last_active = slot->connected_at;
+        strncpy(slot->addr, ipaddr_ntoa(&client->ip_addr), sizeof(slot->addr) - 1);
+        fanout_io(&fanout->config)->apply_opts(client, &fanout->config);
+        fanout->client_num++;
+        ret = ESP_OK;
+    }
+    xSemaphoreGive(fanout->mutex);
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "no free queue for client(%s:%d)", ipaddr_ntoa(&client->ip_addr), client->port);
+    }
+    return ret;
+}
+
+bool tcp_fanout_touch(tcp_fanout_t *fanout, tcp_client_t *client)
+{
+    bool found = false;
+
+    xSemaphoreTake(fanout->mutex, portMAX_DELAY);
+    for (int i = 0; i < UART_BRIDGE_MAX_CLIENTS; i++) {
+        tcp_fanout_slot_t *slot = &fanout->slots[i];
+        if (slot->used && slot->client == client) {
+            slot->last_active = xTaskGetTickCount();
+            found = !slot->closing;
+            break;
+        }
+    }
+    xSemaphoreGive(fanout->mutex);
+
+    return found;
+}
+
+void tcp_fanout_remove_client(tcp_fanout_t *fanout, tcp_client_t *client)
+{
+    xSemaphoreTake(fanout->mutex, portMAX_DELAY);
+    for (int i = 0; i < UART_BRIDGE_MAX_CLIENTS; i++) {
+        tcp_fanout_slot_t *slot = &fanout->slots[i];
+        if (slot->used && slot->client == client) {
+            slot_drop_all(slot);
+            slot->used = false;
+            fanout->client_num--;
+            break;
+        }
+    }
+    xSemaphoreGive(fanout->mutex);
+}
+
+void tcp_fanout_remove_all(tcp_fanout_t *fanout)
+{
+    xSemaphoreTake(fanout->mutex, portMAX_DELAY);
+    for (int i = 0; i < UART_BRIDGE_MAX_CLIENTS; i++) {
+        tcp_fanout_slot_t *slot = &fanout->slots[i];
+        if (slot->used) {
+            slot_drop_all(slot);
+            slot->used = false;
+        }
+    }
+    fanout->client_num = 0;
+    xSemaphoreGive(fanout->mutex);
+}
+
+uint8_t tcp_fanout_client_count(tcp_fanout_t *fanout)
+{
+    return fanout->client_num;
+}
+
+bool tcp_fanout_can_accept(tcp_fanout_t *fanout, size_t len)
+{
+    bool accept = false;
+
+    if (fanout->client_num == 0) {
+        return false;
+    }
+
+    // 转义后最长为原来的两倍
+    const uint32_t need = fanout->config.escape_iac ? len * 2 : len;
+
+    if (fanout->use_pool &&
+        mem_pool_available(&fanout->pool) < (need + TCP_FANOUT_POOL_BLOCK_SIZE - 1) / TCP_FANOUT_POOL_BLOCK_SIZE) {
+        return false;
+    }
+
+    xSemaphoreTake(fanout->mutex, portMAX_DELAY);
+    for (int i = 0; i < UART_BRIDGE_MAX_CLIENTS; i++) {
+        const tcp_fanout_slot_t *slot = &fanout->slots[i];
+        if (!slot->used || slot->closing) {
+            continue;
+        }
+        if (slot->count >= TCP_FANOUT_QUEUE_LEN || slot->queued_bytes + need > fanout->config.queue_bytes) {
+            accept = false;
+            break;
+        }
+        accept = true;
+    }
+    xSemaphoreGive(fanout->mutex);
+
+    return accept;
+}
+
+/**
+ * @brief 把一个数据块挂到所有客户端的发送队列
+ *
+ * @param fanout
+ * @param data
+ * @param len
+ * @param escape
+ * @param drop_bytes
+ * @return int 接收该数据块的客户端数量
+ */
+static int broadcast_chunk(tcp_fanout_t *fanout, const uint8_t *data, size_t len, bool escape, uint32_t *drop_bytes)
+{
+    int receivers = 0;
+
+    const size_t chunk_len = escape ? len + rfc2217_count_iac(data, len) : len;
+    if (chunk_len > UINT16_MAX) {
+        return 0;
+    }
+
+    // 整个数据块只拷贝一次, 所有客户端共享; 使用块池时不再使用堆内存
+    tcp_fanout_chunk_t *chunk = chunk_alloc(fanout, chunk_len, !fanout->use_pool);
+
+    xSemaphoreTake(fanout->mutex, portMAX_DELAY);
+    if (chunk) {
+        chunk->queued_us = esp_timer_get_time();
+        if (escape) {
+            rfc2217_escape_copy(chunk->data, data, len);
+        } else {
+            memcpy(chunk->data, data, len);
+        }
+    }
+
+    for (int i = 0; i < UART_BRIDGE_MAX_CLIENTS; i++) {
+        tcp_fanout_slot_t *slot = &fanout->slots[i];
+        if (!slot->used || slot->closing) {
+            continue;
+        }
+
+        if (!chunk) {
+            slot->drop_bytes += len;
+            slot->drop_count++;
+            *drop_bytes += len;
+            continue;
+        }
+
+        *drop_bytes += slot_enqueue(slot, &fanout->config, chunk);
+        receivers++;
+    }
+    xSemaphoreGive(fanout->mutex);
+
+    if (chunk) {
+        // 释放广播者持有的引用
+        tcp_fanout_chunk_release(chunk);
+    } else {
+        ESP_LOGW(TAG, "failed to allocate chunk(%d), dropped", len);
+    }
+
+    return receivers;
+}
+
+int tcp_fanout_broadcast(tcp_fanout_t *fanout, const uint8_t *data, size_t len, uint32_t *drop_bytes)
+{
+    if (fanout->client_num == 0 || len == 0) {
+        return 0;
+    }
+
+    // 只在服务停止时修改, 不需要加锁
+    const bool escape = fanout->config.escape_iac;
+    if (!fanout->use_pool) {
+        return broadcast_chunk(fanout, data, len, escape, drop_bytes);
+    }
+
+    // 按块大小拆分, 转义后最长为原来的两倍
+    const size_t piece_max = escape ? TCP_FANOUT_POOL_BLOCK_SIZE / 2 : TCP_FANOUT_POOL_BLOCK_SIZE;
+    int receivers = 0;
+    for (size_t offset = 0; offset < len; offset += piece_max) {
+        const size_t piece = MIN(len - offset, piece_max);
+        receivers = MAX(receivers, broadcast_chunk(fanout, data + offset, piece, escape, drop_bytes));
+    }
+
+    return receivers;
+}
+
+esp_err_t tcp_fanout_send_to(tcp_fanout_t *fanout, tcp_client_t *client, const uint8_t *data, size_t len)
+{
+    if (len == 0 || len > UINT16_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 协议回复很少, 块池不可用时使用堆内存
+    tcp_fanout_chunk_t *chunk = chunk_alloc(fanout, len, true);
+    if (!chunk) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    chunk->queued_us = 0;
+    memcpy(chunk->data, data, len);
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(fanout->mutex, portMAX_DELAY);
+    for (int i = 0; i < UART_BRIDGE_MAX_CLIENTS; i++) {
+        tcp_fanout_slot_t *slot = &fanout->slots[i];
+        if (slot->used && !slot->closing && slot->client == client) {
+            slot_enqueue(slot, &fanout->config, chunk);
+            ret = ESP_OK;
+            break;
+        }
+    }
+    xSemaphoreGive(fanout->mutex);
+
+    tcp_fanout_chunk_release(chunk);
+    return ret;
+}
+
+bool tcp_fanout_service(tcp_fanout_t *fanout, uint32_t *sent_bytes, uint32_t *drop_bytes, latency_hist_t *latency)
+{
+    bool pending = false;
+
+    if (fanout->client_num == 0) {
+        return false;
+    }
+
+    xSemaphoreTake(fanout->mutex, portMAX_DELAY);
+    for (int i = 0; i < UART_BRIDGE_MAX_CLIENTS; i++) {
+        tcp_fanout_slot_t *slot = &fanout->slots[i];
+        if (!slot->used || slot->closing || slot->count == 0) {
+            continue;
+        }
+
+        *drop_bytes += slot_service(slot, &fanout->config, sent_bytes, latency);
+        if (slot->count > 0) {
+            pending = true;
+        }
+    }
+    xSemaphoreGive(fanout->mutex);
+
+    return pending;
+}
+
+static void collect_client_stats(tcp_fanout_t *fanout, uart_bridge_client_stats_t *stats, uint8_t *count)
+{
+    uint8_t n = 0;
+    TickType_t now = xTaskGetTickCount();
+
+    for (int i = 0; i < UART_BRIDGE_MAX_CLIENTS && n < *count; i++) {
+        tcp_fanout_slot_t *slot = &fanout->slots[i];
+        if (!slot->used) {
+            continue;
+        }
+
+        uart_bridge_client_stats_t *s = &stats[n++];
+        strncpy(s->addr, slot->addr, sizeof(s->addr) - 1);
+        s->addr[sizeof(s->addr) - 1] = '\0';
+        s->port = slot->port;
+        s->tx_bytes = slot->tx_bytes;
+        s->drop_bytes = slot->drop_bytes;
+        s->drop_count = slot->drop_count;
+        s->queued_bytes = slot->queued_bytes;
+        s->peak_queued_bytes = slot->peak_queued_bytes;
+        s->stalled_ms = (slot->count > 0) ? pdTICKS_TO_MS(now - slot->stall_since) : 0;
+    }
+
+    *count = n;
+}
+
+void tcp_fanout_get_client_stats(tcp_fanout_t *fanout, uart_bridge_client_stats_t *stats, uint8_t *count)
+{
+    xSemaphoreTake(fanout->mutex, portMAX_DELAY);
+    collect_client_stats(fanout, stats, count);
+    xSemaphoreGive(fanout->mutex);
+}
+
+void tcp_fanout_peek_client_stats(tcp_fanout_t *fanout, uart_bridge_client_stats_t *stats, uint8_t *count)
+{
+    // 计数器都是对齐的32位变量, 单个值不会读到一半; 客户端刚连接或断开时地址可能与计数不对应
+    collect_client_stats(fanout, stats, count);
+}
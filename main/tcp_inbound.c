@@ -0,0 +1,385 @@
+/**
+ * @file tcp_inbound.c
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief TCP到串口方向的客户端仲裁
+ * @version 0.1
+ * @date 2025-11-10
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "tcp_inbound.h"
+#include "mem_arena.h"
+#include "esp_log.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "tcp_inbound";
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+#define QUEUE_MASK      (TCP_INBOUND_QUEUE_BYTES - 1)
+
+_Static_assert((TCP_INBOUND_QUEUE_BYTES & QUEUE_MASK) == 0, "queue size must be a power of 2");
+
+static tcp_inbound_slot_t *slot_find(tcp_inbound_t *inbound, tcp_client_t *client)
+{
+    for (int i = 0; i < TCP_INBOUND_MAX_CLIENTS; i++) {
+        if (inbound->slots[i].client == client) {
+            return &inbound->slots[i];
+        }
+    }
+    return NULL;
+}
+
+static uint8_t *slot_buf(tcp_inbound_t *inbound, const tcp_inbound_slot_t *slot)
+{
+    return inbound->pool + (slot - inbound->slots) * TCP_INBOUND_QUEUE_BYTES;
+}
+
+/**
+ * @brief 丢弃排队的数据
+ */
+static void slot_flush(tcp_inbound_t *inbound, tcp_inbound_slot_t *slot)
+{
+    inbound->queued_bytes -= slot->head - slot->tail;
+    slot->tail = slot->head;
+    slot->deficit = 0;
+    slot->mark_head = 0;
+    slot->mark_count = 0;
+}
+
+/**
+ * @brief 队列空间变化后通知留有数据的调用者, 需要持有锁
+ */
+static void notify_resume(tcp_inbound_t *inbound)
+{
+    if (inbound->held && inbound->resume_cb) {
+        inbound->held = false;
+        inbound->resume_cb(inbound->resume_ctx);
+    }
+}
+
+/**
+ * @brief 独占方式下可以写入串口的客户端, 最早连接的客户端
+ */
+static const tcp_inbound_slot_t *owner_slot(const tcp_inbound_t *inbound)
+{
+    const tcp_inbound_slot_t *owner = NULL;
+
+    for (int i = 0; i < TCP_INBOUND_MAX_CLIENTS; i++) {
+        const tcp_inbound_slot_t *slot = &inbound->slots[i];
+        if (slot->client && (!owner || (int32_t)(slot->seq - owner->seq) < 0)) {
+            owner = slot;
+        }
+    }
+    return owner;
+}
+
+esp_err_t tcp_inbound_init(tcp_inbound_t *inbound)
+{
+    memset(inbound, 0, sizeof(tcp_inbound_t));
+    inbound->busy = -1;
+    inbound->mutex = xSemaphoreCreateMutex();
+    if (!inbound->mutex) {
+        tcp_inbound_deinit(inbound);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void tcp_inbound_deinit(tcp_inbound_t *inbound)
+{
+    if (inbound->mutex) {
+        vSemaphoreDelete(inbound->mutex);
+        inbound->mutex = NULL;
+    }
+    mem_arena_free(inbound->pool);
+    inbound->pool = NULL;
+}
+
+esp_err_t tcp_inbound_set_mode(tcp_inbound_t *inbound, uart_bridge_tx_arbiter_t mode)
+{
+    uint8_t *pool = NULL;
+
+    if (mode == UART_BRIDGE_TX_ARBITER_FAIR && !inbound->pool) {
+        pool = mem_arena_malloc(TCP_INBOUND_MAX_CLIENTS * TCP_INBOUND_QUEUE_BYTES, "inbound queues");
+        if (!pool) {
+            ESP_LOGE(TAG, "failed to allocate client queues");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    xSemaphoreTake(inbound->mutex, portMAX_DELAY);
+    for (int i = 0; i < TCP_INBOUND_MAX_CLIENTS; i++) {
+        slot_flush(inbound, &inbound->slots[i]);
+    }
+    // 内存区中的队列不能释放, 留给下一次切换到公平方式
+    if (pool) {
+        inbound->pool = pool;
+    } else if (mode != UART_BRIDGE_TX_ARBITER_FAIR && !mem_arena_owns(inbound->pool)) {
+        pool = inbound->pool;
+        inbound->pool = NULL;
+    }
+    inbound->mode = mode;
+    inbound->cursor = 0;
+    // 留有数据的调用者按新的方式重新交付
+    notify_resume(inbound);
+    xSemaphoreGive(inbound->mutex);
+
+    if (mode != UART_BRIDGE_TX_ARBITER_FAIR) {
+        mem_arena_free(pool);
+    }
+    return ESP_OK;
+}
+
+void tcp_inbound_set_resume(tcp_inbound_t *inbound, tcp_inbound_resume_cb_t cb, void *ctx)
+{
+    xSemaphoreTake(inbound->mutex, portMAX_DELAY);
+    inbound->resume_cb = cb;
+    inbound->resume_ctx = ctx;
+    inbound->held = false;
+    xSemaphoreGive(inbound->mutex);
+}
+
+void tcp_inbound_add_client(tcp_inbound_t *inbound, tcp_client_t *client)
+{
+    tcp_inbound_slot_t *slot = NULL;
+
+    xSemaphoreTake(inbound->mutex, portMAX_DELAY);
+    for (int i = 0; i < TCP_INBOUND_MAX_CLIENTS; i++) {
+        if (!inbound->slots[i].client && i != inbound->busy) {
+            slot = &inbound->slots[i];
+            break;
+        }
+    }
+    if (slot) {
+        memset(slot, 0, sizeof(tcp_inbound_slot_t));
+        slot->client = client;
+        slot->port = client->port;
+        slot->seq = inbound->next_seq++;
+        strncpy(slot->addr, ipaddr_ntoa(&client->ip_addr), sizeof(slot->addr) - 1);
+    }
+    xSemaphoreGive(inbound->mutex);
+
+    if (!slot) {
+        ESP_LOGW(TAG, "no free slot for client(%s:%d)", ipaddr_ntoa(&client->ip_addr), client->port);
+    }
+}
+
+void tcp_inbound_remove_client(tcp_inbound_t *inbound, tcp_client_t *client)
+{
+    if (!client) {
+        return;
+    }
+
+    xSemaphoreTake(inbound->mutex, portMAX_DELAY);
+    tcp_inbound_slot_t *slot = slot_find(inbound, client);
+    if (slot) {
+        slot_flush(inbound, slot);
+        slot->client = NULL;
+    }
+    notify_resume(inbound);
+    xSemaphoreGive(inbound->mutex);
+}
+
+void tcp_inbound_remove_all(tcp_inbound_t *inbound)
+{
+    xSemaphoreTake(inbound->mutex, portMAX_DELAY);
+    for (int i = 0; i < TCP_INBOUND_MAX_CLIENTS; i++) {
+        slot_flush(inbound, &inbound->slots[i]);
+        inbound->slots[i].client = NULL;
+    }
+    notify_resume(inbound);
+    xSemaphoreGive(inbound->mutex);
+}
+
+bool tcp_inbound_admit(tcp_inbound_t *inbound, tcp_client_t *client, size_t len)
+{
+    bool admit = true;
+
+    xSemaphoreTake(inbound->mutex, portMAX_DELAY);
+    tcp_inbound_slot_t *slot = slot_find(inbound, client);
+    if (slot) {
+        slot->rx_bytes += len;
+        if (inbound->mode == UART_BRIDGE_TX_ARBITER_EXCLUSIVE && owner_slot(inbound) != slot) {
+            slot->drop_bytes += len;
+            admit = false;
+        }
+    }
+    xSemaphoreGive(inbound->mutex);
+
+    return admit;
+}
+
+size_t tcp_inbound_push(tcp_inbound_t *inbound, tcp_client_t *client, const uint8_t *data, size_t len,
+                        int64_t now_us, bool hold, bool *held)
+{
+    size_t total = 0;
+    bool keep = false;
+
+    xSemaphoreTake(inbound->mutex, portMAX_DELAY);
+    tcp_inbound_slot_t *slot = slot_find(inbound, client);
+
+    if (slot && inbound->mode == UART_BRIDGE_TX_ARBITER_FAIR && inbound->pool) {
+        const uint32_t queued = slot->head - slot->tail;
+        const size_t n = MIN(TCP_INBOUND_QUEUE_BYTES - queued, len);
+
+        if (n > 0) {
+            uint8_t *buf = slot_buf(inbound, slot);
+            const uint32_t offset = slot->head & QUEUE_MASK;
+            const size_t first = MIN(n, TCP_INBOUND_QUEUE_BYTES - offset);
+            memcpy(buf + offset, data, first);
+            memcpy(buf, data + first, n - first);
+            slot->head += n;
+            inbound->queued_bytes += n;
+            total = n;
+
+            if (slot->mark_count < TCP_INBOUND_MARKS) {
+                tcp_inbound_mark_t *mark = &slot->marks[(slot->mark_head + slot->mark_count) % TCP_INBOUND_MARKS];
+                mark->end = slot->head;
+                mark->received_us = now_us;
+                slot->mark_count++;
+            } else {
+                // 合并到最后一段, 等待时间按较早的到达时间计算
+                slot->marks[(slot->mark_head + TCP_INBOUND_MARKS - 1) % TCP_INBOUND_MARKS].end = slot->head;
+            }
+
+            if (slot->head - slot->tail > slot->peak_queued_bytes) {
+                slot->peak_queued_bytes = slot->head - slot->tail;
+            }
+        }
+
+        // 放不下的部分由调用者保留, 发送任务取走数据后通知重新交付
+        keep = hold && total < len;
+        if (keep) {
+            inbound->held = true;
+        }
+    }
+
+    if (slot) {
+        const size_t taken = keep ? total : len;
+        slot->rx_bytes += taken;
+        slot->drop_bytes += taken - total;
+    }
+    xSemaphoreGive(inbound->mutex);
+
+    if (held) {
+        *held = keep;
+    }
+    return total;
+}
+
+bool tcp_inbound_next(tcp_inbound_t *inbound, size_t limit, tcp_inbound_span_t *span)
+{
+    bool found = false;
+
+    if (limit == 0 || inbound->queued_bytes == 0) {
+        return false;
+    }
+
+    xSemaphoreTake(inbound->mutex, portMAX_DELAY);
+    for (int k = 0; k < TCP_INBOUND_MAX_CLIENTS && inbound->mode == UART_BRIDGE_TX_ARBITER_FAIR && inbound->pool; k++) {
+        const uint8_t index = (inbound->cursor + k) % TCP_INBOUND_MAX_CLIENTS;
+        tcp_inbound_slot_t *slot = &inbound->slots[index];
+        const uint32_t queued = slot->head - slot->tail;
+
+        if (!slot->client || queued == 0) {
+            slot->deficit = 0;
+            continue;
+        }
+
+        // 轮到这个客户端时补充本轮的额度
+        if (slot->deficit == 0) {
+            slot->deficit = TCP_INBOUND_QUANTUM;
+        }
+        inbound->cursor = index;
+
+        const uint32_t offset = slot->tail & QUEUE_MASK;
+        span->index = index;
+        span->seq = slot->seq;
+        span->data = slot_buf(inbound, slot) + offset;
+        span->len = MIN(MIN(queued, TCP_INBOUND_QUEUE_BYTES - offset), MIN(limit, slot->deficit));
+        inbound->busy = index;
+        found = true;
+        break;
+    }
+    xSemaphoreGive(inbound->mutex);
+
+    return found;
+}
+
+void tcp_inbound_consume(tcp_inbound_t *inbound, const tcp_inbound_span_t *span, size_t written,
+                         int64_t now_us, latency_hist_t *latency)
+{
+    xSemaphoreTake(inbound->mutex, portMAX_DELAY);
+    tcp_inbound_slot_t *slot = &inbound->slots[span->index];
+    inbound->busy = -1;
+
+    // 写入期间客户端断开, 队列已经清空
+    if (slot->client && slot->seq == span->seq) {
+        slot->tail += written;
+        inbound->queued_bytes -= written;
+        slot->deficit -= MIN(slot->deficit, written);
+
+        while (slot->mark_count > 0 && (int32_t)(slot->tail - slot->marks[slot->mark_head].end) >= 0) {
+            const uint32_t wait_us = (uint32_t)(now_us - slot->marks[slot->mark_head].received_us);
+            slot->wait_last_us = wait_us;
+            if (wait_us > slot->wait_max_us) {
+                slot->wait_max_us = wait_us;
+            }
+            if (latency) {
+                latency_hist_record(latency, wait_us);
+            }
+            slot->mark_head = (slot->mark_head + 1) % TCP_INBOUND_MARKS;
+            slot->mark_count--;
+        }
+
+        if (slot->head == slot->tail) {
+            slot->deficit = 0;
+        }
+    }
+
+    // 本轮额度用完, 轮到下一个客户端
+    if (slot->deficit == 0) {
+        inbound->cursor = (span->index + 1) % TCP_INBOUND_MAX_CLIENTS;
+    }
+    if (written > 0) {
+        notify_resume(inbound);
+    }
+    xSemaphoreGive(inbound->mutex);
+}
+
+bool tcp_inbound_pending(const tcp_inbound_t *inbound)
+{
+    return inbound->queued_bytes > 0;
+}
+
+void tcp_inbound_get_stats(tcp_inbound_t *inbound, uart_bridge_inbound_stats_t *stats, uint8_t *count)
+{
+    uint8_t n = 0;
+
+    xSemaphoreTake(inbound->mutex, portMAX_DELAY);
+    const tcp_inbound_slot_t *owner = (inbound->mode == UART_BRIDGE_TX_ARBITER_EXCLUSIVE) ? owner_slot(inbound) : NULL;
+    for (int i = 0; i < TCP_INBOUND_MAX_CLIENTS && n < *count; i++) {
+        const tcp_inbound_slot_t *slot = &inbound->slots[i];
+        if (!slot->client) {
+            continue;
+        }
+
+        uart_bridge_inbound_stats_t *s = &stats[n++];
+        memcpy(s->addr, slot->addr, sizeof(s->addr));
+        s->port = slot->port;
+        s->owner = (slot == owner);
+        s->rx_bytes = slot->rx_bytes;
+        s->drop_bytes = slot->drop_bytes;
+        s->queued_bytes = slot->head - slot->tail;
+        s->peak_queued_bytes = slot->peak_queued_bytes;
+        s->wait_last_us = slot->wait_last_us;
+        s->wait_max_us = slot->wait_max_us;
+    }
+    xSemaphoreGive(inbound->mutex);
+
+    *count = n;
+}
@@ -0,0 +1,431 @@
+/**
+ * @file traffic_capture.c
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 串口收发数据捕获
+ * @version 0.1
+ * @date 2025-11-03
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "traffic_capture.h"
+#include "ring_buffer.h"
+#include "task_profile.h"
+#include "hex_dump.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <fcntl.h>
+
+static const char *TAG = "traffic_capture";
+
+// 捕获任务检查缓冲区的周期
+#define CAPTURE_POLL_MS         20
+// 停止时等待捕获任务退出的最长时间
+#define CAPTURE_STOP_TIMEOUT_MS 2000
+// 发给TCP客户端的超时, 超时后断开, 捕获任务不会一直等待
+#define CAPTURE_SEND_TIMEOUT_MS 1000
+
+// pcap格式
+#define PCAP_MAGIC              0xa1b2c3d4
+#define PCAP_VERSION_MAJOR      2
+#define PCAP_VERSION_MINOR      4
+#define PCAP_LINKTYPE_USER0     147
+#define PCAP_PSEUDO_HEADER_LEN  2
+
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+
+// 环形缓冲区中每条记录的头, 后面紧跟cap_len字节数据
+typedef struct {
+    int64_t timestamp_us;
+    uint16_t orig_len;
+    uint16_t cap_len;
+} capture_record_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t version_major;
+    uint16_t version_minor;
+    int32_t thiszone;
+    uint32_t sigfigs;
+    uint32_t snaplen;
+    uint32_t network;
+} pcap_file_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t ts_sec;
+    uint32_t ts_usec;
+    uint32_t incl_len;
+    uint32_t orig_len;
+} pcap_record_header_t;
+
+static struct {
+    traffic_capture_config_t config;
+    atomic_uint mask;                       // 正在捕获的方向, 0表示未捕获
+    atomic_int writers[TRAFFIC_DIR_MAX];    // 正在写入的生产者数, 停止时等待归零
+    ring_buffer_t rings[TRAFFIC_DIR_MAX];
+    uint8_t *ring_mem[TRAFFIC_DIR_MAX];
+
+    atomic_uint truncated;
+    atomic_uint dropped_records;
+    atomic_uint dropped_bytes;
+    uint32_t records;                       // 只由捕获任务修改
+    uint32_t bytes;
+    uint32_t reported_drops;                // 控制台已提示过的丢弃数
+
+    volatile bool running;
+    TaskHandle_t task_handle;
+    int listen_sock;
+    int client_sock;
+    uint8_t data[TRAFFIC_CAPTURE_MAX_RECORD];
+} s_capture = {
+    .listen_sock = -1,
+    .client_sock = -1,
+};
+
+void traffic_capture_record(uint8_t source, traffic_dir_t dir, const uint8_t *data, size_t len)
+{
+    // 未捕获时只有这一次读取
+    if (!(atomic_load_explicit(&s_capture.mask, memory_order_relaxed) & TRAFFIC_DIR_BIT(dir)) ||
+        source != s_capture.config.source || len == 0) {
+        return;
+    }
+
+    atomic_fetch_add(&s_capture.writers[dir], 1);
+    // 重新检查, 保证停止后不再写入即将释放的缓冲区
+    if (atomic_load(&s_capture.mask) & TRAFFIC_DIR_BIT(dir)) {
+        ring_buffer_t *rb = &s_capture.rings[dir];
+        const capture_record_t record = {
+            .timestamp_us = esp_timer_get_time(),
+            .orig_len = (uint16_t)MIN(len, UINT16_MAX),
+            .cap_len = (uint16_t)MIN(len, s_capture.config.snaplen),
+        };
+
+        if (ring_buffer_free(rb) < sizeof(record) + record.cap_len) {
+            atomic_fetch_add(&s_capture.dropped_records, 1);
+            atomic_fetch_add(&s_capture.dropped_bytes, len);
+        } else {
+            ring_buffer_put(rb, 0, &record, sizeof(record));
+            ring_buffer_put(rb, sizeof(record), data, record.cap_len);
+            ring_buffer_commit(rb, sizeof(record) + record.cap_len);
+            if (record.cap_len < len) {
+                atomic_fetch_add(&s_capture.truncated, 1);
+            }
+        }
+    }
+    atomic_fetch_sub(&s_capture.writers[dir], 1);
+}
+
+/**
+ * @brief 两个方向中时间最早的一条记录
+ *
+ * @param record 输出, 记录头
+ * @return int 方向, -1表示没有记录
+ */
+static int next_record(capture_record_t *record)
+{
+    int found = -1;
+
+    for (int dir = 0; dir < TRAFFIC_DIR_MAX; dir++) {
+        ring_buffer_t *rb = &s_capture.rings[dir];
+        capture_record_t head;
+        if (!rb->buffer || ring_buffer_used(rb) < sizeof(head)) {
+            continue;
+        }
+        ring_buffer_peek(rb, 0, &head, sizeof(head));
+        if (found < 0 || head.timestamp_us < record->timestamp_us) {
+            *record = head;
+            found = dir;
+        }
+    }
+
+    return found;
+}
+
+static bool send_all(int sock, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+
+    while (len > 0) {
+        int sent = send(sock, p, len, 0);
+        if (sent <= 0) {
+            return false;
+        }
+        p += sent;
+        len -= sent;
+    }
+    return true;
+}
+
+static void close_client(void)
+{
+    if (s_capture.client_sock >= 0) {
+        close(s_capture.client_sock);
+        s_capture.client_sock = -1;
+        ESP_LOGI(TAG, "capture client disconnected");
+    }
+}
+
+static void accept_client(void)
+{
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    int sock = accept(s_capture.listen_sock, (struct sockaddr *)&addr, &addr_len);
+    if (sock < 0) {
+        return;
+    }
+
+    const struct timeval timeout = {
+        .tv_sec = CAPTURE_SEND_TIMEOUT_MS / 1000,
+        .tv_usec = (CAPTURE_SEND_TIMEOUT_MS % 1000) * 1000,
+    };
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    const pcap_file_header_t header = {
+        .magic = PCAP_MAGIC,
+        .version_major = PCAP_VERSION_MAJOR,
+        .version_minor = PCAP_VERSION_MINOR,
+        .thiszone = 0,
+        .sigfigs = 0,
+        .snaplen = s_capture.config.snaplen + PCAP_PSEUDO_HEADER_LEN,
+        .network = PCAP_LINKTYPE_USER0,
+    };
+    if (!send_all(sock, &header, sizeof(header))) {
+        close(sock);
+        return;
+    }
+
+    s_capture.client_sock = sock;
+    ESP_LOGI(TAG, "capture client connected from %s", inet_ntoa(addr.sin_addr));
+}
+
+static void output_console(int dir, const capture_record_t *record)
+{
+    char prefix[64];
+
+    snprintf(prefix, sizeof(prefix), "[%" PRId64 ".%06" PRId64 "] U%d %s[len=%u%s]:",
+             record->timestamp_us / 1000000, record->timestamp_us % 1000000, s_capture.config.source + 1,
+             dir == TRAFFIC_DIR_UART_RX ? "rx from uart" : "tx to uart",
+             record->orig_len, record->cap_len < record->orig_len ? ",truncated" : "");
+    hex_dump(s_capture.data, record->cap_len, prefix);
+}
+
+static bool output_tcp(int dir, const capture_record_t *record)
+{
+    const pcap_record_header_t header = {
+        .ts_sec = (uint32_t)(record->timestamp_us / 1000000),
+        .ts_usec = (uint32_t)(record->timestamp_us % 1000000),
+        .incl_len = record->cap_len + PCAP_PSEUDO_HEADER_LEN,
+        .orig_len = record->orig_len + PCAP_PSEUDO_HEADER_LEN,
+    };
+    const uint8_t pseudo[PCAP_PSEUDO_HEADER_LEN] = { s_capture.config.source, (uint8_t)dir };
+
+    return send_all(s_capture.client_sock, &header, sizeof(header)) &&
+           send_all(s_capture.client_sock, pseudo, sizeof(pseudo)) &&
+           send_all(s_capture.client_sock, s_capture.data, record->cap_len);
+}
+
+static void capture_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "capture task started");
+
+    while (s_capture.running) {
+        const bool tcp = (s_capture.config.sink == TRAFFIC_SINK_TCP);
+        if (tcp && s_capture.client_sock < 0) {
+            accept_client();
+        }
+
+        capture_record_t record;
+        int dir;
+        while ((dir = next_record(&record)) >= 0) {
+            ring_buffer_t *rb = &s_capture.rings[dir];
+            ring_buffer_peek(rb, sizeof(record), s_capture.data, record.cap_len);
+            ring_buffer_consume(rb, sizeof(record) + record.cap_len);
+
+            if (!tcp) {
+                output_console(dir, &record);
+            } else if (s_capture.client_sock < 0) {
+                // 没有客户端时直接丢弃, 连接后从最新的数据开始
+                continue;
+            } else if (!output_tcp(dir, &record)) {
+                close_client();
+                continue;
+            }
+            s_capture.records++;
+            s_capture.bytes += record.cap_len;
+        }
+
+        const uint32_t dropped = atomic_load(&s_capture.dropped_records);
+        if (!tcp && dropped != s_capture.reported_drops) {
+            printf("*** capture overflow, %" PRIu32 " records dropped\n", dropped - s_capture.reported_drops);
+            s_capture.reported_drops = dropped;
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(CAPTURE_POLL_MS));
+    }
+
+    close_client();
+    ESP_LOGI(TAG, "capture task stopped");
+    s_capture.task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+static int open_listen_socket(uint16_t port)
+{
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "failed to create socket: errno %d", errno);
+        return -1;
+    }
+
+    int opt = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(sock, 1) != 0) {
+        ESP_LOGE(TAG, "failed to listen on port(%d): errno %d", port, errno);
+        close(sock);
+        return -1;
+    }
+
+    // 捕获任务轮询连接, 不能阻塞在accept上
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    return sock;
+}
+
+static void free_rings(void)
+{
+    for (int dir = 0; dir < TRAFFIC_DIR_MAX; dir++) {
+        free(s_capture.ring_mem[dir]);
+        s_capture.ring_mem[dir] = NULL;
+        memset(&s_capture.rings[dir], 0, sizeof(ring_buffer_t));
+    }
+}
+
+esp_err_t traffic_capture_start(const traffic_capture_config_t *config)
+{
+    if (!config || config->sink >= TRAFFIC_SINK_MAX || (config->dir_mask & TRAFFIC_DIR_ALL) == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    traffic_capture_stop();
+
+    s_capture.config = *config;
+    s_capture.config.dir_mask &= TRAFFIC_DIR_ALL;
+    if (s_capture.config.snaplen == 0 || s_capture.config.snaplen > TRAFFIC_CAPTURE_MAX_RECORD) {
+        s_capture.config.snaplen = TRAFFIC_CAPTURE_MAX_RECORD;
+    }
+
+    for (int dir = 0; dir < TRAFFIC_DIR_MAX; dir++) {
+        if (!(s_capture.config.dir_mask & TRAFFIC_DIR_BIT(dir))) {
+            continue;
+        }
+        s_capture.ring_mem[dir] = malloc(TRAFFIC_CAPTURE_RING_SIZE);
+        if (!s_capture.ring_mem[dir]) {
+            ESP_LOGE(TAG, "failed to allocate capture buffer");
+            free_rings();
+            return ESP_ERR_NO_MEM;
+        }
+        ring_buffer_init(&s_capture.rings[dir], s_capture.ring_mem[dir], TRAFFIC_CAPTURE_RING_SIZE);
+    }
+
+    if (s_capture.config.sink == TRAFFIC_SINK_TCP) {
+        s_capture.listen_sock = open_listen_socket(s_capture.config.tcp_port);
+        if (s_capture.listen_sock < 0) {
+            free_rings();
+            return ESP_FAIL;
+        }
+    }
+
+    atomic_store(&s_capture.truncated, 0);
+    atomic_store(&s_capture.dropped_records, 0);
+    atomic_store(&s_capture.dropped_bytes, 0);
+    s_capture.records = 0;
+    s_capture.bytes = 0;
+    s_capture.reported_drops = 0;
+
+    s_capture.running = true;
+    if (task_profile_create(capture_task, "capture", TRAFFIC_CAPTURE_STACK_SIZE, NULL,
+                            TASK_ROLE_CAPTURE, &s_capture.task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "failed to create capture task");
+        s_capture.running = false;
+        s_capture.task_handle = NULL;
+        if (s_capture.listen_sock >= 0) {
+            close(s_capture.listen_sock);
+            s_capture.listen_sock = -1;
+        }
+        free_rings();
+        return ESP_ERR_NO_MEM;
+    }
+
+    // 缓冲区准备好之后才允许写入
+    atomic_store(&s_capture.mask, s_capture.config.dir_mask);
+    ESP_LOGI(TAG, "capture started, bridge(%d), dir(0x%x), sink(%s)", s_capture.config.source,
+             s_capture.config.dir_mask, s_capture.config.sink == TRAFFIC_SINK_TCP ? "tcp" : "console");
+    return ESP_OK;
+}
+
+esp_err_t traffic_capture_stop(void)
+{
+    if (!s_capture.task_handle) {
+        return ESP_OK;
+    }
+
+    atomic_store(&s_capture.mask, 0);
+    for (int dir = 0; dir < TRAFFIC_DIR_MAX; dir++) {
+        while (atomic_load(&s_capture.writers[dir]) > 0) {
+            vTaskDelay(1);
+        }
+    }
+
+    s_capture.running = false;
+    TickType_t start = xTaskGetTickCount();
+    while (s_capture.task_handle) {
+        if (xTaskGetTickCount() - start > pdMS_TO_TICKS(CAPTURE_STOP_TIMEOUT_MS)) {
+            ESP_LOGE(TAG, "capture task did not stop in time");
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    if (s_capture.listen_sock >= 0) {
+        close(s_capture.listen_sock);
+        s_capture.listen_sock = -1;
+    }
+    free_rings();
+
+    ESP_LOGI(TAG, "capture stopped, %" PRIu32 " records, %" PRIu32 " dropped",
+             s_capture.records, (uint32_t)atomic_load(&s_capture.dropped_records));
+    return ESP_OK;
+}
+
+esp_err_t traffic_capture_get_stats(traffic_capture_stats_t *stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    stats->running = (s_capture.task_handle != NULL);
+    stats->client_connected = (s_capture.client_sock >= 0);
+    stats->config = s_capture.config;
+    stats->records = s_capture.records;
+    stats->bytes = s_capture.bytes;
+    stats->truncated = atomic_load(&s_capture.truncated);
+    stats->dropped_records = atomic_load(&s_capture.dropped_records);
+    stats->dropped_bytes = atomic_load(&s_capture.dropped_bytes);
+    return ESP_OK;
+}
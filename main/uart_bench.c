@@ -0,0 +1,444 @@
+/**
+ * @file uart_bench.c
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 串口内部回环测试
+ * @version 0.1
+ * @date 2025-11-04
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "uart_bench.h"
+#include "perf_metrics.h"
+#include "task_profile.h"
+#include "task_monitor.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+
+static const char *TAG = "uart_bench";
+
+// 切换波特率后等待串口和缓冲区稳定的时间
+#define BENCH_SETTLE_MS         200
+// 连接后等待tcp_server把客户端加入转发列表的时间
+#define BENCH_CONNECT_WAIT_MS   200
+// 发送结束后, 连续这么久没有收到数据就结束本轮
+#define BENCH_DRAIN_IDLE_MS     300
+// 发送结束后最多等待的时间
+#define BENCH_DRAIN_MAX_MS      3000
+// 每次等待接收的最长时间, 同时决定发送的节奏
+#define BENCH_POLL_MS           5
+#define BENCH_STOP_TIMEOUT_MS   (BENCH_DRAIN_MAX_MS + 2000)
+
+static const uint8_t s_magic[4] = { 'U', 'B', 'C', 'H' };
+
+// 数据块头, 后面是按序号生成的填充数据
+typedef struct __attribute__((packed)) {
+    uint8_t magic[4];
+    uint32_t seq;
+    int64_t sent_us;
+} bench_header_t;
+
+_Static_assert(sizeof(bench_header_t) == UART_BENCH_HEADER_LEN, "bench header size");
+
+static struct {
+    SemaphoreHandle_t mutex;        // 保护status
+    uart_bench_status_t status;
+    uint32_t baudrates[UART_BENCH_MAX_STEPS];
+    uart_bridge_handle_t bridge;
+    TaskHandle_t task_handle;
+    volatile bool stop;
+
+    // 以下只由测试任务使用
+    latency_hist_t rtt;
+    uint32_t tx_seq;
+    uint32_t rx_seq;                // 期望收到的下一个序号
+    size_t rx_len;
+    uint8_t tx_buf[UART_BENCH_MAX_CHUNK];
+    uint8_t rx_buf[UART_BENCH_MAX_CHUNK * 2];
+} s_bench;
+
+static void build_chunk(uint8_t *buf, uint16_t size, uint32_t seq)
+{
+    bench_header_t header;
+
+    memcpy(header.magic, s_magic, sizeof(s_magic));
+    header.seq = seq;
+    header.sent_us = esp_timer_get_time();
+    memcpy(buf, &header, sizeof(header));
+    for (uint16_t i = sizeof(header); i < size; i++) {
+        buf[i] = (uint8_t)(seq + i);
+    }
+}
+
+static bool chunk_is_valid(const uint8_t *buf, uint16_t size, uint32_t seq)
+{
+    for (uint16_t i = sizeof(bench_header_t); i < size; i++) {
+        if (buf[i] != (uint8_t)(seq + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 解析收到的数据, 回环过程中可能丢失字节, 按标记重新对齐
+ *
+ * @param chunk_size
+ * @param result
+ */
+static void parse_received(uint16_t chunk_size, uart_bench_result_t *result)
+{
+    size_t pos = 0;
+
+    while (s_bench.rx_len - pos >= sizeof(bench_header_t)) {
+        const uint8_t *p = s_bench.rx_buf + pos;
+        if (memcmp(p, s_magic, sizeof(s_magic)) != 0) {
+            pos++;
+            result->corrupt_bytes++;
+            continue;
+        }
+        if (s_bench.rx_len - pos < chunk_size) {
+            break;
+        }
+
+        bench_header_t header;
+        memcpy(&header, p, sizeof(header));
+        if (!chunk_is_valid(p, chunk_size, header.seq)) {
+            // 块内有丢失, 跳过块头后继续查找下一个标记
+            pos += sizeof(header);
+            result->corrupt_bytes += sizeof(header);
+            continue;
+        }
+
+        if (header.seq >= s_bench.rx_seq) {
+            result->lost_chunks += header.seq - s_bench.rx_seq;
+            s_bench.rx_seq = header.seq + 1;
+        }
+        latency_hist_record(&s_bench.rtt, (uint32_t)(esp_timer_get_time() - header.sent_us));
+        pos += chunk_size;
+    }
+
+    memmove(s_bench.rx_buf, s_bench.rx_buf + pos, s_bench.rx_len - pos);
+    s_bench.rx_len -= pos;
+}
+
+static void drain_socket(int sock)
+{
+    while (recv(sock, s_bench.rx_buf, sizeof(s_bench.rx_buf), MSG_DONTWAIT) > 0) {
+    }
+    s_bench.rx_len = 0;
+}
+
+static void run_local_step(int sock, const uart_bench_config_t *config, uart_bench_result_t *result)
+{
+    const uint16_t chunk = config->chunk_size;
+    const uint64_t rate = result->rate;
+    const int64_t start_us = esp_timer_get_time();
+    const int64_t send_end_us = start_us + (int64_t)config->duration_sec * 1000000;
+    int64_t last_rx_us = start_us;
+    uint64_t tx_bytes = 0;
+    size_t tx_offset = 0;           // 当前数据块已发送的字节数, 0表示需要新的数据块
+
+    latency_hist_reset(&s_bench.rtt);
+    s_bench.tx_seq = 0;
+    s_bench.rx_seq = 0;
+
+    while (!s_bench.stop) {
+        int64_t now_us = esp_timer_get_time();
+
+        if (now_us < send_end_us) {
+            // 按设定速率发送, 发送缓冲区满时下次再试
+            const uint64_t allowed = (uint64_t)(now_us - start_us) * rate / 1000000;
+            while (tx_offset > 0 || tx_bytes + chunk <= allowed) {
+                if (tx_offset == 0) {
+                    build_chunk(s_bench.tx_buf, chunk, s_bench.tx_seq);
+                }
+                int sent = send(sock, s_bench.tx_buf + tx_offset, chunk - tx_offset, MSG_DONTWAIT);
+                if (sent <= 0) {
+                    break;
+                }
+                tx_offset += sent;
+                tx_bytes += sent;
+                if (tx_offset == chunk) {
+                    tx_offset = 0;
+                    s_bench.tx_seq++;
+                }
+            }
+        } else if (now_us - last_rx_us > BENCH_DRAIN_IDLE_MS * 1000 ||
+                   now_us - send_end_us > BENCH_DRAIN_MAX_MS * 1000) {
+            break;
+        }
+
+        fd_set readfds;
+        FD_ZERO(&readfds);
+        FD_SET(sock, &readfds);
+        struct timeval timeout = { .tv_sec = 0, .tv_usec = BENCH_POLL_MS * 1000 };
+        if (select(sock + 1, &readfds, NULL, NULL, &timeout) <= 0) {
+            continue;
+        }
+
+        int len = recv(sock, s_bench.rx_buf + s_bench.rx_len, sizeof(s_bench.rx_buf) - s_bench.rx_len, MSG_DONTWAIT);
+        if (len <= 0) {
+            if (len == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                ESP_LOGE(TAG, "bench client disconnected");
+                break;
+            }
+            continue;
+        }
+        last_rx_us = esp_timer_get_time();
+        result->rx_bytes += len;
+        s_bench.rx_len += len;
+        parse_received(chunk, result);
+    }
+
+    // 发出但没有收回的数据块也算丢失
+    if (s_bench.tx_seq > s_bench.rx_seq) {
+        result->lost_chunks += s_bench.tx_seq - s_bench.rx_seq;
+    }
+
+    const int64_t elapsed_us = last_rx_us - start_us;
+    result->duration_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+    result->tx_bytes = (uint32_t)tx_bytes;
+    result->throughput = elapsed_us > 0 ? (uint32_t)((uint64_t)result->rx_bytes * 1000000 / elapsed_us) : 0;
+    result->latency.count = s_bench.rtt.count;
+    result->latency.p50_us = latency_hist_percentile(&s_bench.rtt, 50);
+    result->latency.p95_us = latency_hist_percentile(&s_bench.rtt, 95);
+    result->latency.p99_us = latency_hist_percentile(&s_bench.rtt, 99);
+    result->latency.max_us = s_bench.rtt.max_us;
+    result->latency.sum_us = s_bench.rtt.sum_us;
+}
+
+static void run_external_step(uart_bridge_handle_t bridge, const uart_bench_config_t *config,
+                              uart_bench_result_t *result)
+{
+    const int64_t start_us = esp_timer_get_time();
+    const int64_t end_us = start_us + (int64_t)config->duration_sec * 1000000;
+
+    while (!s_bench.stop && esp_timer_get_time() < end_us) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+
+    uart_bridge_stats_t stats;
+    uart_bridge_perf_t perf;
+    const int64_t elapsed_us = esp_timer_get_time() - start_us;
+    result->duration_ms = (uint32_t)(elapsed_us / 1000);
+    if (uart_bridge_get_stats(bridge, &stats) == ESP_OK) {
+        result->tx_bytes = (uint32_t)stats.uart_tx_bytes;
+        result->rx_bytes = (uint32_t)stats.uart_rx_bytes;
+        result->throughput = elapsed_us > 0 ? (uint32_t)(stats.uart_rx_bytes * 1000000 / elapsed_us) : 0;
+    }
+    if (uart_bridge_get_perf(bridge, &perf) == ESP_OK) {
+        result->latency = perf.latency[UART_BRIDGE_LATENCY_UART_RX];
+    }
+}
+
+static void collect_bridge_counters(uart_bridge_handle_t bridge, uart_bench_result_t *result)
+{
+    uart_bridge_stats_t stats;
+
+    if (uart_bridge_get_stats(bridge, &stats) == ESP_OK) {
+        result->uart_tx_drop_bytes = (uint32_t)stats.uart_tx_drop_bytes;
+        result->ring_overrun_bytes = (uint32_t)stats.ring_overrun_bytes;
+        result->fifo_overflows = (uint32_t)stats.uart_fifo_ovf_count;
+        result->tcp_drop_bytes = (uint32_t)stats.tcp_tx_error_bytes;
+    }
+}
+
+static int connect_local(uint16_t port)
+{
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "failed to create socket: errno %d", errno);
+        return -1;
+    }
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        ESP_LOGE(TAG, "failed to connect to local port(%d): errno %d", port, errno);
+        close(sock);
+        return -1;
+    }
+
+    int opt = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    vTaskDelay(pdMS_TO_TICKS(BENCH_CONNECT_WAIT_MS));
+    return sock;
+}
+
+static void bench_task(void *pvParameters)
+{
+    uart_bridge_handle_t bridge = s_bench.bridge;
+    const uart_bench_config_t *config = &s_bench.status.config;
+    uart_bridge_status_t bridge_status;
+    int sock = -1;
+
+    uart_bridge_get_status(bridge, &bridge_status);
+    const uint32_t saved_baudrate = bridge_status.uart_baudrate;
+
+    if (config->client == UART_BENCH_CLIENT_LOCAL) {
+        sock = connect_local(bridge_status.tcp_port);
+    }
+
+    if ((config->client != UART_BENCH_CLIENT_LOCAL || sock >= 0) &&
+        uart_bridge_set_loopback(bridge, true) == ESP_OK) {
+        for (uint8_t step = 0; step < s_bench.status.step_count && !s_bench.stop; step++) {
+            uart_bench_result_t result = {
+                .baudrate = config->baudrates[step],
+            };
+            if (config->client == UART_BENCH_CLIENT_LOCAL) {
+                // 8N1每个字节10位
+                result.rate = config->rate ? config->rate
+                                           : result.baudrate / 10 * UART_BENCH_AUTO_RATE_PERCENT / 100;
+            }
+
+            if (uart_bridge_set_baudrate(bridge, result.baudrate) != ESP_OK) {
+                continue;
+            }
+            vTaskDelay(pdMS_TO_TICKS(BENCH_SETTLE_MS));
+            if (sock >= 0) {
+                drain_socket(sock);
+            }
+            uart_bridge_reset_stats(bridge);
+
+            task_monitor_mark_t mark;
+            task_monitor_mark(&mark);
+            if (config->client == UART_BENCH_CLIENT_LOCAL) {
+                run_local_step(sock, config, &result);
+            } else {
+                run_external_step(bridge, config, &result);
+            }
+            const uint32_t busy_us = task_monitor_busy_us_since(&mark);
+            if (result.rx_bytes > 0) {
+                result.cpu_ms_per_mb = (uint32_t)((uint64_t)busy_us * 1024 * 1024 / result.rx_bytes / 1000);
+            }
+            collect_bridge_counters(bridge, &result);
+
+            ESP_LOGI(TAG, "baudrate(%" PRIu32 "): %" PRIu32 " B/s, lost %" PRIu32 ", p99 %" PRIu32 " us, cpu %" PRIu32 " ms/MB",
+                     result.baudrate, result.throughput, result.lost_chunks, result.latency.p99_us, result.cpu_ms_per_mb);
+
+            xSemaphoreTake(s_bench.mutex, portMAX_DELAY);
+            s_bench.status.results[step] = result;
+            s_bench.status.step = step + 1;
+            xSemaphoreGive(s_bench.mutex);
+        }
+        uart_bridge_set_loopback(bridge, false);
+    }
+
+    if (sock >= 0) {
+        close(sock);
+    }
+    if (saved_baudrate != 0) {
+        uart_bridge_set_baudrate(bridge, saved_baudrate);
+    }
+
+    ESP_LOGI(TAG, "benchmark finished");
+    xSemaphoreTake(s_bench.mutex, portMAX_DELAY);
+    s_bench.status.running = false;
+    xSemaphoreGive(s_bench.mutex);
+    s_bench.task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t uart_bench_start(uart_bridge_handle_t bridge, const uart_bench_config_t *config)
+{
+    if (!bridge || !config || !config->baudrates || config->baudrate_count == 0 ||
+        config->client >= UART_BENCH_CLIENT_MAX ||
+        config->duration_sec == 0 || config->duration_sec > UART_BENCH_MAX_SEC) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (config->client == UART_BENCH_CLIENT_LOCAL &&
+        (config->chunk_size < UART_BENCH_MIN_CHUNK || config->chunk_size > UART_BENCH_MAX_CHUNK)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_bench.task_handle) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // RFC2217会解释数据中的0xFF, 只支持普通TCP
+    uart_bridge_status_t bridge_status;
+    if (uart_bridge_get_status(bridge, &bridge_status) != ESP_OK ||
+        bridge_status.transport != UART_BRIDGE_TRANSPORT_TCP || !bridge_status.tcp_standby) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (!s_bench.mutex) {
+        s_bench.mutex = xSemaphoreCreateMutex();
+        if (!s_bench.mutex) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    const uint8_t count = config->baudrate_count < UART_BENCH_MAX_STEPS ? config->baudrate_count : UART_BENCH_MAX_STEPS;
+    memcpy(s_bench.baudrates, config->baudrates, count * sizeof(uint32_t));
+
+    xSemaphoreTake(s_bench.mutex, portMAX_DELAY);
+    memset(&s_bench.status, 0, sizeof(s_bench.status));
+    s_bench.status.running = true;
+    s_bench.status.bridge_index = bridge_status.index;
+    s_bench.status.step_count = count;
+    s_bench.status.tcp_engine = bridge_status.tcp_engine;
+    s_bench.status.config = *config;
+    s_bench.status.config.baudrates = s_bench.baudrates;
+    s_bench.status.config.baudrate_count = count;
+    xSemaphoreGive(s_bench.mutex);
+
+    s_bench.bridge = bridge;
+    s_bench.stop = false;
+    if (task_profile_create(bench_task, "uart_bench", UART_BENCH_STACK_SIZE, NULL,
+                            TASK_ROLE_BENCH, &s_bench.task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "failed to create bench task");
+        s_bench.task_handle = NULL;
+        s_bench.status.running = false;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "benchmark started, %d baudrates, chunk(%d), %d s each",
+             count, config->chunk_size, config->duration_sec);
+    return ESP_OK;
+}
+
+esp_err_t uart_bench_stop(void)
+{
+    if (!s_bench.task_handle) {
+        return ESP_OK;
+    }
+
+    s_bench.stop = true;
+    TickType_t start = xTaskGetTickCount();
+    while (s_bench.task_handle) {
+        if (xTaskGetTickCount() - start > pdMS_TO_TICKS(BENCH_STOP_TIMEOUT_MS)) {
+            ESP_LOGE(TAG, "bench task did not stop in time");
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return ESP_OK;
+}
+
+esp_err_t uart_bench_get_status(uart_bench_status_t *status)
+{
+    if (!status) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_bench.mutex) {
+        memset(status, 0, sizeof(uart_bench_status_t));
+        return ESP_OK;
+    }
+
+    xSemaphoreTake(s_bench.mutex, portMAX_DELAY);
+    memcpy(status, &s_bench.status, sizeof(uart_bench_status_t));
+    xSemaphoreGive(s_bench.mutex);
+    return ESP_OK;
+}
@@ -10,15 +10,33 @@
  */
 
 #include "uart_bridge.h"
+#include "ring_buffer.h"
+#include "outage_buffer.h"
+#include "tcp_fanout.h"
+#include "tcp_inbound.h"
+#include "udp_transport.h"
+#include "rfc2217.h"
+#include "modbus_gw.h"
+#include "uart_dma_rx.h"
+#include "perf_metrics.h"
+#include "task_profile.h"
+#include "link_profile.h"
 #include "tcp_server.h"
+#include "raw_tcp_server.h"
 #include "bus_manager.h"
-#include "hex_dump.h"
+#include "board.h"
+#include "traffic_capture.h"
+#include "mem_arena.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "freertos/semphr.h"
 #include "esp_log.h"
 #include "esp_err.h"
+#include "esp_intr_alloc.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_sleep.h"
 #include "nvs_flash.h"
 #include "nvs.h"
 #include "driver/uart.h"
@@ -28,6 +46,7 @@
 #include "lwip/netdb.h"
 #include "lwip/inet.h"
 #include <string.h>
+#include <stdatomic.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include "driver/gpio.h"
@@ -40,461 +59,3864 @@
 static const char *TAG = "uart_bridge";
 
 // NVS存储键名
+// 实例0使用原来的命名空间, 其它实例加上序号
 #define NVS_NAMESPACE           "uart_bridge"
+#define NVS_KEY_INSTANCES       "instances"
 #define NVS_KEY_TCP_PORT        "tcp_port"
 #define NVS_KEY_UART_BAUDRATE   "baudrate"
+#define NVS_KEY_SLOW_POLICY     "slow_policy"
+#define NVS_KEY_STALL_MS        "stall_ms"
+#define NVS_KEY_RX_CONFIG       "rx_config"
+#define NVS_KEY_UART_TX_POLICY  "tx_policy"
+#define NVS_KEY_BUF_OVERRIDE    "buf_override"
+#define NVS_KEY_FLOW_CTRL       "flow_ctrl"
+#define NVS_KEY_TRANSPORT       "transport"
+#define NVS_KEY_UDP_CONFIG      "udp_config"
+#define NVS_KEY_LINE_FORMAT     "line_format"
+#define NVS_KEY_RFC2217_SAVE    "rfc2217_save"
+#define NVS_KEY_RX_ENGINE       "rx_engine"
+#define NVS_KEY_OUTAGE_BUF      "outage_buf"
+#define NVS_KEY_SOCK_OPTS       "sock_opts"
+#define NVS_KEY_TCP_ENGINE      "tcp_engine"
+#define NVS_KEY_RTU_FRAMING     "rtu_framing"
+#define NVS_KEY_MODBUS          "modbus_cfg"
+#define NVS_KEY_TX_ARBITER      "tx_arbiter"
+
+// 环形缓冲区满时, 等待发送任务释放空间的最长时间
+#define RING_FULL_WAIT_MS       10
+// 环形缓冲区满时, 丢弃串口数据使用的临时缓冲区大小
+#define RING_DISCARD_BUF_SIZE   128
+// 客户端队列中还有数据时, 重试发送的周期
+#define SENDER_RETRY_MS         5
+// 调整缓冲区时, 等待读取/发送任务暂停的最长时间
+#define TASK_PAUSE_TIMEOUT_MS   1000
+// 读取统计快照时, 连续重试多少次后让出CPU给正在写入的任务
+#define STATS_READ_SPIN         8
+// 分包时间戳队列长度
+#define RX_MARK_QUEUE_LEN       32
+// RFC2217客户端可以设置的波特率范围
+#define RFC2217_BAUDRATE_MIN    300
+#define RFC2217_BAUDRATE_MAX    5000000
+// 浅睡眠时, RX线上多少个上升沿唤醒芯片(硬件最小值为3)
+#define UART_WAKEUP_THRESHOLD   3
+// RTU帧间隔, 波特率高于19200时按Modbus规范固定为1750us
+#define RTU_GAP_FIXED_BAUDRATE  19200
+#define RTU_GAP_FIXED_US        1750
 
 typedef struct {
     uint16_t tcp_port;
     uint32_t baudrate;
+    uint8_t slow_client_policy;
+    uint32_t stall_timeout_ms;
+    uart_bridge_rx_config_t rx;
+    uint8_t uart_tx_policy;
+    uart_bridge_buffer_sizes_t buffer_override;
+    uint8_t flow_ctrl;
+    uint8_t rts_thresh;
+    uint8_t transport;
+    uart_bridge_udp_config_t udp;
+    // 串口数据格式, 取值为uart_word_length_t/uart_parity_t/uart_stop_bits_t
+    uint8_t data_bits;
+    uint8_t parity;
+    uint8_t stop_bits;
+    uint8_t rfc2217_persist;    // RFC2217客户端修改的串口参数是否保存到NVS
+    uint8_t rx_engine;
+    uint32_t outage_buf_size;   // 断网缓存大小, 0表示不启用
+    uart_bridge_sock_opts_t sock;
+    uint8_t tcp_engine;
+    uint8_t rtu_framing;        // 按RTU帧间隔分包
+    uart_bridge_modbus_config_t modbus;
+    uint8_t tx_arbiter;         // 多个TCP客户端写入串口的仲裁方式
 }uart_bridge_config_t;
 
-// 模块状态结构体
+// 当前生效的串口参数, RFC2217客户端可以临时修改而不保存
+typedef struct {
+    uint32_t baudrate;
+    uint8_t data_bits;
+    uint8_t parity;
+    uint8_t stop_bits;
+    uint8_t flow_ctrl;
+} uart_line_t;
+
+// RFC2217客户端会话
+typedef struct {
+    tcp_client_t *client;       // NULL表示空闲
+    rfc2217_session_t session;
+} rfc2217_client_t;
+
+// 统计信息分片, 每个分片只由一个任务写入
+typedef enum {
+    STATS_SHARD_READER = 0, // 串口读取任务
+    STATS_SHARD_SENDER,     // TCP发送任务, Modbus网关方式下同时负责写入串口
+    STATS_SHARD_NET,        // 网络接收: tcp_server回调(接收/连接/断开)或UDP接收任务, 两者不会同时运行
+    STATS_SHARD_MAX,
+} stats_shard_id_t;
+
+// 写入者在更新前后各递增一次seq(顺序锁), 读取者通过seq判断读到的数据是否完整
+typedef struct {
+    atomic_uint seq;
+    uart_bridge_stats_t counters;
+} stats_shard_t;
+
+_Static_assert(sizeof(uart_bridge_stats_t) % sizeof(uint64_t) == 0,
+               "uart_bridge_stats_t must only contain uint64_t counters");
+
+// 分包提交原因
+typedef enum {
+    UART_RX_FLUSH_NONE = 0,
+    UART_RX_FLUSH_IDLE,
+    UART_RX_FLUSH_SIZE,
+    UART_RX_FLUSH_HOLD,
+} uart_rx_flush_reason_t;
+
+// 串口接收分包状态, 只由读取任务访问
+typedef struct {
+    size_t pending;         // 已读入环形缓冲区但还未提交的字节数
+    TickType_t start;       // 当前分包第一个字节读入的时间
+    int64_t start_us;       // 同上, 用于延迟统计
+    uint32_t commit_pos;    // 已提交的总字节数
+    int64_t throttle_us;    // 开启流控时, 接收被节流(RTS拉高)的起始时间, 0表示没有节流
+    size_t frame_len;       // 分帧模式下, 当前帧在环形缓冲区回绕前已提交的字节数
+    size_t dma_end;         // DMA传输写满时的pending, 用于区分写满和线路空闲
+    bool dma_split;         // 分帧模式下DMA传输在回绕处写满, 帧可能正好在这里结束
+} uart_rx_packet_t;
+
+// 分包时间戳, 读取任务写入, 发送任务读出
 typedef struct {
+    uint32_t end_pos;       // 分包结束位置(已提交的总字节数)
+    int64_t arrival_us;     // 分包第一个字节读入的时间
+} uart_rx_mark_t;
+
+// 桥接实例状态结构体
+typedef struct uart_bridge {
+    uint8_t index;              // 实例序号, 与串口ID相同
+    char nvs_namespace[16];
     uart_bridge_config_t config;
-    uart_bridge_stats_t stats;
+    uart_line_t line;
+    // 统计信息按写入任务分片, 热路径不需要加锁
+    stats_shard_t stats_shards[STATS_SHARD_MAX];
+    atomic_uint ring_high_water;
+    uart_bridge_stats_t stats_base; // 重置统计时的快照, 由stats_mutex保护
+    // 延迟和吞吐量, 每一项只由一个任务写入
+    latency_hist_t latency[UART_BRIDGE_LATENCY_MAX];
+    rate_meter_t uart_rx_rate;  // 读取任务写入
+    rate_meter_t uart_tx_rate;  // tcp_server回调, UDP接收任务或发送任务(Modbus网关, 公平仲裁)写入
+    uart_rx_mark_t rx_marks[RX_MARK_QUEUE_LEN];
+    atomic_uint rx_mark_head;
+    atomic_uint rx_mark_tail;
+    uint32_t rx_consume_pos;    // 发送任务已取出的总字节数
     bool initialized;
     bool running; // 任务是否在运行,由运行任务自已管理 
-    bool uart_tx_verbose;
-    bool uart_rx_verbose;
+    bool sender_running; // 发送任务是否在运行,由发送任务自已管理
+    // 调整缓冲区时暂停读取/发送任务
+    volatile bool reader_pause;
+    volatile bool reader_parked;
+    volatile bool sender_pause;
+    volatile bool sender_parked;
+    uart_bridge_buffer_sizes_t buffers; // 当前使用的缓冲区大小
+    uint32_t read_chunk;
     uint8_t uart_port;
+    int rts_pin;
+    int cts_pin;
+    QueueHandle_t uart_queue; // 串口驱动事件队列
     tcp_server_handle_t tcp_server;
-    SemaphoreHandle_t stats_mutex;
+    raw_tcp_server_handle_t raw_server; // 与tcp_server同时只有一个在运行
+    SemaphoreHandle_t service_mutex;    // 串行化网络服务的启动和停止, WiFi事件, 主任务和命令行都会调用
+    SemaphoreHandle_t stats_mutex; // 只用于读取/重置统计快照, 不在热路径上使用
     TaskHandle_t task_handle;
+    TaskHandle_t sender_handle;
+    // 串口接收环形缓冲区, 读取任务写入, 发送任务读出
+    uint8_t *rx_ring_buf;
+    uint32_t rx_ring_capacity;  // rx_ring_buf的实际大小, 内存区中的缓冲区缩小后继续使用
+    ring_buffer_t rx_ring;
+    // DMA接收引擎, 只由读取任务访问
+    uart_dma_rx_t rx_dma;
+    bool rx_dma_active;
+    // 每个TCP客户端独立的发送队列
+    tcp_fanout_t fanout;
+    // 每个TCP客户端写入串口方向的仲裁, 公平方式下由tcp_server回调写入, 发送任务读出
+    tcp_inbound_t inbound;
+    // 断网缓存, 只由发送任务访问(调整大小时发送任务已暂停)
+    outage_buffer_t outage;
+    // UDP传输, 与TCP服务器二选一
+    udp_transport_t udp;
+    // RFC2217会话, 由rfc2217_mutex保护(tcp_server回调和发送任务)
+    rfc2217_client_t rfc2217_clients[UART_BRIDGE_MAX_CLIENTS];
+    SemaphoreHandle_t rfc2217_mutex;
+    atomic_uint line_events;    // 读取任务记录的线路错误, RFC2217_LINESTATE_xxx, 由发送任务通知客户端
+    bool rfc2217_dtr;           // 板子没有引出DTR, 只记录客户端设置的状态
+    bool rfc2217_rts;           // RTS由硬件流控使用, 同上
+    // RTU分帧, 只在读取和发送任务暂停时修改
+    volatile bool frame_mode;
+    uint8_t frame_buf[MODBUS_RTU_MAX_ADU]; // 发送任务取出跨越回绕的帧
+    // Modbus网关, 由modbus_mutex保护(tcp_server回调和发送任务), 第一次启动网关时分配缓冲区
+    modbus_gw_t modbus;
+    SemaphoreHandle_t modbus_mutex;
 } uart_bridge_t;
 
-static uart_bridge_t g_bridge = {0};
+static uart_bridge_t s_bridges[UART_BRIDGE_MAX_INSTANCES];
+
+// 状态变化回调, 所有实例共用
+static uart_bridge_change_cb_t s_change_cb;
+static void *s_change_ctx;
+
+static inline bool tcp_service_running(const uart_bridge_t *bridge)
+{
+    return (bridge->tcp_server != NULL) || (bridge->raw_server != NULL);
+}
+
+static inline void notify_change(const uart_bridge_t *bridge)
+{
+    const uart_bridge_change_cb_t cb = s_change_cb;
+    if (cb) {
+        cb(bridge->index, s_change_ctx);
+    }
+}
+
+static inline const tcp_fanout_io_t *tcp_engine_io(uint8_t engine)
+{
+    return (engine == UART_BRIDGE_TCP_ENGINE_RAW) ? &raw_tcp_server_fanout_io : &tcp_fanout_socket_io;
+}
 
 // 函数声明
 static void uart_bridge_task(void *pvParameters);
+static void uart_bridge_sender_task(void *pvParameters);
 static void on_tcp_data_received(tcp_client_t *client, const uint8_t *data, size_t len, void *user_ctx);
+static size_t on_raw_data_received(tcp_client_t *client, const uint8_t *data, size_t len, void *user_ctx);
+static void on_inbound_space(void *ctx);
 static void on_tcp_client_connected(tcp_client_t *client, void *user_ctx);
 static void on_tcp_client_disconnected(tcp_client_t *client, void *user_ctx);
-static esp_err_t uart_bridge_load_config(uart_bridge_config_t *config);
-static esp_err_t uart_bridge_save_config(const uart_bridge_config_t *config);
-static esp_err_t send_data_to_uart(const uint8_t *data, size_t len);
+static void on_udp_data_received(const uint8_t *data, size_t len, const udp_transport_rx_info_t *info, void *user_ctx);
+static esp_err_t uart_bridge_load_config(uart_bridge_t *bridge);
+static esp_err_t uart_bridge_save_config(const uart_bridge_t *bridge);
+static esp_err_t send_data_to_uart(uart_bridge_t *bridge, stats_shard_id_t shard, const uint8_t *data, size_t len);
+static esp_err_t uart_bridge_apply_flow_ctrl(uart_bridge_t *bridge, uint8_t mode, uint8_t rts_thresh);
+static void rfc2217_notify_line_events(uart_bridge_t *bridge);
+
+/**
+ * @brief 开始更新统计分片, 只能由该分片的写入任务调用
+ * 
+ * @param id 
+ * @return uart_bridge_stats_t* 
+ */
+static inline uart_bridge_stats_t *stats_write_begin(uart_bridge_t *bridge, stats_shard_id_t id)
+{
+    stats_shard_t *shard = &bridge->stats_shards[id];
+    atomic_fetch_add_explicit(&shard->seq, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    return &shard->counters;
+}
+
+static inline void stats_write_end(uart_bridge_t *bridge, stats_shard_id_t id)
+{
+    atomic_fetch_add_explicit(&bridge->stats_shards[id].seq, 1, memory_order_release);
+}
 
+static void stats_update_ring_high_water(uart_bridge_t *bridge, uint32_t used)
+{
+    if (used > atomic_load_explicit(&bridge->ring_high_water, memory_order_relaxed)) {
+        atomic_store_explicit(&bridge->ring_high_water, used, memory_order_relaxed);
+    }
+}
 
 /**
- * @brief 初始化UART桥接模块
+ * @brief 读取一个分片的完整快照, 写入者正在更新时重试
  * 
- * @param uart_id 
+ * @param id 
+ * @param out 
+ */
+static void stats_read_shard(uart_bridge_t *bridge, stats_shard_id_t id, uart_bridge_stats_t *out)
+{
+    stats_shard_t *shard = &bridge->stats_shards[id];
+
+    for (int retry = 1; ; retry++) {
+        unsigned seq = atomic_load_explicit(&shard->seq, memory_order_acquire);
+        if ((seq & 1) == 0) {
+            memcpy(out, &shard->counters, sizeof(uart_bridge_stats_t));
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&shard->seq, memory_order_relaxed) == seq) {
+                return;
+            }
+        }
+
+        // 写入者可能被抢占, 让它先完成更新
+        if (retry % STATS_READ_SPIN == 0) {
+            vTaskDelay(1);
+        }
+    }
+}
+
+/**
+ * @brief 只读取所有分片的串口收发字节数, 不拷贝整个分片
+ * 
+ * @param rx_bytes 
+ * @param tx_bytes 
+ */
+static void stats_collect_traffic(uart_bridge_t *bridge, uint64_t *rx_bytes, uint64_t *tx_bytes)
+{
+    *rx_bytes = 0;
+    *tx_bytes = 0;
+    for (int id = 0; id < STATS_SHARD_MAX; id++) {
+        stats_shard_t *shard = &bridge->stats_shards[id];
+        for (int retry = 1; ; retry++) {
+            unsigned seq = atomic_load_explicit(&shard->seq, memory_order_acquire);
+            if ((seq & 1) == 0) {
+                const uint64_t rx = shard->counters.uart_rx_bytes;
+                const uint64_t tx = shard->counters.uart_tx_bytes;
+                atomic_thread_fence(memory_order_acquire);
+                if (atomic_load_explicit(&shard->seq, memory_order_relaxed) == seq) {
+                    *rx_bytes += rx;
+                    *tx_bytes += tx;
+                    break;
+                }
+            }
+            if (retry % STATS_READ_SPIN == 0) {
+                vTaskDelay(1);
+            }
+        }
+    }
+}
+
+/**
+ * @brief 汇总所有分片的统计信息
+ * 
+ * @param total 
+ */
+static void stats_collect(uart_bridge_t *bridge, uart_bridge_stats_t *total)
+{
+    uint64_t *sum = (uint64_t *)total;
+    const size_t count = sizeof(uart_bridge_stats_t) / sizeof(uint64_t);
+
+    memset(total, 0, sizeof(uart_bridge_stats_t));
+    for (int id = 0; id < STATS_SHARD_MAX; id++) {
+        uart_bridge_stats_t shard;
+        const uint64_t *value = (const uint64_t *)&shard;
+        stats_read_shard(bridge, (stats_shard_id_t)id, &shard);
+        for (size_t i = 0; i < count; i++) {
+            sum[i] += value[i];
+        }
+    }
+}
+
+static const uart_bridge_rx_config_t s_default_rx_config = {
+    .idle_chars = UART_BRIDGE_DEFAULT_RX_IDLE_CHARS,
+    .fifo_full_thresh = UART_BRIDGE_DEFAULT_RX_FIFO_THRESH,
+    .max_chunk = UART_BRIDGE_DEFAULT_RX_MAX_CHUNK,
+    .max_hold_ms = UART_BRIDGE_DEFAULT_RX_MAX_HOLD_MS,
+};
+
+static const uart_bridge_modbus_config_t s_default_modbus_config = {
+    .response_timeout_ms = UART_BRIDGE_DEFAULT_MODBUS_TIMEOUT_MS,
+    .turnaround_ms = UART_BRIDGE_DEFAULT_MODBUS_TURNAROUND_MS,
+};
+
+static const uart_bridge_sock_opts_t s_default_sock_opts = {
+    .nodelay = UART_BRIDGE_NODELAY_PROFILE,
+    .evict_policy = UART_BRIDGE_EVICT_NONE,
+    .keepalive_idle_s = UART_BRIDGE_DEFAULT_KEEPALIVE_IDLE_S,
+    .keepalive_intvl_s = UART_BRIDGE_DEFAULT_KEEPALIVE_INTVL_S,
+    .keepalive_count = UART_BRIDGE_DEFAULT_KEEPALIVE_COUNT,
+    .user_timeout_ms = UART_BRIDGE_DEFAULT_USER_TIMEOUT_MS,
+    .send_buf = 0,
+    .recv_buf = 0,
+};
+
+static bool sock_buf_is_valid(uint32_t size)
+{
+    return size == 0 || (size >= UART_BRIDGE_SOCK_BUF_MIN && size <= UART_BRIDGE_SOCK_BUF_MAX);
+}
+
+static bool sock_opts_is_valid(const uart_bridge_sock_opts_t *opts)
+{
+    return (opts->nodelay < UART_BRIDGE_NODELAY_MAX) &&
+           (opts->evict_policy < UART_BRIDGE_EVICT_MAX) &&
+           (opts->keepalive_idle_s <= 7200) &&
+           (opts->keepalive_intvl_s >= 1 && opts->keepalive_intvl_s <= 75) &&
+           (opts->keepalive_count >= 1 && opts->keepalive_count <= 10) &&
+           (opts->user_timeout_ms == 0 || (opts->user_timeout_ms >= 1000 && opts->user_timeout_ms <= 600000)) &&
+           sock_buf_is_valid(opts->send_buf) && sock_buf_is_valid(opts->recv_buf);
+}
+
+static uint32_t round_up_pow2(uint32_t value)
+{
+    uint32_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+static uint32_t clamp_u32(uint32_t value, uint32_t min, uint32_t max)
+{
+    return (value < min) ? min : ((value > max) ? max : value);
+}
+
+/**
+ * @brief 根据波特率计算缓冲区大小, 用户指定的大小优先
+ * 
+ * @param baudrate 
+ * @param override 
+ * @param sizes 输出
+ */
+static void buffer_sizes_for_baudrate(uint32_t baudrate, const uart_bridge_buffer_sizes_t *override,
+                                      uart_bridge_buffer_sizes_t *sizes)
+{
+    // 8N1, 每个字节10位
+    const uint32_t bytes_per_sec = baudrate / 10;
+    const uint32_t uart_bytes = round_up_pow2(bytes_per_sec * UART_BRIDGE_UART_BUF_MS / 1000);
+    const uint32_t ring_bytes = round_up_pow2(bytes_per_sec * UART_BRIDGE_RING_MS / 1000);
+
+    sizes->uart_rx_size = override->uart_rx_size ? override->uart_rx_size :
+                          clamp_u32(uart_bytes, UART_BRIDGE_UART_RX_BUF_MIN, UART_BRIDGE_UART_BUF_MAX);
+    sizes->uart_tx_size = override->uart_tx_size ? override->uart_tx_size :
+                          clamp_u32(uart_bytes, UART_BRIDGE_UART_TX_BUF_MIN, UART_BRIDGE_UART_BUF_MAX);
+    sizes->ring_size = override->ring_size ? override->ring_size :
+                       clamp_u32(ring_bytes, UART_BRIDGE_RING_MIN, UART_BRIDGE_RING_MAX);
+}
+
+static uint32_t read_chunk_for(const uart_bridge_buffer_sizes_t *sizes)
+{
+    return clamp_u32(sizes->uart_rx_size / 2, UART_BRIDGE_READ_CHUNK_MIN, UART_BRIDGE_READ_CHUNK_MAX);
+}
+
+static bool buffer_override_is_valid(const uart_bridge_buffer_sizes_t *override)
+{
+    // 串口驱动要求缓冲区大于硬件FIFO
+    if (override->uart_rx_size &&
+        (override->uart_rx_size <= SOC_UART_FIFO_LEN || override->uart_rx_size > UART_BRIDGE_BUF_OVERRIDE_MAX)) {
+        return false;
+    }
+    if (override->uart_tx_size &&
+        (override->uart_tx_size <= SOC_UART_FIFO_LEN || override->uart_tx_size > UART_BRIDGE_BUF_OVERRIDE_MAX)) {
+        return false;
+    }
+    if (override->ring_size &&
+        (override->ring_size < UART_BRIDGE_RING_MIN || override->ring_size > UART_BRIDGE_BUF_OVERRIDE_MAX ||
+         (override->ring_size & (override->ring_size - 1)) != 0)) {
+        return false;
+    }
+    return true;
+}
+
+static bool rx_config_is_valid(const uart_bridge_rx_config_t *rx)
+{
+    return (rx->idle_chars >= 1 && rx->idle_chars <= 100) &&
+           (rx->fifo_full_thresh >= 1 && rx->fifo_full_thresh < SOC_UART_FIFO_LEN) &&
+           (rx->max_chunk >= 1 && rx->max_chunk <= UART_BRIDGE_SEND_CHUNK_SIZE) &&
+           (rx->max_hold_ms >= 1 && rx->max_hold_ms <= 1000);
+}
+
+static bool frame_mode_for(const uart_bridge_config_t *config)
+{
+    return (config->transport == UART_BRIDGE_TRANSPORT_MODBUS) ||
+           (config->rtu_framing && config->transport != UART_BRIDGE_TRANSPORT_RFC2217);
+}
+
+/**
+ * @brief RTU帧间隔对应的硬件接收超时(字符时间)
+ * 
+ * 帧之间至少间隔3.5个字符, 帧内允许1.5个字符的间隔, 取两者之间的3个字符;
+ * 波特率高于19200时帧间隔固定为1750us, 按每个字符11位换算, 不超过分包参数的上限.
+ * 
+ * @param baudrate 
+ * @return uint8_t 
+ */
+static uint8_t rtu_gap_chars(uint32_t baudrate)
+{
+    if (baudrate <= RTU_GAP_FIXED_BAUDRATE) {
+        return 3;
+    }
+    const uint64_t chars = (uint64_t)RTU_GAP_FIXED_US * baudrate / (11 * 1000000ULL);
+    return (uint8_t)clamp_u32((uint32_t)chars, 3, 100);
+}
+
+static uint32_t rtu_gap_ms(uint32_t baudrate)
+{
+    return (uint32_t)((uint64_t)rtu_gap_chars(baudrate) * 11 * 1000 / baudrate) + 1;
+}
+
+/**
+ * @brief 设置硬件接收超时(空闲间隔)和FIFO满中断阈值
+ * 
+ * 分帧模式下空闲间隔按当前波特率的RTU帧间隔设置, 不使用idle_chars.
+ * 
+ * @param rx 
  * @return esp_err_t 
  */
-esp_err_t uart_bridge_init(uint8_t uart_id)
+static esp_err_t uart_bridge_apply_rx_config(uart_bridge_t *bridge, const uart_bridge_rx_config_t *rx)
 {
-    if (g_bridge.initialized) {
-        ESP_LOGW(TAG, "Module already initialized");
-        return ESP_OK;
+    const uint8_t idle_chars = bridge->frame_mode ? rtu_gap_chars(bridge->line.baudrate) : rx->idle_chars;
+    esp_err_t ret = uart_set_rx_timeout(bridge->uart_port, idle_chars);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "failed to set rx timeout(%d): %s", idle_chars, esp_err_to_name(ret));
+        return ret;
     }
 
-    const uart_hw_config_t *hw_config = uart_hw_config_get(uart_id);
-    if (!hw_config) {
-        ESP_LOGE(TAG, "uart(%d) hardware config not found", uart_id);
-        return ESP_ERR_INVALID_ARG;
+    ret = uart_set_rx_full_threshold(bridge->uart_port, rx->fifo_full_thresh);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "failed to set rx full threshold(%d): %s", rx->fifo_full_thresh, esp_err_to_name(ret));
     }
-    
-    ESP_LOGD(TAG, "uart(%d) hardware config, port: %d, txd: %d, rxd: %d", 
-             uart_id, hw_config->uart_port, hw_config->txd_pin, hw_config->rxd_pin);
+    return ret;
+}
 
-    memset(&g_bridge, 0, sizeof(g_bridge));
+/**
+ * @brief 安装串口驱动
+ * 
+ * @param sizes 
+ * @return esp_err_t 
+ */
+static esp_err_t uart_bridge_driver_install(uart_bridge_t *bridge, const uart_bridge_buffer_sizes_t *sizes)
+{
+    // 中断服务放在IRAM中, 写Flash(如保存NVS)时不会被挂起导致FIFO溢出
+    int intr_alloc_flags = 0;
+#if CONFIG_UART_ISR_IN_IRAM
+    intr_alloc_flags = ESP_INTR_FLAG_IRAM;
+#endif
 
-    // 加载配置
-    esp_err_t ret = uart_bridge_load_config(&g_bridge.config);
+    esp_err_t ret = uart_driver_install(bridge->uart_port, sizes->uart_rx_size, sizes->uart_tx_size,
+            UART_BRIDGE_EVENT_QUEUE_SIZE, &bridge->uart_queue, intr_alloc_flags);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "config load failed: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "failed to install port(%d) driver(rx=%" PRIu32 ", tx=%" PRIu32 "): %s",
+                 bridge->uart_port, sizes->uart_rx_size, sizes->uart_tx_size, esp_err_to_name(ret));
         return ret;
     }
 
-    // 创建互斥锁
-    g_bridge.stats_mutex = xSemaphoreCreateMutex();
-    if (!g_bridge.stats_mutex) {
-        ESP_LOGE(TAG, "failed to create stats mutex");
-        return ESP_ERR_NO_MEM;
+    if (bridge->rx_dma_active) {
+        // DMA接收时驱动只用于发送, 接收中断会与DMA争抢FIFO中的数据
+        uart_disable_rx_intr(bridge->uart_port);
     }
+    return ESP_OK;
+}
 
-    // 配置UART
-    const uart_config_t uart_config = {
-        .baud_rate = g_bridge.config.baudrate,
-        .data_bits = UART_DATA_8_BITS,
-        .parity = UART_PARITY_DISABLE,
-        .stop_bits = UART_STOP_BITS_1,
-        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
-        .source_clk = UART_SCLK_DEFAULT,
-    };
+/**
+ * @brief 分配接收环形缓冲区, DMA接收时必须是DMA可访问的内部内存
+ * 
+ * @param size 
+ * @return uint8_t* 
+ */
+static uint8_t *rx_ring_alloc(uart_bridge_t *bridge, size_t size)
+{
+    // 静态内存区在内部RAM中, DMA可以访问
+    uint8_t *buf = (uint8_t*) mem_arena_alloc(size, "rx rings");
+    if (buf) {
+        return buf;
+    }
+    if (bridge->rx_dma_active) {
+        return (uint8_t*) heap_caps_malloc(size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    return (uint8_t*) malloc(size);
+}
 
-    
-    // Configure internal pull-up for RX pin to avoid noise
-    gpio_set_pull_mode(hw_config->rxd_pin, GPIO_PULLUP_ONLY);
-    ESP_LOGI(TAG, "enabled internal pull-up for RX pin(%d)", hw_config->rxd_pin);
+/**
+ * @brief 在任务循环中检查暂停请求, 暂停直到恢复
+ * 
+ * @param pause 
+ * @param parked 
+ */
+static void uart_bridge_park(volatile bool *pause, volatile bool *parked)
+{
+    *parked = true;
+    while (*pause) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+    }
+    *parked = false;
+}
+
+static bool wait_parked(volatile bool *parked)
+{
+    for (int waited = 0; !*parked; waited += 10) {
+        if (waited >= TASK_PAUSE_TIMEOUT_MS) {
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return true;
+}
+
+static void uart_bridge_resume_tasks(uart_bridge_t *bridge)
+{
+    bridge->reader_pause = false;
+    bridge->sender_pause = false;
+    if (bridge->task_handle) {
+        xTaskNotifyGive(bridge->task_handle);
+    }
+    if (bridge->sender_handle) {
+        xTaskNotifyGive(bridge->sender_handle);
+    }
+}
+
+/**
+ * @brief 暂停读取和发送任务
+ * 
+ * 先暂停读取任务(会先提交未完成的分包), 再等发送任务取完环形缓冲区中的数据后暂停.
+ * 
+ * @return esp_err_t 
+ */
+static esp_err_t uart_bridge_pause_tasks(uart_bridge_t *bridge)
+{
+    bridge->reader_pause = true;
+    if (!wait_parked(&bridge->reader_parked)) {
+        ESP_LOGE(TAG, "timeout waiting for reader task to pause");
+        uart_bridge_resume_tasks(bridge);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    bridge->sender_pause = true;
+    xTaskNotifyGive(bridge->sender_handle);
+    if (!wait_parked(&bridge->sender_parked)) {
+        ESP_LOGE(TAG, "timeout waiting for sender task to pause");
+        uart_bridge_resume_tasks(bridge);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief 按新的大小重新分配串口驱动缓冲区和环形缓冲区, 不需要重启
+ * 
+ * @param sizes 
+ * @return esp_err_t 
+ */
+static esp_err_t uart_bridge_resize_buffers(uart_bridge_t *bridge, const uart_bridge_buffer_sizes_t *sizes)
+{
+    const bool driver_changed = (sizes->uart_rx_size != bridge->buffers.uart_rx_size) ||
+                                (sizes->uart_tx_size != bridge->buffers.uart_tx_size);
+    const bool ring_changed = (sizes->ring_size != bridge->buffers.ring_size);
+    uint8_t *new_ring = NULL;
 
-    ret = uart_driver_install(hw_config->uart_port, UART_BRIDGE_BUFFER_SIZE * 2, 
-        UART_BRIDGE_BUFFER_SIZE * 2, 0, NULL, 0);
+    if (!driver_changed && !ring_changed) {
+        return ESP_OK;
+    }
+
+    // 先分配新的环形缓冲区, 失败时保持原样; 内存区中的缓冲区不能释放, 放得下时继续使用
+    if (ring_changed && mem_arena_owns(bridge->rx_ring_buf) && sizes->ring_size <= bridge->rx_ring_capacity) {
+        new_ring = bridge->rx_ring_buf;
+    } else if (ring_changed) {
+        new_ring = rx_ring_alloc(bridge, sizes->ring_size);
+        if (!new_ring) {
+            ESP_LOGE(TAG, "failed to allocate rx ring buffer(%" PRIu32 ")", sizes->ring_size);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    esp_err_t ret = uart_bridge_pause_tasks(bridge);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "failed to install port(%d) driver: %s", hw_config->uart_port, esp_err_to_name(ret));
-        vSemaphoreDelete(g_bridge.stats_mutex);
+        mem_arena_free(new_ring);
         return ret;
     }
 
-    ret = uart_param_config(hw_config->uart_port, &uart_config);
+    if (driver_changed) {
+        // 驱动缓冲区中未读取的数据会丢失
+        uart_driver_delete(bridge->uart_port);
+        ret = uart_bridge_driver_install(bridge, sizes);
+        if (ret != ESP_OK) {
+            // 恢复原来的大小
+            uart_bridge_driver_install(bridge, &bridge->buffers);
+        }
+        // 重新安装驱动后, 中断配置恢复为默认值
+        uart_bridge_apply_rx_config(bridge, &bridge->config.rx);
+        if (bridge->line.flow_ctrl != UART_BRIDGE_FLOW_CTRL_NONE) {
+            uart_bridge_apply_flow_ctrl(bridge, bridge->line.flow_ctrl, bridge->config.rts_thresh);
+        }
+    }
+
+    if (ret == ESP_OK && ring_changed) {
+        // 此时环形缓冲区已经为空, 读取和发送任务也都已暂停
+        if (new_ring != bridge->rx_ring_buf) {
+            mem_arena_free(bridge->rx_ring_buf);
+            bridge->rx_ring_buf = new_ring;
+            bridge->rx_ring_capacity = sizes->ring_size;
+        }
+        ring_buffer_init(&bridge->rx_ring, bridge->rx_ring_buf, sizes->ring_size);
+        new_ring = NULL;
+    }
+
+    if (ret == ESP_OK) {
+        bridge->buffers = *sizes;
+        bridge->read_chunk = read_chunk_for(sizes);
+        ESP_LOGI(TAG, "buffers resized: uart rx(%" PRIu32 "), uart tx(%" PRIu32 "), ring(%" PRIu32 ")",
+                 sizes->uart_rx_size, sizes->uart_tx_size, sizes->ring_size);
+    }
+
+    uart_bridge_resume_tasks(bridge);
+    mem_arena_free(new_ring);
+    return ret;
+}
+
+/**
+ * @brief 配置硬件流控
+ * 
+ * 关闭流控时, 把RTS/CTS引脚恢复为普通GPIO, 不影响连接的设备.
+ * 
+ * @param mode 
+ * @param rts_thresh 
+ * @return esp_err_t 
+ */
+static esp_err_t uart_bridge_apply_flow_ctrl(uart_bridge_t *bridge, uint8_t mode, uint8_t rts_thresh)
+{
+    esp_err_t ret;
+
+    if (mode == UART_BRIDGE_FLOW_CTRL_NONE) {
+        ret = uart_set_hw_flow_ctrl(bridge->uart_port, UART_HW_FLOWCTRL_DISABLE, 0);
+        if (bridge->rts_pin != UART_PIN_NO_CHANGE) {
+            gpio_reset_pin(bridge->rts_pin);
+        }
+        if (bridge->cts_pin != UART_PIN_NO_CHANGE) {
+            gpio_reset_pin(bridge->cts_pin);
+        }
+        return ret;
+    }
+
+    if (bridge->rts_pin == UART_PIN_NO_CHANGE || bridge->cts_pin == UART_PIN_NO_CHANGE) {
+        ESP_LOGE(TAG, "flow control pins not available on this board");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    ret = uart_set_pin(bridge->uart_port, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE, bridge->rts_pin, bridge->cts_pin);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "failed to configure port(%d) params: %s", hw_config->uart_port, esp_err_to_name(ret));
-        uart_driver_delete(hw_config->uart_port);
-        vSemaphoreDelete(g_bridge.stats_mutex);
+        ESP_LOGE(TAG, "failed to set flow control pins: %s", esp_err_to_name(ret));
         return ret;
     }
 
-    ret = uart_set_pin(hw_config->uart_port, hw_config->txd_pin, hw_config->rxd_pin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    ret = uart_set_hw_flow_ctrl(bridge->uart_port, UART_HW_FLOWCTRL_CTS_RTS, rts_thresh);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "failed to configure port(%d) pins: %s", hw_config->uart_port, esp_err_to_name(ret));
-        uart_driver_delete(hw_config->uart_port);
-        vSemaphoreDelete(g_bridge.stats_mutex);
+        ESP_LOGE(TAG, "failed to enable flow control: %s", esp_err_to_name(ret));
         return ret;
     }
 
+    ESP_LOGI(TAG, "rts/cts flow control enabled, rts(%d), cts(%d), threshold(%d)",
+             bridge->rts_pin, bridge->cts_pin, rts_thresh);
+    return ESP_OK;
+}
 
-    g_bridge.uart_port = hw_config->uart_port;
+static uint32_t client_queue_bytes_for(const uart_bridge_config_t *config)
+{
+    return config->sock.send_buf ? config->sock.send_buf : link_profile_params()->client_queue_bytes;
+}
 
-    g_bridge.uart_tx_verbose = false;
-    g_bridge.uart_rx_verbose = false;
+static void fanout_config_from(const uart_bridge_config_t *config, tcp_fanout_config_t *fanout_config)
+{
+    const uart_bridge_sock_opts_t *sock = &config->sock;
 
+    fanout_config->io = tcp_engine_io(config->tcp_engine);
+    fanout_config->policy = (uart_bridge_slow_client_policy_t)config->slow_client_policy;
+    fanout_config->stall_timeout_ms = config->stall_timeout_ms;
+    fanout_config->queue_bytes = client_queue_bytes_for(config);
+    fanout_config->escape_iac = (config->transport == UART_BRIDGE_TRANSPORT_RFC2217);
+    // 分帧模式下每个帧立即单独发出
+    fanout_config->nodelay = frame_mode_for(config) ||
+                             ((sock->nodelay == UART_BRIDGE_NODELAY_PROFILE) ?
+                              link_profile_params()->tcp_nodelay : (sock->nodelay == UART_BRIDGE_NODELAY_ON));
+    fanout_config->user_timeout_ms = sock->user_timeout_ms;
+    fanout_config->evict_policy = (uart_bridge_evict_policy_t)sock->evict_policy;
+    fanout_config->keepalive_idle_s = sock->keepalive_idle_s;
+    fanout_config->keepalive_intvl_s = sock->keepalive_intvl_s;
+    fanout_config->keepalive_count = sock->keepalive_count;
+    fanout_config->recv_buf = sock->recv_buf;
+}
 
-    // 创建UART任务
-    BaseType_t task_ret = xTaskCreate(uart_bridge_task, "uart_bridge", 
-            UART_BRIDGE_TASK_STACK_SIZE, NULL, UART_BRIDGE_TASK_PRIORITY, &g_bridge.task_handle);
-    if (task_ret != pdTRUE) {
-        ESP_LOGE(TAG, "failed to create task");
-        uart_driver_delete(hw_config->uart_port);
-        vSemaphoreDelete(g_bridge.stats_mutex);
-        return ESP_FAIL;
+/**
+ * @brief 允许串口RX唤醒浅睡眠, 唤醒用的前几个字符会丢失
+ * 
+ * @param bridge 
+ */
+static void uart_bridge_enable_sleep_wakeup(uart_bridge_t *bridge)
+{
+    esp_err_t ret = uart_set_wakeup_threshold(bridge->uart_port, UART_WAKEUP_THRESHOLD);
+    if (ret == ESP_OK) {
+        ret = esp_sleep_enable_uart_wakeup(bridge->uart_port);
     }
+    if (ret != ESP_OK) {
+        // 只有部分串口支持唤醒, 其它串口在睡眠期间收不到数据
+        ESP_LOGW(TAG, "port(%d) can not wake up from light sleep: %s", bridge->uart_port, esp_err_to_name(ret));
+        return;
+    }
+    ESP_LOGI(TAG, "port(%d) light sleep wakeup enabled", bridge->uart_port);
+}
 
-    g_bridge.initialized = true;
+
+/**
+ * @brief 初始化UART桥接模块
+ * 
+ * @param uart_id 
+ * @param handle 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_init(uint8_t uart_id, uart_bridge_handle_t *handle)
+{
+    if (uart_id >= UART_BRIDGE_MAX_INSTANCES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uart_bridge_t *bridge = &s_bridges[uart_id];
+    if (bridge->initialized) {
+        ESP_LOGW(TAG, "bridge(%d) already initialized", uart_id);
+        if (handle) {
+            *handle = bridge;
+        }
+        return ESP_OK;
+    }
+
+    const uart_hw_config_t *hw_config = uart_hw_config_get(uart_id);
+    if (!hw_config) {
+        ESP_LOGE(TAG, "uart(%d) hardware config not found", uart_id);
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    ESP_LOGD(TAG, "uart(%d) hardware config, port: %d, txd: %d, rxd: %d", 
+             uart_id, hw_config->uart_port, hw_config->txd_pin, hw_config->rxd_pin);
+
+    // 块池从内存区分配后不能释放, 保留给tcp_fanout_init沿用, 重新初始化时不再分配
+    const mem_pool_t chunk_pool = bridge->fanout.pool;
+    memset(bridge, 0, sizeof(uart_bridge_t));
+    bridge->fanout.pool = chunk_pool;
+    bridge->index = uart_id;
+    if (uart_id == 0) {
+        snprintf(bridge->nvs_namespace, sizeof(bridge->nvs_namespace), "%s", NVS_NAMESPACE);
+    } else {
+        snprintf(bridge->nvs_namespace, sizeof(bridge->nvs_namespace), "%s%d", NVS_NAMESPACE, uart_id);
+    }
+
+    // 加载配置
+    esp_err_t ret = uart_bridge_load_config(bridge);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "config load failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    // 创建互斥锁
+    bridge->stats_mutex = xSemaphoreCreateMutex();
+    bridge->rfc2217_mutex = xSemaphoreCreateMutex();
+    bridge->modbus_mutex = xSemaphoreCreateMutex();
+    bridge->service_mutex = xSemaphoreCreateMutex();
+    if (!bridge->stats_mutex || !bridge->rfc2217_mutex || !bridge->modbus_mutex || !bridge->service_mutex) {
+        ESP_LOGE(TAG, "failed to create mutex");
+        ret = ESP_ERR_NO_MEM;
+        goto err_mutex;
+    }
+
+    // 初始化客户端发送队列
+    tcp_fanout_config_t fanout_config;
+    fanout_config_from(&bridge->config, &fanout_config);
+    ret = tcp_fanout_init(&bridge->fanout, &fanout_config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "failed to init client queues: %s", esp_err_to_name(ret));
+        goto err_mutex;
+    }
+
+    ret = udp_transport_init(&bridge->udp);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "failed to init udp transport: %s", esp_err_to_name(ret));
+        goto err_fanout;
+    }
+
+    ret = tcp_inbound_init(&bridge->inbound);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "failed to init client arbiter: %s", esp_err_to_name(ret));
+        goto err_udp;
+    }
+
+    // 队列分配失败时退回直接写入
+    if (tcp_inbound_set_mode(&bridge->inbound, bridge->config.tx_arbiter) != ESP_OK) {
+        ESP_LOGW(TAG, "fair arbiter disabled");
+        bridge->config.tx_arbiter = UART_BRIDGE_TX_ARBITER_DIRECT;
+        tcp_inbound_set_mode(&bridge->inbound, UART_BRIDGE_TX_ARBITER_DIRECT);
+    }
+
+    // 配置UART
+    const uart_config_t uart_config = {
+        .baud_rate = bridge->config.baudrate,
+        .data_bits = (uart_word_length_t)bridge->config.data_bits,
+        .parity = (uart_parity_t)bridge->config.parity,
+        .stop_bits = (uart_stop_bits_t)bridge->config.stop_bits,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        // 浅睡眠期间APB时钟会变化, 使用XTAL保证波特率不变
+        .source_clk = link_profile_sleep_active() ? UART_SCLK_XTAL : UART_SCLK_DEFAULT,
+    };
+
+    
+    // Configure internal pull-up for RX pin to avoid noise
+    gpio_set_pull_mode(hw_config->rxd_pin, GPIO_PULLUP_ONLY);
+    ESP_LOGI(TAG, "enabled internal pull-up for RX pin(%d)", hw_config->rxd_pin);
+
+    // 根据波特率计算缓冲区大小
+    bridge->uart_port = hw_config->uart_port;
+    const board_uart_flow_pins_t *flow_pins = board_uart_flow_pins_get(uart_id);
+    bridge->rts_pin = flow_pins ? flow_pins->rts_pin : UART_PIN_NO_CHANGE;
+    bridge->cts_pin = flow_pins ? flow_pins->cts_pin : UART_PIN_NO_CHANGE;
+    buffer_sizes_for_baudrate(bridge->config.baudrate, &bridge->config.buffer_override, &bridge->buffers);
+    bridge->read_chunk = read_chunk_for(&bridge->buffers);
+
+    // 读取任务启动时创建UHCI控制器, 失败时退回驱动接收
+    bridge->rx_dma_active = (bridge->config.rx_engine == UART_BRIDGE_RX_ENGINE_DMA) && uart_dma_rx_supported();
+
+    ret = uart_bridge_driver_install(bridge, &bridge->buffers);
+    if (ret != ESP_OK) {
+        goto err_inbound;
+    }
+
+    ret = uart_param_config(hw_config->uart_port, &uart_config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "failed to configure port(%d) params: %s", hw_config->uart_port, esp_err_to_name(ret));
+        goto err_driver;
+    }
+
+    ret = uart_set_pin(hw_config->uart_port, hw_config->txd_pin, hw_config->rxd_pin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "failed to configure port(%d) pins: %s", hw_config->uart_port, esp_err_to_name(ret));
+        goto err_driver;
+    }
+
+
+    if (bridge->config.flow_ctrl != UART_BRIDGE_FLOW_CTRL_NONE &&
+        uart_bridge_apply_flow_ctrl(bridge, bridge->config.flow_ctrl, bridge->config.rts_thresh) != ESP_OK) {
+        // 流控不可用时继续工作, 只是没有流控
+        ESP_LOGW(TAG, "flow control disabled");
+        bridge->config.flow_ctrl = UART_BRIDGE_FLOW_CTRL_NONE;
+    }
+
+    if (link_profile_sleep_active()) {
+        uart_bridge_enable_sleep_wakeup(bridge);
+    }
+
+    bridge->line.baudrate = bridge->config.baudrate;
+    bridge->line.data_bits = bridge->config.data_bits;
+    bridge->line.parity = bridge->config.parity;
+    bridge->line.stop_bits = bridge->config.stop_bits;
+    bridge->line.flow_ctrl = bridge->config.flow_ctrl;
+    bridge->frame_mode = frame_mode_for(&bridge->config);
+
+    ret = uart_bridge_apply_rx_config(bridge, &bridge->config.rx);
+    if (ret != ESP_OK) {
+        goto err_driver;
+    }
+
+
+    // 分配串口接收环形缓冲区
+    bridge->rx_ring_buf = rx_ring_alloc(bridge, bridge->buffers.ring_size);
+    bridge->rx_ring_capacity = bridge->buffers.ring_size;
+    if (!bridge->rx_ring_buf || !ring_buffer_init(&bridge->rx_ring, bridge->rx_ring_buf, bridge->buffers.ring_size)) {
+        ESP_LOGE(TAG, "failed to allocate rx ring buffer(%" PRIu32 ")", bridge->buffers.ring_size);
+        ret = ESP_ERR_NO_MEM;
+        goto err_ring;
+    }
+
+    // 断网缓存分配失败时不影响转发
+    if (outage_buffer_init(&bridge->outage, bridge->config.outage_buf_size) != ESP_OK) {
+        ESP_LOGW(TAG, "failed to allocate outage buffer(%" PRIu32 "), disabled", bridge->config.outage_buf_size);
+    }
+
+    // 创建TCP发送任务, 先于读取任务创建, 读取任务需要通知它
+    char task_name[configMAX_TASK_NAME_LEN];
+    snprintf(task_name, sizeof(task_name), "bridge_sender%d", uart_id);
+    BaseType_t task_ret = task_profile_create_static(uart_bridge_sender_task, task_name,
+            UART_BRIDGE_SENDER_STACK_SIZE, bridge, TASK_ROLE_SENDER, &bridge->sender_handle);
+    if (task_ret != pdTRUE) {
+        ESP_LOGE(TAG, "failed to create sender task");
+        ret = ESP_FAIL;
+        goto err_outage;
+    }
+
+    // 创建UART任务
+    snprintf(task_name, sizeof(task_name), "uart_bridge%d", uart_id);
+    task_ret = task_profile_create_static(uart_bridge_task, task_name,
+            UART_BRIDGE_TASK_STACK_SIZE, bridge, TASK_ROLE_UART_READER, &bridge->task_handle);
+    if (task_ret != pdTRUE) {
+        ESP_LOGE(TAG, "failed to create task");
+        ret = ESP_FAIL;
+        goto err_sender;
+    }
+
+    bridge->initialized = true;
     ESP_LOGI(TAG, "uart-bridge(%d) initialized success, baudrate: %d, tcp-port:%d", 
-            uart_id, g_bridge.config.baudrate, g_bridge.config.tcp_port);
+            uart_id, bridge->config.baudrate, bridge->config.tcp_port);
+
+    if (handle) {
+        *handle = bridge;
+    }
+    return ESP_OK;
+
+    // 按初始化的相反顺序释放资源
+err_sender:
+    vTaskDelete(bridge->sender_handle);
+    bridge->sender_handle = NULL;
+err_outage:
+    outage_buffer_deinit(&bridge->outage);
+err_ring:
+    mem_arena_free(bridge->rx_ring_buf);
+    bridge->rx_ring_buf = NULL;
+err_driver:
+    uart_driver_delete(hw_config->uart_port);
+err_inbound:
+    tcp_inbound_deinit(&bridge->inbound);
+err_udp:
+    udp_transport_deinit(&bridge->udp);
+err_fanout:
+    tcp_fanout_deinit(&bridge->fanout);
+err_mutex:
+    if (bridge->stats_mutex) {
+        vSemaphoreDelete(bridge->stats_mutex);
+        bridge->stats_mutex = NULL;
+    }
+    if (bridge->rfc2217_mutex) {
+        vSemaphoreDelete(bridge->rfc2217_mutex);
+        bridge->rfc2217_mutex = NULL;
+    }
+    if (bridge->modbus_mutex) {
+        vSemaphoreDelete(bridge->modbus_mutex);
+        bridge->modbus_mutex = NULL;
+    }
+    if (bridge->service_mutex) {
+        vSemaphoreDelete(bridge->service_mutex);
+        bridge->service_mutex = NULL;
+    }
+    return ret;
+}
+
+/**
+ * @brief 读取启动时创建的实例数, 保存在实例0的命名空间中
+ * 
+ * @return uint8_t 
+ */
+static uint8_t load_instance_count(void)
+{
+    uint8_t count = UART_BRIDGE_DEFAULT_INSTANCES;
+    nvs_handle_t nvs_handle;
+
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) == ESP_OK) {
+        size_t required_size = sizeof(count);
+        if (nvs_get_blob(nvs_handle, NVS_KEY_INSTANCES, &count, &required_size) != ESP_OK) {
+            count = UART_BRIDGE_DEFAULT_INSTANCES;
+        }
+        nvs_close(nvs_handle);
+    }
+
+    if (count == 0 || count > UART_BRIDGE_MAX_INSTANCES) {
+        count = UART_BRIDGE_DEFAULT_INSTANCES;
+    }
+    return count;
+}
+
+esp_err_t uart_bridge_init_all(void)
+{
+    const uint8_t count = load_instance_count();
+
+    for (uint8_t i = 0; i < count; i++) {
+        esp_err_t ret = uart_bridge_init(i, NULL);
+        if (ret != ESP_OK) {
+            if (i == 0) {
+                return ret;
+            }
+            // 板子没有引出该串口, 或内存不足
+            ESP_LOGW(TAG, "bridge(%d) not available: %s", i, esp_err_to_name(ret));
+        }
+    }
+
+    return ESP_OK;
+}
+
+uart_bridge_handle_t uart_bridge_get(uint8_t index)
+{
+    if (index >= UART_BRIDGE_MAX_INSTANCES || !s_bridges[index].initialized) {
+        return NULL;
+    }
+    return &s_bridges[index];
+}
+
+esp_err_t uart_bridge_set_instance_count(uint8_t count)
+{
+    if (count == 0 || count > UART_BRIDGE_MAX_INSTANCES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to open nvs namespace(%s)", esp_err_to_name(err));
+        return err;
+    }
+
+    err = nvs_set_blob(nvs_handle, NVS_KEY_INSTANCES, &count, sizeof(count));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "set bridge instances(%d), effective after reboot", count);
+    }
+    return err;
+}
+
+uint8_t uart_bridge_get_instance_count(void)
+{
+    return load_instance_count();
+}
+
+/**
+ * @brief 反初始化UART桥接模块
+ * 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_deinit(uart_bridge_handle_t bridge)
+{
+    if (!bridge || !bridge->initialized) {
+        return ESP_OK;
+    }
+
+    // 停止网络服务
+    uart_bridge_stop_tcp_server(bridge);
+
+    // 停止任务
+    bridge->running = false;
+
+    // 删除UART任务
+    if (bridge->task_handle) {
+        vTaskDelete(bridge->task_handle);
+        bridge->task_handle = NULL;
+    }
+
+    // 删除发送任务
+    bridge->sender_running = false;
+    if (bridge->sender_handle) {
+        vTaskDelete(bridge->sender_handle);
+        bridge->sender_handle = NULL;
+    }
+
+    // 删除UART驱动
+    uart_driver_delete(bridge->uart_port);
+
+    // 释放环形缓冲区
+    mem_arena_free(bridge->rx_ring_buf);
+    bridge->rx_ring_buf = NULL;
+    outage_buffer_deinit(&bridge->outage);
+
+    // 释放客户端发送队列
+    tcp_fanout_deinit(&bridge->fanout);
+    tcp_inbound_deinit(&bridge->inbound);
+    udp_transport_deinit(&bridge->udp);
+    modbus_gw_deinit(&bridge->modbus);
+
+    if (bridge->stats_mutex) {
+        vSemaphoreDelete(bridge->stats_mutex);
+        bridge->stats_mutex = NULL;
+    }
+
+    if (bridge->rfc2217_mutex) {
+        vSemaphoreDelete(bridge->rfc2217_mutex);
+        bridge->rfc2217_mutex = NULL;
+    }
+
+    if (bridge->modbus_mutex) {
+        vSemaphoreDelete(bridge->modbus_mutex);
+        bridge->modbus_mutex = NULL;
+    }
+
+    if (bridge->service_mutex) {
+        vSemaphoreDelete(bridge->service_mutex);
+        bridge->service_mutex = NULL;
+    }
+
+    bridge->initialized = false;
+    ESP_LOGI(TAG, "uart-bridge(%d) deinitialized", bridge->index);
+    return ESP_OK;
+}
+
+/**
+ * @brief 获取UART桥接模块状态
+ * 
+ * @param status 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_get_status(uart_bridge_handle_t bridge, uart_bridge_status_t *status)
+{
+    if (!bridge || !status) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    const bool service = tcp_service_running(bridge) || udp_transport_is_running(&bridge->udp);
+
+    status->tcp_standby = service;
+    status->uart_opened = bridge->initialized;
+    status->forwarding = bridge->running && service;
+    status->uart_baudrate = bridge->line.baudrate;
+    status->tcp_port = bridge->config.tcp_port;
+    if (bridge->raw_server) {
+        status->tcp_client_num = raw_tcp_server_get_client_count(bridge->raw_server);
+    } else {
+        status->tcp_client_num = (bridge->tcp_server != NULL) ? 
+                                tcp_server_get_client_count(bridge->tcp_server) : 0;
+    }
+    status->transport = bridge->config.transport;
+    status->rx_engine = bridge->rx_dma_active ? UART_BRIDGE_RX_ENGINE_DMA : UART_BRIDGE_RX_ENGINE_DRIVER;
+    status->tcp_engine = bridge->config.tcp_engine;
+    status->index = bridge->index;
     
     return ESP_OK;
 }
 
-/**
- * @brief 反初始化UART桥接模块
- * 
- * @return esp_err_t 
- */
-esp_err_t uart_bridge_deinit(void)
-{
-    if (!g_bridge.initialized) {
-        return ESP_OK;
-    }
+/**
+ * @brief 获取统计信息
+ * 
+ * @param stats 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_get_stats(uart_bridge_handle_t bridge, uart_bridge_stats_t *stats)
+{
+    if (!bridge || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint64_t *value = (uint64_t *)stats;
+    const uint64_t *base = (const uint64_t *)&bridge->stats_base;
+    const size_t count = sizeof(uart_bridge_stats_t) / sizeof(uint64_t);
+
+    // 计数器只增不减, 减去重置时的快照
+    xSemaphoreTake(bridge->stats_mutex, portMAX_DELAY);
+    stats_collect(bridge, stats);
+    for (size_t i = 0; i < count; i++) {
+        value[i] -= base[i];
+    }
+    xSemaphoreGive(bridge->stats_mutex);
+
+    stats->ring_high_water = atomic_load_explicit(&bridge->ring_high_water, memory_order_relaxed);
+
+    return ESP_OK;
+}
+
+esp_err_t uart_bridge_get_traffic(uart_bridge_handle_t bridge, uint64_t *rx_bytes, uint64_t *tx_bytes)
+{
+    if (!bridge || !rx_bytes || !tx_bytes) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 不加stats_mutex, 重置时的快照可能只更新了一半, 下次读取恢复正常
+    stats_collect_traffic(bridge, rx_bytes, tx_bytes);
+    *rx_bytes -= bridge->stats_base.uart_rx_bytes;
+    *tx_bytes -= bridge->stats_base.uart_tx_bytes;
+
+    return ESP_OK;
+}
+
+static void latency_summary(const latency_hist_t *hist, uart_bridge_latency_t *out)
+{
+    out->count = hist->count;
+    out->p50_us = latency_hist_percentile(hist, 50);
+    out->p95_us = latency_hist_percentile(hist, 95);
+    out->p99_us = latency_hist_percentile(hist, 99);
+    out->max_us = hist->max_us;
+    out->sum_us = hist->sum_us;
+}
+
+static void rate_summary(const rate_meter_t *meter, int64_t now_us, uart_bridge_rate_t *out)
+{
+    out->rate_1s = rate_meter_rate(meter, 1, now_us);
+    out->rate_10s = rate_meter_rate(meter, 10, now_us);
+    out->rate_60s = rate_meter_rate(meter, 60, now_us);
+    out->peak_1s = meter->peak_1s;
+}
+
+/**
+ * @brief 获取延迟和吞吐量统计
+ * 
+ * @param perf 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_get_perf(uart_bridge_handle_t bridge, uart_bridge_perf_t *perf)
+{
+    if (!bridge || !perf) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const int64_t now_us = esp_timer_get_time();
+    for (int i = 0; i < UART_BRIDGE_LATENCY_MAX; i++) {
+        latency_summary(&bridge->latency[i], &perf->latency[i]);
+    }
+    rate_summary(&bridge->uart_rx_rate, now_us, &perf->uart_to_tcp);
+    rate_summary(&bridge->uart_tx_rate, now_us, &perf->tcp_to_uart);
+    return ESP_OK;
+}
+
+/**
+ * @brief 重置统计信息
+ * 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_reset_stats(uart_bridge_handle_t bridge)
+{
+    if (!bridge || !bridge->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // 写入任务只增加计数, 这里只记录快照, 不修改分片
+    xSemaphoreTake(bridge->stats_mutex, portMAX_DELAY);
+    stats_collect(bridge, &bridge->stats_base);
+    atomic_store_explicit(&bridge->ring_high_water, 0, memory_order_relaxed);
+    xSemaphoreGive(bridge->stats_mutex);
+
+    // 直方图/吞吐量只是参考值, 与写入任务并发清空最多丢失几个样本
+    for (int i = 0; i < UART_BRIDGE_LATENCY_MAX; i++) {
+        latency_hist_reset(&bridge->latency[i]);
+    }
+    rate_meter_reset(&bridge->uart_rx_rate);
+    rate_meter_reset(&bridge->uart_tx_rate);
+
+    xSemaphoreTake(bridge->modbus_mutex, portMAX_DELAY);
+    memset(&bridge->modbus.stats, 0, sizeof(bridge->modbus.stats));
+    xSemaphoreGive(bridge->modbus_mutex);
+
+    ESP_LOGI(TAG, "statistics reset");
+    return ESP_OK;
+}
+
+
+/**
+ * @brief 设置UART波特率
+ * 
+ * @param baudrate 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_baudrate(uart_bridge_handle_t bridge, uint32_t baudrate)
+{
+    if (!bridge || !bridge->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = uart_set_baudrate(bridge->uart_port, baudrate);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "set baudrate(%d) success", baudrate);
+        bridge->line.baudrate = baudrate;
+        notify_change(bridge);
+        if (bridge->frame_mode) {
+            // RTU帧间隔随波特率变化
+            uart_bridge_apply_rx_config(bridge, &bridge->config.rx);
+            xSemaphoreTake(bridge->modbus_mutex, portMAX_DELAY);
+            modbus_gw_set_timing(&bridge->modbus, &bridge->config.modbus, baudrate);
+            xSemaphoreGive(bridge->modbus_mutex);
+        }
+        if (bridge->config.baudrate != baudrate) {
+            bridge->config.baudrate = baudrate;
+            // 保存配置到NVS
+            uart_bridge_save_config(bridge);
+
+            // 按新的波特率调整缓冲区
+            uart_bridge_buffer_sizes_t sizes;
+            buffer_sizes_for_baudrate(baudrate, &bridge->config.buffer_override, &sizes);
+            if (uart_bridge_resize_buffers(bridge, &sizes) != ESP_OK) {
+                ESP_LOGW(TAG, "failed to resize buffers for baudrate(%" PRIu32 "), keep current size", baudrate);
+            }
+        }        
+    } else {
+        ESP_LOGE(TAG, "failed to set baudrate(%d): %s", baudrate, esp_err_to_name(ret));
+    }
+
+    return ret;
+}
+
+/**
+ * @brief 指定缓冲区大小
+ * 
+ * @param override 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_buffer_override(uart_bridge_handle_t bridge, const uart_bridge_buffer_sizes_t *override)
+{
+    if (!bridge || !bridge->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (!override || !buffer_override_is_valid(override)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uart_bridge_buffer_sizes_t sizes;
+    buffer_sizes_for_baudrate(bridge->config.baudrate, override, &sizes);
+    esp_err_t ret = uart_bridge_resize_buffers(bridge, &sizes);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    if (memcmp(&bridge->config.buffer_override, override, sizeof(uart_bridge_buffer_sizes_t)) == 0) {
+        return ESP_OK;
+    }
+
+    bridge->config.buffer_override = *override;
+    return uart_bridge_save_config(bridge);
+}
+
+esp_err_t uart_bridge_get_buffer_info(uart_bridge_handle_t bridge, uart_bridge_buffer_info_t *info)
+{
+    if (!bridge || !info) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    info->active = bridge->buffers;
+    info->override = bridge->config.buffer_override;
+    info->read_chunk = bridge->read_chunk;
+    info->client_queue_bytes = client_queue_bytes_for(&bridge->config) * UART_BRIDGE_MAX_CLIENTS;
+    info->inbound_queue_bytes = (bridge->inbound.mode == UART_BRIDGE_TX_ARBITER_FAIR && bridge->inbound.pool) ?
+                                TCP_INBOUND_MAX_CLIENTS * TCP_INBOUND_QUEUE_BYTES : 0;
+    info->task_stack_bytes = UART_BRIDGE_TASK_STACK_SIZE + UART_BRIDGE_SENDER_STACK_SIZE + UART_BRIDGE_TCP_STACK_SIZE;
+    info->outage_size = bridge->outage.size;
+    info->outage_used = outage_buffer_used(&bridge->outage);
+    info->outage_psram = bridge->outage.psram;
+    info->total_bytes = info->active.uart_rx_size + info->active.uart_tx_size + info->active.ring_size +
+                        info->client_queue_bytes + info->inbound_queue_bytes + info->task_stack_bytes +
+                        (info->outage_psram ? 0 : info->outage_size);
+    return ESP_OK;
+}
+
+/**
+ * @brief 设置断网缓存大小
+ * 
+ * @param size 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_outage_buffer(uart_bridge_handle_t bridge, uint32_t size)
+{
+    if (!bridge || !bridge->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (size != 0 && (size < UART_BRIDGE_OUTAGE_BUF_MIN || size > UART_BRIDGE_OUTAGE_BUF_MAX)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (bridge->config.outage_buf_size == size && bridge->outage.size == size) {
+        return ESP_OK;
+    }
+
+    // 先分配新的缓存, 失败时保持原样
+    outage_buffer_t new_outage;
+    esp_err_t ret = outage_buffer_init(&new_outage, size);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "failed to allocate outage buffer(%" PRIu32 ")", size);
+        return ret;
+    }
+
+    ret = uart_bridge_pause_tasks(bridge);
+    if (ret != ESP_OK) {
+        outage_buffer_deinit(&new_outage);
+        return ret;
+    }
+
+    // 发送任务已暂停, 原来缓存中还没有补发的数据丢弃
+    outage_buffer_t old_outage = bridge->outage;
+    bridge->outage = new_outage;
+    uart_bridge_resume_tasks(bridge);
+    outage_buffer_deinit(&old_outage);
+
+    bridge->config.outage_buf_size = size;
+    ESP_LOGI(TAG, "set outage buffer(%" PRIu32 ")%s", size, bridge->outage.psram ? ", psram" : "");
+    return uart_bridge_save_config(bridge);
+}
+
+uint32_t uart_bridge_get_outage_buffer(uart_bridge_handle_t bridge)
+{
+    return bridge->config.outage_buf_size;
+}
+
+/**
+ * @brief 设置慢客户端处理策略
+ * 
+ * @param policy 
+ * @param stall_timeout_ms 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_slow_client_policy(uart_bridge_handle_t bridge, uart_bridge_slow_client_policy_t policy, uint32_t stall_timeout_ms)
+{
+    if (!bridge || !bridge->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (policy >= UART_BRIDGE_SLOW_CLIENT_MAX || stall_timeout_ms == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (bridge->config.slow_client_policy == policy && bridge->config.stall_timeout_ms == stall_timeout_ms) {
+        return ESP_OK;
+    }
+
+    bridge->config.slow_client_policy = policy;
+    bridge->config.stall_timeout_ms = stall_timeout_ms;
+
+    tcp_fanout_config_t fanout_config;
+    fanout_config_from(&bridge->config, &fanout_config);
+    tcp_fanout_set_config(&bridge->fanout, &fanout_config);
+
+    ESP_LOGI(TAG, "set slow client policy(%d), stall timeout(%" PRIu32 "ms)", policy, stall_timeout_ms);
+    return uart_bridge_save_config(bridge);
+}
+
+esp_err_t uart_bridge_get_slow_client_policy(uart_bridge_handle_t bridge, uart_bridge_slow_client_policy_t *policy, uint32_t *stall_timeout_ms)
+{
+    if (!bridge || !policy || !stall_timeout_ms) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *policy = (uart_bridge_slow_client_policy_t)bridge->config.slow_client_policy;
+    *stall_timeout_ms = bridge->config.stall_timeout_ms;
+    return ESP_OK;
+}
+
+/**
+ * @brief 设置TCP转串口策略
+ * 
+ * @param policy 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_uart_tx_policy(uart_bridge_handle_t bridge, uart_bridge_uart_tx_policy_t policy)
+{
+    if (!bridge || !bridge->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (policy >= UART_BRIDGE_UART_TX_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (bridge->config.uart_tx_policy == policy) {
+        return ESP_OK;
+    }
+
+    bridge->config.uart_tx_policy = policy;
+    ESP_LOGI(TAG, "set uart tx policy(%d)", policy);
+    return uart_bridge_save_config(bridge);
+}
+
+uart_bridge_uart_tx_policy_t uart_bridge_get_uart_tx_policy(uart_bridge_handle_t bridge)
+{
+    return (uart_bridge_uart_tx_policy_t)bridge->config.uart_tx_policy;
+}
+
+/**
+ * @brief 设置多个TCP客户端写入串口的仲裁方式
+ * 
+ * @param arbiter 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_tx_arbiter(uart_bridge_handle_t bridge, uart_bridge_tx_arbiter_t arbiter)
+{
+    if (!bridge || !bridge->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (arbiter >= UART_BRIDGE_TX_ARBITER_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (bridge->config.tx_arbiter == arbiter) {
+        return ESP_OK;
+    }
+
+    // 发送任务暂停后才能释放队列
+    esp_err_t ret = uart_bridge_pause_tasks(bridge);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = tcp_inbound_set_mode(&bridge->inbound, arbiter);
+    if (ret == ESP_OK) {
+        bridge->config.tx_arbiter = arbiter;
+    }
+    uart_bridge_resume_tasks(bridge);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "set uart tx arbiter(%d)", arbiter);
+    return uart_bridge_save_config(bridge);
+}
+
+uart_bridge_tx_arbiter_t uart_bridge_get_tx_arbiter(uart_bridge_handle_t bridge)
+{
+    return (uart_bridge_tx_arbiter_t)bridge->config.tx_arbiter;
+}
+
+/**
+ * @brief 设置串口硬件流控
+ * 
+ * @param mode 
+ * @param rts_thresh 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_flow_ctrl(uart_bridge_handle_t bridge, uart_bridge_flow_ctrl_t mode, uint8_t rts_thresh)
+{
+    if (!bridge || !bridge->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (mode >= UART_BRIDGE_FLOW_CTRL_MAX || rts_thresh == 0 || rts_thresh >= SOC_UART_FIFO_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (bridge->config.flow_ctrl == mode && bridge->line.flow_ctrl == mode && bridge->config.rts_thresh == rts_thresh) {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = uart_bridge_apply_flow_ctrl(bridge, mode, rts_thresh);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    bridge->config.flow_ctrl = mode;
+    bridge->config.rts_thresh = rts_thresh;
+    bridge->line.flow_ctrl = mode;
+    return uart_bridge_save_config(bridge);
+}
+
+esp_err_t uart_bridge_get_flow_ctrl(uart_bridge_handle_t bridge, uart_bridge_flow_ctrl_t *mode, uint8_t *rts_thresh)
+{
+    if (!bridge || !mode || !rts_thresh) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *mode = (uart_bridge_flow_ctrl_t)bridge->config.flow_ctrl;
+    *rts_thresh = bridge->config.rts_thresh;
+    return ESP_OK;
+}
+
+/**
+ * @brief 设置串口接收分包参数
+ * 
+ * @param config 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_rx_config(uart_bridge_handle_t bridge, const uart_bridge_rx_config_t *config)
+{
+    if (!bridge || !bridge->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (!config || !rx_config_is_valid(config)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (memcmp(&bridge->config.rx, config, sizeof(uart_bridge_rx_config_t)) == 0) {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = uart_bridge_apply_rx_config(bridge, config);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    // 读取任务每次循环都会重新读取这些参数
+    bridge->config.rx = *config;
+
+    ESP_LOGI(TAG, "set rx config: idle(%d chars), fifo-thresh(%d), max-chunk(%d), max-hold(%dms)",
+             config->idle_chars, config->fifo_full_thresh, config->max_chunk, config->max_hold_ms);
+    return uart_bridge_save_config(bridge);
+}
+
+esp_err_t uart_bridge_get_rx_config(uart_bridge_handle_t bridge, uart_bridge_rx_config_t *config)
+{
+    if (!bridge || !config) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *config = bridge->config.rx;
+    return ESP_OK;
+}
+
+esp_err_t uart_bridge_set_sock_opts(uart_bridge_handle_t bridge, const uart_bridge_sock_opts_t *opts)
+{
+    if (!bridge || !bridge->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (!opts || !sock_opts_is_valid(opts)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (memcmp(&bridge->config.sock, opts, sizeof(uart_bridge_sock_opts_t)) == 0) {
+        return ESP_OK;
+    }
+
+    // tcp_server的客户端上限在创建时确定
+    const bool restart = tcp_service_running(bridge) &&
+                         ((bridge->config.sock.evict_policy == UART_BRIDGE_EVICT_NONE) !=
+                          (opts->evict_policy == UART_BRIDGE_EVICT_NONE));
+    if (restart) {
+        uart_bridge_stop_tcp_server(bridge);
+    }
+
+    bridge->config.sock = *opts;
+
+    tcp_fanout_config_t fanout_config;
+    fanout_config_from(&bridge->config, &fanout_config);
+    tcp_fanout_set_config(&bridge->fanout, &fanout_config);
+
+    ESP_LOGI(TAG, "set sock opts: nodelay(%d), evict(%d), keepalive(%ds/%ds/%d), user-timeout(%" PRIu32 "ms), "
+             "send-buf(%" PRIu32 "), recv-buf(%" PRIu32 ")", opts->nodelay, opts->evict_policy, opts->keepalive_idle_s,
+             opts->keepalive_intvl_s, opts->keepalive_count, opts->user_timeout_ms, opts->send_buf, opts->recv_buf);
+
+    esp_err_t ret = uart_bridge_save_config(bridge);
+    if (restart) {
+        esp_err_t start_ret = uart_bridge_start_tcp_server(bridge);
+        if (ret == ESP_OK) {
+            ret = start_ret;
+        }
+    }
+    return ret;
+}
+
+esp_err_t uart_bridge_get_sock_opts(uart_bridge_handle_t bridge, uart_bridge_sock_opts_t *opts)
+{
+    if (!bridge || !opts) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *opts = bridge->config.sock;
+    return ESP_OK;
+}
+
+void uart_bridge_refresh_link_profile(uart_bridge_handle_t bridge)
+{
+    if (!bridge || !bridge->initialized) {
+        return;
+    }
+
+    tcp_fanout_config_t fanout_config;
+    fanout_config_from(&bridge->config, &fanout_config);
+    tcp_fanout_set_config(&bridge->fanout, &fanout_config);
+}
+
+static bool udp_config_is_valid(const uart_bridge_udp_config_t *udp)
+{
+    return udp->seq_header <= 1;
+}
+
+static bool modbus_config_is_valid(const uart_bridge_modbus_config_t *modbus)
+{
+    return (modbus->response_timeout_ms >= 10 && modbus->response_timeout_ms <= 10000) &&
+           (modbus->turnaround_ms <= 1000);
+}
+
+/**
+ * @brief 按传输方式和分帧设置切换分帧模式, 切换时暂停读取和发送任务
+ * 
+ * 暂停时读取任务提交未完成的分包, 发送任务取完环形缓冲区, 两种模式的数据不会混在一起.
+ * 
+ * @return esp_err_t 
+ */
+static esp_err_t uart_bridge_update_frame_mode(uart_bridge_t *bridge)
+{
+    const bool frame_mode = frame_mode_for(&bridge->config);
+    if (bridge->frame_mode == frame_mode) {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = uart_bridge_pause_tasks(bridge);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    bridge->frame_mode = frame_mode;
+    ret = uart_bridge_apply_rx_config(bridge, &bridge->config.rx);
+    uart_bridge_resume_tasks(bridge);
+
+    ESP_LOGI(TAG, "rtu framing %s", frame_mode ? "on" : "off");
+    return ret;
+}
+
+/**
+ * @brief 设置网络传输方式
+ * 
+ * @param transport 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_transport(uart_bridge_handle_t bridge, uart_bridge_transport_t transport)
+{
+    if (!bridge || !bridge->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (transport >= UART_BRIDGE_TRANSPORT_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (bridge->config.transport == transport) {
+        return ESP_OK;
+    }
+
+    // 服务正在运行时, 按新的方式重新启动
+    const bool service = tcp_service_running(bridge) || udp_transport_is_running(&bridge->udp);
+    if (service) {
+        uart_bridge_stop_tcp_server(bridge);
+    }
+
+    bridge->config.transport = transport;
+    ESP_LOGI(TAG, "set transport(%d)", transport);
+
+    esp_err_t ret = uart_bridge_update_frame_mode(bridge);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "failed to switch rtu framing: %s", esp_err_to_name(ret));
+    }
+
+    ret = uart_bridge_save_config(bridge);
+    if (service) {
+        esp_err_t start_ret = uart_bridge_start_tcp_server(bridge);
+        if (ret == ESP_OK) {
+            ret = start_ret;
+        }
+    }
+    return ret;
+}
+
+uart_bridge_transport_t uart_bridge_get_transport(uart_bridge_handle_t bridge)
+{
+    return (uart_bridge_transport_t)bridge->config.transport;
+}
+
+/**
+ * @brief 设置RTU分帧
+ * 
+ * @param enable 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_rtu_framing(uart_bridge_handle_t bridge, bool enable)
+{
+    if (!bridge || !bridge->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (bridge->config.rtu_framing == (enable ? 1 : 0)) {
+        return ESP_OK;
+    }
+
+    const uint8_t old = bridge->config.rtu_framing;
+    bridge->config.rtu_framing = enable ? 1 : 0;
+    esp_err_t ret = uart_bridge_update_frame_mode(bridge);
+    if (ret != ESP_OK) {
+        bridge->config.rtu_framing = old;
+        return ret;
+    }
+
+    // 分帧模式下客户端使用TCP_NODELAY
+    tcp_fanout_config_t fanout_config;
+    fanout_config_from(&bridge->config, &fanout_config);
+    tcp_fanout_set_config(&bridge->fanout, &fanout_config);
+
+    ESP_LOGI(TAG, "set rtu framing(%d)", enable);
+    return uart_bridge_save_config(bridge);
+}
+
+bool uart_bridge_get_rtu_framing(uart_bridge_handle_t bridge)
+{
+    return bridge->config.rtu_framing != 0;
+}
+
+/**
+ * @brief 设置Modbus网关参数
+ * 
+ * @param config 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_modbus_config(uart_bridge_handle_t bridge, const uart_bridge_modbus_config_t *config)
+{
+    if (!bridge || !bridge->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (!config || !modbus_config_is_valid(config)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (memcmp(&bridge->config.modbus, config, sizeof(uart_bridge_modbus_config_t)) == 0) {
+        return ESP_OK;
+    }
+
+    xSemaphoreTake(bridge->modbus_mutex, portMAX_DELAY);
+    bridge->config.modbus = *config;
+    modbus_gw_set_timing(&bridge->modbus, config, bridge->line.baudrate);
+    xSemaphoreGive(bridge->modbus_mutex);
+
+    ESP_LOGI(TAG, "set modbus config: response-timeout(%dms), turnaround(%dms)",
+             config->response_timeout_ms, config->turnaround_ms);
+    return uart_bridge_save_config(bridge);
+}
+
+esp_err_t uart_bridge_get_modbus_config(uart_bridge_handle_t bridge, uart_bridge_modbus_config_t *config)
+{
+    if (!bridge || !config) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *config = bridge->config.modbus;
+    return ESP_OK;
+}
+
+esp_err_t uart_bridge_get_modbus_stats(uart_bridge_handle_t bridge, uart_bridge_modbus_stats_t *stats)
+{
+    if (!bridge || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!bridge->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(bridge->modbus_mutex, portMAX_DELAY);
+    *stats = bridge->modbus.stats;
+    xSemaphoreGive(bridge->modbus_mutex);
+    return ESP_OK;
+}
+
+/**
+ * @brief 设置UDP传输参数
+ * 
+ * @param config 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_udp_config(uart_bridge_handle_t bridge, const uart_bridge_udp_config_t *config)
+{
+    if (!bridge || !bridge->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (!config || !udp_config_is_valid(config)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (memcmp(&bridge->config.udp, config, sizeof(uart_bridge_udp_config_t)) == 0) {
+        return ESP_OK;
+    }
+
+    // 对端和序号头在启动时确定, 正在运行时重新启动UDP
+    const bool restart = udp_transport_is_running(&bridge->udp);
+    if (restart) {
+        uart_bridge_stop_tcp_server(bridge);
+    }
+
+    bridge->config.udp = *config;
+    ESP_LOGI(TAG, "set udp config: peer(%d.%d.%d.%d:%d), seq-header(%d)",
+             (int)(config->peer_addr & 0xFF), (int)((config->peer_addr >> 8) & 0xFF),
+             (int)((config->peer_addr >> 16) & 0xFF), (int)((config->peer_addr >> 24) & 0xFF),
+             config->peer_port, config->seq_header);
+
+    esp_err_t ret = uart_bridge_save_config(bridge);
+    if (restart) {
+        esp_err_t start_ret = uart_bridge_start_tcp_server(bridge);
+        if (ret == ESP_OK) {
+            ret = start_ret;
+        }
+    }
+    return ret;
+}
+
+esp_err_t uart_bridge_get_udp_config(uart_bridge_handle_t bridge, uart_bridge_udp_config_t *config)
+{
+    if (!bridge || !config) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *config = bridge->config.udp;
+    return ESP_OK;
+}
+
+/**
+ * @brief 设置RFC2217客户端修改的串口参数是否保存
+ * 
+ * @param persist 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_rfc2217_persist(uart_bridge_handle_t bridge, bool persist)
+{
+    if (!bridge || !bridge->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (bridge->config.rfc2217_persist == (persist ? 1 : 0)) {
+        return ESP_OK;
+    }
+
+    bridge->config.rfc2217_persist = persist ? 1 : 0;
+    ESP_LOGI(TAG, "set rfc2217 persist(%d)", persist);
+    return uart_bridge_save_config(bridge);
+}
+
+bool uart_bridge_get_rfc2217_persist(uart_bridge_handle_t bridge)
+{
+    return bridge->config.rfc2217_persist != 0;
+}
+
+/**
+ * @brief 设置串口接收引擎, 重启后生效
+ * 
+ * @param engine 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_rx_engine(uart_bridge_handle_t bridge, uart_bridge_rx_engine_t engine)
+{
+    if (!bridge || !bridge->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (engine >= UART_BRIDGE_RX_ENGINE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (engine == UART_BRIDGE_RX_ENGINE_DMA && !uart_dma_rx_supported()) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if (bridge->config.rx_engine == engine) {
+        return ESP_OK;
+    }
+
+    bridge->config.rx_engine = engine;
+    ESP_LOGI(TAG, "set rx engine(%d), effective after reboot", engine);
+    return uart_bridge_save_config(bridge);
+}
+
+uart_bridge_rx_engine_t uart_bridge_get_rx_engine(uart_bridge_handle_t bridge)
+{
+    return (uart_bridge_rx_engine_t)bridge->config.rx_engine;
+}
+
+/**
+ * @brief 设置TCP服务器引擎, 已连接的客户端会断开
+ * 
+ * @param engine 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_set_tcp_engine(uart_bridge_handle_t bridge, uart_bridge_tcp_engine_t engine)
+{
+    if (!bridge || !bridge->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (engine >= UART_BRIDGE_TCP_ENGINE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (engine == UART_BRIDGE_TCP_ENGINE_RAW && !raw_tcp_server_supported()) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if (bridge->config.tcp_engine == engine) {
+        return ESP_OK;
+    }
+
+    const bool restart = tcp_service_running(bridge);
+    if (restart) {
+        uart_bridge_stop_tcp_server(bridge);
+    }
+
+    bridge->config.tcp_engine = engine;
+    ESP_LOGI(TAG, "set tcp engine(%d)", engine);
+
+    esp_err_t ret = uart_bridge_save_config(bridge);
+    if (restart) {
+        esp_err_t start_ret = uart_bridge_start_tcp_server(bridge);
+        if (ret == ESP_OK) {
+            ret = start_ret;
+        }
+    }
+    return ret;
+}
+
+uart_bridge_tcp_engine_t uart_bridge_get_tcp_engine(uart_bridge_handle_t bridge)
+{
+    return (uart_bridge_tcp_engine_t)bridge->config.tcp_engine;
+}
+
+/**
+ * @brief 获取所有TCP客户端的统计信息
+ * 
+ * @param stats 
+ * @param count 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_get_client_stats(uart_bridge_handle_t bridge, uart_bridge_client_stats_t *stats, uint8_t *count)
+{
+    if (!bridge || !stats || !count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!bridge->initialized) {
+        *count = 0;
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    tcp_fanout_get_client_stats(&bridge->fanout, stats, count);
+    return ESP_OK;
+}
+
+esp_err_t uart_bridge_peek_client_stats(uart_bridge_handle_t bridge, uart_bridge_client_stats_t *stats, uint8_t *count)
+{
+    if (!bridge || !stats || !count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!bridge->initialized) {
+        *count = 0;
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    tcp_fanout_peek_client_stats(&bridge->fanout, stats, count);
+    return ESP_OK;
+}
+
+/**
+ * @brief 获取所有TCP客户端写入串口方向的统计信息
+ * 
+ * @param stats 
+ * @param count 
+ * @return esp_err_t 
+ */
+esp_err_t uart_bridge_get_inbound_stats(uart_bridge_handle_t bridge, uart_bridge_inbound_stats_t *stats, uint8_t *count)
+{
+    if (!bridge || !stats || !count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!bridge->initialized) {
+        *count = 0;
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    tcp_inbound_get_stats(&bridge->inbound, stats, count);
+    return ESP_OK;
+}
+
+/**
+ * @brief 启动UDP传输
+ * 
+ * @return esp_err_t 
+ */
+static esp_err_t uart_bridge_start_udp(uart_bridge_t *bridge)
+{
+    if (udp_transport_is_running(&bridge->udp)) {
+        ESP_LOGW(TAG, "udp transport already running");
+        return ESP_OK;
+    }
+
+    const udp_transport_config_t udp_config = {
+        .port = bridge->config.tcp_port,
+        .peer_addr = bridge->config.udp.peer_addr,
+        .peer_port = bridge->config.udp.peer_port,
+        .seq_header = bridge->config.udp.seq_header != 0,
+        .recv_callback = on_udp_data_received,
+        .user_ctx = bridge,
+        .task_priority = task_profile_placement(TASK_ROLE_UDP_RX)->priority,
+        .task_core = task_profile_placement(TASK_ROLE_UDP_RX)->core,
+    };
+
+    esp_err_t err = udp_transport_start(&bridge->udp, &udp_config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to start udp transport: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    // 唤醒发送任务, 按UDP方式发送
+    if (bridge->sender_handle) {
+        xTaskNotifyGive(bridge->sender_handle);
+    }
+
+    ESP_LOGI(TAG, "udp transport started on port(%d)", bridge->config.tcp_port);
+    return ESP_OK;
+}
+
+static const char *transport_suffix(const uart_bridge_t *bridge)
+{
+    switch (bridge->config.transport) {
+    case UART_BRIDGE_TRANSPORT_RFC2217:
+        return ", rfc2217";
+    case UART_BRIDGE_TRANSPORT_MODBUS:
+        return ", modbus gateway";
+    default:
+        return bridge->frame_mode ? ", rtu framing" : "";
+    }
+}
+
+/**
+ * @brief 启动网络服务, 需要持有service_mutex
+ * 
+ * @return esp_err_t 
+ */
+static esp_err_t start_tcp_server_locked(uart_bridge_t *bridge)
+{
+    if (bridge->config.transport == UART_BRIDGE_TRANSPORT_UDP) {
+        return uart_bridge_start_udp(bridge);
+    }
+
+    if (tcp_service_running(bridge)) {
+        // WiFi连接和获取IP都会启动服务
+        ESP_LOGD(TAG, "tcp server already running");
+        return ESP_OK;
+    }
+
+    if (bridge->config.transport == UART_BRIDGE_TRANSPORT_MODBUS) {
+        xSemaphoreTake(bridge->modbus_mutex, portMAX_DELAY);
+        esp_err_t err = modbus_gw_ready(&bridge->modbus) ? ESP_OK : modbus_gw_init(&bridge->modbus);
+        if (err == ESP_OK) {
+            modbus_gw_set_timing(&bridge->modbus, &bridge->config.modbus, bridge->line.baudrate);
+        }
+        xSemaphoreGive(bridge->modbus_mutex);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "failed to allocate modbus gateway: %s", esp_err_to_name(err));
+            return err;
+        }
+    }
+
+    // RFC2217模式下广播的数据需要转义
+    tcp_fanout_config_t fanout_config;
+    fanout_config_from(&bridge->config, &fanout_config);
+    tcp_fanout_set_config(&bridge->fanout, &fanout_config);
+
+    // 配置TCP服务器
+    tcp_server_config_t tcp_config = {
+        .port = bridge->config.tcp_port,
+        // 允许断开已有客户端时, 多接受一个连接, 由连接回调决定断开哪个
+        .max_clients = UART_BRIDGE_MAX_CLIENTS + (bridge->config.sock.evict_policy != UART_BRIDGE_EVICT_NONE ? 1 : 0),
+        .recv_callback = on_tcp_data_received,
+        .connect_callback = on_tcp_client_connected,
+        .disconnect_callback = on_tcp_client_disconnected,
+        .user_ctx = bridge,
+        .stack_size = UART_BRIDGE_TCP_STACK_SIZE,
+        .task_priority = task_profile_placement(TASK_ROLE_TCP_SERVER)->priority,
+        .verbose = false
+    };
+
+    esp_err_t err;
+    if (bridge->config.tcp_engine == UART_BRIDGE_TCP_ENGINE_RAW) {
+        bridge->raw_server = raw_tcp_server_create(&tcp_config, &err);
+        if (!bridge->raw_server || err != ESP_OK) {
+            ESP_LOGE(TAG, "failed to create raw tcp server: %s", esp_err_to_name(err));
+            return err;
+        }
+
+        // 公平方式下队列满时只暂停这个连接的交付, 不阻塞服务器任务
+        raw_tcp_server_set_recv_callback(bridge->raw_server, on_raw_data_received);
+        tcp_inbound_set_resume(&bridge->inbound, on_inbound_space, bridge->raw_server);
+
+        err = raw_tcp_server_start(bridge->raw_server);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "failed to start raw tcp server: %s", esp_err_to_name(err));
+            tcp_inbound_set_resume(&bridge->inbound, NULL, NULL);
+            raw_tcp_server_destroy(bridge->raw_server);
+            bridge->raw_server = NULL;
+            return err;
+        }
+
+        ESP_LOGI(TAG, "raw tcp server started on port(%d)%s", bridge->config.tcp_port, transport_suffix(bridge));
+        return ESP_OK;
+    }
+
+    // 创建TCP服务器
+    bridge->tcp_server = tcp_server_create(&tcp_config, &err);
+    if (!bridge->tcp_server || err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to create tcp server: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    // 启动TCP服务器
+    err = tcp_server_start(bridge->tcp_server);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to start tcp server: %s", esp_err_to_name(err));
+        tcp_server_destroy(bridge->tcp_server);
+        bridge->tcp_server = NULL;
+        return err;
+    }
+
+    ESP_LOGI(TAG, "tcp server started on port(%d)%s", bridge->config.tcp_port, transport_suffix(bridge));
+    return ESP_OK;
+}
+
+/**
+ * @brief 停止网络服务, 需要持有service_mutex
+ * 
+ * @return esp_err_t 
+ */
+static esp_err_t stop_tcp_server_locked(uart_bridge_t *bridge)
+{
+    if (udp_transport_is_running(&bridge->udp)) {
+        udp_transport_stop(&bridge->udp);
+    }
+
+    if (!tcp_service_running(bridge)) {
+        return ESP_OK;
+    }
+
+    // 先清空客户端发送队列, 发送任务不再访问这些连接
+    tcp_fanout_remove_all(&bridge->fanout);
+    // 丢弃接收队列中的数据, 销毁raw服务器之前取消恢复回调
+    tcp_inbound_remove_all(&bridge->inbound);
+    tcp_inbound_set_resume(&bridge->inbound, NULL, NULL);
+
+    xSemaphoreTake(bridge->rfc2217_mutex, portMAX_DELAY);
+    memset(bridge->rfc2217_clients, 0, sizeof(bridge->rfc2217_clients));
+    xSemaphoreGive(bridge->rfc2217_mutex);
+
+    // 已发出请求的回复到达时没有等待的事务, 计入unexpected
+    xSemaphoreTake(bridge->modbus_mutex, portMAX_DELAY);
+    modbus_gw_reset(&bridge->modbus);
+    xSemaphoreGive(bridge->modbus_mutex);
+
+    // 停止并销毁TCP服务器
+    if (bridge->raw_server) {
+        raw_tcp_server_stop(bridge->raw_server);
+        raw_tcp_server_destroy(bridge->raw_server);
+        bridge->raw_server = NULL;
+    } else {
+        tcp_server_stop(bridge->tcp_server);
+        tcp_server_destroy(bridge->tcp_server);
+        bridge->tcp_server = NULL;
+    }
+
+    ESP_LOGI(TAG, "tcp server stopped");
+    notify_change(bridge);
+    return ESP_OK;
+}
+
+esp_err_t uart_bridge_start_tcp_server(uart_bridge_handle_t bridge)
+{
+    if (!bridge || !bridge->initialized || !bridge->running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(bridge->service_mutex, portMAX_DELAY);
+    esp_err_t ret = start_tcp_server_locked(bridge);
+    xSemaphoreGive(bridge->service_mutex);
+    return ret;
+}
+
+esp_err_t uart_bridge_stop_tcp_server(uart_bridge_handle_t bridge)
+{
+    if (!bridge) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 没有初始化的实例没有运行网络服务
+    if (!bridge->service_mutex) {
+        return ESP_OK;
+    }
+
+    xSemaphoreTake(bridge->service_mutex, portMAX_DELAY);
+    esp_err_t ret = stop_tcp_server_locked(bridge);
+    xSemaphoreGive(bridge->service_mutex);
+    return ret;
+}
+
+esp_err_t uart_bridge_start_all(void)
+{
+    esp_err_t ret = ESP_OK;
+
+    for (int i = 0; i < UART_BRIDGE_MAX_INSTANCES; i++) {
+        if (!s_bridges[i].initialized) {
+            continue;
+        }
+        esp_err_t err = uart_bridge_start_tcp_server(&s_bridges[i]);
+        if (err != ESP_OK && ret == ESP_OK) {
+            ret = err;
+        }
+    }
+    return ret;
+}
+
+void uart_bridge_stop_all(void)
+{
+    for (int i = 0; i < UART_BRIDGE_MAX_INSTANCES; i++) {
+        if (s_bridges[i].initialized) {
+            uart_bridge_stop_tcp_server(&s_bridges[i]);
+        }
+    }
+}
+
+void uart_bridge_set_change_callback(uart_bridge_change_cb_t callback, void *user_ctx)
+{
+    // 先设置参数, 变化回调随时可能在其它任务中调用
+    s_change_ctx = user_ctx;
+    s_change_cb = callback;
+}
+
+
+bool uart_bridge_set_tcp_verbose(uart_bridge_handle_t bridge, bool tx_verbose, bool rx_verbose)
+{
+    if (bridge && bridge->tcp_server) {
+        tcp_server_set_verbose(bridge->tcp_server, tx_verbose, rx_verbose);
+        return true;
+    }
+
+    return false;
+}
+
+bool uart_bridge_set_uart_verbose(uart_bridge_handle_t bridge, bool tx_verbose, bool rx_verbose)
+{
+    if (!bridge) {
+        return false;
+    }
+
+    if (!tx_verbose && !rx_verbose) {
+        return traffic_capture_stop() == ESP_OK;
+    }
+
+    // 显示改为控制台捕获, 不再在转发路径上输出
+    const traffic_capture_config_t config = {
+        .source = bridge->index,
+        .dir_mask = (tx_verbose ? TRAFFIC_DIR_BIT(TRAFFIC_DIR_UART_TX) : 0) |
+                    (rx_verbose ? TRAFFIC_DIR_BIT(TRAFFIC_DIR_UART_RX) : 0),
+        .sink = TRAFFIC_SINK_CONSOLE,
+        .snaplen = TRAFFIC_CAPTURE_CONSOLE_SNAPLEN,
+    };
+    return traffic_capture_start(&config) == ESP_OK;
+}
+
+esp_err_t uart_bridge_set_loopback(uart_bridge_handle_t bridge, bool enable)
+{
+    if (!bridge || !bridge->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = uart_set_loop_back(bridge->uart_port, enable);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "uart(%d) loopback %s", bridge->uart_port, enable ? "enabled" : "disabled");
+    }
+    return ret;
+}
+
+
+// RFC2217回调的上下文
+typedef struct {
+    uart_bridge_t *bridge;
+    tcp_client_t *client;
+    size_t uart_bytes;      // 写入串口的字节数
+    size_t net_bytes;       // 收到的全部字节数, 包括Telnet命令
+} rfc2217_ctx_t;
+
+static rfc2217_client_t *rfc2217_client_find(uart_bridge_t *bridge, tcp_client_t *client)
+{
+    for (int i = 0; i < UART_BRIDGE_MAX_CLIENTS; i++) {
+        if (bridge->rfc2217_clients[i].client == client) {
+            return &bridge->rfc2217_clients[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 是否需要保存RFC2217客户端修改的参数
+ * 
+ * @return true 
+ * @return false 
+ */
+static bool rfc2217_save_line(uart_bridge_t *bridge)
+{
+    if (!bridge->config.rfc2217_persist) {
+        return false;
+    }
+
+    bridge->config.baudrate = bridge->line.baudrate;
+    bridge->config.data_bits = bridge->line.data_bits;
+    bridge->config.parity = bridge->line.parity;
+    bridge->config.stop_bits = bridge->line.stop_bits;
+    bridge->config.flow_ctrl = bridge->line.flow_ctrl;
+    uart_bridge_save_config(bridge);
+    return true;
+}
+
+/**
+ * @brief 恢复保存的串口参数, 最后一个RFC2217客户端断开时调用
+ * 
+ * 只修改串口参数, 不重新安装驱动.
+ */
+static void rfc2217_restore_line(uart_bridge_t *bridge)
+{
+    const uart_port_t port = bridge->uart_port;
+
+    if (bridge->line.baudrate != bridge->config.baudrate) {
+        uart_set_baudrate(port, bridge->config.baudrate);
+    }
+    if (bridge->line.data_bits != bridge->config.data_bits) {
+        uart_set_word_length(port, (uart_word_length_t)bridge->config.data_bits);
+    }
+    if (bridge->line.parity != bridge->config.parity) {
+        uart_set_parity(port, (uart_parity_t)bridge->config.parity);
+    }
+    if (bridge->line.stop_bits != bridge->config.stop_bits) {
+        uart_set_stop_bits(port, (uart_stop_bits_t)bridge->config.stop_bits);
+    }
+    if (bridge->line.flow_ctrl != bridge->config.flow_ctrl) {
+        uart_bridge_apply_flow_ctrl(bridge, bridge->config.flow_ctrl, bridge->config.rts_thresh);
+    }
+
+    bridge->line.baudrate = bridge->config.baudrate;
+    bridge->line.data_bits = bridge->config.data_bits;
+    bridge->line.parity = bridge->config.parity;
+    bridge->line.stop_bits = bridge->config.stop_bits;
+    bridge->line.flow_ctrl = bridge->config.flow_ctrl;
+    ESP_LOGI(TAG, "rfc2217 line settings restored, baudrate(%" PRIu32 ")", bridge->line.baudrate);
+    notify_change(bridge);
+}
+
+static void rfc2217_on_data(const uint8_t *data, size_t len, void *ctx)
+{
+    rfc2217_ctx_t *rctx = (rfc2217_ctx_t *)ctx;
+    uart_bridge_t *bridge = rctx->bridge;
+    if (send_data_to_uart(bridge, STATS_SHARD_NET, data, len) == ESP_OK) {
+        rctx->uart_bytes += len;
+    }
+}
+
+static void rfc2217_on_reply(const uint8_t *data, size_t len, void *ctx)
+{
+    rfc2217_ctx_t *rctx = (rfc2217_ctx_t *)ctx;
+    uart_bridge_t *bridge = rctx->bridge;
+    if (tcp_fanout_send_to(&bridge->fanout, rctx->client, data, len) == ESP_OK && bridge->sender_handle) {
+        xTaskNotifyGive(bridge->sender_handle);
+    }
+}
+
+static uint8_t rfc2217_on_modem_state(void *ctx)
+{
+    // 没有modem信号, 始终报告对端就绪, 开启流控时CTS由硬件处理
+    return RFC2217_MODEMSTATE_CTS | RFC2217_MODEMSTATE_DSR | RFC2217_MODEMSTATE_CD;
+}
+
+/**
+ * @brief RFC2217串口参数设置, 只修改串口参数, 不重新安装驱动
+ * 
+ * @param command 
+ * @param value 0表示查询
+ * @param ctx 
+ * @return uint32_t 实际生效的值
+ */
+static uint32_t rfc2217_on_control(uint8_t command, uint32_t value, void *ctx)
+{
+    uart_bridge_t *bridge = ((rfc2217_ctx_t *)ctx)->bridge;
+    const uart_port_t port = bridge->uart_port;
+    uart_line_t *line = &bridge->line;
+    bool changed = false;
+
+    switch (command) {
+    case RFC2217_SET_BAUDRATE:
+        if (value >= RFC2217_BAUDRATE_MIN && value <= RFC2217_BAUDRATE_MAX && value != line->baudrate &&
+            uart_set_baudrate(port, value) == ESP_OK) {
+            line->baudrate = value;
+            changed = true;
+            notify_change(bridge);
+        }
+        value = line->baudrate;
+        break;
+    case RFC2217_SET_DATASIZE:
+        if (value >= 5 && value <= 8) {
+            const uint8_t data_bits = UART_DATA_5_BITS + (value - 5);
+            if (data_bits != line->data_bits && uart_set_word_length(port, (uart_word_length_t)data_bits) == ESP_OK) {
+                line->data_bits = data_bits;
+                changed = true;
+            }
+        }
+        value = line->data_bits - UART_DATA_5_BITS + 5;
+        break;
+    case RFC2217_SET_PARITY: {
+        // 硬件不支持MARK/SPACE校验, 回复当前值
+        int parity = -1;
+        if (value == RFC2217_PARITY_NONE) {
+            parity = UART_PARITY_DISABLE;
+        } else if (value == RFC2217_PARITY_ODD) {
+            parity = UART_PARITY_ODD;
+        } else if (value == RFC2217_PARITY_EVEN) {
+            parity = UART_PARITY_EVEN;
+        }
+        if (parity >= 0 && parity != line->parity && uart_set_parity(port, (uart_parity_t)parity) == ESP_OK) {
+            line->parity = parity;
+            changed = true;
+        }
+        value = (line->parity == UART_PARITY_ODD) ? RFC2217_PARITY_ODD :
+                (line->parity == UART_PARITY_EVEN) ? RFC2217_PARITY_EVEN : RFC2217_PARITY_NONE;
+        break;
+    }
+    case RFC2217_SET_STOPSIZE: {
+        int stop_bits = -1;
+        if (value == RFC2217_STOPSIZE_1) {
+            stop_bits = UART_STOP_BITS_1;
+        } else if (value == RFC2217_STOPSIZE_2) {
+            stop_bits = UART_STOP_BITS_2;
+        } else if (value == RFC2217_STOPSIZE_1_5) {
+            stop_bits = UART_STOP_BITS_1_5;
+        }
+        if (stop_bits >= 0 && stop_bits != line->stop_bits &&
+            uart_set_stop_bits(port, (uart_stop_bits_t)stop_bits) == ESP_OK) {
+            line->stop_bits = stop_bits;
+            changed = true;
+        }
+        value = (line->stop_bits == UART_STOP_BITS_2) ? RFC2217_STOPSIZE_2 :
+                (line->stop_bits == UART_STOP_BITS_1_5) ? RFC2217_STOPSIZE_1_5 : RFC2217_STOPSIZE_1;
+        break;
+    }
+    case RFC2217_SET_CONTROL:
+        switch (value) {
+        case RFC2217_CONTROL_FLOW_NONE:
+        case RFC2217_CONTROL_FLOW_HW: {
+            // 不支持XON/XOFF, 回复当前值
+            const uint8_t mode = (value == RFC2217_CONTROL_FLOW_HW) ? UART_BRIDGE_FLOW_CTRL_RTS_CTS : UART_BRIDGE_FLOW_CTRL_NONE;
+            if (mode != line->flow_ctrl && uart_bridge_apply_flow_ctrl(bridge, mode, bridge->config.rts_thresh) == ESP_OK) {
+                line->flow_ctrl = mode;
+                changed = true;
+            }
+        }
+        /* fall through */
+        case RFC2217_CONTROL_FLOW_QUERY:
+        case RFC2217_CONTROL_FLOW_XONXOFF:
+            value = (line->flow_ctrl == UART_BRIDGE_FLOW_CTRL_RTS_CTS) ? RFC2217_CONTROL_FLOW_HW : RFC2217_CONTROL_FLOW_NONE;
+            break;
+        case RFC2217_CONTROL_BREAK_QUERY:
+        case RFC2217_CONTROL_BREAK_ON:
+        case RFC2217_CONTROL_BREAK_OFF:
+            // 驱动不支持持续的BREAK状态
+            value = RFC2217_CONTROL_BREAK_OFF;
+            break;
+        case RFC2217_CONTROL_DTR_ON:
+        case RFC2217_CONTROL_DTR_OFF:
+            bridge->rfc2217_dtr = (value == RFC2217_CONTROL_DTR_ON);
+            /* fall through */
+        case RFC2217_CONTROL_DTR_QUERY:
+            value = bridge->rfc2217_dtr ? RFC2217_CONTROL_DTR_ON : RFC2217_CONTROL_DTR_OFF;
+            break;
+        case RFC2217_CONTROL_RTS_ON:
+        case RFC2217_CONTROL_RTS_OFF:
+            bridge->rfc2217_rts = (value == RFC2217_CONTROL_RTS_ON);
+            /* fall through */
+        case RFC2217_CONTROL_RTS_QUERY:
+            value = bridge->rfc2217_rts ? RFC2217_CONTROL_RTS_ON : RFC2217_CONTROL_RTS_OFF;
+            break;
+        default:
+            break;
+        }
+        break;
+    case RFC2217_PURGE_DATA:
+        // 1=接收缓冲区, 2=发送缓冲区, 3=两者; 驱动不支持清空发送缓冲区
+        if (value == 1 || value == 3) {
+            uart_flush_input(port);
+        }
+        break;
+    default:
+        break;
+    }
+
+    if (changed) {
+        ESP_LOGI(TAG, "rfc2217 set line: %" PRIu32 " %d%c%s%s", line->baudrate, line->data_bits - UART_DATA_5_BITS + 5,
+                 line->parity == UART_PARITY_ODD ? 'O' : (line->parity == UART_PARITY_EVEN ? 'E' : 'N'),
+                 line->stop_bits == UART_STOP_BITS_2 ? "2" : (line->stop_bits == UART_STOP_BITS_1_5 ? "1.5" : "1"),
+                 line->flow_ctrl == UART_BRIDGE_FLOW_CTRL_RTS_CTS ? " rts/cts" : "");
+        rfc2217_save_line(bridge);
+    }
+
+    return value;
+}
+
+/**
+ * @brief (发送任务)把读取任务记录的线路错误通知给RFC2217客户端
+ */
+static void rfc2217_notify_line_events(uart_bridge_t *bridge)
+{
+    const uint8_t events = (uint8_t)atomic_exchange(&bridge->line_events, 0);
+    if (events == 0 || bridge->config.transport != UART_BRIDGE_TRANSPORT_RFC2217) {
+        return;
+    }
+
+    // tcp_server回调可能正阻塞在串口写入(NO_DROP策略), 拿不到锁时下次再通知
+    if (xSemaphoreTake(bridge->rfc2217_mutex, 0) != pdTRUE) {
+        atomic_fetch_or(&bridge->line_events, events);
+        return;
+    }
+
+    uint8_t frame[RFC2217_FRAME_MAX];
+    for (int i = 0; i < UART_BRIDGE_MAX_CLIENTS; i++) {
+        rfc2217_client_t *rc = &bridge->rfc2217_clients[i];
+        size_t len = rc->client ? rfc2217_notify_linestate(&rc->session, events, frame) : 0;
+        if (len > 0) {
+            tcp_fanout_send_to(&bridge->fanout, rc->client, frame, len);
+        }
+    }
+    xSemaphoreGive(bridge->rfc2217_mutex);
+}
+
+static void on_rfc2217_data_received(uart_bridge_t *bridge, tcp_client_t *client, const uint8_t *data, size_t len)
+{
+    rfc2217_ctx_t ctx = {
+        .bridge = bridge,
+        .client = client,
+    };
+    const rfc2217_ops_t ops = {
+        .data = rfc2217_on_data,
+        .reply = rfc2217_on_reply,
+        .control = rfc2217_on_control,
+        .modem_state = rfc2217_on_modem_state,
+        .ctx = &ctx,
+    };
+    const int64_t received_us = esp_timer_get_time();
+
+    xSemaphoreTake(bridge->rfc2217_mutex, portMAX_DELAY);
+    rfc2217_client_t *rc = rfc2217_client_find(bridge, client);
+    if (rc) {
+        rfc2217_input(&rc->session, data, len, &ops);
+    }
+    xSemaphoreGive(bridge->rfc2217_mutex);
+
+    if (ctx.uart_bytes > 0) {
+        const int64_t now_us = esp_timer_get_time();
+        latency_hist_record(&bridge->latency[UART_BRIDGE_LATENCY_UART_TX], (uint32_t)(now_us - received_us));
+        rate_meter_add(&bridge->uart_tx_rate, ctx.uart_bytes, now_us);
+    }
+
+    uart_bridge_stats_t *stats = stats_write_begin(bridge, STATS_SHARD_NET);
+    stats->tcp_rx_bytes += len;
+    stats_write_end(bridge, STATS_SHARD_NET);
+}
+
+static void modbus_on_send_rtu(const uint8_t *frame, size_t len, void *ctx)
+{
+    uart_bridge_t *bridge = (uart_bridge_t *)ctx;
+    if (send_data_to_uart(bridge, STATS_SHARD_SENDER, frame, len) == ESP_OK) {
+        rate_meter_add(&bridge->uart_tx_rate, len, esp_timer_get_time());
+    }
+}
+
+static void modbus_on_send_tcp(tcp_client_t *client, const uint8_t *data, size_t len, void *ctx)
+{
+    uart_bridge_t *bridge = (uart_bridge_t *)ctx;
+    if (tcp_fanout_send_to(&bridge->fanout, client, data, len) == ESP_OK && bridge->sender_handle) {
+        xTaskNotifyGive(bridge->sender_handle);
+    }
+}
+
+static void modbus_ops_init(uart_bridge_t *bridge, modbus_gw_ops_t *ops)
+{
+    ops->send_rtu = modbus_on_send_rtu;
+    ops->send_tcp = modbus_on_send_tcp;
+    ops->ctx = bridge;
+}
+
+/**
+ * @brief 客户端的Modbus TCP请求进入事务队列, 由发送任务发到总线
+ * 
+ * @param client 
+ * @param data 
+ * @param len 
+ */
+static void on_modbus_data_received(uart_bridge_t *bridge, tcp_client_t *client, const uint8_t *data, size_t len)
+{
+    modbus_gw_ops_t ops;
+    modbus_ops_init(bridge, &ops);
+
+    xSemaphoreTake(bridge->modbus_mutex, portMAX_DELAY);
+    modbus_gw_tcp_input(&bridge->modbus, client, data, len, &ops);
+    xSemaphoreGive(bridge->modbus_mutex);
+
+    if (bridge->sender_handle) {
+        xTaskNotifyGive(bridge->sender_handle);
+    }
+
+    uart_bridge_stats_t *stats = stats_write_begin(bridge, STATS_SHARD_NET);
+    stats->tcp_rx_bytes += len;
+    stats_write_end(bridge, STATS_SHARD_NET);
+}
+
+/**
+ * @brief (发送任务)串口收到的RTU帧交给网关, 匹配的回复发给发起请求的客户端
+ * 
+ * @param frame 
+ * @param len 
+ */
+static void modbus_rtu_received(uart_bridge_t *bridge, const uint8_t *frame, size_t len)
+{
+    modbus_gw_ops_t ops;
+    modbus_ops_init(bridge, &ops);
+
+    xSemaphoreTake(bridge->modbus_mutex, portMAX_DELAY);
+    modbus_gw_rtu_input(&bridge->modbus, frame, len, esp_timer_get_time(), &ops);
+    xSemaphoreGive(bridge->modbus_mutex);
+}
+
+/**
+ * @brief (发送任务)处理回复超时并发出下一个请求
+ * 
+ * @return uint32_t 距离下一个截止时间的毫秒数
+ */
+static uint32_t modbus_poll(uart_bridge_t *bridge)
+{
+    modbus_gw_ops_t ops;
+    modbus_ops_init(bridge, &ops);
+
+    xSemaphoreTake(bridge->modbus_mutex, portMAX_DELAY);
+    const uint32_t wait_ms = modbus_gw_poll(&bridge->modbus, esp_timer_get_time(), &ops);
+    xSemaphoreGive(bridge->modbus_mutex);
+    return wait_ms;
+}
+
+/**
+ * @brief 公平仲裁方式下, 数据放入客户端自己的队列, 由发送任务轮询写入串口
+ * 
+ * 接收回调由一个任务处理所有连接, 队列满时不能在这里等待, 否则其它客户端也读不到数据.
+ * 按TCP转串口策略处理: 丢弃放不下的数据; 不丢弃时, raw引擎把剩下的数据留在服务器中,
+ * 只关闭这个连接的接收窗口, 队列有空间后重新交付. socket引擎无法只暂停一个连接, 同样丢弃.
+ * 
+ * @param client 
+ * @param data 
+ * @param len 
+ * @param received_us 
+ * @param hold 服务器可以保留没有接收的数据
+ * @return size_t 接收的字节数(放入队列或丢弃)
+ */
+static size_t on_fair_data_received(uart_bridge_t *bridge, tcp_client_t *client, const uint8_t *data, size_t len,
+                                    int64_t received_us, bool hold)
+{
+    hold = hold && (bridge->config.uart_tx_policy == UART_BRIDGE_UART_TX_NO_DROP);
+    bool held = false;
+
+    const size_t queued = tcp_inbound_push(&bridge->inbound, client, data, len, received_us, hold, &held);
+    if (queued > 0 && bridge->sender_handle) {
+        xTaskNotifyGive(bridge->sender_handle);
+    }
+
+    // 保留的数据之后重新交付, 这次不计入
+    const size_t accepted = held ? queued : len;
+    uart_bridge_stats_t *stats = stats_write_begin(bridge, STATS_SHARD_NET);
+    stats->tcp_rx_bytes += accepted;
+    stats->uart_tx_drop_bytes += accepted - queued;
+    if (held) {
+        stats->uart_tx_wait_count++;
+    }
+    stats_write_end(bridge, STATS_SHARD_NET);
+    return accepted;
+}
+
+/**
+ * @brief 处理客户端的数据
+ * 
+ * @param bridge 
+ * @param client 
+ * @param data 
+ * @param len 
+ * @param hold 服务器可以保留没有接收的数据, 只用于raw引擎
+ * @return size_t 接收的字节数, 只在公平方式下队列满时少于len
+ */
+static size_t tcp_data_received(uart_bridge_t *bridge, tcp_client_t *client, const uint8_t *data, size_t len,
+                                bool hold)
+{
+    if (!data || len == 0) {
+        return len;
+    }
+
+    const int64_t received_us = esp_timer_get_time();
+
+    ESP_LOGD(TAG, "received %d bytes from client(%s:%d)", 
+             len, ipaddr_ntoa(&client->ip_addr), client->port);
+
+    // 已经被断开或拒绝的客户端, 关闭前收到的数据不再写入串口
+    if (!tcp_fanout_touch(&bridge->fanout, client)) {
+        return len;
+    }
+
+    if (bridge->config.transport == UART_BRIDGE_TRANSPORT_RFC2217) {
+        on_rfc2217_data_received(bridge, client, data, len);
+        return len;
+    }
+
+    if (bridge->config.transport == UART_BRIDGE_TRANSPORT_MODBUS) {
+        on_modbus_data_received(bridge, client, data, len);
+        return len;
+    }
+
+    if (bridge->config.tx_arbiter == UART_BRIDGE_TX_ARBITER_FAIR) {
+        return on_fair_data_received(bridge, client, data, len, received_us, hold);
+    }
+
+    // 发送数据到UART, 独占方式下其它客户端的数据丢弃
+    if (tcp_inbound_admit(&bridge->inbound, client, len) &&
+        send_data_to_uart(bridge, STATS_SHARD_NET, data, len) == ESP_OK) {
+        const int64_t now_us = esp_timer_get_time();
+        latency_hist_record(&bridge->latency[UART_BRIDGE_LATENCY_UART_TX], (uint32_t)(now_us - received_us));
+        rate_meter_add(&bridge->uart_tx_rate, len, now_us);
+    }
+
+    // 更新统计信息
+    uart_bridge_stats_t *stats = stats_write_begin(bridge, STATS_SHARD_NET);
+    stats->tcp_rx_bytes += len;
+    stats_write_end(bridge, STATS_SHARD_NET);    
+    return len;
+}
+
+static void on_tcp_data_received(tcp_client_t *client, const uint8_t *data, size_t len, void *user_ctx)
+{
+    tcp_data_received((uart_bridge_t *)user_ctx, client, data, len, false);
+}
+
+static size_t on_raw_data_received(tcp_client_t *client, const uint8_t *data, size_t len, void *user_ctx)
+{
+    return tcp_data_received((uart_bridge_t *)user_ctx, client, data, len, true);
+}
+
+/**
+ * @brief 公平方式的接收队列有空间后, 唤醒raw服务器重新交付暂停的数据
+ * 
+ * @param ctx raw服务器
+ */
+static void on_inbound_space(void *ctx)
+{
+    raw_tcp_server_resume((raw_tcp_server_handle_t)ctx);
+}
+
+static void on_tcp_client_connected(tcp_client_t *client, void *user_ctx)
+{
+    uart_bridge_t *bridge = (uart_bridge_t *)user_ctx;
+    ESP_LOGI(TAG, "tcp client(%s:%d) connected", 
+             ipaddr_ntoa(&client->ip_addr), client->port);
+
+    tcp_client_t *evicted = NULL;
+    if (tcp_fanout_add_client(&bridge->fanout, client, &evicted) != ESP_OK) {
+        // 服务器随后回调断开
+        tcp_engine_io(bridge->config.tcp_engine)->close(client);
+        uart_bridge_stats_t *stats = stats_write_begin(bridge, STATS_SHARD_NET);
+        stats->tcp_reject_count++;
+        stats_write_end(bridge, STATS_SHARD_NET);
+        return;
+    }
+
+    // 被断开的客户端让出接收队列
+    tcp_inbound_remove_client(&bridge->inbound, evicted);
+    tcp_inbound_add_client(&bridge->inbound, client);
+
+    if (bridge->sender_handle) {
+        // 断网缓存中有数据时立即开始补发
+        xTaskNotifyGive(bridge->sender_handle);
+    }
+
+    if (bridge->config.transport == UART_BRIDGE_TRANSPORT_RFC2217) {
+        xSemaphoreTake(bridge->rfc2217_mutex, portMAX_DELAY);
+        // 被断开的客户端让出会话
+        rfc2217_client_t *old = evicted ? rfc2217_client_find(bridge, evicted) : NULL;
+        if (old) {
+            old->client = NULL;
+        }
+        rfc2217_client_t *rc = rfc2217_client_find(bridge, NULL);
+        if (rc) {
+            rc->client = client;
+            rfc2217_session_init(&rc->session);
+        }
+        xSemaphoreGive(bridge->rfc2217_mutex);
+    }
+
+    uart_bridge_stats_t *stats = stats_write_begin(bridge, STATS_SHARD_NET);
+    stats->tcp_connect_count++;
+    if (evicted) {
+        stats->tcp_evict_count++;
+    }
+    stats_write_end(bridge, STATS_SHARD_NET);
+
+    notify_change(bridge);
+}
+
+static void on_tcp_client_disconnected(tcp_client_t *client, void *user_ctx)
+{
+    uart_bridge_t *bridge = (uart_bridge_t *)user_ctx;
+    ESP_LOGI(TAG, "tcp client(%s:%d) disconnected", 
+             ipaddr_ntoa(&client->ip_addr), client->port);
+
+    tcp_fanout_remove_client(&bridge->fanout, client);
+    tcp_inbound_remove_client(&bridge->inbound, client);
+
+    if (bridge->config.transport == UART_BRIDGE_TRANSPORT_RFC2217) {
+        bool last = true;
+        xSemaphoreTake(bridge->rfc2217_mutex, portMAX_DELAY);
+        rfc2217_client_t *rc = rfc2217_client_find(bridge, client);
+        if (rc) {
+            rc->client = NULL;
+        }
+        for (int i = 0; i < UART_BRIDGE_MAX_CLIENTS; i++) {
+            if (bridge->rfc2217_clients[i].client) {
+                last = false;
+            }
+        }
+        // 不保存时, 最后一个客户端断开后恢复原来的参数
+        if (last && !bridge->config.rfc2217_persist) {
+            rfc2217_restore_line(bridge);
+        }
+        xSemaphoreGive(bridge->rfc2217_mutex);
+    }
+
+    if (bridge->config.transport == UART_BRIDGE_TRANSPORT_MODBUS) {
+        xSemaphoreTake(bridge->modbus_mutex, portMAX_DELAY);
+        modbus_gw_remove_client(&bridge->modbus, client);
+        xSemaphoreGive(bridge->modbus_mutex);
+    }
+
+    uart_bridge_stats_t *stats = stats_write_begin(bridge, STATS_SHARD_NET);
+    stats->tcp_disconnect_count++;
+    stats_write_end(bridge, STATS_SHARD_NET);
+
+    notify_change(bridge);
+}
+
+static void on_udp_data_received(const uint8_t *data, size_t len, const udp_transport_rx_info_t *info, void *user_ctx)
+{
+    uart_bridge_t *bridge = (uart_bridge_t *)user_ctx;
+    const int64_t received_us = esp_timer_get_time();
+
+    if (len > 0 && send_data_to_uart(bridge, STATS_SHARD_NET, data, len) == ESP_OK) {
+        const int64_t now_us = esp_timer_get_time();
+        latency_hist_record(&bridge->latency[UART_BRIDGE_LATENCY_UART_TX], (uint32_t)(now_us - received_us));
+        rate_meter_add(&bridge->uart_tx_rate, len, now_us);
+    }
+
+    uart_bridge_stats_t *stats = stats_write_begin(bridge, STATS_SHARD_NET);
+    stats->udp_rx_datagrams++;
+    stats->udp_rx_bytes += len;
+    stats->udp_rx_lost += info->lost;
+    stats->udp_rx_reordered += info->reordered ? 1 : 0;
+    stats->udp_rx_malformed += info->malformed ? 1 : 0;
+    stats_write_end(bridge, STATS_SHARD_NET);
+}
+
+/**
+ * @brief (读取任务)记录分包的时间戳
+ * 
+ * 队列满时计入rx_mark_overflow_count. 普通方式下时间戳只用于延迟统计, 直接丢弃;
+ * 分帧方式下时间戳同时是帧边界, 丢弃会把两个帧合成一个, 这时等待发送任务取走已经提交的帧.
+ * 
+ * @param end_pos 
+ * @param arrival_us 
+ */
+static void uart_rx_mark_push(uart_bridge_t *bridge, uint32_t end_pos, int64_t arrival_us)
+{
+    unsigned head = atomic_load_explicit(&bridge->rx_mark_head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&bridge->rx_mark_tail, memory_order_acquire);
+
+    if (head - tail >= RX_MARK_QUEUE_LEN) {
+        uart_bridge_stats_t *stats = stats_write_begin(bridge, STATS_SHARD_READER);
+        stats->rx_mark_overflow_count++;
+        stats_write_end(bridge, STATS_SHARD_READER);
+
+        if (!bridge->frame_mode) {
+            return;
+        }
+
+        // 串口驱动的接收缓冲区在等待期间继续接收
+        while (head - tail >= RX_MARK_QUEUE_LEN && bridge->sender_running) {
+            xTaskNotifyGive(bridge->sender_handle);
+            vTaskDelay(1);
+            tail = atomic_load_explicit(&bridge->rx_mark_tail, memory_order_acquire);
+        }
+        if (head - tail >= RX_MARK_QUEUE_LEN) {
+            return;
+        }
+    }
+
+    bridge->rx_marks[head % RX_MARK_QUEUE_LEN].end_pos = end_pos;
+    bridge->rx_marks[head % RX_MARK_QUEUE_LEN].arrival_us = arrival_us;
+    atomic_store_explicit(&bridge->rx_mark_head, head + 1, memory_order_release);
+}
+
+/**
+ * @brief (发送任务)查找pos处数据所在的分包, 同时丢弃已经发出的分包时间戳
+ * 
+ * @param pos 
+ * @param end_pos 输出分包结束位置, 未知时为pos
+ * @return int64_t 到达时间, 0表示未知
+ */
+static int64_t uart_rx_mark_find(uart_bridge_t *bridge, uint32_t pos, uint32_t *end_pos)
+{
+    unsigned tail = atomic_load_explicit(&bridge->rx_mark_tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&bridge->rx_mark_head, memory_order_acquire);
+
+    for (; tail != head; tail++) {
+        const uart_rx_mark_t *mark = &bridge->rx_marks[tail % RX_MARK_QUEUE_LEN];
+        if ((int32_t)(mark->end_pos - pos) > 0) {
+            atomic_store_explicit(&bridge->rx_mark_tail, tail, memory_order_release);
+            *end_pos = mark->end_pos;
+            return mark->arrival_us;
+        }
+    }
+
+    atomic_store_explicit(&bridge->rx_mark_tail, tail, memory_order_release);
+    *end_pos = pos;
+    return 0;
+}
+
+/**
+ * @brief 提交当前分包, 交给发送任务
+ * 
+ * @param rx 分包状态
+ * @param reason 提交原因, 用于统计
+ */
+static void uart_rx_packet_flush(uart_bridge_t *bridge, uart_rx_packet_t *rx, uart_rx_flush_reason_t reason)
+{
+    if (rx->pending == 0 && rx->frame_len == 0) {
+        return;
+    }
+
+    ring_buffer_commit(&bridge->rx_ring, rx->pending);
+    rx->commit_pos += rx->pending;
+    rx->pending = 0;
+    rx->frame_len = 0;
+    rx->dma_split = false;
+    uart_rx_mark_push(bridge, rx->commit_pos, rx->start_us);
+    xTaskNotifyGive(bridge->sender_handle);
+
+    stats_update_ring_high_water(bridge, (uint32_t)ring_buffer_used(&bridge->rx_ring));
+
+    if (reason != UART_RX_FLUSH_NONE) {
+        uart_bridge_stats_t *stats = stats_write_begin(bridge, STATS_SHARD_READER);
+        if (reason == UART_RX_FLUSH_IDLE) {
+            stats->rx_flush_idle_count++;
+        } else if (reason == UART_RX_FLUSH_SIZE) {
+            stats->rx_flush_size_count++;
+        } else {
+            stats->rx_flush_hold_count++;
+        }
+        stats_write_end(bridge, STATS_SHARD_READER);
+    }
+}
+
+/**
+ * @brief (分帧模式)连续区间已用完, 提交已读入的数据但不结束当前帧
+ * 
+ * 不记录分包时间戳, 发送任务等到帧结束后一起取出.
+ * 
+ * @param rx 
+ */
+static void uart_rx_packet_wrap(uart_bridge_t *bridge, uart_rx_packet_t *rx)
+{
+    ring_buffer_commit(&bridge->rx_ring, rx->pending);
+    rx->commit_pos += rx->pending;
+    rx->frame_len += rx->pending;
+    rx->pending = 0;
+}
+
+/**
+ * @brief 当前分包还可以读入的最大长度, 分帧模式下为RTU帧的最大长度
+ * 
+ * @param rx 
+ * @return size_t 
+ */
+static size_t uart_rx_max_chunk(const uart_bridge_t *bridge, const uart_rx_packet_t *rx)
+{
+    if (bridge->frame_mode) {
+        return (rx->frame_len < MODBUS_RTU_MAX_ADU) ? (MODBUS_RTU_MAX_ADU - rx->frame_len) : 0;
+    }
+    return bridge->config.rx.max_chunk;
+}
+
+/**
+ * @brief 读入数据前记录分包的开始时间
+ * 
+ * @param rx 
+ */
+static inline void uart_rx_packet_begin(uart_rx_packet_t *rx)
+{
+    if (rx->pending == 0 && rx->frame_len == 0) {
+        rx->start = xTaskGetTickCount();
+        rx->start_us = esp_timer_get_time();
+    }
+}
+
+/**
+ * @brief 开始节流: 不再读取串口驱动, 驱动缓冲区和硬件FIFO满后, 由硬件拉高RTS
+ * 
+ * 串口驱动不提供RTS引脚状态, 以读取任务停止读取的时间作为RTS拉高的时间.
+ * 
+ * @param rx 
+ */
+static void uart_rx_throttle_begin(uart_bridge_t *bridge, uart_rx_packet_t *rx)
+{
+    if (bridge->line.flow_ctrl != UART_BRIDGE_FLOW_CTRL_NONE && rx->throttle_us == 0) {
+        rx->throttle_us = esp_timer_get_time();
+    }
+}
+
+static void uart_rx_throttle_end(uart_bridge_t *bridge, uart_rx_packet_t *rx)
+{
+    if (rx->throttle_us == 0) {
+        return;
+    }
+
+    uart_bridge_stats_t *stats = stats_write_begin(bridge, STATS_SHARD_READER);
+    stats->uart_rts_assert_count++;
+    stats->uart_rts_assert_ms += (esp_timer_get_time() - rx->throttle_us) / 1000;
+    stats_write_end(bridge, STATS_SHARD_READER);
+    rx->throttle_us = 0;
+}
+
+/**
+ * @brief 环形缓冲区已满, 等待发送任务释放空间
+ * 
+ * 开启流控时不丢弃数据, 由RTS通知对端暂停发送; 否则仍然没有空间时丢弃串口数据.
+ * 
+ * @param rx 
+ */
+static void uart_rx_ring_full(uart_bridge_t *bridge, uart_rx_packet_t *rx)
+{
+    uart_rx_throttle_begin(bridge, rx);
+
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RING_FULL_WAIT_MS));
+    if (ring_buffer_free(&bridge->rx_ring) > 0 || bridge->line.flow_ctrl != UART_BRIDGE_FLOW_CTRL_NONE) {
+        return;
+    }
+
+    // 丢弃串口数据, 避免驱动缓冲区溢出后无法统计
+    uint8_t discard_buf[RING_DISCARD_BUF_SIZE];
+    const int drop_bytes = uart_read_bytes(bridge->uart_port, discard_buf, sizeof(discard_buf), 0);
+    if (drop_bytes > 0) {
+        uart_bridge_stats_t *stats = stats_write_begin(bridge, STATS_SHARD_READER);
+        stats->uart_rx_bytes += drop_bytes;
+        stats->ring_overrun_count++;
+        stats->ring_overrun_bytes += drop_bytes;
+        stats_write_end(bridge, STATS_SHARD_READER);
+    }
+}
+
+/**
+ * @brief 把串口驱动缓冲区中已有的数据直接读入环形缓冲区
+ * 
+ * 数据先追加到当前分包, 达到最大分包长度时提交.
+ * 
+ * @param rx 分包状态
+ */
+static void uart_rx_drain(uart_bridge_t *bridge, uart_rx_packet_t *rx)
+{
+    size_t buffered = 0;
+
+    while (uart_get_buffered_data_len(bridge->uart_port, &buffered) == ESP_OK && buffered > 0) {
+        const size_t max_chunk = uart_rx_max_chunk(bridge, rx);
+        uint8_t *span = NULL;
+        size_t span_len = ring_buffer_write_span(&bridge->rx_ring, &span);
+
+        if (bridge->frame_mode && rx->pending < max_chunk && rx->pending > 0 && span_len <= rx->pending) {
+            // 帧跨越回绕
+            uart_rx_packet_wrap(bridge, rx);
+            continue;
+        }
+
+        if (rx->pending >= max_chunk || span_len <= rx->pending) {
+            if (rx->pending > 0 || (rx->frame_len > 0 && max_chunk == 0)) {
+                // 达到最大分包长度, 或连续区间已用完(回绕)
+                uart_rx_packet_flush(bridge, rx, UART_RX_FLUSH_SIZE);
+            } else {
+                uart_rx_ring_full(bridge, rx);
+            }
+            continue;
+        }
+
+        // 直接读入环形缓冲区, 不需要中间拷贝
+        size_t room = MIN(span_len, max_chunk) - rx->pending;
+        room = MIN(room, bridge->read_chunk);
+        const int rx_bytes = uart_read_bytes(bridge->uart_port, span + rx->pending, MIN(room, buffered), 0);
+        if (rx_bytes <= 0) {
+            if (rx_bytes < 0) {
+                ESP_LOGE(TAG, "uart read data failed:%d", rx_bytes);
+            }
+            break;
+        }
+
+        uart_rx_throttle_end(bridge, rx);
+        uart_rx_packet_begin(rx);
+        rx->pending += rx_bytes;
+        rate_meter_add(&bridge->uart_rx_rate, rx_bytes, esp_timer_get_time());
+
+        uart_bridge_stats_t *stats = stats_write_begin(bridge, STATS_SHARD_READER);
+        stats->uart_rx_bytes += rx_bytes;
+        stats_write_end(bridge, STATS_SHARD_READER);
+    }
+
+    if (rx->pending > 0 && rx->pending >= uart_rx_max_chunk(bridge, rx)) {
+        uart_rx_packet_flush(bridge, rx, UART_RX_FLUSH_SIZE);
+    }
+}
+
+/**
+ * @brief 处理串口驱动事件
+ * 
+ * @param rx 
+ * @param event 
+ */
+static void uart_rx_handle_event(uart_bridge_t *bridge, uart_rx_packet_t *rx, const uart_event_t *event)
+{
+    switch (event->type) {
+    case UART_DATA:
+        uart_rx_drain(bridge, rx);
+        if (event->timeout_flag) {
+            // 硬件接收超时, 线路已空闲
+            uart_rx_packet_flush(bridge, rx, UART_RX_FLUSH_IDLE);
+        }
+        break;
+    case UART_BUFFER_FULL:
+        // 驱动缓冲区满, 尽快读出
+        stats_write_begin(bridge, STATS_SHARD_READER)->uart_buffer_full_count++;
+        stats_write_end(bridge, STATS_SHARD_READER);
+        uart_rx_throttle_begin(bridge, rx);
+        uart_rx_drain(bridge, rx);
+        break;
+    case UART_FIFO_OVF:
+        // 硬件FIFO溢出, 数据已不完整, 提交已读入的数据后清空驱动缓冲区
+        ESP_LOGW(TAG, "uart hw fifo overflow");
+        stats_write_begin(bridge, STATS_SHARD_READER)->uart_fifo_ovf_count++;
+        stats_write_end(bridge, STATS_SHARD_READER);
+        uart_rx_packet_flush(bridge, rx, UART_RX_FLUSH_NONE);
+        uart_flush_input(bridge->uart_port);
+        xQueueReset(bridge->uart_queue);
+        atomic_fetch_or(&bridge->line_events, RFC2217_LINESTATE_OVERRUN);
+        break;
+    case UART_PARITY_ERR:
+        atomic_fetch_or(&bridge->line_events, RFC2217_LINESTATE_PARITY);
+        break;
+    case UART_FRAME_ERR:
+        atomic_fetch_or(&bridge->line_events, RFC2217_LINESTATE_FRAMING);
+        break;
+    case UART_BREAK:
+        atomic_fetch_or(&bridge->line_events, RFC2217_LINESTATE_BREAK);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief 取出DMA已写入环形缓冲区的数据, 计入当前分包
+ * 
+ * DMA的写入位置始终是环形缓冲区写位置+pending, 提交分包不影响进行中的传输.
+ * 
+ * @param rx 
+ * @return true 当前传输已结束
+ * @return false 
+ */
+static bool uart_rx_dma_collect(uart_bridge_t *bridge, uart_rx_packet_t *rx)
+{
+    bool done = false;
+    const size_t rx_bytes = uart_dma_rx_take(&bridge->rx_dma, &done);
+
+    if (rx_bytes > 0) {
+        uart_rx_throttle_end(bridge, rx);
+        uart_rx_packet_begin(rx);
+        rx->pending += rx_bytes;
+        rate_meter_add(&bridge->uart_rx_rate, rx_bytes, esp_timer_get_time());
+
+        uart_bridge_stats_t *stats = stats_write_begin(bridge, STATS_SHARD_READER);
+        stats->uart_rx_bytes += rx_bytes;
+        stats_write_end(bridge, STATS_SHARD_READER);
+    }
+
+    return done;
+}
+
+/**
+ * @brief (读取任务)创建DMA接收引擎, 失败时退回驱动接收
+ */
+static void uart_rx_dma_open(uart_bridge_t *bridge)
+{
+    if (!bridge->rx_dma_active) {
+        return;
+    }
+
+    esp_err_t ret = uart_dma_rx_open(&bridge->rx_dma, bridge->uart_port, xTaskGetCurrentTaskHandle());
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "dma rx unavailable(%s), fall back to driver rx", esp_err_to_name(ret));
+        bridge->rx_dma_active = false;
+        uart_enable_rx_intr(bridge->uart_port);
+    }
+}
+
+/**
+ * @brief DMA接收: 把环形缓冲区的空闲区间交给DMA, 等待传输结束或分包超时
+ * 
+ * @param rx 
+ * @param wait 
+ */
+static void uart_rx_dma_service(uart_bridge_t *bridge, uart_rx_packet_t *rx, TickType_t wait)
+{
+    if (!bridge->rx_dma.armed) {
+        const size_t max_chunk = uart_rx_max_chunk(bridge, rx);
+        uint8_t *span = NULL;
+        size_t span_len = ring_buffer_write_span(&bridge->rx_ring, &span);
+
+        if (bridge->frame_mode && rx->pending < max_chunk && rx->pending > 0 && span_len <= rx->pending) {
+            // 帧跨越回绕
+            uart_rx_packet_wrap(bridge, rx);
+            return;
+        }
+
+        if (rx->pending >= max_chunk || span_len <= rx->pending) {
+            if (rx->pending > 0 || (rx->frame_len > 0 && max_chunk == 0)) {
+                // 达到最大分包长度, 或连续区间已用完(回绕)
+                uart_rx_packet_flush(bridge, rx, UART_RX_FLUSH_SIZE);
+                return;
+            }
+            // 环形缓冲区满, 不再启动传输, 开启流控时由RTS通知对端暂停
+            uart_rx_throttle_begin(bridge, rx);
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RING_FULL_WAIT_MS));
+            return;
+        }
+
+        const size_t room = MIN(span_len, max_chunk) - rx->pending;
+        esp_err_t ret = uart_dma_rx_arm(&bridge->rx_dma, span + rx->pending, room);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "failed to start dma rx: %s", esp_err_to_name(ret));
+            vTaskDelay(pdMS_TO_TICKS(RING_FULL_WAIT_MS));
+            return;
+        }
+        rx->dma_end = rx->pending + room;
+
+        stats_write_begin(bridge, STATS_SHARD_READER)->uart_rx_dma_count++;
+        stats_write_end(bridge, STATS_SHARD_READER);
+    }
+
+    // DMA中断和发送任务释放空间时都会通知
+    ulTaskNotifyTake(pdTRUE, wait);
+
+    // 驱动的接收中断已关闭, 事件队列中只有溢出/校验等错误事件
+    uart_event_t event;
+    while (xQueueReceive(bridge->uart_queue, &event, 0) == pdTRUE) {
+        uart_rx_handle_event(bridge, rx, &event);
+    }
+
+    const size_t before = rx->pending;
+    const bool done = uart_rx_dma_collect(bridge, rx);
+
+    if (rx->dma_split) {
+        rx->dma_split = false;
+        if (rx->pending == before) {
+            // 一个帧间隔内没有新数据, 帧正好在回绕处结束
+            uart_rx_packet_flush(bridge, rx, UART_RX_FLUSH_IDLE);
+            return;
+        }
+    }
+
+    if (done) {
+        if (bridge->frame_mode && rx->pending == rx->dma_end) {
+            // 缓冲区已写满, 下次启动传输时按回绕或最大长度处理
+            rx->dma_split = true;
+            return;
+        }
+        // 线路空闲或缓冲区已写满
+        uart_rx_packet_flush(bridge, rx, rx->pending >= bridge->config.rx.max_chunk ? UART_RX_FLUSH_SIZE : UART_RX_FLUSH_IDLE);
+    }
+}
+
+/**
+ * @brief UART桥接数据读取任务
+ * 
+ * 只负责把串口数据读入环形缓冲区, 不做任何网络操作, 
+ * 避免TCP发送阻塞导致串口驱动缓冲区溢出.
+ * 
+ * 由串口驱动事件驱动, 满足以下任一条件即提交分包:
+ * 1. 空闲间隔达到idle_chars个字符时间(硬件接收超时)
+ * 2. 分包长度达到max_chunk
+ * 3. 分包缓存时间达到max_hold_ms
+ * 分帧模式下只按RTU帧间隔(硬件接收超时)和帧最大长度提交, 跨越回绕的帧分两次提交数据, 只记录一个时间戳.
+ * 
+ * @param pvParameters 
+ */
+static void uart_bridge_task(void *pvParameters)
+{
+    uart_bridge_t *bridge = (uart_bridge_t *)pvParameters;
+    uart_rx_packet_t rx = {0};
+
+    ESP_LOGI(TAG, "uart-bridge task started");
+    bridge->running = true;
+    uart_rx_dma_open(bridge);
+
+    while (bridge->running) {
+        if (bridge->reader_pause) {
+            // 调整缓冲区, 先提交未完成的分包
+            if (bridge->rx_dma_active) {
+                // 缓冲区会被替换, 停止进行中的DMA传输
+                uart_rx_dma_collect(bridge, &rx);
+                uart_dma_rx_close(&bridge->rx_dma);
+            }
+            uart_rx_packet_flush(bridge, &rx, UART_RX_FLUSH_NONE);
+            uart_bridge_park(&bridge->reader_pause, &bridge->reader_parked);
+            if (bridge->rx_dma_active) {
+                uart_rx_dma_open(bridge);
+            }
+            continue;
+        }
+
+        TickType_t hold = pdMS_TO_TICKS(bridge->config.rx.max_hold_ms);
+        TickType_t wait = pdMS_TO_TICKS(100);
+        uart_event_t event;
+
+        if (hold == 0) {
+            hold = 1;
+        }
 
-    // 停止TCP服务器
-    uart_bridge_stop_tcp_server();
+        // 分帧模式下只按帧间隔提交
+        const bool hold_flush = !bridge->frame_mode;
 
-    // 停止任务
-    g_bridge.running = false;
+        if (hold_flush && rx.pending > 0) {
+            TickType_t elapsed = xTaskGetTickCount() - rx.start;
+            wait = (elapsed >= hold) ? 0 : (hold - elapsed);
+        } else if (rx.dma_split) {
+            // 等待一个帧间隔, 判断帧是否已经结束
+            wait = pdMS_TO_TICKS(rtu_gap_ms(bridge->line.baudrate)) + 1;
+        }
 
-    // 删除UART任务
-    if (g_bridge.task_handle) {
-        vTaskDelete(g_bridge.task_handle);
-        g_bridge.task_handle = NULL;
-    }
+        if (bridge->rx_dma_active) {
+            uart_rx_dma_service(bridge, &rx, wait);
+        } else if (xQueueReceive(bridge->uart_queue, &event, wait) == pdTRUE) {
+            uart_rx_handle_event(bridge, &rx, &event);
+        }
 
-    // 删除UART驱动
-    uart_driver_delete(g_bridge.uart_port);
+        if (hold_flush && rx.pending > 0 && (xTaskGetTickCount() - rx.start) >= hold) {
+            uart_rx_packet_flush(bridge, &rx, UART_RX_FLUSH_HOLD);
+        }
+    }
 
-    if (g_bridge.stats_mutex) {
-        vSemaphoreDelete(g_bridge.stats_mutex);
-        g_bridge.stats_mutex = NULL;
+    if (bridge->rx_dma_active) {
+        uart_dma_rx_close(&bridge->rx_dma);
     }
 
-    g_bridge.initialized = false;
-    ESP_LOGI(TAG, "uart-bridge deinitialized");
-    return ESP_OK;
+    ESP_LOGW(TAG, "uart-bridge task stopped");
+    bridge->task_handle = NULL;
+    bridge->running = false;
+    vTaskDelete(NULL);
 }
 
 /**
- * @brief 获取UART桥接模块状态
+ * @brief 没有客户端时把数据存入断网缓存
  * 
- * @param status 
- * @return esp_err_t 
+ * 正在补发时新数据也排在缓存的数据后面, 保证客户端收到的顺序不变.
+ * 
+ * @return true 数据已存入缓存
+ * @return false 没有启用缓存, 或者可以直接发送
  */
-esp_err_t uart_bridge_get_status(uart_bridge_status_t *status)
+static bool outage_store(uart_bridge_t *bridge, const uint8_t *data, size_t len)
 {
-    if (!status) {
-        return ESP_ERR_INVALID_ARG;
+    if (bridge->outage.size == 0 || bridge->config.transport == UART_BRIDGE_TRANSPORT_UDP) {
+        return false;
     }
-    
-    status->tcp_standby = (g_bridge.tcp_server != NULL);
-    status->uart_opened = g_bridge.initialized;
-    status->forwarding = g_bridge.running && (g_bridge.tcp_server != NULL);
-    status->uart_baudrate = g_bridge.config.baudrate;
-    status->tcp_port = g_bridge.config.tcp_port;
-    status->tcp_client_num = (g_bridge.tcp_server != NULL) ? 
-                            tcp_server_get_client_count(g_bridge.tcp_server) : 0;
-    
-    return ESP_OK;
-}
 
-/**
- * @brief 获取统计信息
- * 
- * @param stats 
- * @return esp_err_t 
- */
-esp_err_t uart_bridge_get_stats(uart_bridge_stats_t *stats)
-{
-    if (!stats) {
-        return ESP_ERR_INVALID_ARG;
+    if (outage_buffer_used(&bridge->outage) == 0 && tcp_service_running(bridge) &&
+        tcp_fanout_client_count(&bridge->fanout) > 0) {
+        return false;
     }
 
-    xSemaphoreTake(g_bridge.stats_mutex, portMAX_DELAY);
-    memcpy(stats, &g_bridge.stats, sizeof(uart_bridge_stats_t));
-    xSemaphoreGive(g_bridge.stats_mutex);
+    const uint32_t lost = outage_buffer_write(&bridge->outage, data, len);
 
-    return ESP_OK;
+    uart_bridge_stats_t *stats = stats_write_begin(bridge, STATS_SHARD_SENDER);
+    stats->outage_buffered_bytes += len;
+    stats->outage_lost_bytes += lost;
+    stats_write_end(bridge, STATS_SHARD_SENDER);
+    return true;
 }
 
 /**
- * @brief 重置统计信息
+ * @brief 客户端连接后补发断网缓存中的数据
  * 
- * @return esp_err_t 
+ * 只在所有客户端队列都放得下时挂入, 补发的数据不会被慢客户端策略丢弃,
+ * 速度只受网络限制.
+ * 
+ * @return true 本次补发了数据, 缓存中还有剩余
+ * @return false 补发完成或暂时无法补发
  */
-esp_err_t uart_bridge_reset_stats(void)
+static bool outage_replay(uart_bridge_t *bridge)
 {
-    xSemaphoreTake(g_bridge.stats_mutex, portMAX_DELAY);
-    memset(&g_bridge.stats, 0, sizeof(uart_bridge_stats_t));
-    xSemaphoreGive(g_bridge.stats_mutex);
+    uint32_t replayed = 0;
+    uint32_t drop_bytes = 0;
 
-    ESP_LOGI(TAG, "statistics reset");
-    return ESP_OK;
-}
+    if (outage_buffer_used(&bridge->outage) == 0 || !tcp_service_running(bridge) ||
+        tcp_fanout_client_count(&bridge->fanout) == 0) {
+        return false;
+    }
 
+    while (outage_buffer_used(&bridge->outage) > 0) {
+        const uint8_t *span = NULL;
+        size_t span_len = outage_buffer_read_span(&bridge->outage, &span);
+        span_len = MIN(span_len, UART_BRIDGE_SEND_CHUNK_SIZE);
 
-/**
- * @brief 设置UART波特率
- * 
- * @param baudrate 
- * @return esp_err_t 
- */
-esp_err_t uart_bridge_set_baudrate(uint32_t baudrate)
-{
-    if (!g_bridge.initialized) {
-        return ESP_ERR_INVALID_STATE;
+        if (!tcp_fanout_can_accept(&bridge->fanout, span_len) ||
+            tcp_fanout_broadcast(&bridge->fanout, span, span_len, &drop_bytes) == 0) {
+            break;
+        }
+        outage_buffer_consume(&bridge->outage, span_len);
+        replayed += span_len;
     }
 
-    esp_err_t ret = uart_set_baudrate(g_bridge.uart_port, baudrate);
-    if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "set baudrate(%d) success", baudrate);
-        if (g_bridge.config.baudrate != baudrate) {
-            g_bridge.config.baudrate = baudrate;
-            // 保存配置到NVS
-            uart_bridge_save_config(&g_bridge.config);
-        }        
-    } else {
-        ESP_LOGE(TAG, "failed to set baudrate(%d): %s", baudrate, esp_err_to_name(ret));
+    if (replayed == 0) {
+        return false;
     }
 
-    return ret;
+    uart_bridge_stats_t *stats = stats_write_begin(bridge, STATS_SHARD_SENDER);
+    stats->outage_replayed_bytes += replayed;
+    stats_write_end(bridge, STATS_SHARD_SENDER);
+
+    if (outage_buffer_used(&bridge->outage) == 0) {
+        ESP_LOGI(TAG, "bridge(%d) outage buffer replayed", bridge->index);
+    }
+    return outage_buffer_used(&bridge->outage) > 0;
 }
 
 /**
- * @brief 启动TCP服务器
+ * @brief (发送任务)公平仲裁方式下, 轮询把客户端队列中的数据写入串口
  * 
- * @return esp_err_t 
+ * 串口发送缓冲区中只保持约两个重试周期能发完的数据, 新到的命令不会排在
+ * 大量已写入驱动的数据之后. 写入不超过缓冲区的空闲空间, 不会阻塞发送任务.
+ * 
+ * @return uint32_t 还有数据排队时, 下一次写入前等待的毫秒数
  */
-esp_err_t uart_bridge_start_tcp_server(void)
+static uint32_t inbound_service(uart_bridge_t *bridge)
 {
-    if (!g_bridge.initialized || !g_bridge.running) {
-        return ESP_ERR_INVALID_STATE;
-    }
+    size_t free_size = 0;
 
-    if (g_bridge.tcp_server) {
-        ESP_LOGW(TAG, "tcp server already running");
-        return ESP_OK;
+    if (!tcp_inbound_pending(&bridge->inbound) ||
+        uart_get_tx_buffer_free_size(bridge->uart_port, &free_size) != ESP_OK) {
+        return UINT32_MAX;
     }
 
-    // 配置TCP服务器
-    tcp_server_config_t tcp_config = {
-        .port = g_bridge.config.tcp_port,
-        .max_clients = UART_BRIDGE_MAX_CLIENTS,
-        .recv_callback = on_tcp_data_received,
-        .connect_callback = on_tcp_client_connected,
-        .disconnect_callback = on_tcp_client_disconnected,
-        .user_ctx = NULL,
-        .stack_size = 4096,
-        .task_priority = 5,
-        .verbose = false
-    };
+    // 8N1, 每个字节10位
+    const uint32_t bytes_per_ms = (bridge->line.baudrate / 10000) ? (bridge->line.baudrate / 10000) : 1;
+    const size_t tx_size = bridge->buffers.uart_tx_size;
+    size_t high_water = bytes_per_ms * SENDER_RETRY_MS * 2;
+    high_water = MIN(high_water < 2 * TCP_INBOUND_QUANTUM ? 2 * TCP_INBOUND_QUANTUM : high_water, tx_size);
+    size_t used = tx_size - MIN(free_size, tx_size);
+    uint32_t written_bytes = 0;
+    uint32_t error_bytes = 0;
+    tcp_inbound_span_t span;
 
-    // 创建TCP服务器
-    esp_err_t err;
-    g_bridge.tcp_server = tcp_server_create(&tcp_config, &err);
-    if (!g_bridge.tcp_server || err != ESP_OK) {
-        ESP_LOGE(TAG, "failed to create tcp server: %s", esp_err_to_name(err));
-        return err;
+    while (used < high_water && tcp_inbound_next(&bridge->inbound, high_water - used, &span)) {
+        traffic_capture_record(bridge->index, TRAFFIC_DIR_UART_TX, span.data, span.len);
+
+        const int written = uart_write_bytes(bridge->uart_port, span.data, span.len);
+        const int64_t now_us = esp_timer_get_time();
+        // 写入失败的数据丢弃, 不会反复重试同一段数据
+        tcp_inbound_consume(&bridge->inbound, &span, span.len, now_us,
+                            &bridge->latency[UART_BRIDGE_LATENCY_UART_TX]);
+        if (written < 0) {
+            error_bytes += span.len;
+            break;
+        }
+
+        written_bytes += written;
+        error_bytes += span.len - written;
+        used += written;
+        rate_meter_add(&bridge->uart_tx_rate, written, now_us);
     }
 
-    // 启动TCP服务器
-    err = tcp_server_start(g_bridge.tcp_server);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "failed to start tcp server: %s", esp_err_to_name(err));
-        tcp_server_destroy(g_bridge.tcp_server);
-        g_bridge.tcp_server = NULL;
-        return err;
+    if (written_bytes > 0 || error_bytes > 0) {
+        uart_bridge_stats_t *stats = stats_write_begin(bridge, STATS_SHARD_SENDER);
+        stats->uart_tx_bytes += written_bytes;
+        stats->uart_tx_error_bytes += error_bytes;
+        stats_write_end(bridge, STATS_SHARD_SENDER);
     }
 
-    ESP_LOGI(TAG, "tcp server started on port(%d)", g_bridge.config.tcp_port);
-    return ESP_OK;
+    if (!tcp_inbound_pending(&bridge->inbound)) {
+        return UINT32_MAX;
+    }
+    // 缓冲区中的数据发出约一半时再写入
+    return clamp_u32(used / bytes_per_ms / 2, 1, SENDER_RETRY_MS);
 }
 
-esp_err_t uart_bridge_stop_tcp_server(void)
+/**
+ * @brief TCP发送任务
+ * 
+ * 从环形缓冲区取出连续数据块, 广播到所有TCP客户端.
+ * 分帧模式下每次取出一个完整的帧; Modbus网关方式下把帧交给网关, 并负责把排队的请求发到总线.
+ * 
+ * @param pvParameters 
+ */
+static void uart_bridge_sender_task(void *pvParameters)
 {
-    if (!g_bridge.tcp_server) {
-        return ESP_OK;
-    }
+    uart_bridge_t *bridge = (uart_bridge_t *)pvParameters;
+    bool pending = false;
 
-    // 停止并销毁TCP服务器
-    tcp_server_stop(g_bridge.tcp_server);
-    tcp_server_destroy(g_bridge.tcp_server);
-    g_bridge.tcp_server = NULL;
+    ESP_LOGI(TAG, "sender task started");
+    bridge->sender_running = true;
 
-    ESP_LOGI(TAG, "tcp server stopped");
-    return ESP_OK;
-}
+    while (bridge->sender_running) {
+        uint32_t sent_bytes = 0;
+        uint32_t drop_bytes = 0;
+        const uint8_t *span = NULL;
+        size_t span_len = ring_buffer_read_span(&bridge->rx_ring, &span);
 
+        if (bridge->sender_pause && span_len == 0) {
+            // 调整缓冲区, 环形缓冲区中的数据已经取完
+            uart_bridge_park(&bridge->sender_pause, &bridge->sender_parked);
+            continue;
+        }
 
-bool uart_bridge_set_tcp_verbose(bool tx_verbose, bool rx_verbose)
-{
-    if (g_bridge.tcp_server) {
-        tcp_server_set_verbose(g_bridge.tcp_server, tx_verbose, rx_verbose);
-        return true;
-    }
+        uint32_t packet_end = 0;
+        int64_t arrival_us = 0;
+        const bool udp = udp_transport_is_running(&bridge->udp);
 
-    return false;
-}
+        if (span_len > 0) {
+            arrival_us = uart_rx_mark_find(bridge, bridge->rx_consume_pos, &packet_end);
+        }
 
-bool uart_bridge_set_uart_verbose(bool tx_verbose, bool rx_verbose)
-{
-    g_bridge.uart_tx_verbose = tx_verbose;
-    g_bridge.uart_rx_verbose = rx_verbose;
-    return true;
-}
+        if (span_len > 0 && bridge->frame_mode) {
+            // 只取出完整的帧, 跨越回绕的帧复制到frame_buf
+            const uint32_t frame_len = packet_end - bridge->rx_consume_pos;
+            if (frame_len == 0) {
+                // 帧还没有结束, 读取任务提交帧时会通知
+                span_len = 0;
+            } else if (span_len < frame_len) {
+                span_len = MIN(frame_len, sizeof(bridge->frame_buf));
+                ring_buffer_peek(&bridge->rx_ring, 0, bridge->frame_buf, span_len);
+                span = bridge->frame_buf;
+            } else {
+                span_len = MIN(frame_len, sizeof(bridge->frame_buf));
+            }
+        } else if (span_len > 0) {
+            if (udp) {
+                // 一个分包一个数据报, 过长的分包拆成多个数据报
+                const uint32_t packet_len = packet_end - bridge->rx_consume_pos;
+                if (packet_len > 0) {
+                    span_len = MIN(span_len, packet_len);
+                }
+                span_len = MIN(span_len, UDP_TRANSPORT_MAX_PAYLOAD);
+            } else {
+                span_len = MIN(span_len, UART_BRIDGE_SEND_CHUNK_SIZE);
+            }
+        }
 
+        if (span_len > 0) {
+            traffic_capture_record(bridge->index, TRAFFIC_DIR_UART_RX, span, span_len);
 
-static void on_tcp_data_received(tcp_client_t *client, const uint8_t *data, size_t len, void *user_ctx)
-{
-    if (!data || len == 0) {
-        return;
-    }
+            bool delivered = false;
+            if (udp) {
+                delivered = (udp_transport_send(&bridge->udp, span, span_len) == ESP_OK);
 
-    ESP_LOGD(TAG, "received %d bytes from client(%s:%d)", 
-             len, ipaddr_ntoa(&client->ip_addr), client->port);
+                uart_bridge_stats_t *stats = stats_write_begin(bridge, STATS_SHARD_SENDER);
+                if (delivered) {
+                    stats->udp_tx_datagrams++;
+                    stats->udp_tx_bytes += span_len;
+                } else {
+                    stats->udp_tx_drop_count++;
+                }
+                stats_write_end(bridge, STATS_SHARD_SENDER);
+            } else if (bridge->config.transport == UART_BRIDGE_TRANSPORT_MODBUS) {
+                // 回复只发给发起请求的客户端
+                modbus_rtu_received(bridge, span, span_len);
+                delivered = true;
+            } else if (outage_store(bridge, span, span_len)) {
+                // 没有客户端, 连接后补发
+            } else if (tcp_service_running(bridge)) {
+                // 挂到所有客户端的发送队列, 没有客户端时直接丢弃
+                delivered = (tcp_fanout_broadcast(&bridge->fanout, span, span_len, &drop_bytes) > 0);
+            }
 
-    // 发送数据到UART
-    send_data_to_uart(data, len);
+            if (delivered && arrival_us > 0) {
+                latency_hist_record(&bridge->latency[UART_BRIDGE_LATENCY_UART_RX],
+                                    (uint32_t)(esp_timer_get_time() - arrival_us));
+            }
 
-    // 更新统计信息
-    xSemaphoreTake(g_bridge.stats_mutex, portMAX_DELAY);
-    g_bridge.stats.tcp_rx_bytes += len;
-    xSemaphoreGive(g_bridge.stats_mutex);    
-}
+            // 释放空间, 并通知可能在等待空间的读取任务
+            ring_buffer_consume(&bridge->rx_ring, span_len);
+            bridge->rx_consume_pos += span_len;
+            if (bridge->task_handle) {
+                xTaskNotifyGive(bridge->task_handle);
+            }
+        }
 
-static void on_tcp_client_connected(tcp_client_t *client, void *user_ctx)
-{
-    ESP_LOGI(TAG, "tcp client(%s:%d) connected", 
-             ipaddr_ntoa(&client->ip_addr), client->port);
+        if (atomic_load_explicit(&bridge->line_events, memory_order_relaxed) != 0) {
+            rfc2217_notify_line_events(bridge);
+        }
 
-    xSemaphoreTake(g_bridge.stats_mutex, portMAX_DELAY);
-    g_bridge.stats.tcp_connect_count++;
-    xSemaphoreGive(g_bridge.stats_mutex);
-}
+        // 断网缓存的数据先于新数据进入客户端队列
+        const bool replaying = outage_replay(bridge);
 
-static void on_tcp_client_disconnected(tcp_client_t *client, void *user_ctx)
-{
-    ESP_LOGI(TAG, "tcp client(%s:%d) disconnected", 
-             ipaddr_ntoa(&client->ip_addr), client->port);
+        // 非阻塞发送, 慢客户端不会阻塞其它客户端
+        pending = tcp_fanout_service(&bridge->fanout, &sent_bytes, &drop_bytes,
+                                     &bridge->latency[UART_BRIDGE_LATENCY_TCP_TX]);
+
+        if (sent_bytes > 0 || drop_bytes > 0) {
+            uart_bridge_stats_t *stats = stats_write_begin(bridge, STATS_SHARD_SENDER);
+            stats->tcp_tx_bytes += sent_bytes;
+            stats->tcp_tx_error_bytes += drop_bytes;
+            stats_write_end(bridge, STATS_SHARD_SENDER);
+        }
+
+        // 回复超时后发出下一个请求
+        uint32_t wait_ms = pending ? SENDER_RETRY_MS : 100;
+        if (bridge->config.transport == UART_BRIDGE_TRANSPORT_MODBUS) {
+            wait_ms = MIN(wait_ms, modbus_poll(bridge));
+        }
+
+        // 客户端队列中的数据轮询写入串口
+        wait_ms = MIN(wait_ms, inbound_service(bridge));
+
+        if (span_len == 0 && !replaying) {
+            // 没有新数据, 等待读取任务通知; 还有排队数据时, 定期重试发送
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait_ms));
+        }
+    }
 
-    xSemaphoreTake(g_bridge.stats_mutex, portMAX_DELAY);
-    g_bridge.stats.tcp_disconnect_count++;
-    xSemaphoreGive(g_bridge.stats_mutex);
+    ESP_LOGW(TAG, "sender task stopped");
+    bridge->sender_handle = NULL;
+    bridge->sender_running = false;
+    vTaskDelete(NULL);
 }
 
 /**
- * @brief UART桥接数据转发任务
+ * @brief 不丢弃数据地写入串口
  * 
- * @param pvParameters 
+ * 在tcp_server的接收回调(Modbus网关方式下为发送任务)中调用, 串口发送缓冲区满时阻塞等待.
+ * 阻塞期间tcp_server不再读取socket, 客户端的TCP接收窗口会逐渐关闭,
+ * 从而端到端地限制发送方的速度.
+ * 
+ * @param shard 调用者所在任务的统计分片
+ * @param data 
+ * @param len 
+ * @return esp_err_t 
  */
-static void uart_bridge_task(void *pvParameters)
+static esp_err_t send_data_to_uart_no_drop(uart_bridge_t *bridge, stats_shard_id_t shard, const uint8_t *data, size_t len)
 {
-    esp_err_t err = ESP_OK;
-
-    ESP_LOGI(TAG, "uart-bridge task started");
-    g_bridge.running = true;
+    size_t available_space = 0;
+    TickType_t wait_start = 0;
+    bool waiting = (uart_get_tx_buffer_free_size(bridge->uart_port, &available_space) == ESP_OK) &&
+                   (available_space < len);
 
-    uint8_t* rx_buf = (uint8_t*) malloc(UART_BRIDGE_BUFFER_SIZE);
-    if (!rx_buf) {
-        ESP_LOGE(TAG, "failed to allocate rx buffer, uart-bridge task exit");
-        g_bridge.running = false;
-        vTaskDelete(NULL);
-        return;
+    if (waiting) {
+        wait_start = xTaskGetTickCount();
     }
 
-    while (g_bridge.running) {
-        const int rx_bytes = uart_read_bytes(g_bridge.uart_port, rx_buf, UART_BRIDGE_BUFFER_SIZE, 100 / portTICK_PERIOD_MS);
-        if (rx_bytes > 0) {
+    traffic_capture_record(bridge->index, TRAFFIC_DIR_UART_TX, data, len);
 
-            if (g_bridge.uart_rx_verbose) {
-                char prefix[32];
-                sprintf(prefix, "rx from uart[len=%d]:", rx_bytes);
-                hex_dump(rx_buf, rx_bytes, prefix);
-            }
+    // 缓冲区空间不足时, uart_write_bytes会一直等到全部数据写入
+    int bytes_written = uart_write_bytes(bridge->uart_port, data, len);
 
-            // 如果TCP服务器已就绪,则广播数据到所有TCP客户端
-            if (g_bridge.tcp_server && tcp_server_get_client_count(g_bridge.tcp_server) > 0) {
-                // TCP服务有效, 转发到所有TCP客户端
-                err = tcp_server_broadcast(g_bridge.tcp_server, rx_buf, rx_bytes);
-                xSemaphoreTake(g_bridge.stats_mutex, portMAX_DELAY);
-                g_bridge.stats.uart_rx_bytes += rx_bytes;
-                if (err == ESP_OK) {
-                    g_bridge.stats.tcp_tx_bytes += rx_bytes;// 以客户端收到的数据长度为视角 
-                } else {
-                    g_bridge.stats.tcp_tx_error_bytes += rx_bytes;
-                }
-                xSemaphoreGive(g_bridge.stats_mutex);
-            } else {
-                // TCP服务无效, 仅更新UART 接收数据
-                xSemaphoreTake(g_bridge.stats_mutex, portMAX_DELAY);
-                g_bridge.stats.uart_rx_bytes += rx_bytes;
-                xSemaphoreGive(g_bridge.stats_mutex);
-            }
-        } else if (rx_bytes < 0) {
-            // 读取数据失败, 需要等待一段时间 
-            ESP_LOGE(TAG, "uart read data failed:%d, wait 100ms", rx_bytes);
-            vTaskDelay(100 / portTICK_PERIOD_MS);
-        }
+    uart_bridge_stats_t *stats = stats_write_begin(bridge, shard);
+    if (waiting) {
+        stats->uart_tx_wait_count++;
+        stats->uart_tx_wait_ms += pdTICKS_TO_MS(xTaskGetTickCount() - wait_start);
     }
-    free(rx_buf);
+    if (bytes_written < 0) {
+        stats->uart_tx_error_bytes += len;
+    } else {
+        stats->uart_tx_bytes += bytes_written;
+        stats->uart_tx_error_bytes += (len - bytes_written);
+    }
+    stats_write_end(bridge, shard);
 
-    ESP_LOGW(TAG, "uart-bridge task stopped");
-    g_bridge.task_handle = NULL;
-    g_bridge.running = false;
-    vTaskDelete(NULL);
+    if (bytes_written < 0) {
+        ESP_LOGE(TAG, "uart send data failed");
+        return ESP_FAIL;
+    } else if (bytes_written != len) {
+        ESP_LOGW(TAG, "uart send data incomplete: expected(%d), actual(%d)", len, bytes_written);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    return ESP_OK;
 }
 
-static esp_err_t send_data_to_uart(const uint8_t *data, size_t len)
+static esp_err_t send_data_to_uart(uart_bridge_t *bridge, stats_shard_id_t shard, const uint8_t *data, size_t len)
 {
     if (!data || len == 0) {
         return ESP_ERR_INVALID_ARG;
     }
 
+    if (bridge->config.uart_tx_policy == UART_BRIDGE_UART_TX_NO_DROP) {
+        return send_data_to_uart_no_drop(bridge, shard, data, len);
+    }
+
     // 检查缓冲区是否有足够空间
     size_t available_space = 0;
-    esp_err_t ret = uart_get_tx_buffer_free_size(g_bridge.uart_port, &available_space);
+    esp_err_t ret = uart_get_tx_buffer_free_size(bridge->uart_port, &available_space);
     if (ret != ESP_OK) {
         // unexpected error, should not happen
-        xSemaphoreTake(g_bridge.stats_mutex, portMAX_DELAY);
-        g_bridge.stats.uart_tx_drop_bytes += len;
-        xSemaphoreGive(g_bridge.stats_mutex);        
+        uart_bridge_stats_t *stats = stats_write_begin(bridge, shard);
+        stats->uart_tx_drop_bytes += len;
+        stats_write_end(bridge, shard);        
         return ret;
     }
 
@@ -504,9 +3926,9 @@ static esp_err_t send_data_to_uart(const uint8_t *data, size_t len)
 
     if (drop_len > 0) {
         ESP_LOGW(TAG, "uart tx buffer overflow, discarding %d bytes", drop_len);
-        xSemaphoreTake(g_bridge.stats_mutex, portMAX_DELAY);
-        g_bridge.stats.uart_tx_drop_bytes += drop_len;
-        xSemaphoreGive(g_bridge.stats_mutex);
+        uart_bridge_stats_t *stats = stats_write_begin(bridge, shard);
+        stats->uart_tx_drop_bytes += drop_len;
+        stats_write_end(bridge, shard);
     }
 
     if (nice_len <= 0) {
@@ -514,56 +3936,70 @@ static esp_err_t send_data_to_uart(const uint8_t *data, size_t len)
         return ESP_ERR_NO_MEM;
     }
 
-    if (g_bridge.uart_tx_verbose) {
-        char prefix[32];
-        sprintf(prefix, "tx to uart[len=%d]:", nice_len);
-        hex_dump(data, nice_len, prefix);
-    }
+    traffic_capture_record(bridge->index, TRAFFIC_DIR_UART_TX, data, nice_len);
 
-    int bytes_written = uart_write_bytes(g_bridge.uart_port, data, nice_len);
+    int bytes_written = uart_write_bytes(bridge->uart_port, data, nice_len);
     if (bytes_written < 0) {
         ESP_LOGE(TAG, "uart send data failed");
-        xSemaphoreTake(g_bridge.stats_mutex, portMAX_DELAY);
-        g_bridge.stats.uart_tx_error_bytes += nice_len;
-        xSemaphoreGive(g_bridge.stats_mutex);
+        uart_bridge_stats_t *stats = stats_write_begin(bridge, shard);
+        stats->uart_tx_error_bytes += nice_len;
+        stats_write_end(bridge, shard);
         return ESP_FAIL;
     } else if (bytes_written != nice_len) {
         ESP_LOGW(TAG, "uart send data incomplete: expected(%d), actual(%d)", nice_len, bytes_written);
-        xSemaphoreTake(g_bridge.stats_mutex, portMAX_DELAY);
-        g_bridge.stats.uart_tx_bytes += bytes_written;
-        g_bridge.stats.uart_tx_error_bytes += (nice_len - bytes_written);
-        xSemaphoreGive(g_bridge.stats_mutex);
+        uart_bridge_stats_t *stats = stats_write_begin(bridge, shard);
+        stats->uart_tx_bytes += bytes_written;
+        stats->uart_tx_error_bytes += (nice_len - bytes_written);
+        stats_write_end(bridge, shard);
         return ESP_ERR_INVALID_SIZE;
     }
 
     // 到这里,表示所有数据完成写入
-    xSemaphoreTake(g_bridge.stats_mutex, portMAX_DELAY);
-    g_bridge.stats.uart_tx_bytes += bytes_written;
-    xSemaphoreGive(g_bridge.stats_mutex);
+    uart_bridge_stats_t *stats = stats_write_begin(bridge, shard);
+    stats->uart_tx_bytes += bytes_written;
+    stats_write_end(bridge, shard);
 
     return ESP_OK;
 }
 
-static esp_err_t uart_bridge_load_config(uart_bridge_config_t *config)
+static esp_err_t uart_bridge_load_config(uart_bridge_t *bridge)
 {
-    if (!config) {
-        return ESP_ERR_INVALID_ARG;
-    }
+    uart_bridge_config_t *config = &bridge->config;
 
     nvs_handle_t nvs_handle;
-    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
+    esp_err_t err = nvs_open(bridge->nvs_namespace, NVS_READONLY, &nvs_handle);
     if (err != ESP_OK) {
         ESP_LOGW(TAG, "failed to open nvs namespace(%s), using default config", esp_err_to_name(err));
         // 使用默认配置
-        config->tcp_port = UART_BRIDGE_DEFAULT_PORT;
+        config->tcp_port = UART_BRIDGE_DEFAULT_PORT + bridge->index;
         config->baudrate = UART_BRIDGE_DEFAULT_BAUDRATE;
+        config->slow_client_policy = UART_BRIDGE_SLOW_CLIENT_DROP_OLDEST;
+        config->stall_timeout_ms = UART_BRIDGE_DEFAULT_STALL_MS;
+        config->rx = s_default_rx_config;
+        config->uart_tx_policy = UART_BRIDGE_UART_TX_DROP;
+        memset(&config->buffer_override, 0, sizeof(config->buffer_override));
+        config->flow_ctrl = UART_BRIDGE_FLOW_CTRL_NONE;
+        config->rts_thresh = UART_BRIDGE_DEFAULT_RTS_THRESH;
+        config->transport = UART_BRIDGE_TRANSPORT_TCP;
+        memset(&config->udp, 0, sizeof(config->udp));
+        config->data_bits = UART_DATA_8_BITS;
+        config->parity = UART_PARITY_DISABLE;
+        config->stop_bits = UART_STOP_BITS_1;
+        config->rfc2217_persist = 0;
+        config->rx_engine = UART_BRIDGE_RX_ENGINE_DRIVER;
+        config->outage_buf_size = 0;
+        config->sock = s_default_sock_opts;
+        config->tcp_engine = UART_BRIDGE_TCP_ENGINE_SOCKET;
+        config->rtu_framing = 0;
+        config->modbus = s_default_modbus_config;
+        config->tx_arbiter = UART_BRIDGE_TX_ARBITER_DIRECT;
         return ESP_OK;
     }
 
     size_t required_size = sizeof(uint16_t);
     err = nvs_get_blob(nvs_handle, NVS_KEY_TCP_PORT, &config->tcp_port, &required_size);
     if (err != ESP_OK) {
-        config->tcp_port = UART_BRIDGE_DEFAULT_PORT;
+        config->tcp_port = UART_BRIDGE_DEFAULT_PORT + bridge->index;
     }
 
     required_size = sizeof(uint32_t);
@@ -572,19 +4008,137 @@ static esp_err_t uart_bridge_load_config(uart_bridge_config_t *config)
         config->baudrate = UART_BRIDGE_DEFAULT_BAUDRATE;
     }
 
+    required_size = sizeof(uint8_t);
+    err = nvs_get_blob(nvs_handle, NVS_KEY_SLOW_POLICY, &config->slow_client_policy, &required_size);
+    if (err != ESP_OK || config->slow_client_policy >= UART_BRIDGE_SLOW_CLIENT_MAX) {
+        config->slow_client_policy = UART_BRIDGE_SLOW_CLIENT_DROP_OLDEST;
+    }
+
+    required_size = sizeof(uint32_t);
+    err = nvs_get_blob(nvs_handle, NVS_KEY_STALL_MS, &config->stall_timeout_ms, &required_size);
+    if (err != ESP_OK || config->stall_timeout_ms == 0) {
+        config->stall_timeout_ms = UART_BRIDGE_DEFAULT_STALL_MS;
+    }
+
+    required_size = sizeof(uart_bridge_rx_config_t);
+    err = nvs_get_blob(nvs_handle, NVS_KEY_RX_CONFIG, &config->rx, &required_size);
+    if (err != ESP_OK || !rx_config_is_valid(&config->rx)) {
+        config->rx = s_default_rx_config;
+    }
+
+    required_size = sizeof(uint8_t);
+    err = nvs_get_blob(nvs_handle, NVS_KEY_UART_TX_POLICY, &config->uart_tx_policy, &required_size);
+    if (err != ESP_OK || config->uart_tx_policy >= UART_BRIDGE_UART_TX_MAX) {
+        config->uart_tx_policy = UART_BRIDGE_UART_TX_DROP;
+    }
+
+    required_size = sizeof(uart_bridge_buffer_sizes_t);
+    err = nvs_get_blob(nvs_handle, NVS_KEY_BUF_OVERRIDE, &config->buffer_override, &required_size);
+    if (err != ESP_OK || !buffer_override_is_valid(&config->buffer_override)) {
+        memset(&config->buffer_override, 0, sizeof(config->buffer_override));
+    }
+
+    // 流控模式和RTS阈值保存在一起
+    uint8_t flow_ctrl[2] = {0};
+    required_size = sizeof(flow_ctrl);
+    err = nvs_get_blob(nvs_handle, NVS_KEY_FLOW_CTRL, flow_ctrl, &required_size);
+    if (err != ESP_OK || flow_ctrl[0] >= UART_BRIDGE_FLOW_CTRL_MAX || flow_ctrl[1] == 0 || flow_ctrl[1] >= SOC_UART_FIFO_LEN) {
+        config->flow_ctrl = UART_BRIDGE_FLOW_CTRL_NONE;
+        config->rts_thresh = UART_BRIDGE_DEFAULT_RTS_THRESH;
+    } else {
+        config->flow_ctrl = flow_ctrl[0];
+        config->rts_thresh = flow_ctrl[1];
+    }
+
+    required_size = sizeof(uint8_t);
+    err = nvs_get_blob(nvs_handle, NVS_KEY_TRANSPORT, &config->transport, &required_size);
+    if (err != ESP_OK || config->transport >= UART_BRIDGE_TRANSPORT_MAX) {
+        config->transport = UART_BRIDGE_TRANSPORT_TCP;
+    }
+
+    required_size = sizeof(uart_bridge_udp_config_t);
+    err = nvs_get_blob(nvs_handle, NVS_KEY_UDP_CONFIG, &config->udp, &required_size);
+    if (err != ESP_OK || !udp_config_is_valid(&config->udp)) {
+        memset(&config->udp, 0, sizeof(config->udp));
+    }
+
+    // 数据位/校验/停止位保存在一起
+    uint8_t line_format[3] = {0};
+    required_size = sizeof(line_format);
+    err = nvs_get_blob(nvs_handle, NVS_KEY_LINE_FORMAT, line_format, &required_size);
+    if (err != ESP_OK || line_format[0] > UART_DATA_8_BITS ||
+        (line_format[1] != UART_PARITY_DISABLE && line_format[1] != UART_PARITY_EVEN && line_format[1] != UART_PARITY_ODD) ||
+        line_format[2] < UART_STOP_BITS_1 || line_format[2] > UART_STOP_BITS_2) {
+        config->data_bits = UART_DATA_8_BITS;
+        config->parity = UART_PARITY_DISABLE;
+        config->stop_bits = UART_STOP_BITS_1;
+    } else {
+        config->data_bits = line_format[0];
+        config->parity = line_format[1];
+        config->stop_bits = line_format[2];
+    }
+
+    required_size = sizeof(uint8_t);
+    err = nvs_get_blob(nvs_handle, NVS_KEY_RFC2217_SAVE, &config->rfc2217_persist, &required_size);
+    if (err != ESP_OK || config->rfc2217_persist > 1) {
+        config->rfc2217_persist = 0;
+    }
+
+    required_size = sizeof(uint8_t);
+    err = nvs_get_blob(nvs_handle, NVS_KEY_RX_ENGINE, &config->rx_engine, &required_size);
+    if (err != ESP_OK || config->rx_engine >= UART_BRIDGE_RX_ENGINE_MAX) {
+        config->rx_engine = UART_BRIDGE_RX_ENGINE_DRIVER;
+    }
+
+    required_size = sizeof(uint32_t);
+    err = nvs_get_blob(nvs_handle, NVS_KEY_OUTAGE_BUF, &config->outage_buf_size, &required_size);
+    if (err != ESP_OK || (config->outage_buf_size != 0 &&
+        (config->outage_buf_size < UART_BRIDGE_OUTAGE_BUF_MIN || config->outage_buf_size > UART_BRIDGE_OUTAGE_BUF_MAX))) {
+        config->outage_buf_size = 0;
+    }
+
+    required_size = sizeof(uart_bridge_sock_opts_t);
+    err = nvs_get_blob(nvs_handle, NVS_KEY_SOCK_OPTS, &config->sock, &required_size);
+    if (err != ESP_OK || !sock_opts_is_valid(&config->sock)) {
+        config->sock = s_default_sock_opts;
+    }
+
+    required_size = sizeof(uint8_t);
+    err = nvs_get_blob(nvs_handle, NVS_KEY_TCP_ENGINE, &config->tcp_engine, &required_size);
+    if (err != ESP_OK || config->tcp_engine >= UART_BRIDGE_TCP_ENGINE_MAX ||
+        (config->tcp_engine == UART_BRIDGE_TCP_ENGINE_RAW && !raw_tcp_server_supported())) {
+        config->tcp_engine = UART_BRIDGE_TCP_ENGINE_SOCKET;
+    }
+
+    required_size = sizeof(uint8_t);
+    err = nvs_get_blob(nvs_handle, NVS_KEY_RTU_FRAMING, &config->rtu_framing, &required_size);
+    if (err != ESP_OK || config->rtu_framing > 1) {
+        config->rtu_framing = 0;
+    }
+
+    required_size = sizeof(uart_bridge_modbus_config_t);
+    err = nvs_get_blob(nvs_handle, NVS_KEY_MODBUS, &config->modbus, &required_size);
+    if (err != ESP_OK || !modbus_config_is_valid(&config->modbus)) {
+        config->modbus = s_default_modbus_config;
+    }
+
+    required_size = sizeof(uint8_t);
+    err = nvs_get_blob(nvs_handle, NVS_KEY_TX_ARBITER, &config->tx_arbiter, &required_size);
+    if (err != ESP_OK || config->tx_arbiter >= UART_BRIDGE_TX_ARBITER_MAX) {
+        config->tx_arbiter = UART_BRIDGE_TX_ARBITER_DIRECT;
+    }
+
     nvs_close(nvs_handle);
-    ESP_LOGI(TAG, "config loaded: tcp-port(%d), baudrate(%lu)", config->tcp_port, config->baudrate);
+    ESP_LOGI(TAG, "bridge(%d) config loaded: tcp-port(%d), baudrate(%lu)", bridge->index, config->tcp_port, config->baudrate);
     return ESP_OK;
 }
 
-static esp_err_t uart_bridge_save_config(const uart_bridge_config_t *config)
+static esp_err_t uart_bridge_save_config(const uart_bridge_t *bridge)
 {
-    if (!config) {
-        return ESP_ERR_INVALID_ARG;
-    }
+    const uart_bridge_config_t *config = &bridge->config;
 
     nvs_handle_t nvs_handle;
-    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    esp_err_t err = nvs_open(bridge->nvs_namespace, NVS_READWRITE, &nvs_handle);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "failed to open nvs namespace(%s)", esp_err_to_name(err));
         return err;
@@ -596,12 +4150,65 @@ static esp_err_t uart_bridge_save_config(const uart_bridge_config_t *config)
     err = nvs_set_blob(nvs_handle, NVS_KEY_UART_BAUDRATE, &config->baudrate, sizeof(config->baudrate));
     if (err != ESP_OK) goto cleanup;
 
+    err = nvs_set_blob(nvs_handle, NVS_KEY_SLOW_POLICY, &config->slow_client_policy, sizeof(config->slow_client_policy));
+    if (err != ESP_OK) goto cleanup;
+
+    err = nvs_set_blob(nvs_handle, NVS_KEY_STALL_MS, &config->stall_timeout_ms, sizeof(config->stall_timeout_ms));
+    if (err != ESP_OK) goto cleanup;
+
+    err = nvs_set_blob(nvs_handle, NVS_KEY_RX_CONFIG, &config->rx, sizeof(config->rx));
+    if (err != ESP_OK) goto cleanup;
+
+    err = nvs_set_blob(nvs_handle, NVS_KEY_UART_TX_POLICY, &config->uart_tx_policy, sizeof(config->uart_tx_policy));
+    if (err != ESP_OK) goto cleanup;
+
+    err = nvs_set_blob(nvs_handle, NVS_KEY_BUF_OVERRIDE, &config->buffer_override, sizeof(config->buffer_override));
+    if (err != ESP_OK) goto cleanup;
+
+    const uint8_t flow_ctrl[2] = { config->flow_ctrl, config->rts_thresh };
+    err = nvs_set_blob(nvs_handle, NVS_KEY_FLOW_CTRL, flow_ctrl, sizeof(flow_ctrl));
+    if (err != ESP_OK) goto cleanup;
+
+    err = nvs_set_blob(nvs_handle, NVS_KEY_TRANSPORT, &config->transport, sizeof(config->transport));
+    if (err != ESP_OK) goto cleanup;
+
+    err = nvs_set_blob(nvs_handle, NVS_KEY_UDP_CONFIG, &config->udp, sizeof(config->udp));
+    if (err != ESP_OK) goto cleanup;
+
+    const uint8_t line_format[3] = { config->data_bits, config->parity, config->stop_bits };
+    err = nvs_set_blob(nvs_handle, NVS_KEY_LINE_FORMAT, line_format, sizeof(line_format));
+    if (err != ESP_OK) goto cleanup;
+
+    err = nvs_set_blob(nvs_handle, NVS_KEY_RFC2217_SAVE, &config->rfc2217_persist, sizeof(config->rfc2217_persist));
+    if (err != ESP_OK) goto cleanup;
+
+    err = nvs_set_blob(nvs_handle, NVS_KEY_RX_ENGINE, &config->rx_engine, sizeof(config->rx_engine));
+    if (err != ESP_OK) goto cleanup;
+
+    err = nvs_set_blob(nvs_handle, NVS_KEY_OUTAGE_BUF, &config->outage_buf_size, sizeof(config->outage_buf_size));
+    if (err != ESP_OK) goto cleanup;
+
+    err = nvs_set_blob(nvs_handle, NVS_KEY_SOCK_OPTS, &config->sock, sizeof(config->sock));
+    if (err != ESP_OK) goto cleanup;
+
+    err = nvs_set_blob(nvs_handle, NVS_KEY_TCP_ENGINE, &config->tcp_engine, sizeof(config->tcp_engine));
+    if (err != ESP_OK) goto cleanup;
+
+    err = nvs_set_blob(nvs_handle, NVS_KEY_RTU_FRAMING, &config->rtu_framing, sizeof(config->rtu_framing));
+    if (err != ESP_OK) goto cleanup;
+
+    err = nvs_set_blob(nvs_handle, NVS_KEY_MODBUS, &config->modbus, sizeof(config->modbus));
+    if (err != ESP_OK) goto cleanup;
+
+    err = nvs_set_blob(nvs_handle, NVS_KEY_TX_ARBITER, &config->tx_arbiter, sizeof(config->tx_arbiter));
+    if (err != ESP_OK) goto cleanup;
+
     err = nvs_commit(nvs_handle);
 
 cleanup:
     nvs_close(nvs_handle);
     if (err == ESP_OK) {
-        ESP_LOGI(TAG, "config saved successfully");
+        ESP_LOGI(TAG, "bridge(%d) config saved successfully", bridge->index);
     } else {
         ESP_LOGE(TAG, "config save failed: %s", esp_err_to_name(err));
     }
@@ -0,0 +1,148 @@
+/**
+ * @file uart_dma_rx.c
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief 基于UHCI/GDMA的串口接收引擎
+ * @version 0.1
+ * @date 2025-10-31
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "uart_dma_rx.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include <string.h>
+
+bool uart_dma_rx_supported(void)
+{
+    return SOC_UHCI_SUPPORTED;
+}
+
+#if SOC_UHCI_SUPPORTED
+
+static const char *TAG = "uart_dma_rx";
+
+static bool IRAM_ATTR on_rx_event(uhci_controller_handle_t uhci, const uhci_rx_event_data_t *edata, void *user_ctx)
+{
+    uart_dma_rx_t *dma = (uart_dma_rx_t *)user_ctx;
+    BaseType_t woken = pdFALSE;
+
+    // 数据依次写入uhci_receive传入的缓冲区, 这里只累计长度
+    atomic_fetch_add(&dma->received, edata->recv_size);
+    if (edata->flags.totally_received) {
+        atomic_store(&dma->done, true);
+    }
+
+    if (dma->notify_task) {
+        vTaskNotifyGiveFromISR(dma->notify_task, &woken);
+    }
+    return woken == pdTRUE;
+}
+
+esp_err_t uart_dma_rx_open(uart_dma_rx_t *dma, uart_port_t port, TaskHandle_t notify_task)
+{
+    if (!dma) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(dma, 0, sizeof(uart_dma_rx_t));
+    dma->notify_task = notify_task;
+
+    const uhci_controller_config_t config = {
+        .uart_port = port,
+        .tx_trans_queue_depth = 1,
+        .max_transmit_size = UART_DMA_TX_UNUSED_SIZE,   // 发送仍使用串口驱动
+        .max_receive_internal_mem = UART_DMA_RX_NODE_MEM,
+        .dma_burst_size = 0,
+        .max_packet_receive = 0,
+        .rx_eof_flags = {
+            // 线路空闲时结束传输, 与驱动接收的空闲超时对应
+            .idle_eof = 1,
+        },
+    };
+
+    esp_err_t ret = uhci_new_controller(&config, &dma->uhci);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "failed to create uhci controller: %s", esp_err_to_name(ret));
+        dma->uhci = NULL;
+        return ret;
+    }
+
+    const uhci_event_callbacks_t callbacks = {
+        .on_rx_trans_event = on_rx_event,
+    };
+    ret = uhci_register_event_callbacks(dma->uhci, &callbacks, dma);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "failed to register uhci callbacks: %s", esp_err_to_name(ret));
+        uhci_del_controller(dma->uhci);
+        dma->uhci = NULL;
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "uhci rx engine attached to port(%d)", port);
+    return ESP_OK;
+}
+
+void uart_dma_rx_close(uart_dma_rx_t *dma)
+{
+    if (dma && dma->uhci) {
+        uhci_del_controller(dma->uhci);
+        dma->uhci = NULL;
+        dma->armed = false;
+    }
+}
+
+esp_err_t uart_dma_rx_arm(uart_dma_rx_t *dma, uint8_t *buffer, size_t size)
+{
+    if (!dma || !dma->uhci || !buffer || size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    atomic_store(&dma->received, 0);
+    atomic_store(&dma->done, false);
+    dma->taken = 0;
+
+    esp_err_t ret = uhci_receive(dma->uhci, buffer, size);
+    dma->armed = (ret == ESP_OK);
+    return ret;
+}
+
+size_t uart_dma_rx_take(uart_dma_rx_t *dma, bool *done)
+{
+    // 先读done, 保证之前接收的字节数都已计入received
+    const bool finished = dma->armed && atomic_load(&dma->done);
+    const size_t received = atomic_load(&dma->received);
+    const size_t fresh = received - dma->taken;
+
+    dma->taken = received;
+    if (finished) {
+        dma->armed = false;
+    }
+    *done = finished;
+    return fresh;
+}
+
+#else
+
+esp_err_t uart_dma_rx_open(uart_dma_rx_t *dma, uart_port_t port, TaskHandle_t notify_task)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void uart_dma_rx_close(uart_dma_rx_t *dma)
+{
+}
+
+esp_err_t uart_dma_rx_arm(uart_dma_rx_t *dma, uint8_t *buffer, size_t size)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+size_t uart_dma_rx_take(uart_dma_rx_t *dma, bool *done)
+{
+    *done = false;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,289 @@
+/**
+ * @file udp_transport.c
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief UDP传输, 串口分包以数据报的形式发给对端
+ * @version 0.1
+ * @date 2025-10-29
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "udp_transport.h"
+#include "esp_log.h"
+#include "lwip/inet.h"
+#include <string.h>
+#include <errno.h>
+
+static const char *TAG = "udp_transport";
+
+// 接收超时, 用于定期检查是否需要退出
+#define UDP_RECV_TIMEOUT_MS     100
+// 停止时等待接收任务退出的最长时间
+#define UDP_STOP_TIMEOUT_MS     1000
+
+static bool peer_equal(const struct sockaddr_in *a, const struct sockaddr_in *b)
+{
+    return a->sin_addr.s_addr == b->sin_addr.s_addr && a->sin_port == b->sin_port;
+}
+
+/**
+ * @brief 解析序号头, 计算丢包和乱序
+ *
+ * @param udp
+ * @param seq
+ * @param info
+ */
+static void rx_track_seq(udp_transport_t *udp, uint32_t seq, udp_transport_rx_info_t *info)
+{
+    if (!udp->rx_seq_synced) {
+        udp->rx_seq_synced = true;
+        udp->rx_expected_seq = seq + 1;
+        return;
+    }
+
+    int32_t gap = (int32_t)(seq - udp->rx_expected_seq);
+    if (gap < 0 && gap > -UDP_TRANSPORT_SEQ_RESYNC) {
+        // 迟到或重复的数据报, 不影响期望序号
+        info->reordered = true;
+        return;
+    }
+
+    if (gap > 0 && gap < UDP_TRANSPORT_SEQ_RESYNC) {
+        info->lost = (uint32_t)gap;
+    }
+    // 跳变过大时直接重新同步
+    udp->rx_expected_seq = seq + 1;
+}
+
+static void udp_rx_task(void *pvParameters)
+{
+    udp_transport_t *udp = (udp_transport_t *)pvParameters;
+
+    ESP_LOGI(TAG, "udp rx task started");
+
+    while (udp->running) {
+        struct sockaddr_in source;
+        socklen_t source_len = sizeof(source);
+        int len = recvfrom(udp->sock, udp->rx_buf, sizeof(udp->rx_buf), 0,
+                           (struct sockaddr *)&source, &source_len);
+        if (len < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                ESP_LOGW(TAG, "recvfrom failed: errno %d", errno);
+                vTaskDelay(pdMS_TO_TICKS(UDP_RECV_TIMEOUT_MS));
+            }
+            continue;
+        }
+
+        if (udp->config.peer_addr == 0) {
+            // 回复最后一个发来数据的地址
+            xSemaphoreTake(udp->mutex, portMAX_DELAY);
+            if (!udp->peer_valid || !peer_equal(&udp->peer, &source)) {
+                udp->peer = source;
+                udp->peer_valid = true;
+                udp->rx_seq_synced = false;
+                ESP_LOGI(TAG, "peer changed to %s:%d", inet_ntoa(source.sin_addr), ntohs(source.sin_port));
+            }
+            xSemaphoreGive(udp->mutex);
+        }
+
+        udp_transport_rx_info_t info = {0};
+        const uint8_t *payload = udp->rx_buf;
+        size_t payload_len = (size_t)len;
+
+        if (udp->config.seq_header) {
+            if (payload_len < UDP_TRANSPORT_SEQ_HEADER_LEN) {
+                info.malformed = true;
+                payload_len = 0;
+            } else {
+                uint32_t seq = ((uint32_t)payload[0] << 24) | ((uint32_t)payload[1] << 16) |
+                               ((uint32_t)payload[2] << 8) | payload[3];
+                rx_track_seq(udp, seq, &info);
+                payload += UDP_TRANSPORT_SEQ_HEADER_LEN;
+                payload_len -= UDP_TRANSPORT_SEQ_HEADER_LEN;
+            }
+        }
+
+        if (udp->config.recv_callback) {
+            udp->config.recv_callback(payload, payload_len, &info, udp->config.user_ctx);
+        }
+    }
+
+    ESP_LOGW(TAG, "udp rx task stopped");
+    udp->task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t udp_transport_init(udp_transport_t *udp)
+{
+    if (!udp) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(udp, 0, sizeof(udp_transport_t));
+    udp->sock = -1;
+    udp->mutex = xSemaphoreCreateMutex();
+    if (!udp->mutex) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+void udp_transport_deinit(udp_transport_t *udp)
+{
+    if (udp && udp->mutex) {
+        vSemaphoreDelete(udp->mutex);
+        udp->mutex = NULL;
+    }
+}
+
+esp_err_t udp_transport_start(udp_transport_t *udp, const udp_transport_config_t *config)
+{
+    if (!udp || !config || !udp->mutex) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (udp->running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "failed to create socket: errno %d", errno);
+        return ESP_FAIL;
+    }
+
+    struct sockaddr_in local = {
+        .sin_family = AF_INET,
+        .sin_port = htons(config->port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(sock, (struct sockaddr *)&local, sizeof(local)) != 0) {
+        ESP_LOGE(TAG, "failed to bind port(%d): errno %d", config->port, errno);
+        close(sock);
+        return ESP_FAIL;
+    }
+
+    struct timeval timeout = {
+        .tv_sec = 0,
+        .tv_usec = UDP_RECV_TIMEOUT_MS * 1000,
+    };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    udp->config = *config;
+    udp->sock = sock;
+    udp->tx_seq = 0;
+    udp->rx_seq_synced = false;
+    udp->peer_valid = false;
+    memset(&udp->peer, 0, sizeof(udp->peer));
+    if (config->peer_addr != 0) {
+        udp->peer.sin_family = AF_INET;
+        udp->peer.sin_addr.s_addr = config->peer_addr;
+        udp->peer.sin_port = htons(config->peer_port ? config->peer_port : config->port);
+        udp->peer_valid = true;
+    }
+
+    udp->running = true;
+    if (xTaskCreatePinnedToCore(udp_rx_task, "udp_rx", UDP_TRANSPORT_STACK_SIZE, udp,
+                                config->task_priority, &udp->task_handle, config->task_core) != pdPASS) {
+        ESP_LOGE(TAG, "failed to create udp rx task");
+        udp->running = false;
+        udp->task_handle = NULL;
+        udp->sock = -1;
+        close(sock);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "udp transport started on port(%d)", config->port);
+    return ESP_OK;
+}
+
+esp_err_t udp_transport_stop(udp_transport_t *udp)
+{
+    if (!udp) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!udp->running) {
+        return ESP_OK;
+    }
+
+    udp->running = false;
+
+    TickType_t start = xTaskGetTickCount();
+    while (udp->task_handle) {
+        if (xTaskGetTickCount() - start > pdMS_TO_TICKS(UDP_STOP_TIMEOUT_MS)) {
+            ESP_LOGE(TAG, "udp rx task did not stop in time");
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    xSemaphoreTake(udp->mutex, portMAX_DELAY);
+    close(udp->sock);
+    udp->sock = -1;
+    udp->peer_valid = false;
+    xSemaphoreGive(udp->mutex);
+
+    ESP_LOGI(TAG, "udp transport stopped");
+    return ESP_OK;
+}
+
+bool udp_transport_is_running(const udp_transport_t *udp)
+{
+    return udp && udp->running;
+}
+
+esp_err_t udp_transport_send(udp_transport_t *udp, const uint8_t *data, size_t len)
+{
+    if (!udp || !data || len == 0 || len > UDP_TRANSPORT_MAX_PAYLOAD) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t header[UDP_TRANSPORT_SEQ_HEADER_LEN];
+    struct iovec iov[2];
+    int iov_count = 0;
+
+    if (udp->config.seq_header) {
+        uint32_t seq = udp->tx_seq;
+        header[0] = (uint8_t)(seq >> 24);
+        header[1] = (uint8_t)(seq >> 16);
+        header[2] = (uint8_t)(seq >> 8);
+        header[3] = (uint8_t)seq;
+        iov[iov_count].iov_base = header;
+        iov[iov_count].iov_len = sizeof(header);
+        iov_count++;
+    }
+    // 数据直接从环形缓冲区发出, 不需要拼接
+    iov[iov_count].iov_base = (void *)data;
+    iov[iov_count].iov_len = len;
+    iov_count++;
+
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(udp->mutex, portMAX_DELAY);
+    if (udp->sock < 0) {
+        ret = ESP_ERR_INVALID_STATE;
+    } else if (!udp->peer_valid) {
+        ret = ESP_ERR_NOT_FOUND;
+    } else {
+        struct msghdr msg = {
+            .msg_name = &udp->peer,
+            .msg_namelen = sizeof(udp->peer),
+            .msg_iov = iov,
+            .msg_iovlen = iov_count,
+        };
+        if (sendmsg(udp->sock, &msg, MSG_DONTWAIT) < 0) {
+            ESP_LOGD(TAG, "sendmsg failed: errno %d", errno);
+            ret = ESP_FAIL;
+        }
+    }
+    xSemaphoreGive(udp->mutex);
+
+    // 发送失败的数据报也占用序号, 接收方据此统计丢包
+    if (ret == ESP_OK || ret == ESP_FAIL) {
+        udp->tx_seq++;
+    }
+
+    return ret;
+}
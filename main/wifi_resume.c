@@ -0,0 +1,372 @@
+/**
+ * @file wifi_resume.c
+ * @author LiuChuansen (179712066@qq.com)
+ * @brief WiFi短时断开时保留会话, 并用缓存的BSSID和信道快速重连
+ * @version 0.1
+ * @date 2025-11-06
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "wifi_resume.h"
+#include "uart_bridge.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "wifi_resume";
+
+#define NVS_NAMESPACE       "wifi_resume"
+#define NVS_KEY_GRACE       "grace"
+#define NVS_KEY_AP_CACHE    "ap_cache"
+
+typedef struct {
+    char ssid[33];
+    uint8_t bssid[6];
+    uint8_t channel;                // 0表示空位
+    uint32_t used;                  // 最近使用的序号, 用于替换
+} ap_cache_entry_t;
+
+typedef struct {
+    SemaphoreHandle_t mutex;
+    uint16_t grace_sec;
+    ap_cache_entry_t aps[WIFI_RESUME_MAX_APS];
+    uint32_t use_seq;
+
+    // 当前连接, 获取IP时记录
+    char ssid[33];
+    uint32_t ip_addr;
+
+    // 本次断开的状态
+    int64_t down_us;
+    bool fast_pending;              // 已经指定了BSSID, 等待连接结果
+    bool bssid_pinned;              // STA配置中指定了BSSID和信道
+    uint8_t fast_bssid[6];
+
+    wifi_resume_stats_t stats;
+} wifi_resume_ctx_t;
+
+static wifi_resume_ctx_t s_ctx;
+
+static void load_settings(void)
+{
+    nvs_handle_t nvs_handle;
+
+    s_ctx.grace_sec = WIFI_RESUME_DEFAULT_GRACE_SEC;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return;
+    }
+
+    uint16_t grace = 0;
+    size_t required_size = sizeof(grace);
+    if (nvs_get_blob(nvs_handle, NVS_KEY_GRACE, &grace, &required_size) == ESP_OK &&
+        grace <= WIFI_RESUME_MAX_GRACE_SEC) {
+        s_ctx.grace_sec = grace;
+    }
+
+    required_size = sizeof(s_ctx.aps);
+    if (nvs_get_blob(nvs_handle, NVS_KEY_AP_CACHE, s_ctx.aps, &required_size) != ESP_OK ||
+        required_size != sizeof(s_ctx.aps)) {
+        memset(s_ctx.aps, 0, sizeof(s_ctx.aps));
+    }
+    nvs_close(nvs_handle);
+
+    for (int i = 0; i < WIFI_RESUME_MAX_APS; i++) {
+        s_ctx.aps[i].ssid[sizeof(s_ctx.aps[i].ssid) - 1] = '\0';
+        if (s_ctx.aps[i].used > s_ctx.use_seq) {
+            s_ctx.use_seq = s_ctx.aps[i].used;
+        }
+    }
+}
+
+static esp_err_t save_blob(const char *key, const void *value, size_t size)
+{
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to open nvs namespace(%s)", esp_err_to_name(err));
+        return err;
+    }
+
+    err = nvs_set_blob(nvs_handle, key, value, size);
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to save %s(%s)", key, esp_err_to_name(err));
+    }
+    return err;
+}
+
+static ap_cache_entry_t *find_ap(const char *ssid)
+{
+    for (int i = 0; i < WIFI_RESUME_MAX_APS; i++) {
+        if (s_ctx.aps[i].channel != 0 && strcmp(s_ctx.aps[i].ssid, ssid) == 0) {
+            return &s_ctx.aps[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 记录当前AP, 只有BSSID或信道变化时才写NVS
+ *
+ * @param ssid
+ */
+static void update_ap_cache(const char *ssid)
+{
+    wifi_ap_record_t ap_info;
+    if (ssid[0] == '\0' || esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK) {
+        return;
+    }
+
+    ap_cache_entry_t *entry = find_ap(ssid);
+    if (entry && entry->channel == ap_info.primary && memcmp(entry->bssid, ap_info.bssid, sizeof(entry->bssid)) == 0) {
+        // 使用序号只在内存中更新, 避免每次连接都写flash
+        entry->used = ++s_ctx.use_seq;
+        return;
+    }
+
+    if (!entry) {
+        entry = &s_ctx.aps[0];
+        for (int i = 1; i < WIFI_RESUME_MAX_APS; i++) {
+            if (s_ctx.aps[i].used < entry->used) {
+                entry = &s_ctx.aps[i];
+            }
+        }
+        memset(entry, 0, sizeof(*entry));
+        strncpy(entry->ssid, ssid, sizeof(entry->ssid) - 1);
+    }
+    memcpy(entry->bssid, ap_info.bssid, sizeof(entry->bssid));
+    entry->channel = ap_info.primary;
+    entry->used = ++s_ctx.use_seq;
+
+    ESP_LOGI(TAG, "cache ap(%s) %02x:%02x:%02x:%02x:%02x:%02x channel %d", ssid,
+             entry->bssid[0], entry->bssid[1], entry->bssid[2],
+             entry->bssid[3], entry->bssid[4], entry->bssid[5], entry->channel);
+    save_blob(NVS_KEY_AP_CACHE, s_ctx.aps, sizeof(s_ctx.aps));
+}
+
+/**
+ * @brief 在STA配置中指定或清除BSSID和信道
+ *
+ * @param entry 为NULL时清除, 恢复全信道扫描
+ * @return esp_err_t
+ */
+static esp_err_t pin_ap(const ap_cache_entry_t *entry)
+{
+    wifi_config_t config;
+    esp_err_t err = esp_wifi_get_config(WIFI_IF_STA, &config);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    if (entry) {
+        config.sta.bssid_set = true;
+        memcpy(config.sta.bssid, entry->bssid, sizeof(config.sta.bssid));
+        config.sta.channel = entry->channel;
+    } else {
+        config.sta.bssid_set = false;
+        memset(config.sta.bssid, 0, sizeof(config.sta.bssid));
+        config.sta.channel = 0;
+    }
+
+    err = esp_wifi_set_config(WIFI_IF_STA, &config);
+    if (err == ESP_OK) {
+        s_ctx.bssid_pinned = (entry != NULL);
+    }
+    return err;
+}
+
+static uint32_t elapsed_ms(void)
+{
+    return (uint32_t)((esp_timer_get_time() - s_ctx.down_us) / 1000);
+}
+
+void wifi_resume_poll(void)
+{
+    if (!s_ctx.mutex) {
+        return;
+    }
+
+    // 关闭服务期间持有锁: 同时到达的连接事件要等关闭完成, 之后由WiFi事件回调重新启动服务,
+    // 不会在重新连接之后才关闭服务. 各实例的启动和停止另外由实例自己的锁串行化
+    xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
+    const bool expired = s_ctx.stats.in_outage && s_ctx.stats.sessions_kept &&
+                         elapsed_ms() >= (uint32_t)s_ctx.grace_sec * 1000;
+    if (expired) {
+        s_ctx.stats.sessions_kept = false;
+        s_ctx.stats.expired++;
+        ESP_LOGI(TAG, "grace period(%" PRIu16 "s) expired, stopping network services", s_ctx.grace_sec);
+        uart_bridge_stop_all();
+    }
+    xSemaphoreGive(s_ctx.mutex);
+}
+
+esp_err_t wifi_resume_init(void)
+{
+    if (s_ctx.mutex) {
+        return ESP_OK;
+    }
+
+    s_ctx.mutex = xSemaphoreCreateMutex();
+    if (!s_ctx.mutex) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    load_settings();
+    ESP_LOGI(TAG, "grace period %" PRIu16 "s", s_ctx.grace_sec);
+    return ESP_OK;
+}
+
+void wifi_resume_on_connected(const wifi_connection_status_t *status)
+{
+    (void)status;
+
+    if (!s_ctx.mutex) {
+        return;
+    }
+
+    xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
+    if (s_ctx.stats.in_outage) {
+        const uint32_t ms = elapsed_ms();
+        s_ctx.stats.last_reconnect_ms = ms;
+        if (ms > s_ctx.stats.max_reconnect_ms) {
+            s_ctx.stats.max_reconnect_ms = ms;
+        }
+
+        wifi_ap_record_t ap_info;
+        if (s_ctx.fast_pending && esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK &&
+            memcmp(ap_info.bssid, s_ctx.fast_bssid, sizeof(ap_info.bssid)) == 0) {
+            s_ctx.stats.fast_hits++;
+        }
+        s_ctx.fast_pending = false;
+        ESP_LOGI(TAG, "reconnected in %" PRIu32 " ms", ms);
+    }
+    // 已经连上, 取消指定的BSSID和信道, 之后wifi_station的重连可以漫游或跟随AP换信道
+    if (s_ctx.bssid_pinned) {
+        pin_ap(NULL);
+    }
+    xSemaphoreGive(s_ctx.mutex);
+}
+
+bool wifi_resume_on_got_ip(const wifi_connection_status_t *status)
+{
+    bool restart = false;
+
+    if (!s_ctx.mutex || !status) {
+        return false;
+    }
+
+    xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
+    if (s_ctx.stats.in_outage) {
+        const uint32_t ms = elapsed_ms();
+        s_ctx.stats.last_outage_ms = ms;
+        if (ms > s_ctx.stats.max_outage_ms) {
+            s_ctx.stats.max_outage_ms = ms;
+        }
+
+        if (s_ctx.stats.sessions_kept) {
+            // 客户端连接绑定在原来的IP上, IP变化后只能重新开始
+            const bool same_network = strcmp(s_ctx.ssid, status->ssid) == 0 && s_ctx.ip_addr == status->ip_addr;
+            if (same_network) {
+                s_ctx.stats.resumed++;
+            } else {
+                s_ctx.stats.expired++;
+                restart = true;
+            }
+            s_ctx.stats.sessions_kept = false;
+        }
+        s_ctx.stats.in_outage = false;
+        ESP_LOGI(TAG, "outage %" PRIu32 " ms%s", ms, restart ? ", address changed" : "");
+    }
+
+    strncpy(s_ctx.ssid, status->ssid, sizeof(s_ctx.ssid) - 1);
+    s_ctx.ssid[sizeof(s_ctx.ssid) - 1] = '\0';
+    s_ctx.ip_addr = status->ip_addr;
+    update_ap_cache(s_ctx.ssid);
+    xSemaphoreGive(s_ctx.mutex);
+
+    return restart;
+}
+
+bool wifi_resume_on_disconnected(const wifi_connection_status_t *status)
+{
+    (void)status;
+
+    if (!s_ctx.mutex) {
+        return false;
+    }
+
+    xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
+    if (!s_ctx.stats.in_outage) {
+        s_ctx.stats.in_outage = true;
+        s_ctx.stats.disconnects++;
+        s_ctx.down_us = esp_timer_get_time();
+
+        // 只有获取过IP的网络服务才值得保留
+        s_ctx.stats.sessions_kept = s_ctx.grace_sec > 0 && s_ctx.ip_addr != 0;
+
+        // 第一次断开时指定上次的AP, wifi_station重连时直接连接, 跳过扫描
+        // 不在这里调用esp_wifi_connect, 避免与wifi_station自己的重连冲突
+        const ap_cache_entry_t *entry = find_ap(s_ctx.ssid);
+        if (entry && pin_ap(entry) == ESP_OK) {
+            memcpy(s_ctx.fast_bssid, entry->bssid, sizeof(s_ctx.fast_bssid));
+            s_ctx.fast_pending = true;
+            s_ctx.stats.fast_attempts++;
+            ESP_LOGI(TAG, "fast reconnect to %s on channel %d", entry->ssid, entry->channel);
+        }
+    } else if (s_ctx.bssid_pinned) {
+        // 快速重连失败, AP可能已经换了信道或者需要漫游到其它AP
+        ESP_LOGI(TAG, "fast reconnect failed, fallback to scan");
+        s_ctx.fast_pending = false;
+        pin_ap(NULL);
+    }
+    const bool kept = s_ctx.stats.sessions_kept;
+    xSemaphoreGive(s_ctx.mutex);
+
+    return kept;
+}
+
+esp_err_t wifi_resume_set_grace(uint16_t seconds)
+{
+    if (seconds > WIFI_RESUME_MAX_GRACE_SEC) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err = save_blob(NVS_KEY_GRACE, &seconds, sizeof(seconds));
+    if (err == ESP_OK) {
+        s_ctx.grace_sec = seconds;
+        ESP_LOGI(TAG, "set grace period %" PRIu16 "s", seconds);
+    }
+    return err;
+}
+
+uint16_t wifi_resume_get_grace(void)
+{
+    return s_ctx.grace_sec;
+}
+
+esp_err_t wifi_resume_get_stats(wifi_resume_stats_t *stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_ctx.mutex) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
+    *stats = s_ctx.stats;
+    xSemaphoreGive(s_ctx.mutex);
+    return ESP_OK;
+}
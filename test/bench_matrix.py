@@ -0,0 +1,508 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+"""
+串口桥接性能矩阵测试
+
+按 波特率 x 数据包大小 x 发送速率 x 客户端数 的组合依次测试, 每个数据包带有
+来源, 序号和发送时间戳, 用于计算丢包和延迟的百分位数.
+
+测试方式:
+  - 指定 --serial: 电脑的USB串口接到设备的桥接串口, 同时测试两个方向的单向延迟
+    (TCP -> 串口, 串口 -> TCP). 加上 --echo 时电脑把串口收到的数据原样发回,
+    改为测试往返延迟(TCP -> 串口 -> 电脑 -> 串口 -> TCP).
+  - 不指定 --serial: 设备的桥接串口TX/RX短接, 只测试往返延迟.
+
+指定 --console 时, 通过设备控制台的命令行菜单切换波特率, 每组测试前清零统计信息,
+测试后读取设备的计数器. 结果写入CSV/JSON, 按阈值判断是否通过,
+也可以和上一次的JSON结果对比, 发现吞吐量下降.
+"""
+
+import argparse
+import csv
+import json
+import math
+import re
+import socket
+import struct
+import sys
+import threading
+import time
+
+try:
+    import serial
+except ImportError:
+    serial = None
+
+# 与main/include/uart_bridge.h中的UART_BRIDGE_MAX_CLIENTS一致
+MAX_CLIENTS = 5
+
+# 包头: 标记, 来源(客户端序号, 0xFF表示串口), 序号, 发送时间(微秒)
+HEADER = struct.Struct('<4sBIQ')
+MAGIC = b'UBMX'
+SOURCE_SERIAL = 0xFF
+MIN_PACKET_SIZE = 32
+MAX_PACKET_SIZE = 1024
+
+# 自动速率为波特率对应字节速率的百分比(8N1每个字节10位)
+AUTO_RATE_PERCENT = 80
+# 发送结束后, 连续这么久没有收到数据就结束本组测试
+DRAIN_IDLE_SEC = 0.5
+DRAIN_MAX_SEC = 3.0
+
+# 从设备统计信息中取出的计数器: (段落, 名称) -> 结果字段
+DEVICE_COUNTERS = {
+    ('UART Communication', 'TX Drop Bytes'): 'dev_uart_tx_drop',
+    ('UART Communication', 'FIFO Overflows'): 'dev_fifo_overflows',
+    ('UART Communication', 'RX Buffer Full'): 'dev_rx_buffer_full',
+    ('RX Ring Buffer', 'Overrun Bytes'): 'dev_ring_overrun_bytes',
+    ('TCP Communication', 'TX Error Bytes'): 'dev_tcp_tx_error',
+}
+
+_PATTERN = bytes(range(256)) * (MAX_PACKET_SIZE // 256 + 2)
+
+
+def now_us():
+    return time.monotonic_ns() // 1000
+
+
+def build_packet(source, seq, size):
+    """生成数据包, 填充数据由序号决定, 用于校验"""
+    header = HEADER.pack(MAGIC, source, seq, now_us())
+    offset = seq & 0xFF
+    return header + _PATTERN[offset:offset + size - HEADER.size]
+
+
+def percentile(values, percent):
+    """计算百分位数(最近秩), 没有数据时返回None"""
+    if not values:
+        return None
+    ordered = sorted(values)
+    index = min(len(ordered) - 1, max(0, math.ceil(percent / 100.0 * len(ordered)) - 1))
+    return ordered[index]
+
+
+class StreamParser:
+    """从字节流中解析数据包, 数据可能丢失, 按标记重新对齐"""
+
+    def __init__(self, packet_size):
+        self.packet_size = packet_size
+        self.buffer = bytearray()
+        self.latencies = []                 # 微秒
+        self.received = {}                  # 来源 -> 收到的包数
+        self.bytes = 0
+        self.corrupt_bytes = 0
+        self.first_time = None
+        self.last_time = None
+
+    def feed(self, data):
+        t = now_us()
+        if self.first_time is None:
+            self.first_time = t
+        self.last_time = t
+        self.bytes += len(data)
+        self.buffer.extend(data)
+
+        pos = 0
+        size = self.packet_size
+        while len(self.buffer) - pos >= HEADER.size:
+            index = self.buffer.find(MAGIC, pos)
+            if index < 0:
+                # 保留可能是标记开头的几个字节
+                keep = len(self.buffer) - (len(MAGIC) - 1)
+                self.corrupt_bytes += max(0, keep - pos)
+                pos = max(pos, keep)
+                break
+            self.corrupt_bytes += index - pos
+            pos = index
+            if len(self.buffer) - pos < size:
+                break
+
+            _, source, seq, sent = HEADER.unpack_from(self.buffer, pos)
+            offset = seq & 0xFF
+            if self.buffer[pos + HEADER.size:pos + size] != _PATTERN[offset:offset + size - HEADER.size]:
+                # 包内有丢失, 跳过标记继续查找
+                pos += len(MAGIC)
+                self.corrupt_bytes += len(MAGIC)
+                continue
+
+            self.latencies.append(t - sent)
+            self.received[source] = self.received.get(source, 0) + 1
+            pos += size
+        del self.buffer[:pos]
+
+
+class Pacer:
+    """按字节速率发送, rate为0表示不限速"""
+
+    def __init__(self, rate):
+        self.rate = rate
+        self.start = time.monotonic()
+        self.sent = 0
+
+    def wait(self, size):
+        if self.rate > 0:
+            due = self.start + (self.sent + size) / self.rate
+            delay = due - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+        self.sent += size
+
+
+class DeviceConsole:
+    """通过设备控制台的命令行菜单操作"""
+
+    PROMPTS = (b'Please input', b'Input [Enter] to return')
+
+    def __init__(self, device, baudrate=115200):
+        self.port = serial.Serial(device, baudrate, timeout=0.1)
+        self.main_menu()
+
+    def close(self):
+        self.port.close()
+
+    def send(self, text, timeout=3.0):
+        """发送一行输入, 读取到下一个提示为止"""
+        self.port.reset_input_buffer()
+        self.port.write(text.encode() + b'\n')
+        output = bytearray()
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            output.extend(self.port.read(256))
+            if any(p in output for p in self.PROMPTS):
+                # 提示后面可能还有输出, 再读一会
+                output.extend(self.port.read(256))
+                break
+        return output.decode(errors='replace')
+
+    def main_menu(self):
+        # 从任意菜单退回主菜单
+        for _ in range(3):
+            self.send('0')
+        self.send('')
+
+    def set_baudrate(self, baudrate):
+        menu = self.send('3')
+        for line in menu.splitlines():
+            m = re.match(r'\s*(\d+)\.\s+(\d+)', line)
+            if m and int(m.group(2)) == baudrate:
+                self.send(m.group(1))
+                return True
+        self.send('0')
+        return False
+
+    def reset_stats(self):
+        self.send('4')
+        self.send('2')
+        self.send('0')
+
+    def read_stats(self):
+        """读取 Statistics & Debug -> Show Statistics, 返回 {(段落, 名称): 数值}"""
+        self.send('4')
+        output = self.send('1')
+        self.send('')
+        self.send('0')
+
+        stats = {}
+        section = ''
+        for line in output.splitlines():
+            if line and not line.startswith(' ') and line.endswith(':'):
+                section = line[:-1].strip()
+                continue
+            m = re.match(r'\s+(.+?)\s*:\s*(\d+)', line)
+            if m:
+                stats[(section, m.group(1))] = int(m.group(2))
+        return stats
+
+
+class MatrixRunner:
+    def __init__(self, args):
+        self.args = args
+        self.console = DeviceConsole(args.console) if args.console else None
+        self.previous = {}
+        if args.baseline:
+            with open(args.baseline) as f:
+                for row in json.load(f):
+                    self.previous[self.case_key(row)] = row
+
+    @staticmethod
+    def case_key(row):
+        return (row['baudrate'], row['packet_size'], row['rate_kbps'], row['clients'])
+
+    def open_clients(self, count):
+        clients = []
+        for _ in range(count):
+            sock = socket.create_connection((self.args.host, self.args.port), timeout=5)
+            sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            sock.settimeout(0.2)
+            clients.append(sock)
+        # 等待设备把客户端加入转发列表
+        time.sleep(0.5)
+        return clients
+
+    def run_case(self, baudrate, packet_size, rate_kbps, client_count):
+        args = self.args
+        mode = 'loopback' if not args.serial else ('echo' if args.echo else 'oneway')
+        offered = rate_kbps * 1000 // 8 if rate_kbps > 0 else baudrate // 10 * AUTO_RATE_PERCENT // 100
+
+        if self.console:
+            if not self.console.set_baudrate(baudrate):
+                print(f"警告: 设备不支持波特率 {baudrate}, 跳过")
+                return None
+            time.sleep(0.5)
+            self.console.reset_stats()
+
+        port = None
+        if args.serial:
+            port = serial.Serial(args.serial, baudrate, timeout=0.05)
+            port.reset_input_buffer()
+
+        clients = self.open_clients(client_count)
+        running = threading.Event()
+        running.set()
+        sending = threading.Event()
+        sending.set()
+
+        client_parsers = [StreamParser(packet_size) for _ in clients]
+        serial_parser = StreamParser(packet_size)
+        sent = {}
+
+        def client_rx(sock, parser):
+            while running.is_set():
+                try:
+                    data = sock.recv(4096)
+                except socket.timeout:
+                    continue
+                except OSError:
+                    break
+                if not data:
+                    break
+                parser.feed(data)
+
+        def client_tx(sock, source):
+            # 总速率平均分给所有客户端
+            pacer = Pacer(offered / client_count)
+            seq = 0
+            while sending.is_set():
+                pacer.wait(packet_size)
+                try:
+                    sock.sendall(build_packet(source, seq, packet_size))
+                except OSError:
+                    break
+                seq += 1
+            sent[source] = seq
+
+        def serial_rx():
+            while running.is_set():
+                data = port.read(4096)
+                if not data:
+                    continue
+                if args.echo:
+                    port.write(data)
+                serial_parser.feed(data)
+
+        def serial_tx():
+            pacer = Pacer(offered)
+            seq = 0
+            while sending.is_set():
+                pacer.wait(packet_size)
+                port.write(build_packet(SOURCE_SERIAL, seq, packet_size))
+                seq += 1
+            sent[SOURCE_SERIAL] = seq
+
+        threads = [threading.Thread(target=client_rx, args=(s, p), daemon=True)
+                   for s, p in zip(clients, client_parsers)]
+        threads += [threading.Thread(target=client_tx, args=(s, i), daemon=True)
+                    for i, s in enumerate(clients)]
+        if port:
+            threads.append(threading.Thread(target=serial_rx, daemon=True))
+            if mode == 'oneway':
+                threads.append(threading.Thread(target=serial_tx, daemon=True))
+
+        start = time.monotonic()
+        for t in threads:
+            t.start()
+        time.sleep(args.duration)
+        sending.clear()
+
+        # 等待在途数据
+        drain_start = time.monotonic()
+        while time.monotonic() - drain_start < DRAIN_MAX_SEC:
+            parsers = client_parsers + [serial_parser]
+            last = max((p.last_time or 0) for p in parsers)
+            if now_us() - last > DRAIN_IDLE_SEC * 1e6:
+                break
+            time.sleep(0.1)
+        running.clear()
+        for t in threads:
+            t.join(timeout=1.0)
+        for sock in clients:
+            sock.close()
+        if port:
+            port.close()
+        elapsed = time.monotonic() - start
+
+        row = {
+            'baudrate': baudrate,
+            'packet_size': packet_size,
+            'rate_kbps': rate_kbps,
+            'clients': client_count,
+            'mode': mode,
+            'duration_s': round(elapsed, 2),
+            'offered_Bps': offered,
+        }
+        tcp_sent = sum(sent.get(i, 0) for i in range(client_count))
+
+        if mode == 'loopback' or mode == 'echo':
+            # 每个客户端都收到所有客户端的数据
+            latencies = [v for p in client_parsers for v in p.latencies]
+            received = sum(sum(p.received.get(i, 0) for i in range(client_count)) for p in client_parsers)
+            expected = tcp_sent * client_count
+            self.fill_direction(row, 'rtt', latencies, expected, received,
+                                sum(p.bytes for p in client_parsers) / client_count, args.duration)
+        if port:
+            # TCP -> 串口方向
+            received = sum(serial_parser.received.get(i, 0) for i in range(client_count))
+            self.fill_direction(row, 'down', serial_parser.latencies, tcp_sent, received,
+                                serial_parser.bytes, args.duration)
+        if mode == 'oneway':
+            # 串口 -> TCP方向, 每个客户端收到一份
+            latencies = [v for p in client_parsers for v in p.latencies]
+            received = sum(p.received.get(SOURCE_SERIAL, 0) for p in client_parsers)
+            self.fill_direction(row, 'up', latencies, sent.get(SOURCE_SERIAL, 0) * client_count, received,
+                                sum(p.bytes for p in client_parsers) / client_count, args.duration)
+
+        if self.console:
+            stats = self.console.read_stats()
+            for key, name in DEVICE_COUNTERS.items():
+                row[name] = stats.get(key, '')
+
+        self.judge(row)
+        return row
+
+    @staticmethod
+    def fill_direction(row, name, latencies, expected, received, rx_bytes, duration):
+        row[f'{name}_Bps'] = int(rx_bytes / duration)
+        row[f'{name}_sent'] = expected
+        row[f'{name}_lost'] = max(0, expected - received)
+        row[f'{name}_loss_pct'] = round(100.0 * row[f'{name}_lost'] / expected, 3) if expected else 0.0
+        for p in (50, 95, 99):
+            value = percentile(latencies, p)
+            row[f'{name}_p{p}_ms'] = round(value / 1000.0, 2) if value is not None else ''
+        row[f'{name}_max_ms'] = round(max(latencies) / 1000.0, 2) if latencies else ''
+
+    def judge(self, row):
+        args = self.args
+        reasons = []
+        for name in ('down', 'up', 'rtt'):
+            if f'{name}_Bps' not in row:
+                continue
+            if row[f'{name}_Bps'] < row['offered_Bps'] * args.min_throughput / 100.0:
+                reasons.append(f'{name} throughput {row[name + "_Bps"]} B/s')
+            if row[f'{name}_loss_pct'] > args.max_loss:
+                reasons.append(f'{name} loss {row[name + "_loss_pct"]}%')
+            p99 = row[f'{name}_p99_ms']
+            if args.max_p99 > 0 and (p99 == '' or p99 > args.max_p99):
+                reasons.append(f'{name} p99 {p99} ms')
+
+            prev = self.previous.get(self.case_key(row))
+            if prev and prev.get(f'{name}_Bps'):
+                drop = 100.0 * (prev[f'{name}_Bps'] - row[f'{name}_Bps']) / prev[f'{name}_Bps']
+                if drop > args.max_regression:
+                    reasons.append(f'{name} throughput -{drop:.1f}% vs baseline')
+
+        row['result'] = 'FAIL' if reasons else 'PASS'
+        row['reasons'] = '; '.join(reasons)
+
+    def run(self):
+        args = self.args
+        rows = []
+        try:
+            for baudrate in args.baudrates:
+                for packet_size in args.sizes:
+                    for rate_kbps in args.rates:
+                        for clients in args.clients:
+                            print(f"测试: 波特率 {baudrate}, 包大小 {packet_size}, "
+                                  f"速率 {rate_kbps or 'auto'} kbps, 客户端 {clients}")
+                            row = self.run_case(baudrate, packet_size, rate_kbps, clients)
+                            if row:
+                                rows.append(row)
+                                print(f"  {row['result']} {row['reasons']}")
+        except KeyboardInterrupt:
+            print("\n收到中止信号，保存已完成的结果...")
+        finally:
+            if self.console:
+                self.console.close()
+        return rows
+
+
+def write_results(rows, csv_path, json_path):
+    if json_path:
+        with open(json_path, 'w') as f:
+            json.dump(rows, f, indent=2)
+        print(f"结果已写入 {json_path}")
+    if csv_path and rows:
+        fields = []
+        for row in rows:
+            fields += [k for k in row if k not in fields]
+        with open(csv_path, 'w', newline='') as f:
+            writer = csv.DictWriter(f, fieldnames=fields)
+            writer.writeheader()
+            writer.writerows(rows)
+        print(f"结果已写入 {csv_path}")
+
+
+def int_list(text):
+    return [int(v) for v in text.split(',') if v]
+
+
+def main():
+    parser = argparse.ArgumentParser(description='串口桥接性能矩阵测试')
+    parser.add_argument('host', help='设备地址')
+    parser.add_argument('port', nargs='?', type=int, default=5678, help='桥接端口 (默认: 5678)')
+    parser.add_argument('--serial', help='接到设备桥接串口的USB串口, 不指定时要求桥接串口TX/RX短接')
+    parser.add_argument('--echo', action='store_true', help='电脑把串口收到的数据发回, 测试往返延迟')
+    parser.add_argument('--console', help='设备控制台串口, 用于切换波特率和读取计数器')
+    parser.add_argument('-b', '--baudrates', type=int_list, default=[115200], help='波特率列表 (默认: 115200)')
+    parser.add_argument('-s', '--sizes', type=int_list, default=[100], help='数据包大小列表 32-1024字节 (默认: 100)')
+    parser.add_argument('-r', '--rates', type=int_list, default=[0],
+                        help=f'发送速率列表 kbps, 0为波特率的{AUTO_RATE_PERCENT}%% (默认: 0)')
+    parser.add_argument('-c', '--clients', type=int_list, default=[1], help=f'客户端数列表 1-{MAX_CLIENTS} (默认: 1)')
+    parser.add_argument('-d', '--duration', type=int, default=10, help='每组测试时长(秒) (默认: 10)')
+    parser.add_argument('--min-throughput', type=float, default=95.0, help='最低吞吐量, 占设定速率的百分比 (默认: 95)')
+    parser.add_argument('--max-loss', type=float, default=0.0, help='最大丢包率百分比 (默认: 0)')
+    parser.add_argument('--max-p99', type=float, default=0.0, help='最大p99延迟(毫秒), 0为不检查 (默认: 0)')
+    parser.add_argument('--baseline', help='上一次的JSON结果, 用于对比吞吐量')
+    parser.add_argument('--max-regression', type=float, default=10.0, help='相对baseline最大吞吐量下降百分比 (默认: 10)')
+    parser.add_argument('--csv', help='CSV结果文件')
+    parser.add_argument('--json', help='JSON结果文件')
+
+    args = parser.parse_args()
+
+    # 验证参数
+    if any(s < MIN_PACKET_SIZE or s > MAX_PACKET_SIZE for s in args.sizes):
+        print(f"错误: 数据包大小必须在{MIN_PACKET_SIZE}-{MAX_PACKET_SIZE}字节范围内")
+        sys.exit(1)
+    if any(c < 1 or c > MAX_CLIENTS for c in args.clients):
+        print(f"错误: 客户端数必须在1-{MAX_CLIENTS}范围内")
+        sys.exit(1)
+    if (args.serial or args.console) and serial is None:
+        print("错误: 需要安装pyserial")
+        sys.exit(1)
+    if args.echo and not args.serial:
+        print("错误: --echo 需要同时指定 --serial")
+        sys.exit(1)
+    if len(args.baudrates) > 1 and not args.console:
+        print("错误: 测试多个波特率需要指定 --console")
+        sys.exit(1)
+
+    rows = MatrixRunner(args).run()
+    write_results(rows, args.csv, args.json)
+
+    failed = [r for r in rows if r['result'] != 'PASS']
+    print(f"\n共 {len(rows)} 组, 通过 {len(rows) - len(failed)}, 失败 {len(failed)}")
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()